@@ -2,6 +2,7 @@
 #define SEGAOS_APP_RUNTIME_H
 
 #include "app_catalog.h"
+#include "mem.h"
 #include <stdint.h>
 
 #define APP_RUNTIME_SERVICE_VERSION 1U
@@ -67,6 +68,7 @@ typedef struct AppRuntimeContext {
   const struct AppRuntimeServices *services;
   const AppCatalogEntry *catalog;
   void *appState;
+  MemArena *arena; /* Scratch + document bytes, NULL if none */
   uint16_t windowId;
 } AppRuntimeContext;
 
@@ -111,6 +113,7 @@ typedef struct AppRuntime {
   AppCatalogEntry activeCatalog;
   AppRuntimeContext context;
   const AppDefinition *definition;
+  MemArena arena; /* Released in one go by APP_RT_Stop() */
 } AppRuntime;
 
 void APP_RT_Init(AppRuntime *runtime);
@@ -126,5 +129,6 @@ AppRuntimeStatus APP_RT_Draw(AppRuntime *runtime,
                              const AppRuntimeDraw *draw);
 AppRuntimeStatus APP_RT_Command(AppRuntime *runtime, uint16_t command);
 AppRuntimeStatus APP_RT_Stop(AppRuntime *runtime);
+void *APP_RT_Alloc(AppRuntimeContext *ctx, uint32_t bytes);
 
 #endif
@@ -4,9 +4,14 @@
  * This is the first interpreter seam: line-number parsing, small keyword
  * tokenization, sorted storage, replace/delete, LIST/NEW/SAVE/LOAD shell
  * commands, decode, fixed-format program image export/import, simple
- * expression values, and a tiny PRINT/END/GOTO/GOSUB/IF/INPUT runner. It does
- * handle fixed A-Z integer LET variables, but not string variables or concrete
- * display/storage hardware yet.
+ * expression values, and a tiny PRINT/END/GOTO/GOSUB/IF/INPUT/FOR/NEXT
+ * runner. It does handle fixed A-Z integer LET variables, but not string
+ * variables or concrete display/storage hardware yet.
+ *
+ * Storing a line also compiles the whole program into a small stack
+ * bytecode kept in a separate caller-provided code buffer, so the text
+ * storage holds as many lines as it always did. RUN executes the bytecode
+ * and never re-parses text; program images still carry the text only.
  */
 
 #ifndef BASIC_H
@@ -19,9 +24,19 @@
 #define BAS_MAX_STRING_VALUE 96U
 #define BAS_MAX_PROGRAM_LINES 64U
 #define BAS_MAX_PROGRAM_STORAGE 2048U
-#define BAS_RUN_MAX_STEPS 128U
+#define BAS_RUN_MAX_STEPS 128U /* Slice given to a blocking RUN */
 #define BAS_VARIABLE_COUNT 26U
 #define BAS_GOSUB_STACK_DEPTH 8U
+#define BAS_FOR_STACK_DEPTH 8U
+
+/*
+ * Code bytes that always hold the compiled form of 'textBytes' of stored
+ * text in 'lines' lines. A code buffer this size never makes a store or
+ * import fail that the text storage alone would accept.
+ */
+#define BAS_CODE_CAPACITY(textBytes, lines) (2U * (textBytes) + 8U * (lines))
+#define BAS_MAX_PROGRAM_CODE                                                   \
+  BAS_CODE_CAPACITY(BAS_MAX_PROGRAM_STORAGE, BAS_MAX_PROGRAM_LINES)
 
 typedef enum {
   BAS_TOK_RAW = 0,
@@ -51,6 +66,7 @@ typedef struct {
   uint16_t number;
   uint16_t offset;
   uint16_t length;
+  uint16_t code; /* Offset of the compiled line in the code buffer */
 } BasicLine;
 
 typedef struct {
@@ -60,6 +76,9 @@ typedef struct {
   uint8_t *storage;
   uint16_t storageCapacity;
   uint16_t storageUsed;
+  uint8_t *code; /* Compiled lines, rebuilt on every edit */
+  uint16_t codeCapacity;
+  uint16_t codeUsed;
 } BasicProgram;
 
 typedef enum {
@@ -130,7 +149,11 @@ typedef enum {
   BAS_RUN_INPUT_UNAVAILABLE = 11,
   BAS_RUN_BAD_INPUT = 12,
   BAS_RUN_RETURN_WITHOUT_GOSUB = 13,
-  BAS_RUN_GOSUB_STACK_OVERFLOW = 14
+  BAS_RUN_GOSUB_STACK_OVERFLOW = 14,
+  BAS_RUN_YIELDED = 15,      /* Slice budget spent; step again */
+  BAS_RUN_WAITING_INPUT = 16, /* Parked on INPUT with no line yet */
+  BAS_RUN_NEXT_WITHOUT_FOR = 17,
+  BAS_RUN_FOR_STACK_OVERFLOW = 18
 } BasicRunStatus;
 
 typedef struct {
@@ -140,9 +163,50 @@ typedef struct {
   uint16_t errorLine;
 } BasicRunResult;
 
+/*
+ * Open FOR loop. Everything NEXT needs is cached here, so it is an add,
+ * a compare and a branch to 'body' with no line lookup.
+ */
+typedef struct {
+  uint8_t slot; /* Loop variable, 0-25 */
+  uint8_t body; /* Index of the line after the FOR */
+  int16_t limit;
+  int16_t step;
+} BasicForFrame;
+
+/*
+ * Resumable interpreter context. BAS_Step() runs a bounded slice and
+ * returns, keeping the line index, GOSUB stack and any INPUT it is parked
+ * on here, so the frame loop can interleave BASIC with rendering.
+ */
+typedef struct {
+  const BasicProgram *program;
+  BasicRuntime *runtime;
+  BasicLineSink sink;
+  BasicInputSource input;
+  void *user;
+  char *lineBuffer;
+  uint16_t lineBufferBytes;
+  uint8_t pc; /* Index of the next line to run */
+  uint8_t returnStack[BAS_GOSUB_STACK_DEPTH];
+  uint8_t returnDepth;
+  BasicForFrame forStack[BAS_FOR_STACK_DEPTH];
+  uint8_t forDepth;
+  uint8_t waitingInput; /* INPUT at pc found no line yet */
+  BasicRunStatus status;
+  uint32_t statementsExecuted;
+  uint16_t linesEmitted;
+  uint16_t errorLine; /* Line number of the failing statement */
+} BasicExecState;
+
+/*
+ * 'code' receives the compiled program; size it with BAS_CODE_CAPACITY()
+ * of the storage and line capacities so it never limits what fits.
+ */
 void BAS_InitProgram(BasicProgram *program, BasicLine *lines,
                      uint8_t lineCapacity, uint8_t *storage,
-                     uint16_t storageCapacity);
+                     uint16_t storageCapacity, uint8_t *code,
+                     uint16_t codeCapacity);
 void BAS_ClearProgram(BasicProgram *program);
 uint8_t BAS_ParseSourceLine(const char *source, BasicParsedLine *out);
 uint8_t BAS_StoreSourceLine(BasicProgram *program, const char *source);
@@ -190,4 +254,21 @@ uint8_t BAS_RunProgramWithIO(const BasicProgram *program, BasicRuntime *runtime,
                              uint16_t lineBufferBytes,
                              BasicRunResult *result);
 
+/*
+ * Start a run of 'program' from its first line. The program must not be
+ * edited until the run is finished.
+ */
+void BAS_ExecInit(BasicExecState *state, const BasicProgram *program,
+                  BasicRuntime *runtime, BasicLineSink sink,
+                  BasicInputSource input, void *user, char *lineBuffer,
+                  uint16_t lineBufferBytes);
+
+/*
+ * Run at most 'budget' statements. Returns BAS_RUN_YIELDED when the budget
+ * runs out, BAS_RUN_WAITING_INPUT when the input source had no line (the
+ * next call asks again), or the finished run's status, which later calls
+ * keep returning.
+ */
+BasicRunStatus BAS_Step(BasicExecState *state, uint16_t budget);
+
 #endif /* BASIC_H */
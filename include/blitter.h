@@ -232,6 +232,14 @@ void BLT_FillRectPattern(const Rect *r, const Pattern *pat);
 void BLT_FillRectPattern2(const Rect *r, const Pattern *pat, uint8_t fgColor,
                           uint8_t bgColor);
 
+/* XOR every pixel in the rect with `color` (clipped). XOR undoes itself, so
+ * highlights and drag outlines are erased by drawing them again instead of
+ * redrawing what lies beneath. BLT_InvertRect() swaps BLT_BLACK and
+ * BLT_WHITE; BLT_InvertFrame() inverts the 1px outline, each pixel once. */
+void BLT_XorRect(const Rect *r, uint8_t color);
+void BLT_InvertRect(const Rect *r);
+void BLT_InvertFrame(const Rect *r);
+
 /* ============================================================
  * Bitmap Blitting
  * ============================================================ */
@@ -276,6 +284,11 @@ int16_t BLT_StringWidth(const char *str, const Font *font);
 struct Window;
 
 void BLT_DrawWindowFrame(const struct Window *win, const Font *titleFont);
+
+/* The two halves of BLT_DrawWindowFrame(): everything but the title bar, and
+ * the title bar alone, clipped to itself */
+void BLT_DrawWindowBody(const struct Window *win);
+void BLT_DrawWindowTitle(const struct Window *win, const Font *titleFont);
 void BLT_DrawTitleBar(const Rect *titleBar, const char *title, uint8_t hilited,
                       uint8_t hasClose, const Font *titleFont);
 void BLT_DrawCloseBox(int16_t x, int16_t y, uint8_t pressed);
@@ -294,4 +307,31 @@ void BLT_GetClipRect(Rect *r);
  * ============================================================ */
 void BLT_ScrollRect(const Rect *r, int16_t dx, int16_t dy);
 
+/* Copy the pixels of `src` so its top-left lands at (dstX, dstY). Source and
+ * destination may overlap; the destination is clipped to the clip rect.
+ * Spans whose source and destination share byte alignment move a word at a
+ * time. */
+void BLT_CopyRect(const Rect *src, int16_t dstX, int16_t dstY);
+
+/* Save-under copies: BLT_SaveRect() copies the pixels of `part` (all of `r`
+ * when NULL) into `buf`, laid out as the saved copy of `r`; BLT_RestoreRect()
+ * writes them back. Only pixels inside both rects change; neither call is
+ * clipped to the clip rect. BLT_SaveUnderSize() is the buffer size `r`
+ * needs. */
+uint32_t BLT_SaveUnderSize(const Rect *r);
+void BLT_SaveRect(const Rect *r, const Rect *part, uint8_t *buf);
+void BLT_RestoreRect(const Rect *r, const Rect *part, const uint8_t *buf);
+
+#ifdef BLT_HOST_TEST
+/* ============================================================
+ * Host Statistics
+ *
+ * Pixels written by the pixel, line, fill and copy paths since the last
+ * reset, counting a pixel again each time it is overwritten. Host builds
+ * only; the target pays nothing for it.
+ * ============================================================ */
+uint32_t BLT_GetPixelWrites(void);
+void BLT_ResetPixelWrites(void);
+#endif
+
 #endif /* BLITTER_H */
@@ -55,6 +55,23 @@
 #define CMD_FILE_WRITE 0x51   /* Write file to Backup RAM        */
 #define CMD_BASIC_BRAM_PROBE 0x52 /* Probe BASIC SAVE/LOAD via BRAM */
 #define CMD_MOUSE_EVENT 0x60  /* Mouse input event from Main CPU */
+#define CMD_HEAP_TELEMETRY 0x70 /* Page of Sub heap telemetry     */
+
+/* CMD_RENDER_FRAME result words 2-5: the frame's published window move
+ * (WM_GetPublishedMoveEvent), so Main can remap Plane A during a fast drag.
+ * Tile coordinates are 8x8 cells of the 40x28 framebuffer. */
+#define RESULT_MOVE_KIND_ID 2   /* (WM_MOVE_* << 8) | window id, 0xFFFF=none */
+#define RESULT_MOVE_ORIGIN_XY 3 /* (origin tile x0 << 8) | y0                */
+#define RESULT_MOVE_ORIGIN_END 4 /* (origin tile x1 << 8) | y1, exclusive     */
+#define RESULT_MOVE_DELTA 5     /* (int8 dx tiles << 8) | (uint8)(dy tiles)  */
+
+/* CMD_HEAP_TELEMETRY: param 0 is the first MEM_PackTelemetry() word wanted;
+ * asking for word 0 takes a fresh snapshot, later pages read the same one.
+ * Result word 0 is (first << 8) | MEM_TELEMETRY_WORDS, words 1-7 the
+ * snapshot from 'first' on (0 past the end). tools/heap_telemetry.py
+ * reassembles the pages. */
+#define RESULT_TELEMETRY_HEADER 0
+#define RESULT_TELEMETRY_PAGE_WORDS 7
 
 #define COMM_MAIN_IDLE 0x00
 #define COMM_MAIN_PENDING 0x02
@@ -49,13 +49,83 @@ typedef struct {
   uint8_t overflow;
 } DirtyTileQueue;
 
+/* Modelled Main-side cost of one queued span. Each span pays setupCycles
+ * (DMA register writes plus the wait) on top of cyclesPerByte for every byte
+ * converted and transferred. Two spans are coalesced when re-sending the tiles
+ * between them costs less than the setup it saves; setupCycles == 0 only
+ * joins touching or overlapping spans. */
+typedef struct {
+  uint16_t setupCycles;
+  uint16_t cyclesPerByte;
+} DirtyDmaCost;
+
+#define DR_DMA_SETUP_CYCLES_DEFAULT 512U
+#define DR_DMA_CYCLES_PER_BYTE_DEFAULT 4U
+#define DR_COALESCE_MAX_RECTS 32U
+
+/* A run of consecutive tiles that are one solid 4bpp colour. Main services
+ * these with VDP VRAM fill DMA instead of converting and copying them. */
+typedef struct {
+  uint16_t firstTile;
+  uint16_t tileCount;
+  uint8_t colorIndex;
+  uint8_t _pad;
+} DirtyTileFill;
+
+typedef struct {
+  DirtyTileFill *items;
+  uint8_t capacity;
+  uint8_t count;
+  uint16_t tileCount;
+  uint8_t overflow;
+  uint8_t _pad;
+} DirtyFillList;
+
+#define DR_FILL_MIN_RUN_TILES 2U
+
+/* Two rects merge only when their bounding box is at most (100 + waste)%
+ * of their summed areas, so an L-shaped pair stays two rects instead of
+ * redrawing and uploading the empty corner. */
+#define DR_MERGE_WASTE_DEFAULT 50U
+#define DR_MERGE_WASTE_ANY 0xffffU /* Merge every overlapping/touching pair */
+
 typedef struct {
   DirtyRect *items;
   uint8_t capacity;
   uint8_t count;
   Rect bounds;
+  uint16_t mergeWaste; /* Percent; DR_MERGE_WASTE_DEFAULT after init */
 } DirtyRectList;
 
+/* One bit per 8x8 framebuffer tile, in VRAM tile order (row-major, MSB of
+ * byte 0 is tile 0). Marking costs one bit per touched tile and never
+ * overflows, so a full DirtyRectList's overflow merges never widen it. */
+#define DR_TILE_BITMAP_TILES_X 40U /* FB_TILES_X */
+#define DR_TILE_BITMAP_TILES_Y 28U /* FB_TILES_Y */
+#define DR_TILE_BITMAP_TILES (DR_TILE_BITMAP_TILES_X * DR_TILE_BITMAP_TILES_Y)
+#define DR_TILE_BITMAP_BYTES (DR_TILE_BITMAP_TILES / 8U) /* 140 */
+
+typedef struct {
+  uint8_t bits[DR_TILE_BITMAP_BYTES];
+} DirtyTileBitmap;
+
+/*
+ * Banded region, X11 style: rects are grouped into y-bands that share top
+ * and bottom, bands are sorted top to bottom and never overlap, rects within
+ * a band are sorted left to right with gaps between them, and vertically
+ * adjacent bands with identical spans are coalesced. Union, intersect and
+ * subtract walk both inputs once, so cost grows with the rect counts rather
+ * than their product. Storage is caller-owned; an operation that runs out of
+ * capacity sets overflow and returns 0.
+ */
+typedef struct {
+  Rect *rects;
+  uint16_t capacity;
+  uint16_t count;
+  uint8_t overflow;
+  uint8_t _pad;
+} DirtyRegion;
+
 typedef struct {
   Rect menu;
   Rect desktop;
@@ -90,14 +160,51 @@ Boolean DR_BuildTileQueueFromDirtyList(const DirtyRectList *list,
                                        uint8_t tileH, uint16_t planeTilesX,
                                        uint16_t bytesPerTile);
 DirtyTileUpload *DR_GetTileUpload(DirtyTileQueue *queue, uint8_t index);
+void DR_InitFillList(DirtyFillList *fills, DirtyTileFill *storage,
+                     uint8_t capacity);
+void DR_ClearFillList(DirtyFillList *fills);
+Boolean DR_SplitSolidTileRuns(const DirtyTileQueue *in, const uint8_t *linear,
+                              uint16_t bytesPerRow, uint16_t planeTilesX,
+                              uint8_t minRunTiles, DirtyTileQueue *copies,
+                              DirtyFillList *fills);
+void DR_SetDmaCost(const DirtyDmaCost *cost);
+void DR_GetDmaCost(DirtyDmaCost *out);
+uint32_t DR_TileQueueCost(const DirtyTileQueue *queue,
+                          const DirtyDmaCost *cost);
 void DR_PlanRootRedraw(const Rect *dirty, int16_t menuBarHeight,
                        DirtyRootRedraw *out);
 void DR_PlanWindowRedraw(const Rect *dirty, const Rect *windowBounds,
                          DirtyWindowRedraw *out);
 
+void DR_ClearTileBitmap(DirtyTileBitmap *map);
+Boolean DR_MarkTileBitmap(DirtyTileBitmap *map, const Rect *r);
+Boolean DR_TileBitmapTest(const DirtyTileBitmap *map, uint16_t tile);
+uint16_t DR_TileBitmapCount(const DirtyTileBitmap *map);
+Boolean DR_BuildTileQueueFromBitmap(const DirtyTileBitmap *map,
+                                    DirtyTileQueue *queue,
+                                    uint16_t bytesPerTile);
+
+void DR_InitRegion(DirtyRegion *rgn, Rect *storage, uint16_t capacity);
+void DR_RegionClear(DirtyRegion *rgn);
+Boolean DR_RegionSetRect(DirtyRegion *rgn, const Rect *r);
+Boolean DR_RegionCopy(DirtyRegion *out, const DirtyRegion *src);
+/* out must not be a or b */
+Boolean DR_RegionUnion(DirtyRegion *out, const DirtyRegion *a,
+                       const DirtyRegion *b);
+Boolean DR_RegionIntersect(DirtyRegion *out, const DirtyRegion *a,
+                           const DirtyRegion *b);
+Boolean DR_RegionSubtract(DirtyRegion *out, const DirtyRegion *a,
+                          const DirtyRegion *b);
+Boolean DR_RegionIsEmpty(const DirtyRegion *rgn);
+uint32_t DR_RegionArea(const DirtyRegion *rgn);
+Boolean DR_BuildTileQueueFromRegion(const DirtyRegion *rgn,
+                                    DirtyTileQueue *queue,
+                                    uint16_t bytesPerTile);
+
 void DR_InitList(DirtyRectList *list, DirtyRect *storage, uint8_t capacity,
                  const Rect *bounds);
 void DR_ClearList(DirtyRectList *list);
+void DR_SetMergeWaste(DirtyRectList *list, uint16_t wastePercent);
 Boolean DR_AddRect(DirtyRectList *list, const Rect *r);
 uint8_t DR_GetCount(const DirtyRectList *list);
 DirtyRect *DR_GetRect(DirtyRectList *list, uint8_t index);
@@ -0,0 +1,78 @@
+/*
+ * drag_remap.h - Plane A nametable remapping for fast window drags.
+ *
+ * Main CPU policy seam. FB_Init maps Plane A cell (x, y) to framebuffer tile
+ * y * 40 + x. While Sub reports a fast drag (WM_MOVE_DRAG), the cells under
+ * the dragged window are pointed at the tiles the window already occupies in
+ * VRAM from where the drag started, so a move costs a few rows of 2-byte
+ * nametable entries instead of re-rendering and re-uploading the window.
+ *
+ * Desktop cells uncovered inside the drag origin cannot use their home tiles,
+ * which still hold the window's pixels. Those cells are redirected to spare
+ * VRAM tiles between the framebuffer and the text console glyphs, and dirty
+ * uploads for them are routed there by DRM_RoutedUpload.
+ */
+
+#ifndef DRAG_REMAP_H
+#define DRAG_REMAP_H
+
+#include "framebuffer.h"
+#include "text_plane.h"
+#include <stdint.h>
+
+#define DRM_PLANE_CELLS_X 64 /* Plane A is 64 cells wide (see FB_Init) */
+#define DRM_SPARE_FIRST_TILE FB_TILE_COUNT
+#define DRM_SPARE_TILE_COUNT (TP_GLYPH_TILE - FB_TILE_COUNT) /* 321 */
+
+typedef struct {
+  uint8_t active;
+  uint8_t originX0; /* Drag-origin tile rect, exclusive end */
+  uint8_t originY0;
+  uint8_t originX1;
+  uint8_t originY1;
+  int8_t dx; /* Current offset in whole tiles */
+  int8_t dy;
+  uint8_t _pad;
+} DragRemap;
+
+/* Receives one nametable row span: count entries starting at vramAddr. */
+typedef uint8_t (*DRM_NametableSink)(uint16_t vramAddr,
+                                     const uint16_t *entries, uint8_t count,
+                                     void *user);
+
+void DRM_Init(DragRemap *remap);
+uint8_t DRM_Begin(DragRemap *remap, const DirtyTileRange *origin);
+uint8_t DRM_MoveTo(DragRemap *remap, int8_t dxTiles, int8_t dyTiles,
+                   DRM_NametableSink sink, void *user);
+uint8_t DRM_End(DragRemap *remap, DRM_NametableSink sink, void *user);
+
+/* Nametable entry Plane A cell (cx, cy) should hold right now. */
+uint16_t DRM_EntryForCell(const DragRemap *remap, uint16_t cx, uint16_t cy);
+/* VRAM tile a dirty framebuffer tile must be uploaded to right now. */
+uint16_t DRM_RouteTile(const DragRemap *remap, uint16_t tile);
+
+/* Apply CMD_RENDER_FRAME's RESULT_MOVE_* words (see common.h). */
+uint8_t DRM_ApplyMoveResult(DragRemap *remap, uint16_t kindId,
+                            uint16_t originXY, uint16_t originEnd,
+                            uint16_t delta, DRM_NametableSink sink,
+                            void *user);
+
+/* FB_TileUploadCallback that splits each chunk by DRM_RouteTile and forwards
+ * the pieces to the wrapped upload. Pass a DragRemapUpload as user. */
+typedef struct {
+  const DragRemap *remap;
+  FB_TileUploadCallback upload;
+  void *user;
+} DragRemapUpload;
+
+uint8_t DRM_RoutedUpload(const uint8_t *tileData, uint16_t firstTile,
+                         uint16_t tileCount, uint16_t vramAddr,
+                         uint16_t wordCount, void *user);
+
+#ifndef FB_HOST_TEST
+/* Nametable sink that writes straight to VDP VRAM. */
+uint8_t DRM_VdpNametableSink(uint16_t vramAddr, const uint16_t *entries,
+                             uint8_t count, void *user);
+#endif
+
+#endif /* DRAG_REMAP_H */
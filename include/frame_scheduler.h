@@ -31,6 +31,18 @@ typedef struct {
   uint16_t nextTile;
 } FrameScheduleResult;
 
+/* Fill runs skip the 68000 source read and the linear-to-tile conversion, so
+ * they charge a fixed register setup plus a quarter of the bytes they write
+ * against the same per-frame byte budget as copy spans. */
+#define FS_FILL_SETUP_BYTES 16U
+#define FS_FILL_COST_SHIFT 2U
+
+typedef struct {
+  uint8_t nextFill;
+  uint8_t _pad;
+  uint16_t doneTiles; /* tiles already serviced from fills[nextFill] */
+} FrameFillCursor;
+
 void FS_ClearTileCursor(FrameTileCursor *cursor);
 void FS_StartTileCursor(FrameTileCursor *cursor, uint16_t firstTile,
                         uint16_t tileCount);
@@ -38,4 +50,12 @@ uint8_t FS_PlanTileCursorFrame(FrameTileCursor *cursor, DirtyTileQueue *queue,
                                uint16_t bytesPerTile,
                                FrameScheduleResult *result);
 
+uint16_t FS_FillRunCost(uint16_t tileCount, uint16_t bytesPerTile);
+void FS_ClearFillCursor(FrameFillCursor *cursor);
+/* Copy the next budget's worth of fill runs into slice, splitting the last run
+ * when it does not fit. Returns 1 once every run has been handed out. */
+uint8_t FS_PlanFillFrame(FrameFillCursor *cursor, const DirtyFillList *fills,
+                         DirtyFillList *slice, uint16_t budgetBytes,
+                         uint16_t bytesPerTile, uint16_t *chargedBytes);
+
 #endif /* FRAME_SCHEDULER_H */
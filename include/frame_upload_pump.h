@@ -4,6 +4,12 @@
  * The pump owns a scheduler cursor for one rendered Word RAM frame. Each tick
  * plans one budgeted DirtyTileQueue and sends it through a caller-provided
  * upload function. When the cursor completes, Main may return Word RAM to Sub.
+ *
+ * Latest-frame-wins mode replaces the single cursor with a short list of tile
+ * spans stamped with the frame sequence that produced them. When Sub publishes
+ * a newer frame mid-upload, the unsent tail of the old frame is clipped against
+ * the new frame's damage and carried over ahead of it, so tiles the new frame
+ * overwrites anyway are uploaded once, from the newest bank.
  */
 
 #ifndef FRAME_UPLOAD_PUMP_H
@@ -16,6 +22,13 @@
 #define FUP_STATE_UPLOADING 1U
 #define FUP_STATE_READY_TO_RETURN 2U
 #define FUP_STATE_ERROR 3U
+#define FUP_STATE_SUPERSEDED 4U /* Newer frame accepted; next tick resumes */
+#define FUP_STATE_CARRYOVER 5U  /* Sending old-frame tiles from new bank   */
+
+#define FUP_MODE_SINGLE 0U
+#define FUP_MODE_LATEST_WINS 1U
+
+#define FUP_MAX_SPANS 8U
 
 #define FUP_ERROR_NONE 0U
 #define FUP_ERROR_PLAN_FAILED 1U
@@ -24,6 +37,12 @@
 typedef uint8_t (*FrameUploadPumpCallback)(const DirtyTileQueue *queue,
                                            void *user);
 
+typedef struct {
+  uint16_t firstTile;
+  uint16_t tileCount;
+  uint16_t frameSeq;
+} FrameUploadSpan;
+
 typedef struct {
   FrameTileCursor cursor;
   DirtyTileUpload upload;
@@ -32,6 +51,15 @@ typedef struct {
   uint16_t bytesPerTile;
   uint8_t state;
   uint8_t lastError;
+
+  /* Latest-frame-wins span list; unused by the single-cursor paths. */
+  uint8_t mode;
+  uint8_t spanCount;
+  uint8_t spanIndex;
+  uint8_t _pad;
+  uint16_t frameSeq;
+  FrameUploadSpan spans[FUP_MAX_SPANS];
+  DirtyTileUpload spanUploads[FUP_MAX_SPANS];
 } FrameUploadPump;
 
 /* Compact planner path for IP-constrained target code. The caller performs
@@ -65,6 +93,7 @@ static inline uint8_t FUP_BeginFrame(FrameUploadPump *pump, uint16_t firstTile,
   pump->bytesPerTile = bytesPerTile;
   pump->state = FUP_STATE_UPLOADING;
   pump->lastError = FUP_ERROR_NONE;
+  pump->mode = FUP_MODE_SINGLE;
   fup_bind_single_queue(pump);
   return 1;
 }
@@ -116,4 +145,14 @@ uint8_t FUP_IsUploading(const FrameUploadPump *pump);
 uint8_t FUP_HasError(const FrameUploadPump *pump);
 uint16_t FUP_NextTile(const FrameUploadPump *pump);
 
+/* Latest-frame-wins mode. FUP_OfferFrame() accepts a frame's damage spans
+ * while idle, or replaces an in-flight frame when frameSeq is newer. Tick then
+ * batches up to FUP_MAX_SPANS spans per budgeted queue. */
+void FUP_InitLatestWins(FrameUploadPump *pump, uint16_t budgetBytes,
+                        uint16_t bytesPerTile);
+uint8_t FUP_OfferFrame(FrameUploadPump *pump, uint16_t frameSeq,
+                       const DirtyTileQueue *damage);
+uint16_t FUP_PendingTiles(const FrameUploadPump *pump);
+uint16_t FUP_FrameSeq(const FrameUploadPump *pump);
+
 #endif /* FRAME_UPLOAD_PUMP_H */
@@ -123,6 +123,16 @@ uint8_t FB_FlushTileQueueWithCallback(const uint8_t *linear_fb,
                                       FB_TileUploadCallback upload,
                                       void *user);
 
+typedef uint8_t (*FB_TileFillCallback)(uint16_t firstTile, uint16_t tileCount,
+                                       uint16_t vramAddr, uint16_t byteCount,
+                                       uint8_t fillByte, void *user);
+
+/* Flush solid-colour tile runs through a fill sink. Each run becomes one or
+ * more fills of the packed colour byte (index in both nibbles); runs are
+ * chunked so byteCount always fits the VDP's 16-bit DMA length. */
+uint8_t FB_FlushFillListWithCallback(const DirtyFillList *fills,
+                                     FB_TileFillCallback fill, void *user);
+
 /* ============================================================
  * Frame Update
  *
@@ -136,5 +146,15 @@ uint8_t FB_FlushTileQueueWithCallback(const uint8_t *linear_fb,
 void FB_UpdateFrame(const uint8_t *wram_bank);
 uint8_t FB_UpdateTileQueue(const uint8_t *wram_bank,
                            const DirtyTileQueue *queue);
+/* FB_UpdateTileQueue with each converted chunk handed to 'upload' instead
+ * of DMAed directly; FB_DmaTileUpload is the DMA sink for it to wrap. */
+uint8_t FB_UpdateTileQueueWithUpload(const uint8_t *wram_bank,
+                                     const DirtyTileQueue *queue,
+                                     FB_TileUploadCallback upload,
+                                     void *user);
+uint8_t FB_DmaTileUpload(const uint8_t *tileData, uint16_t firstTile,
+                         uint16_t tileCount, uint16_t vramAddr,
+                         uint16_t wordCount, void *user);
+uint8_t FB_UpdateFillList(const DirtyFillList *fills);
 
 #endif /* FRAMEBUFFER_H */
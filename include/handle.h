@@ -0,0 +1,107 @@
+/*
+ * handle.h - Relocatable memory for Genesis System 1 (Sub CPU)
+ *
+ * Mac-style handles layered over mem.c. A Handle points at a master
+ * pointer in a fixed table, and the master pointer points at the data.
+ * Unlocked blocks may move whenever the heap is compacted, so code goes
+ * through *h and reloads it after anything that can allocate, or locks
+ * the handle while it holds the address. Purgeable handles (caches) may
+ * be emptied when memory runs out: *h becomes NULL and the owner
+ * rebuilds the contents with HND_SetSize().
+ *
+ * HND_Init() installs a grow zone, so any MEM_Alloc() that finds no
+ * block that fits first compacts the heap, then purges, before failing.
+ * Blocks from MEM_Alloc() itself and locked handles never move.
+ */
+
+#ifndef HANDLE_H
+#define HANDLE_H
+
+#include "mem.h"
+#include "sega_os.h"
+#include <stdint.h>
+
+#define HND_MASTER_COUNT 64
+
+/* Master pointer flags */
+#define HND_FLAG_USED 0x01
+#define HND_FLAG_LOCKED 0x02
+#define HND_FLAG_PURGEABLE 0x04
+
+/* ============================================================
+ * Master Pointer
+ * ============================================================
+ * 'ptr' comes first so a Handle is the address of the entry. Each
+ * handle block starts with a hidden back-link to its entry, which is
+ * how compaction tells handle blocks from plain MEM_Alloc() ones.
+ * ============================================================ */
+typedef struct MasterPointer {
+  void *ptr;     /* Handle data, NULL when purged or empty */
+  uint32_t size; /* Bytes requested                        */
+  uint8_t flags;
+  uint8_t _pad[3];
+} MasterPointer;
+
+typedef struct {
+  uint16_t handles;     /* Master pointers in use         */
+  uint16_t locked;      /* Handles currently locked       */
+  uint32_t compactions; /* HND_Compact() runs             */
+  uint32_t bytesMoved;  /* Bytes slid down by compaction  */
+  uint32_t purged;      /* Handles emptied by HND_Purge() */
+} HndStats;
+
+/*
+ * Clear the master pointer table and install the grow zone. Call after
+ * MEM_Init().
+ */
+void HND_Init(void);
+
+/*
+ * Allocate a relocatable block of 'size' bytes. Returns NULL when the
+ * table is full or the heap cannot fit it even after compaction and
+ * purging.
+ */
+Handle HND_New(uint32_t size);
+
+/*
+ * Free the block and its master pointer. h may be NULL (no-op).
+ */
+void HND_Dispose(Handle h);
+
+/*
+ * Bytes in the block, 0 when purged.
+ */
+uint32_t HND_GetSize(Handle h);
+
+/*
+ * Resize the block, keeping its contents; a purged handle gets a fresh
+ * block. Size 0 empties the handle. Returns 0 on success, -1 on failure
+ * (the block is unchanged).
+ */
+int8_t HND_SetSize(Handle h, uint32_t size);
+
+/*
+ * Pin the block in place / let it move again.
+ */
+void HND_Lock(Handle h);
+void HND_Unlock(Handle h);
+
+/*
+ * Mark a handle as a cache the heap may empty when memory runs out.
+ */
+void HND_SetPurgeable(Handle h, uint8_t purgeable);
+
+/*
+ * Slide unlocked handle blocks down over free space. Returns bytes
+ * moved.
+ */
+uint32_t HND_Compact(void);
+
+/*
+ * Empty every unlocked purgeable handle. Returns bytes released.
+ */
+uint32_t HND_Purge(void);
+
+void HND_GetStats(HndStats *stats);
+
+#endif /* HANDLE_H */
@@ -1,12 +1,15 @@
 /*
  * mem.h - Memory Manager for Genesis System 1 (Sub CPU)
  *
- * First-fit free list allocator with coalescing.
+ * Segregated-fit allocator: free blocks are filed by size class and two
+ * bitmaps find the smallest class that fits, so alloc and free take the
+ * same time however many blocks are free.
  * Operates on a contiguous heap region within PRG-RAM.
  *
  * All allocations are 4-byte aligned (68000 requirement).
  * Each block has an 8-byte header (size + flags).
- * Adjacent free blocks are coalesced on free().
+ * Free blocks carry boundary tags, so free() merges with both physical
+ * neighbours directly.
  *
  * PRG-RAM layout (512KB):
  *   0x000000 - 0x00xxxx  Code + rodata + bss (linker-defined)
@@ -29,33 +32,58 @@
  * would be smaller than this (header + at least 8 usable bytes) */
 #define MEM_MIN_SPLIT 16
 
+/* Smallest block: a free block holds its list back-link after the header
+ * and a size footer in its last word */
+#define MEM_MIN_BLOCK                                                          \
+  (sizeof(BlockHeader) + sizeof(struct BlockHeader *) + sizeof(uint32_t))
+
+/* Size classes (TLSF-style). Blocks under MEM_SMALL_BLOCK bytes share
+ * first-level class 0, split into MEM_SL_COUNT equal ranges; first-level
+ * class n > 0 holds [2^(n + MEM_FL_SHIFT - 1), 2^(n + MEM_FL_SHIFT)), split
+ * the same way. Sizes include the block header. */
+#define MEM_FL_SHIFT 6
+#define MEM_SMALL_BLOCK (1UL << MEM_FL_SHIFT)
+#define MEM_FL_COUNT 16 /* Heaps under 2 MB */
+#define MEM_SL_LOG2 2
+#define MEM_SL_COUNT (1 << MEM_SL_LOG2)
+
 /* ============================================================
  * Block Header
  * ============================================================
  * Stored immediately before each allocation.
- * |  size (28 bits) | flags (4 bits) |  -- 4 bytes
+ * |  size (30 bits) | flags (2 bits) |  -- 4 bytes
  * |  next free pointer               |  -- 4 bytes
  *
  * Total overhead: 8 bytes per block.
- * 'next' is only meaningful when the block is free.
+ * 'next' links a free block into its size-class list.
+ *
+ * A free block also stores the previous block on its list in its first
+ * data word and its size in its last word (the footer). The header of the
+ * block after it has MEM_FLAG_PREV_FREE set, which says that footer is
+ * there to find the free block's start.
  * ============================================================ */
 
-/* Flag bits stored in the low 4 bits of the size field */
+/* Flag bits stored in the low bits of the size field, which MEM_ALIGN
+ * keeps clear */
 #define MEM_FLAG_USED 0x01
+#define MEM_FLAG_PREV_FREE 0x02 /* Block before this one is free */
+#define MEM_FLAG_MASK (MEM_ALIGN - 1)
 
 typedef struct BlockHeader {
-  uint32_t sizeAndFlags;    /* Upper 28 bits = size, lower 4 = flags  */
+  uint32_t sizeAndFlags;    /* Upper 30 bits = size, lower 2 = flags  */
   struct BlockHeader *next; /* Next free block (only valid when free) */
 } BlockHeader;
 
 /* Helper macros */
-#define BLK_SIZE(b) ((b)->sizeAndFlags & ~0x0FU)
+#define BLK_SIZE(b) ((b)->sizeAndFlags & ~(uint32_t)MEM_FLAG_MASK)
 #define BLK_IS_USED(b) ((b)->sizeAndFlags & MEM_FLAG_USED)
 #define BLK_IS_FREE(b) (!BLK_IS_USED(b))
 #define BLK_SET_USED(b) ((b)->sizeAndFlags |= MEM_FLAG_USED)
 #define BLK_SET_FREE(b) ((b)->sizeAndFlags &= ~MEM_FLAG_USED)
+#define BLK_PREV_IS_FREE(b) ((b)->sizeAndFlags & MEM_FLAG_PREV_FREE)
 #define BLK_SET_SIZE(b, s)                                                     \
-  ((b)->sizeAndFlags = ((s) & ~0x0FU) | ((b)->sizeAndFlags & 0x0FU))
+  ((b)->sizeAndFlags =                                                         \
+       ((s) & ~(uint32_t)MEM_FLAG_MASK) | ((b)->sizeAndFlags & MEM_FLAG_MASK))
 
 /* Get pointer to user data from block header */
 #define BLK_DATA(b) ((void *)((uint8_t *)(b) + sizeof(BlockHeader)))
@@ -66,6 +94,15 @@ typedef struct BlockHeader {
 /* Get next adjacent block in memory (by adding size) */
 #define BLK_NEXT_ADJ(b) ((BlockHeader *)((uint8_t *)(b) + BLK_SIZE(b)))
 
+/* Free blocks only: list back-link and size footer */
+#define BLK_PREV_LINK(b) (*(BlockHeader **)BLK_DATA(b))
+#define BLK_FOOTER(b) (((uint32_t *)BLK_NEXT_ADJ(b))[-1])
+
+/* Previous adjacent block, found through its footer (only when
+ * BLK_PREV_IS_FREE) */
+#define BLK_PREV_ADJ(b)                                                        \
+  ((BlockHeader *)((uint8_t *)(b) - ((uint32_t *)(b))[-1]))
+
 /* ============================================================
  * Heap Statistics
  * ============================================================ */
@@ -78,8 +115,68 @@ typedef struct {
   uint32_t largestFree; /* Largest contiguous free block  */
   uint32_t totalAllocs; /* Lifetime allocation count      */
   uint32_t totalFrees;  /* Lifetime free count            */
+  uint32_t searchSteps; /* List links and blocks visited  */
 } MemStats;
 
+/* ============================================================
+ * Heap Telemetry
+ * ============================================================
+ * Kept up to date by alloc and free, so reading it does not walk the
+ * heap. The histogram counts allocations by requested size in power-of-
+ * two bins: bin 0 is 1-15 bytes, bin n is [2^(n+3), 2^(n+4)), and the
+ * last bin takes everything from 1 KB up.
+ * ============================================================ */
+#define MEM_HIST_BINS 8
+
+typedef struct {
+  uint32_t heapSize;
+  uint32_t usedBytes;    /* Used block bytes, headers included */
+  uint32_t highWater;    /* Most usedBytes since MEM_Init      */
+  uint32_t largestFree;  /* Largest free block, data bytes     */
+  uint32_t failedAllocs; /* MEM_Alloc() calls that returned NULL */
+  uint32_t sizeHistogram[MEM_HIST_BINS];
+} MemTelemetry;
+
+/* MEM_PackTelemetry() layout, 16-bit words, 32-bit values high word
+ * first; histogram counts saturate at 0xFFFF. tools/heap_telemetry.py
+ * decodes it. */
+#define MEM_TELEMETRY_VERSION 1
+#define MEM_TM_VERSION 0
+#define MEM_TM_HEAP_SIZE 1
+#define MEM_TM_USED 3
+#define MEM_TM_HIGH_WATER 5
+#define MEM_TM_LARGEST_FREE 7
+#define MEM_TM_FAILED 9
+#define MEM_TM_HISTOGRAM 11
+#define MEM_TELEMETRY_WORDS (MEM_TM_HISTOGRAM + MEM_HIST_BINS)
+
+/* ============================================================
+ * Relocation
+ * ============================================================
+ * The heap never moves a block on its own. MEM_Compact() offers each
+ * used block that has free space below it to a MemRelocateFn, which says
+ * whether the block may slide down and repoints the owner's references
+ * at the new address. A MemGrowZoneFn runs when MEM_Alloc() finds no
+ * block that fits; if it returns nonzero the search is retried once.
+ * ============================================================ */
+typedef uint8_t (*MemRelocateFn)(void *data, void *newData, void *user);
+typedef uint8_t (*MemGrowZoneFn)(uint32_t size, void *user);
+
+/* ============================================================
+ * Arenas
+ * ============================================================
+ * One heap block carved up by bumping an offset. Allocations are never
+ * freed one by one: MEM_ArenaReset() empties the arena and
+ * MEM_ArenaDestroy() hands the block back, so everything an owner
+ * allocated goes in a single operation.
+ * ============================================================ */
+typedef struct {
+  uint8_t *base;      /* Heap block, NULL when not created   */
+  uint32_t size;      /* Bytes in the block                  */
+  uint32_t used;      /* Bytes handed out since last reset   */
+  uint32_t highWater; /* Most bytes ever in use              */
+} MemArena;
+
 /* ============================================================
  * Public API
  * ============================================================ */
@@ -123,7 +220,9 @@ void MEM_GetStats(MemStats *stats);
 
 /*
  * Validate heap integrity. Returns 0 if OK, -1 if corrupt.
- * Walks all blocks checking size chains and free list consistency.
+ * Walks all blocks checking size chains, boundary tags (footers and
+ * prev-free bits) and that no two free blocks touch, then every
+ * size-class list's links against its class and the bitmaps.
  */
 int8_t MEM_Validate(void);
 
@@ -132,4 +231,49 @@ int8_t MEM_Validate(void);
  */
 uint32_t MEM_GetFreeBytes(void);
 
+/*
+ * Copy the telemetry counters; the largest free block is read from the
+ * top non-empty size class.
+ */
+void MEM_GetTelemetry(MemTelemetry *telemetry);
+
+/*
+ * Flatten telemetry into MEM_TELEMETRY_WORDS words for the Main CPU.
+ */
+void MEM_PackTelemetry(const MemTelemetry *telemetry, uint16_t *words);
+
+/*
+ * Slide every block 'relocate' accepts down into the free space below
+ * it, merging the free space above. Returns the number of bytes moved.
+ */
+uint32_t MEM_Compact(MemRelocateFn relocate, void *user);
+
+/*
+ * Install the hook MEM_Alloc() calls before failing (NULL removes it).
+ * MEM_Init() removes it. The hook is not re-entered while it runs.
+ */
+void MEM_SetGrowZone(MemGrowZoneFn growZone, void *user);
+
+/*
+ * Create an arena backed by one MEM_Alloc() block of 'size' bytes
+ * (rounded up to MEM_ALIGN). Returns 0 on success, -1 on failure.
+ */
+int8_t MEM_ArenaCreate(MemArena *arena, uint32_t size);
+
+/*
+ * Take 'size' bytes from the arena. Returns NULL when it is full.
+ * Returned pointer is 4-byte aligned.
+ */
+void *MEM_ArenaAlloc(MemArena *arena, uint32_t size);
+
+/*
+ * Forget every allocation, keeping the block for reuse.
+ */
+void MEM_ArenaReset(MemArena *arena);
+
+/*
+ * Return the arena's block to the heap. Safe on a zeroed arena.
+ */
+void MEM_ArenaDestroy(MemArena *arena);
+
 #endif /* MEM_H */
@@ -41,6 +41,14 @@
 #define MENU_PADDING_Y 2    /* Vert padding at top/bottom      */
 #define MENU_MIN_WIDTH 80   /* Minimum dropdown width          */
 #define MENU_SHADOW_SIZE 2  /* Drop shadow offset              */
+#define MENU_CHECK_W 10     /* Checkmark column width          */
+
+/* Dropdown hit-testing is one lookup per 2px row: every item boundary lies
+ * on an even offset from the dropdown top. */
+#define MENU_HIT_ROW_H 2
+#define MENU_HIT_ROWS                                                          \
+  ((MENU_PADDING_Y * 2 + MENU_MAX_ITEMS * MENU_ITEM_HEIGHT) / MENU_HIT_ROW_H)
+#define MENU_NO_ITEM 0xFF
 
 /* ============================================================
  * Menu Item Flags
@@ -69,6 +77,13 @@ typedef struct {
   int16_t titleWidth; /* Computed pixel width of title     */
   uint8_t itemCount;  /* Number of items                   */
   MenuItem items[MENU_MAX_ITEMS];
+
+  /* Dropdown layout, recomputed whenever an item is added or changed.
+   * Item i spans rows itemTop[i]..itemTop[i + 1] from the dropdown top. */
+  int16_t dropWidth;
+  int16_t dropHeight;
+  int16_t itemTop[MENU_MAX_ITEMS + 1];
+  uint8_t rowItem[MENU_HIT_ROWS]; /* Selectable item per row, MENU_NO_ITEM */
 } Menu;
 
 /* The complete menu bar state */
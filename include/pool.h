@@ -0,0 +1,77 @@
+/*
+ * pool.h - Fixed-size object pools for Genesis System 1
+ *
+ * A pool hands out equal-sized slots from caller-owned static storage.
+ * Free slots are chained through a small link table, so alloc and free
+ * are a pop and a push; an occupancy bitmap catches double frees and
+ * answers "is slot n live" without touching the objects. Every pool
+ * keeps the same counters, so window records and any later fixed-slot
+ * storage are accounted for alike.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+
+#define POOL_MAX_SLOTS 32 /* One occupancy word */
+#define POOL_NONE 0xFF    /* End of the free list */
+
+typedef struct {
+  uint8_t *slots;     /* count * slotBytes of storage       */
+  uint16_t slotBytes; /* Bytes per slot                     */
+  uint8_t count;      /* Slots in the pool                  */
+  uint8_t freeHead;   /* First free slot, POOL_NONE if full */
+  uint8_t used;       /* Slots handed out                   */
+  uint8_t highWater;  /* Most slots ever out at once        */
+  uint16_t failures;  /* Allocations refused when full      */
+  uint32_t occupied;  /* Bit n: slot n handed out           */
+  uint8_t next[POOL_MAX_SLOTS]; /* Free-list links           */
+} Pool;
+
+typedef struct {
+  uint8_t count;
+  uint8_t used;
+  uint8_t highWater;
+  uint16_t failures;
+  uint32_t bytes; /* Storage behind the pool */
+} PoolStats;
+
+/* Typed storage and access */
+#define POOL_INIT(pool, array)                                                 \
+  POOL_Init((pool), (array), (uint16_t)sizeof((array)[0]),                     \
+            (uint8_t)(sizeof(array) / sizeof((array)[0])))
+#define POOL_ALLOC(pool, type) ((type *)POOL_Alloc(pool))
+#define POOL_AT(pool, type, index) ((type *)POOL_At((pool), (index)))
+
+/*
+ * Set up a pool over 'count' slots of 'slotBytes' each (count at most
+ * POOL_MAX_SLOTS). Slots are first handed out in index order.
+ */
+void POOL_Init(Pool *pool, void *slots, uint16_t slotBytes, uint8_t count);
+
+/*
+ * Take a free slot. Returns NULL when the pool is full. The slot's
+ * contents are left as they were.
+ */
+void *POOL_Alloc(Pool *pool);
+
+/*
+ * Return a slot. Pointers the pool did not hand out, and double frees,
+ * are ignored.
+ */
+void POOL_Free(Pool *pool, void *slot);
+
+/*
+ * Slot index of a pointer into the pool, or -1.
+ */
+int16_t POOL_Index(const Pool *pool, const void *slot);
+
+/*
+ * Live slot at 'index', or NULL if that slot is free.
+ */
+void *POOL_At(const Pool *pool, uint8_t index);
+
+void POOL_GetStats(const Pool *pool, PoolStats *stats);
+
+#endif /* POOL_H */
@@ -5,7 +5,7 @@
 
 /* Types */
 typedef int16_t OSErr;
-typedef uint32_t Handle; /* Pointer to Pointer */
+typedef void **Handle; /* Pointer to master pointer (handle.h) */
 typedef uint32_t Ptr;
 typedef uint8_t Boolean;
 typedef uint32_t Time; /* Ticks (1/60th sec) */
@@ -0,0 +1,97 @@
+/*
+ * text_plane.h - Tile-mapped text console on VDP Plane B.
+ *
+ * The console's characters are Plane B nametable entries pointing at the 95
+ * sysfont glyphs preloaded as VDP tiles, so printing a character costs one
+ * 2-byte nametable write instead of BLT_DrawString into the framebuffer plus
+ * tile conversion and DMA. Console cells set the priority bit, which draws
+ * them above the framebuffer's low-priority Plane A tiles; cells outside the
+ * console stay at entry 0 and fall behind Plane A.
+ *
+ * Sub owns the TextPlane and publishes each frame's changed cells into a
+ * TextPlanePage placed after the framebuffer in the Word RAM bank it hands to
+ * Main. Main applies the page with TPV_ApplyPage (text_plane_vdp.c).
+ */
+
+#ifndef TEXT_PLANE_H
+#define TEXT_PLANE_H
+
+#include "blitter.h"
+#include <stdint.h>
+
+/* VRAM layout: glyph tiles sit just below Plane A ($C000). */
+#define TP_GLYPH_FIRST 32U
+#define TP_GLYPH_COUNT 95U
+#define TP_GLYPH_BYTES 32U
+#define TP_GLYPH_TILE ((0xC000U / TP_GLYPH_BYTES) - TP_GLYPH_COUNT) /* 1441 */
+#define TP_PLANE_ADDR 0xE000U /* VRAM_PLANE_B */
+#define TP_PLANE_CELLS_X 64U
+
+#define TP_MAX_COLS 40U
+#define TP_MAX_ROWS 28U
+#define TP_LOG_MAX 48U
+
+/* Console colours: opaque black ink on white, palette line 0. */
+#define TP_INK 1U
+#define TP_PAPER 15U
+#define TP_ATTR_PRIORITY 0x8000U
+
+/* TextPlanePage lives right after the 35,840-byte framebuffer. */
+#define TP_PAGE_OFFSET 0x8C00UL
+#define TP_PAGE_MAGIC 0x5450U  /* "TP" */
+#define TP_GLYPH_MAGIC 0x4746U /* "GF" */
+
+typedef struct {
+  uint16_t vramAddr;
+  uint16_t entry;
+} TextPlaneCell;
+
+typedef struct {
+  uint8_t x0; /* Plane cell of the console's top-left character */
+  uint8_t y0;
+  uint8_t cols;
+  uint8_t rows;
+  uint8_t curX;
+  uint8_t curY;
+  uint8_t logCount;
+  uint8_t full; /* Log overflowed or scrolled: republish every cell */
+  uint16_t attr;
+  uint16_t log[TP_LOG_MAX]; /* Cell indices changed since last publish */
+  uint16_t cells[TP_MAX_COLS * TP_MAX_ROWS];
+} TextPlane;
+
+typedef struct {
+  uint16_t magic;
+  uint16_t count;
+  uint16_t glyphMagic; /* TP_GLYPH_MAGIC once glyphTiles is filled */
+  uint16_t _pad;
+  TextPlaneCell cells[TP_MAX_COLS * TP_MAX_ROWS];
+  uint8_t glyphTiles[TP_GLYPH_COUNT * TP_GLYPH_BYTES];
+} TextPlanePage;
+
+/* Sub side */
+uint8_t TP_Init(TextPlane *tp, uint8_t x0, uint8_t y0, uint8_t cols,
+                uint8_t rows);
+void TP_Clear(TextPlane *tp);
+void TP_Close(TextPlane *tp);
+void TP_PutChar(TextPlane *tp, char ch);
+void TP_Write(TextPlane *tp, const char *str);
+uint16_t TP_EntryForChar(const TextPlane *tp, char ch);
+uint8_t TP_BasicLineSink(const char *line, void *user);
+void TP_BuildGlyphTile(const uint8_t rows[8], uint8_t ink, uint8_t paper,
+                       uint8_t *out);
+uint8_t TP_BuildGlyphTiles(const Font *font, uint8_t ink, uint8_t paper,
+                           uint8_t *out);
+uint16_t TP_Publish(TextPlane *tp, TextPlanePage *page, const Font *font);
+
+/* Main side */
+typedef uint8_t (*TPV_CellSink)(uint16_t vramAddr, uint16_t entry,
+                                void *user);
+uint16_t TPV_ApplyPage(const TextPlanePage *page, TPV_CellSink sink,
+                       void *user);
+#ifndef FB_HOST_TEST
+uint8_t TPV_VdpCellSink(uint16_t vramAddr, uint16_t entry, void *user);
+uint8_t TPV_UploadGlyphs(const TextPlanePage *page);
+#endif
+
+#endif /* TEXT_PLANE_H */
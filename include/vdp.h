@@ -131,6 +131,23 @@ static inline void VDP_DMAToVRAM(uint32_t src, uint16_t dest,
       (uint32_t)(0x40000080 | (((dest) & 0x3FFF) << 16) | (((dest) >> 14) & 3));
 }
 
+/* VRAM fill DMA: write fill_byte to len_bytes consecutive VRAM bytes from
+ * dest. Auto-increment is left at 1; callers wait for DMA completion before
+ * the next VDP access, which the DMA helpers above reset to 2. */
+static inline void VDP_DMAFillVRAM(uint16_t dest, uint16_t len_bytes,
+                                   uint8_t fill_byte) {
+  uint16_t len = (uint16_t)(len_bytes - 1);
+
+  VDP_SET_REG(VDP_REG_AUTOINC, 1);
+  VDP_SET_REG(VDP_REG_DMALEN_LO, len & 0xFF);
+  VDP_SET_REG(VDP_REG_DMALEN_HI, (len >> 8) & 0xFF);
+  VDP_SET_REG(VDP_REG_DMASRC_HI, 0x80); /* DMA type: VRAM fill */
+
+  VDP_CTRL_PORT32 =
+      (uint32_t)(0x40000080 | (((dest) & 0x3FFF) << 16) | (((dest) >> 14) & 3));
+  VDP_DATA_PORT = (uint16_t)(((uint16_t)fill_byte << 8) | fill_byte);
+}
+
 /* Load palette (16 colors) to CRAM */
 static inline void VDP_LoadPalette(const uint16_t *colors, uint8_t palLine,
                                    uint8_t count) {
@@ -6,7 +6,7 @@
  *
  * Design constraints:
  *   - 320x224 resolution, 1-bit (B&W) rendering
- *   - Max ~16 windows (RAM budget: ~2KB for window records)
+ *   - Max ~16 windows (RAM budget: ~3.5KB for window records)
  *   - Dirty rectangle tracking for partial screen updates
  *   - Cooperative: only one window moves/resizes at a time
  */
@@ -14,7 +14,9 @@
 #ifndef WM_H
 #define WM_H
 
+#include "blitter.h"
 #include "dirty_rect.h"
+#include "pool.h"
 #include "sega_os.h"
 
 /* ============================================================
@@ -26,6 +28,26 @@
 #define WM_SCREEN_W 320
 #define WM_SCREEN_H 224
 #define WM_MENUBAR_H 20 /* Menu bar height in pixels    */
+#define WM_MAX_MOVE_EVENTS 4
+#define WM_VIS_MAX_RECTS 12 /* Visible-region pieces cached per window */
+#define WM_PLAN_MAX_PIECES 96 /* Clip pieces per planned dirty rect    */
+#define WM_CURSOR_W 11
+#define WM_CURSOR_H 16
+
+/* Save-under: pixels beneath transient surfaces, in a PRG-RAM pool */
+#define WM_SAVE_UNDER_SLOTS 4
+#define WM_SAVE_UNDER_BYTES 24576U /* ~ an alert plus an open dropdown */
+#define WM_SAVE_UNDER_STALE 4      /* Stale-area rects tracked per slot */
+
+/* Chrome cache: rendered title bars, kept per window and hilite state */
+#define WM_CHROME_SLOTS 8
+#define WM_CHROME_BYTES 16384U /* ~ five full-width title bars at 4bpp */
+
+/* Fast drag reuses the window's uploaded tiles and parks exposed desktop
+ * cells in the VRAM gap between the framebuffer tiles and the text console
+ * glyphs (text_plane.h), so the drag-start frame must fit in that many 8x8
+ * tiles. */
+#define WM_FAST_DRAG_MAX_TILES 321
 
 /* ============================================================
  * Window Parts (hit-test results)
@@ -82,7 +104,8 @@ typedef enum {
 /* ============================================================
  * WindowRecord - The core window data structure
  *
- * Each window occupies ~128 bytes. At 16 max = 2KB total.
+ * Each window occupies 218 bytes on the 68000, 96 of them the cached
+ * visible region. At 16 max = ~3.5KB total.
  * This is allocated from a static pool (no malloc needed).
  * ============================================================ */
 typedef struct Window {
@@ -117,18 +140,126 @@ typedef struct Window {
   uint8_t dirtyCount; /* Number of dirty sub-rects    */
   uint8_t _pad1;
   Rect dirtyRects[4]; /* Per-window dirty rects       */
+
+  /* Visible region: painted area minus windows above, as disjoint rects.
+   * visOverflow means the pieces did not fit and visRects holds the whole
+   * painted area instead. Kept current by the WM. */
+  uint8_t visCount;
+  uint8_t visOverflow;
+  Rect visRects[WM_VIS_MAX_RECTS];
+
+  /* Save-under slot + 1 for alert/dialog windows (0 = none) */
+  uint8_t saveUnder;
+  uint8_t _pad2;
 } Window;
 
+/* ============================================================
+ * Window Move Events
+ *
+ * WM_MoveWindow records what moved as well as what it invalidated so the
+ * Main CPU can act on a drag without waiting for re-rendered pixels.
+ * ============================================================ */
+#define WM_MOVE_PLAIN 0 /* Ordinary move: pixels blitted at next update    */
+#define WM_MOVE_DRAG 1  /* Fast-drag step: from = drag origin, to = frame  */
+                        /* snapped to whole tiles relative to the origin   */
+#define WM_MOVE_DROP 2  /* Fast drag ended: window re-rendered at to       */
+
+typedef struct {
+  uint8_t windowId;
+  uint8_t kind; /* WM_MOVE_* */
+  Rect from;
+  Rect to;
+} WindowMoveEvent;
+
+/* ============================================================
+ * Redraw Planning
+ *
+ * WM_PlanRedraw walks the z-order front to back, handing each window the
+ * part of the damage it paints and subtracting that from what the windows
+ * below and the desktop (win == 0) will see. Pieces are disjoint and listed
+ * back-to-front, so each damaged pixel is painted once.
+ * ============================================================ */
+typedef struct {
+  struct Window *win; /* 0 = desktop */
+  Rect clip;
+} WMRedrawPiece;
+
+typedef struct {
+  uint8_t count;
+  uint8_t overflow; /* Fell back to painter's order over whole frames */
+  WMRedrawPiece pieces[WM_PLAN_MAX_PIECES];
+} WMRedrawPlan;
+
+/* Overdraw = pixelsPainted / pixelsDamaged; 1.0 means no pixel is painted
+ * twice. pixelsPainted is the blitter's count of pixels actually written,
+ * kept only in host builds (BLT_HOST_TEST); it reads 0 on the target. */
+typedef struct {
+  uint32_t pixelsDamaged;
+  uint32_t pixelsPainted;
+  uint16_t plans;
+  uint16_t planOverflows;
+  uint16_t chromeHits;   /* Title bars blitted from the chrome cache */
+  uint16_t chromeMisses; /* Title bars drawn from scratch            */
+} WMStats;
+
+/* ============================================================
+ * Save-under
+ *
+ * A transient surface (open dropdown, alert or dialog window) keeps a copy
+ * of the pixels it covers so dismissing it is one BLT_RestoreRect() instead
+ * of every window underneath redrawing. Anything invalidated beneath the
+ * surface while it is up is recorded as stale and invalidated again after
+ * the restore, so the copy never has to be exact to be correct.
+ * ============================================================ */
+#define WM_SU_FREE 0
+#define WM_SU_PENDING 1 /* Capture at the next WM_BeginUpdate           */
+#define WM_SU_SAVED 2
+#define WM_SU_RESTORE 3 /* Blit back at the next WM_BeginUpdate         */
+
+typedef struct {
+  Rect rect;
+  struct Window *owner; /* NULL for surfaces drawn over everything */
+  uint16_t offset;      /* Into the save-under pool */
+  uint16_t size;
+  uint8_t state;
+  uint8_t seq; /* Capture order: overlapping copies restore newest first */
+  DirtyRect staleRects[WM_SAVE_UNDER_STALE];
+  DirtyRectList stale;
+} WMSaveUnder;
+
+/* ============================================================
+ * Chrome cache
+ *
+ * A title bar depends only on its width, title and hilite state, so the WM
+ * keeps the rendered pixels of each window's title bar (one copy per hilite
+ * state) and blits them back instead of redrawing stripes, text and close
+ * box. A copy is keyed on the title bar's origin modulo the 8x8 stripe
+ * pattern, so it stays valid while the window moves by whole pattern cells
+ * (as snapped drags do); resizing, retitling or
+ * disposing of the window drops them. Least recently used copies are
+ * evicted when the pool fills.
+ * ============================================================ */
+typedef struct {
+  uint8_t windowId; /* Window id + 1; 0 = free slot */
+  uint8_t hilited;
+  uint8_t phase;    /* titleBar origin on the 8x8 pattern grid   */
+  uint8_t mode;     /* BlitMode the copy was taken in            */
+  const Font *font;
+  int16_t width;
+  uint16_t offset;  /* Into the chrome pool */
+  uint16_t size;
+  uint16_t lastUse;
+} WMChromeEntry;
+
 /* ============================================================
  * WindowManager - Global state
  *
  * Single instance, lives in Sub CPU BSS.
  * ============================================================ */
 typedef struct {
-  /* Window pool (static allocation) */
-  Window pool[WM_MAX_WINDOWS];
-  uint8_t poolUsed[WM_MAX_WINDOWS]; /* 0=free, 1=in-use  */
-  uint8_t windowCount;
+  /* Window records (static allocation, handed out by windowPool) */
+  Window windows[WM_MAX_WINDOWS];
+  Pool windowPool;
 
   /* Z-order (linked list) */
   Window *topWindow;    /* Frontmost window             */
@@ -140,6 +271,7 @@ typedef struct {
   /* Global dirty rect accumulator */
   DirtyRect dirtyRects[WM_MAX_DIRTY_RECTS];
   DirtyRectList dirtyList;
+  DirtyTileBitmap dirtyTiles; /* Same damage at tile granularity, no merging */
 
   /* Desktop state */
   uint8_t desktopPattern; /* 0=white, 1=gray, 2=checker  */
@@ -148,6 +280,44 @@ typedef struct {
   /* Cursor */
   Point cursorPos;
   uint8_t cursorVisible;
+
+  /* Fast drag (Plane A nametable remap on the Main CPU) */
+  uint8_t fastDragEnabled;
+  Window *fastDragWindow;
+  Rect fastDragOrigin; /* Frame when the drag started          */
+  Rect fastDragShown;  /* Last snapped frame reported to Main  */
+
+  /* Outline drag (XOR frame in the framebuffer) */
+  uint8_t outlineDragEnabled;
+  uint8_t outlineDrawn; /* outlineShown is XOR-ed into the framebuffer */
+  Window *outlineWindow;
+  Rect outlineFrame; /* Where the window would land now         */
+  Rect outlineShown;
+
+  /* Redraw statistics since WM_Init / WM_ResetStats */
+  WMStats stats;
+
+  /* Visible regions need recomputing (z-order/geometry changed) */
+  uint8_t visStale;
+
+  /* Blit move waiting for the next WM_BeginUpdate */
+  Window *blitWindow;
+  Rect blitFrom; /* Frame whose pixels are still in the framebuffer */
+
+  /* Move events since the last WM_EndUpdate */
+  WindowMoveEvent moveEvents[WM_MAX_MOVE_EVENTS];
+  uint8_t moveEventCount;
+
+  /* Between WM_BeginUpdate and WM_EndUpdate (Sub owns Word RAM) */
+  uint8_t inUpdate;
+  uint8_t saveUnderSeq;
+  WMSaveUnder saveUnders[WM_SAVE_UNDER_SLOTS];
+  DirtyRect lateRects[WM_SAVE_UNDER_STALE];
+  DirtyRectList lateList; /* Stale rects of mid-update restores */
+
+  /* Chrome cache */
+  uint16_t chromeClock;
+  WMChromeEntry chrome[WM_CHROME_SLOTS];
 } WindowManager;
 
 /* ============================================================
@@ -175,6 +345,52 @@ void WM_MoveWindow(Window *win, int16_t x, int16_t y);
 void WM_SizeWindow(Window *win, int16_t w, int16_t h);
 void WM_SetTitle(Window *win, const char *title);
 
+/* WM_MoveWindow does not redraw a visible window at its new position: the
+ * next WM_BeginUpdate copies its pixels there with BLT_CopyRect and
+ * invalidates only the uncovered part of the old frame plus whatever the copy
+ * cannot supply (areas that were dirty or covered before the move, and
+ * windows above the new position). Without a framebuffer, or if the move
+ * clipped the window, both frames are invalidated instead. */
+
+/* Fast drag: while active, WM_MoveWindow snaps the window to whole-tile
+ * offsets from where the drag began and invalidates only the desktop it
+ * uncovers; WM_EndFastDrag places it at full precision and re-renders it. */
+void WM_SetFastDrag(Boolean enabled);
+Boolean WM_BeginFastDrag(Window *win);
+void WM_EndFastDrag(int16_t x, int16_t y);
+Boolean WM_IsFastDragging(void);
+
+/* Outline drag: while active, WM_MoveWindow leaves the window where it is
+ * and only moves an XOR outline. WM_DrawDragOutline() draws the outline as
+ * the frame's last step (after the cursor); the next WM_BeginUpdate erases
+ * it by XOR-ing it again, so tracking invalidates nothing. WM_EndOutlineDrag
+ * moves the window for real. */
+void WM_SetOutlineDrag(Boolean enabled);
+Boolean WM_BeginOutlineDrag(Window *win);
+void WM_EndOutlineDrag(int16_t x, int16_t y);
+Boolean WM_IsOutlineDragging(void);
+void WM_DrawDragOutline(void);
+
+/* Move events */
+uint8_t WM_GetMoveEventCount(void);
+const WindowMoveEvent *WM_GetMoveEvent(uint8_t index);
+const WindowMoveEvent *WM_GetPublishedMoveEvent(void);
+
+/* Visible regions: each visible window's painted area (frame plus drop
+ * shadow strips) minus the windows above it. Recomputed lazily after z-order,
+ * visibility or geometry changes. WM_GetVisiblePieces clips a dirty rect to
+ * a window's visible pieces and returns how many it wrote. */
+void WM_UpdateVisibleRegions(void);
+uint8_t WM_GetVisibleRectCount(Window *win);
+const Rect *WM_GetVisibleRect(Window *win, uint8_t index);
+uint8_t WM_GetVisiblePieces(Window *win, const Rect *dirty, Rect *out,
+                            uint8_t maxOut);
+
+/* Redraw planning and statistics */
+Boolean WM_PlanRedraw(const Rect *dirty, WMRedrawPlan *plan);
+void WM_GetStats(WMStats *out);
+void WM_ResetStats(void);
+
 /* Hit testing */
 WindowPart WM_FindWindow(Point pt, Window **outWin);
 HitTestResult WM_HitTest(Point pt); /* Convenience wrapper */
@@ -189,8 +405,29 @@ void WM_ValidateRect(Rect *r);            /* Mark region as clean     */
 /* Returns number of dirty rects that need VDP transfer */
 uint8_t WM_BeginUpdate(void);
 DirtyRect *WM_GetDirtyRect(uint8_t index);
+uint8_t WM_GetDirtyCount(void);
+/* Tiles touched this frame, for DR_BuildTileQueueFromBitmap() uploads */
+const DirtyTileBitmap *WM_GetDirtyTiles(void);
 void WM_EndUpdate(void);
 
+/* Save-under for transient surfaces. WM_SaveUnder() returns a handle or
+ * -1 when the pool is full (callers then invalidate on dismissal as before).
+ * Inside an update the pixels are copied at once, so call it after the
+ * layers below have painted; outside, the copy waits for WM_BeginUpdate.
+ * WM_RefreshSaveUnder() re-copies this frame's dirty areas for a surface
+ * drawn after everything else (a dropdown); restoring one inside an update
+ * does the same first. WM_RestoreUnder() blits the copy back (deferred to
+ * WM_BeginUpdate outside an update) and frees it. */
+int8_t WM_SaveUnder(const Rect *r);
+void WM_RefreshSaveUnder(int8_t handle);
+void WM_RestoreUnder(int8_t handle);
+void WM_SetCursorPos(int16_t x, int16_t y);
+
+/* Window chrome: BLT_DrawWindowFrame() with the title bar served from the
+ * chrome cache. Only the part inside the clip rect is drawn; a title bar
+ * drawn whole is cached for next time. */
+void WM_DrawWindowFrame(Window *win, const Font *titleFont);
+
 /* Desktop */
 void WM_DrawDesktop(void);
 void WM_DrawDesktopInRect(const Rect *dirty);
@@ -204,5 +441,6 @@ Window *WM_GetActiveWindow(void); /* Currently active window  */
 
 /* Debug */
 uint8_t WM_GetWindowCount(void);
+void WM_GetWindowPoolStats(PoolStats *out); /* Slots, high water, refusals */
 
 #endif /* WM_H */
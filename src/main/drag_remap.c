@@ -0,0 +1,281 @@
+#include "drag_remap.h"
+
+/* Move kinds as published by Sub's WM_GetPublishedMoveEvent (wm.h). */
+#define DRM_KIND_PLAIN 0 /* WM_MOVE_PLAIN */
+#define DRM_KIND_DRAG 1  /* WM_MOVE_DRAG */
+#define DRM_KIND_DROP 2  /* WM_MOVE_DROP */
+
+typedef struct {
+  int16_t x0;
+  int16_t y0;
+  int16_t x1;
+  int16_t y1;
+} DrmCellRect;
+
+static uint8_t drm_in_rect(const DrmCellRect *r, int16_t x, int16_t y) {
+  return (x >= r->x0 && x < r->x1 && y >= r->y0 && y < r->y1) ? 1 : 0;
+}
+
+static void drm_origin_rect(const DragRemap *remap, DrmCellRect *out) {
+  out->x0 = remap->originX0;
+  out->y0 = remap->originY0;
+  out->x1 = remap->originX1;
+  out->y1 = remap->originY1;
+}
+
+static void drm_shifted_rect(const DragRemap *remap, int8_t dx, int8_t dy,
+                             DrmCellRect *out) {
+  drm_origin_rect(remap, out);
+  out->x0 = (int16_t)(out->x0 + dx);
+  out->x1 = (int16_t)(out->x1 + dx);
+  out->y0 = (int16_t)(out->y0 + dy);
+  out->y1 = (int16_t)(out->y1 + dy);
+}
+
+static void drm_union_clip(const DrmCellRect *a, const DrmCellRect *b,
+                           DrmCellRect *out) {
+  out->x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+  out->y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+  out->x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+  out->y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+
+  if (out->x0 < 0)
+    out->x0 = 0;
+  if (out->y0 < 0)
+    out->y0 = 0;
+  if (out->x1 > FB_TILES_X)
+    out->x1 = FB_TILES_X;
+  if (out->y1 > FB_TILES_Y)
+    out->y1 = FB_TILES_Y;
+}
+
+static uint16_t drm_spare_tile(const DragRemap *remap, int16_t cx, int16_t cy) {
+  uint16_t width = (uint16_t)(remap->originX1 - remap->originX0);
+
+  return (uint16_t)(DRM_SPARE_FIRST_TILE +
+                    ((uint16_t)(cy - remap->originY0) * width) +
+                    (uint16_t)(cx - remap->originX0));
+}
+
+/* Rewrite every cell of `rows` from DRM_EntryForCell, one sink call per row */
+static uint8_t drm_write_rows(const DragRemap *remap, const DrmCellRect *rows,
+                              DRM_NametableSink sink, void *user) {
+  uint16_t entries[FB_TILES_X];
+  int16_t x;
+  int16_t y;
+
+  if (rows->x0 >= rows->x1)
+    return 1;
+
+  for (y = rows->y0; y < rows->y1; y++) {
+    for (x = rows->x0; x < rows->x1; x++)
+      entries[x - rows->x0] =
+          DRM_EntryForCell(remap, (uint16_t)x, (uint16_t)y);
+
+    if (!sink((uint16_t)(VRAM_PLANE_A +
+                         (((uint16_t)y * DRM_PLANE_CELLS_X) +
+                          (uint16_t)rows->x0) *
+                             2U),
+              entries, (uint8_t)(rows->x1 - rows->x0), user))
+      return 0;
+  }
+
+  return 1;
+}
+
+void DRM_Init(DragRemap *remap) {
+  if (!remap)
+    return;
+
+  remap->active = 0;
+  remap->originX0 = 0;
+  remap->originY0 = 0;
+  remap->originX1 = 0;
+  remap->originY1 = 0;
+  remap->dx = 0;
+  remap->dy = 0;
+  remap->_pad = 0;
+}
+
+uint8_t DRM_Begin(DragRemap *remap, const DirtyTileRange *origin) {
+  uint32_t tiles;
+
+  if (!remap || !origin)
+    return 0;
+  if (origin->x0 >= origin->x1 || origin->y0 >= origin->y1)
+    return 0;
+  if (origin->x1 > FB_TILES_X || origin->y1 > FB_TILES_Y)
+    return 0;
+
+  tiles = (uint32_t)(origin->x1 - origin->x0) * (origin->y1 - origin->y0);
+  if (tiles > DRM_SPARE_TILE_COUNT)
+    return 0;
+
+  /* At offset zero every cell already maps home; nothing to write yet. */
+  remap->active = 1;
+  remap->originX0 = (uint8_t)origin->x0;
+  remap->originY0 = (uint8_t)origin->y0;
+  remap->originX1 = (uint8_t)origin->x1;
+  remap->originY1 = (uint8_t)origin->y1;
+  remap->dx = 0;
+  remap->dy = 0;
+  return 1;
+}
+
+uint8_t DRM_MoveTo(DragRemap *remap, int8_t dxTiles, int8_t dyTiles,
+                   DRM_NametableSink sink, void *user) {
+  DrmCellRect was;
+  DrmCellRect now;
+  DrmCellRect rows;
+
+  if (!remap || !remap->active || !sink)
+    return 0;
+  if (dxTiles == remap->dx && dyTiles == remap->dy)
+    return 1;
+
+  /* Cells outside both window positions keep their entry across the move */
+  drm_shifted_rect(remap, remap->dx, remap->dy, &was);
+  drm_shifted_rect(remap, dxTiles, dyTiles, &now);
+  drm_union_clip(&was, &now, &rows);
+
+  remap->dx = dxTiles;
+  remap->dy = dyTiles;
+  return drm_write_rows(remap, &rows, sink, user);
+}
+
+uint8_t DRM_End(DragRemap *remap, DRM_NametableSink sink, void *user) {
+  DrmCellRect origin;
+  DrmCellRect shown;
+  DrmCellRect rows;
+
+  if (!remap || !sink)
+    return 0;
+  if (!remap->active)
+    return 1;
+
+  drm_origin_rect(remap, &origin);
+  drm_shifted_rect(remap, remap->dx, remap->dy, &shown);
+  drm_union_clip(&origin, &shown, &rows);
+
+  remap->active = 0;
+  return drm_write_rows(remap, &rows, sink, user);
+}
+
+uint16_t DRM_EntryForCell(const DragRemap *remap, uint16_t cx, uint16_t cy) {
+  DrmCellRect origin;
+  DrmCellRect shown;
+
+  if (remap && remap->active) {
+    drm_origin_rect(remap, &origin);
+    drm_shifted_rect(remap, remap->dx, remap->dy, &shown);
+
+    if (drm_in_rect(&shown, (int16_t)cx, (int16_t)cy))
+      return TILE_ENTRY(0, 0, 0, 0,
+                        ((uint16_t)(cy - remap->dy) * FB_TILES_X) +
+                            (uint16_t)(cx - remap->dx));
+    if (drm_in_rect(&origin, (int16_t)cx, (int16_t)cy))
+      return TILE_ENTRY(0, 0, 0, 0,
+                        drm_spare_tile(remap, (int16_t)cx, (int16_t)cy));
+  }
+
+  return TILE_ENTRY(0, 0, 0, 0, (cy * FB_TILES_X) + cx);
+}
+
+uint16_t DRM_RouteTile(const DragRemap *remap, uint16_t tile) {
+  DrmCellRect origin;
+  int16_t cx = (int16_t)(tile % FB_TILES_X);
+  int16_t cy = (int16_t)(tile / FB_TILES_X);
+
+  if (!remap || !remap->active)
+    return tile;
+
+  /* Origin home tiles are the remap source; keep them intact until drop */
+  drm_origin_rect(remap, &origin);
+  if (drm_in_rect(&origin, cx, cy))
+    return drm_spare_tile(remap, cx, cy);
+  return tile;
+}
+
+uint8_t DRM_ApplyMoveResult(DragRemap *remap, uint16_t kindId,
+                            uint16_t originXY, uint16_t originEnd,
+                            uint16_t delta, DRM_NametableSink sink,
+                            void *user) {
+  DirtyTileRange origin;
+  uint8_t kind;
+
+  if (!remap || !sink)
+    return 0;
+  if (kindId == 0xFFFFU)
+    return 1;
+
+  kind = (uint8_t)(kindId >> 8);
+  if (kind != DRM_KIND_DRAG)
+    return DRM_End(remap, sink, user);
+
+  origin.x0 = (uint16_t)(originXY >> 8);
+  origin.y0 = (uint16_t)(originXY & 0xFFU);
+  origin.x1 = (uint16_t)(originEnd >> 8);
+  origin.y1 = (uint16_t)(originEnd & 0xFFU);
+
+  if (remap->active &&
+      (remap->originX0 != origin.x0 || remap->originY0 != origin.y0 ||
+       remap->originX1 != origin.x1 || remap->originY1 != origin.y1)) {
+    if (!DRM_End(remap, sink, user))
+      return 0;
+  }
+  if (!remap->active && !DRM_Begin(remap, &origin))
+    return 0;
+
+  return DRM_MoveTo(remap, (int8_t)(delta >> 8), (int8_t)(delta & 0xFFU),
+                    sink, user);
+}
+
+uint8_t DRM_RoutedUpload(const uint8_t *tileData, uint16_t firstTile,
+                         uint16_t tileCount, uint16_t vramAddr,
+                         uint16_t wordCount, void *user) {
+  DragRemapUpload *routed = (DragRemapUpload *)user;
+  uint16_t done = 0;
+
+  (void)vramAddr;
+  (void)wordCount;
+
+  if (!routed || !routed->upload || !tileData)
+    return 0;
+
+  while (done < tileCount) {
+    uint16_t target = DRM_RouteTile(routed->remap,
+                                    (uint16_t)(firstTile + done));
+    uint16_t run = 1;
+
+    while ((uint16_t)(done + run) < tileCount &&
+           DRM_RouteTile(routed->remap, (uint16_t)(firstTile + done + run)) ==
+               (uint16_t)(target + run))
+      run++;
+
+    if (!routed->upload(tileData + ((uint32_t)done * FB_BYTES_PER_TILE),
+                        (uint16_t)(firstTile + done), run,
+                        (uint16_t)(target * FB_BYTES_PER_TILE),
+                        (uint16_t)(run * (FB_BYTES_PER_TILE / 2)),
+                        routed->user))
+      return 0;
+    done = (uint16_t)(done + run);
+  }
+
+  return 1;
+}
+
+#ifndef FB_HOST_TEST
+uint8_t DRM_VdpNametableSink(uint16_t vramAddr, const uint16_t *entries,
+                             uint8_t count, void *user) {
+  uint8_t i;
+
+  (void)user;
+
+  VDP_WaitDMA();
+  VDP_SET_REG(VDP_REG_AUTOINC, 2);
+  VDP_VRAM_WRITE(vramAddr);
+  for (i = 0; i < count; i++)
+    VDP_DATA_PORT = entries[i];
+  return 1;
+}
+#endif /* FB_HOST_TEST */
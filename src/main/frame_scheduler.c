@@ -35,6 +35,13 @@ static void fs_clear_queue(DirtyTileQueue *queue) {
   }
 }
 
+static void fs_clear_fills(DirtyFillList *fills) {
+  fills->count = 0;
+  fills->tileCount = 0;
+  fills->overflow = 0;
+  fills->_pad = 0;
+}
+
 void FS_ClearTileCursor(FrameTileCursor *cursor) {
   if (!cursor)
     return;
@@ -156,3 +163,82 @@ uint8_t FS_PlanTileCursorFrame(FrameTileCursor *cursor, DirtyTileQueue *queue,
 
   return 1;
 }
+
+uint16_t FS_FillRunCost(uint16_t tileCount, uint16_t bytesPerTile) {
+  uint32_t cost;
+
+  if (tileCount == 0)
+    return 0;
+
+  cost = FS_FILL_SETUP_BYTES +
+         (((uint32_t)tileCount * bytesPerTile) >> FS_FILL_COST_SHIFT);
+  return (cost > 0xffffU) ? 0xffffU : (uint16_t)cost;
+}
+
+void FS_ClearFillCursor(FrameFillCursor *cursor) {
+  if (!cursor)
+    return;
+
+  cursor->nextFill = 0;
+  cursor->_pad = 0;
+  cursor->doneTiles = 0;
+}
+
+uint8_t FS_PlanFillFrame(FrameFillCursor *cursor, const DirtyFillList *fills,
+                         DirtyFillList *slice, uint16_t budgetBytes,
+                         uint16_t bytesPerTile, uint16_t *chargedBytes) {
+  uint16_t charged = 0;
+
+  if (chargedBytes)
+    *chargedBytes = 0;
+  if (slice)
+    fs_clear_fills(slice);
+
+  if (!cursor || !fills || !slice || bytesPerTile == 0)
+    return 0;
+
+  while (cursor->nextFill < fills->count) {
+    const DirtyTileFill *run = &fills->items[cursor->nextFill];
+    uint16_t left = (uint16_t)(run->tileCount - cursor->doneTiles);
+    uint16_t take = left;
+    DirtyTileFill *out;
+
+    if (slice->count >= slice->capacity || !slice->items)
+      break;
+
+    while (take > 0 &&
+           (uint32_t)charged + FS_FillRunCost(take, bytesPerTile) >
+               budgetBytes) {
+      uint16_t spare = (uint16_t)(budgetBytes - charged);
+
+      if (spare <= FS_FILL_SETUP_BYTES) {
+        take = 0;
+        break;
+      }
+      take = (uint16_t)((((uint32_t)(spare - FS_FILL_SETUP_BYTES))
+                         << FS_FILL_COST_SHIFT) /
+                        bytesPerTile);
+    }
+    if (take == 0)
+      break;
+
+    out = &slice->items[slice->count++];
+    out->firstTile = (uint16_t)(run->firstTile + cursor->doneTiles);
+    out->tileCount = take;
+    out->colorIndex = run->colorIndex;
+    out->_pad = 0;
+    slice->tileCount = (uint16_t)(slice->tileCount + take);
+    charged = (uint16_t)(charged + FS_FillRunCost(take, bytesPerTile));
+
+    if (take < left) {
+      cursor->doneTiles = (uint16_t)(cursor->doneTiles + take);
+      break;
+    }
+    cursor->nextFill++;
+    cursor->doneTiles = 0;
+  }
+
+  if (chargedBytes)
+    *chargedBytes = charged;
+  return (cursor->nextFill >= fills->count) ? 1 : 0;
+}
@@ -23,12 +23,18 @@ void FUP_Init(FrameUploadPump *pump, uint16_t budgetBytes,
   pump->bytesPerTile = bytesPerTile;
   pump->state = FUP_STATE_IDLE;
   pump->lastError = FUP_ERROR_NONE;
+  pump->mode = FUP_MODE_SINGLE;
+  pump->spanCount = 0;
+  pump->spanIndex = 0;
+  pump->_pad = 0;
+  pump->frameSeq = 0;
   fup_bind_queue(pump);
 }
 
 uint8_t FUP_StartFrame(FrameUploadPump *pump, uint16_t firstTile,
                        uint16_t tileCount) {
-  if (!pump || pump->state != FUP_STATE_IDLE || tileCount == 0 ||
+  if (!pump || pump->mode != FUP_MODE_SINGLE ||
+      pump->state != FUP_STATE_IDLE || tileCount == 0 ||
       pump->bytesPerTile == 0) {
     return 0;
   }
@@ -40,6 +46,271 @@ uint8_t FUP_StartFrame(FrameUploadPump *pump, uint16_t firstTile,
   return 1;
 }
 
+static uint8_t fup_seq_newer(uint16_t candidate, uint16_t current) {
+  return ((int16_t)(candidate - current) > 0) ? 1 : 0;
+}
+
+static void fup_bind_span_queue(FrameUploadPump *pump) {
+  uint8_t i;
+
+  pump->queue.items = pump->spanUploads;
+  pump->queue.capacity = FUP_MAX_SPANS;
+  pump->queue.count = 0;
+  pump->queue.maxBytes = pump->budgetBytes;
+  pump->queue.byteCount = 0;
+  pump->queue.budgetExceeded = 0;
+  pump->queue.overflow = 0;
+
+  for (i = 0; i < FUP_MAX_SPANS; i++) {
+    pump->spanUploads[i].firstTile = 0;
+    pump->spanUploads[i].tileCount = 0;
+    pump->spanUploads[i].byteCount = 0;
+  }
+}
+
+/* Append a span, widening the last slot to cover it when the list is full.
+ * Widening can only re-send tiles, never drop them. */
+static void fup_push_span(FrameUploadSpan *spans, uint8_t *count,
+                          uint16_t firstTile, uint16_t tileCount,
+                          uint16_t frameSeq) {
+  FrameUploadSpan *last;
+  uint16_t lastEnd;
+  uint16_t end;
+
+  if (tileCount == 0)
+    return;
+
+  if (*count < FUP_MAX_SPANS) {
+    spans[*count].firstTile = firstTile;
+    spans[*count].tileCount = tileCount;
+    spans[*count].frameSeq = frameSeq;
+    (*count)++;
+    return;
+  }
+
+  last = &spans[FUP_MAX_SPANS - 1U];
+  lastEnd = (uint16_t)(last->firstTile + last->tileCount);
+  end = (uint16_t)(firstTile + tileCount);
+  if (firstTile < last->firstTile)
+    last->firstTile = firstTile;
+  if (end > lastEnd)
+    lastEnd = end;
+  last->tileCount = (uint16_t)(lastEnd - last->firstTile);
+  last->frameSeq = frameSeq;
+}
+
+/* Push the parts of [firstTile, firstTile + tileCount) that no damage item
+ * covers. Damage spans may arrive unsorted and overlapping. */
+static void fup_push_uncovered(FrameUploadSpan *spans, uint8_t *count,
+                               uint16_t firstTile, uint16_t tileCount,
+                               uint16_t frameSeq,
+                               const DirtyTileQueue *damage) {
+  uint16_t pos = firstTile;
+  uint16_t end = (uint16_t)(firstTile + tileCount);
+
+  while (pos < end) {
+    uint16_t nextCut = end;
+    uint8_t covered = 0;
+    uint8_t i;
+
+    for (i = 0; i < damage->count; i++) {
+      uint16_t cutStart = damage->items[i].firstTile;
+      uint16_t cutEnd =
+          (uint16_t)(cutStart + damage->items[i].tileCount);
+
+      if (cutStart <= pos && pos < cutEnd) {
+        pos = cutEnd;
+        covered = 1;
+        break;
+      }
+      if (cutStart > pos && cutStart < nextCut)
+        nextCut = cutStart;
+    }
+
+    if (covered)
+      continue;
+
+    fup_push_span(spans, count, pos, (uint16_t)(nextCut - pos), frameSeq);
+    pos = nextCut;
+  }
+}
+
+static uint8_t fup_span_state(const FrameUploadPump *pump) {
+  if (pump->spanIndex >= pump->spanCount)
+    return FUP_STATE_READY_TO_RETURN;
+  return (pump->spans[pump->spanIndex].frameSeq == pump->frameSeq)
+             ? FUP_STATE_UPLOADING
+             : FUP_STATE_CARRYOVER;
+}
+
+static uint8_t fup_is_in_flight(const FrameUploadPump *pump) {
+  return (pump->state == FUP_STATE_UPLOADING ||
+          pump->state == FUP_STATE_SUPERSEDED ||
+          pump->state == FUP_STATE_CARRYOVER)
+             ? 1
+             : 0;
+}
+
+void FUP_InitLatestWins(FrameUploadPump *pump, uint16_t budgetBytes,
+                        uint16_t bytesPerTile) {
+  if (!pump)
+    return;
+
+  FUP_Init(pump, budgetBytes, bytesPerTile);
+  pump->mode = FUP_MODE_LATEST_WINS;
+  fup_bind_span_queue(pump);
+}
+
+uint8_t FUP_OfferFrame(FrameUploadPump *pump, uint16_t frameSeq,
+                       const DirtyTileQueue *damage) {
+  FrameUploadSpan next[FUP_MAX_SPANS];
+  uint8_t nextCount = 0;
+  uint8_t inFlight;
+  uint8_t i;
+
+  if (!pump || pump->mode != FUP_MODE_LATEST_WINS || !damage ||
+      pump->bytesPerTile == 0)
+    return 0;
+  if (damage->count != 0 && !damage->items)
+    return 0;
+
+  inFlight = fup_is_in_flight(pump);
+  if (!inFlight && pump->state != FUP_STATE_IDLE)
+    return 0;
+  if (inFlight && !fup_seq_newer(frameSeq, pump->frameSeq))
+    return 0;
+
+  if (inFlight) {
+    i = pump->spanIndex;
+    if (pump->cursor.active && i < pump->spanCount) {
+      uint16_t end =
+          (uint16_t)(pump->cursor.firstTile + pump->cursor.tileCount);
+      fup_push_uncovered(next, &nextCount, pump->cursor.nextTile,
+                         (uint16_t)(end - pump->cursor.nextTile),
+                         pump->spans[i].frameSeq, damage);
+      i++;
+    }
+    for (; i < pump->spanCount; i++) {
+      fup_push_uncovered(next, &nextCount, pump->spans[i].firstTile,
+                         pump->spans[i].tileCount, pump->spans[i].frameSeq,
+                         damage);
+    }
+  }
+
+  for (i = 0; i < damage->count; i++) {
+    fup_push_span(next, &nextCount, damage->items[i].firstTile,
+                  damage->items[i].tileCount, frameSeq);
+  }
+
+  for (i = 0; i < nextCount; i++) {
+    pump->spans[i] = next[i];
+  }
+  pump->spanCount = nextCount;
+  pump->spanIndex = 0;
+  pump->frameSeq = frameSeq;
+  pump->lastError = FUP_ERROR_NONE;
+  FS_ClearTileCursor(&pump->cursor);
+  fup_bind_span_queue(pump);
+
+  if (nextCount == 0) {
+    pump->state = FUP_STATE_READY_TO_RETURN;
+  } else {
+    pump->state = inFlight ? FUP_STATE_SUPERSEDED : FUP_STATE_UPLOADING;
+  }
+  return 1;
+}
+
+static uint8_t fup_tick_spans(FrameUploadPump *pump,
+                              FrameUploadPumpCallback upload, void *user,
+                              FrameScheduleResult *result) {
+  FrameTileCursor previousCursor;
+  uint8_t previousIndex;
+  uint8_t budgetLimited = 0;
+
+  previousCursor = pump->cursor;
+  previousIndex = pump->spanIndex;
+  fup_bind_span_queue(pump);
+
+  while (pump->spanIndex < pump->spanCount &&
+         pump->queue.count < pump->queue.capacity) {
+    DirtyTileQueue slice;
+    FrameScheduleResult sliceResult;
+    DirtyTileUpload *item = &pump->spanUploads[pump->queue.count];
+
+    if (pump->budgetBytes != 0 &&
+        (uint16_t)(pump->budgetBytes - pump->queue.byteCount) <
+            pump->bytesPerTile) {
+      budgetLimited = 1;
+      break;
+    }
+
+    if (!pump->cursor.active) {
+      const FrameUploadSpan *span = &pump->spans[pump->spanIndex];
+      FS_StartTileCursor(&pump->cursor, span->firstTile, span->tileCount);
+      if (!pump->cursor.active) {
+        pump->spanIndex++;
+        continue;
+      }
+    }
+
+    slice.items = item;
+    slice.capacity = 1;
+    slice.maxBytes = (pump->budgetBytes != 0)
+                         ? (uint16_t)(pump->budgetBytes -
+                                      pump->queue.byteCount)
+                         : 0;
+    if (!FS_PlanTileCursorFrame(&pump->cursor, &slice, pump->bytesPerTile,
+                                &sliceResult)) {
+      pump->cursor = previousCursor;
+      pump->spanIndex = previousIndex;
+      pump->state = FUP_STATE_ERROR;
+      pump->lastError = FUP_ERROR_PLAN_FAILED;
+      return 0;
+    }
+
+    if (slice.count != 0) {
+      pump->queue.count++;
+      pump->queue.byteCount =
+          (uint16_t)(pump->queue.byteCount + item->byteCount);
+    }
+
+    if (pump->cursor.active) {
+      budgetLimited = 1;
+      break;
+    }
+    pump->spanIndex++;
+  }
+
+  pump->queue.budgetExceeded =
+      (budgetLimited && pump->spanIndex < pump->spanCount) ? 1 : 0;
+
+  if (pump->queue.count != 0 && !upload(&pump->queue, user)) {
+    pump->cursor = previousCursor;
+    pump->spanIndex = previousIndex;
+    pump->state = FUP_STATE_ERROR;
+    pump->lastError = FUP_ERROR_UPLOAD_FAILED;
+    return 0;
+  }
+
+  pump->state = fup_span_state(pump);
+
+  if (result) {
+    result->queued = (pump->queue.count != 0) ? 1 : 0;
+    result->complete =
+        (pump->state == FUP_STATE_READY_TO_RETURN) ? 1 : 0;
+    result->budgetLimited = pump->queue.budgetExceeded;
+    result->overflow =
+        (!budgetLimited && pump->spanIndex < pump->spanCount) ? 1 : 0;
+    result->queuedTiles = (uint16_t)(pump->queue.byteCount /
+                                     pump->bytesPerTile);
+    result->queuedBytes = pump->queue.byteCount;
+    result->remainingTiles = FUP_PendingTiles(pump);
+    result->nextTile = pump->cursor.nextTile;
+  }
+
+  return 1;
+}
+
 uint8_t FUP_Tick(FrameUploadPump *pump, FrameUploadPumpCallback upload,
                  void *user, FrameScheduleResult *result) {
   FrameTileCursor previousCursor;
@@ -48,6 +319,14 @@ uint8_t FUP_Tick(FrameUploadPump *pump, FrameUploadPumpCallback upload,
 
   if (!pump || !upload)
     return 0;
+  if (pump->mode == FUP_MODE_LATEST_WINS) {
+    if (pump->state == FUP_STATE_IDLE ||
+        pump->state == FUP_STATE_READY_TO_RETURN)
+      return 1;
+    if (!fup_is_in_flight(pump))
+      return 0;
+    return fup_tick_spans(pump, upload, user, result);
+  }
   if (pump->state == FUP_STATE_IDLE ||
       pump->state == FUP_STATE_READY_TO_RETURN)
     return 1;
@@ -87,14 +366,20 @@ uint8_t FUP_MarkWordRamReturned(FrameUploadPump *pump) {
     return 0;
 
   FS_ClearTileCursor(&pump->cursor);
-  fup_bind_queue(pump);
+  if (pump->mode == FUP_MODE_LATEST_WINS) {
+    pump->spanCount = 0;
+    pump->spanIndex = 0;
+    fup_bind_span_queue(pump);
+  } else {
+    fup_bind_queue(pump);
+  }
   pump->state = FUP_STATE_IDLE;
   pump->lastError = FUP_ERROR_NONE;
   return 1;
 }
 
 uint8_t FUP_IsUploading(const FrameUploadPump *pump) {
-  return (pump && pump->state == FUP_STATE_UPLOADING) ? 1 : 0;
+  return (pump && fup_is_in_flight(pump)) ? 1 : 0;
 }
 
 uint8_t FUP_HasError(const FrameUploadPump *pump) {
@@ -104,3 +389,32 @@ uint8_t FUP_HasError(const FrameUploadPump *pump) {
 uint16_t FUP_NextTile(const FrameUploadPump *pump) {
   return pump ? pump->cursor.nextTile : 0;
 }
+
+uint16_t FUP_PendingTiles(const FrameUploadPump *pump) {
+  uint16_t pending = 0;
+  uint8_t i;
+
+  if (!pump)
+    return 0;
+  if (pump->mode != FUP_MODE_LATEST_WINS) {
+    if (!pump->cursor.active)
+      return 0;
+    return (uint16_t)(pump->cursor.firstTile + pump->cursor.tileCount -
+                      pump->cursor.nextTile);
+  }
+
+  i = pump->spanIndex;
+  if (pump->cursor.active && i < pump->spanCount) {
+    pending = (uint16_t)(pump->cursor.firstTile + pump->cursor.tileCount -
+                         pump->cursor.nextTile);
+    i++;
+  }
+  for (; i < pump->spanCount; i++) {
+    pending = (uint16_t)(pending + pump->spans[i].tileCount);
+  }
+  return pending;
+}
+
+uint16_t FUP_FrameSeq(const FrameUploadPump *pump) {
+  return pump ? pump->frameSeq : 0;
+}
@@ -155,6 +155,48 @@ uint8_t FB_FlushTileQueueWithCallback(const uint8_t *linear_fb,
   return 1;
 }
 
+uint8_t FB_FlushFillListWithCallback(const DirtyFillList *fills,
+                                     FB_TileFillCallback fill, void *user) {
+  const uint16_t maxChunkTiles = (uint16_t)(0xffffU / FB_BYTES_PER_TILE);
+  uint8_t i;
+
+  if (!fills || !fill)
+    return 0;
+  if (fills->count == 0)
+    return 1;
+  if (!fills->items || fills->count > fills->capacity)
+    return 0;
+
+  for (i = 0; i < fills->count; i++) {
+    const DirtyTileFill *run = &fills->items[i];
+    uint16_t firstTile = run->firstTile;
+    uint16_t remaining = run->tileCount;
+    uint8_t fillByte = (uint8_t)((run->colorIndex & 0x0fU) * 0x11U);
+
+    if (remaining == 0 || run->colorIndex > 0x0fU)
+      return 0;
+    if ((uint32_t)firstTile + remaining > FB_TILE_COUNT)
+      return 0;
+
+    while (remaining > 0) {
+      uint16_t chunkTiles = remaining;
+
+      if (chunkTiles > maxChunkTiles)
+        chunkTiles = maxChunkTiles;
+
+      if (!fill(firstTile, chunkTiles,
+                (uint16_t)(firstTile * FB_BYTES_PER_TILE),
+                (uint16_t)(chunkTiles * FB_BYTES_PER_TILE), fillByte, user))
+        return 0;
+
+      firstTile = (uint16_t)(firstTile + chunkTiles);
+      remaining = (uint16_t)(remaining - chunkTiles);
+    }
+  }
+
+  return 1;
+}
+
 /* ============================================================
  * FB_Init - Set up VDP tilemap and palette
  *
@@ -292,9 +334,9 @@ void FB_UpdateFrame(const uint8_t *wram_bank) {
   }
 }
 
-static uint8_t fb_dma_tile_upload(const uint8_t *tileData, uint16_t firstTile,
-                                  uint16_t tileCount, uint16_t vramAddr,
-                                  uint16_t wordCount, void *user) {
+uint8_t FB_DmaTileUpload(const uint8_t *tileData, uint16_t firstTile,
+                         uint16_t tileCount, uint16_t vramAddr,
+                         uint16_t wordCount, void *user) {
   (void)firstTile;
   (void)tileCount;
   (void)user;
@@ -307,10 +349,39 @@ static uint8_t fb_dma_tile_upload(const uint8_t *tileData, uint16_t firstTile,
 uint8_t FB_UpdateTileQueue(const uint8_t *wram_bank,
                            const DirtyTileQueue *queue) {
   return FB_FlushTileQueueWithCallback(wram_bank, queue, strip_buf,
-                                       STRIP_BUF_SIZE, fb_dma_tile_upload,
+                                       STRIP_BUF_SIZE, FB_DmaTileUpload,
                                        (void *)0);
 }
 
+uint8_t FB_UpdateTileQueueWithUpload(const uint8_t *wram_bank,
+                                     const DirtyTileQueue *queue,
+                                     FB_TileUploadCallback upload,
+                                     void *user) {
+  return FB_FlushTileQueueWithCallback(wram_bank, queue, strip_buf,
+                                       STRIP_BUF_SIZE, upload, user);
+}
+
+static uint8_t fb_dma_tile_fill(uint16_t firstTile, uint16_t tileCount,
+                                uint16_t vramAddr, uint16_t byteCount,
+                                uint8_t fillByte, void *user) {
+  (void)firstTile;
+  (void)tileCount;
+  (void)user;
+
+  VDP_WaitDMA();
+  VDP_DMAFillVRAM(vramAddr, byteCount, fillByte);
+  return 1;
+}
+
+uint8_t FB_UpdateFillList(const DirtyFillList *fills) {
+  uint8_t ok = FB_FlushFillListWithCallback(fills, fb_dma_tile_fill, (void *)0);
+
+  /* Leave the VDP idle with the normal word auto-increment restored. */
+  VDP_WaitDMA();
+  VDP_SET_REG(VDP_REG_AUTOINC, 2);
+  return ok;
+}
+
 #ifdef DESKTOP_TIMING_PROBE
 void FB_UpdateFrameProfile(const uint8_t *wram_bank) {
   uint16_t vram_addr;
@@ -16,6 +16,9 @@
 #include "boot_live_probe.h"
 #endif
 #include "boot_probe.h"
+#ifdef FAST_DRAG_REMAP
+#include "drag_remap.h"
+#endif
 #include "frame_upload_pump.h"
 #include "frame_scheduler.h"
 #include "framebuffer.h"
@@ -26,6 +29,14 @@
 #define MAIN_FRAME_UPLOAD_BUDGET_NTSC 7524U
 #define BOOT_SAFE_LIVE_PROBE_FRAMES 4U
 
+#ifdef FAST_DRAG_REMAP
+/* Plane A remap for the window Sub reports as fast-dragged. Uploads go
+ * through main_drag_upload so the origin's home tiles stay intact. */
+static DragRemap main_drag_remap;
+static DragRemapUpload main_drag_upload = {&main_drag_remap, FB_DmaTileUpload,
+                                           (void *)0};
+#endif
+
 /*
  * NOTE: The BIOS has already:
  *   - Loaded the SP (Sub CPU program) to PRG-RAM $006000
@@ -327,9 +338,16 @@ static uint8_t main_upload_frame_budgeted(const uint8_t *wram_bank) {
     if (!FUP_PlanNextQueueCompact(&pump) || pump.queue.count != 1) {
       return 0;
     }
+#ifdef FAST_DRAG_REMAP
+    if (!FB_UpdateTileQueueWithUpload(wram_bank, &pump.queue,
+                                      DRM_RoutedUpload, &main_drag_upload)) {
+      return 0;
+    }
+#else
     if (!FB_UpdateTileQueue(wram_bank, &pump.queue)) {
       return 0;
     }
+#endif
     VDP_WaitDMA();
   }
 
@@ -415,6 +433,9 @@ static void boot_sequence(void) {
   boot_safe_probe_init_display();
 #elif !defined(DESKTOP_SCHEDULER_PROBE) && !defined(DESKTOP_PUMP_PROBE)
   FB_Init();
+#ifdef FAST_DRAG_REMAP
+  DRM_Init(&main_drag_remap);
+#endif
 #endif
 #if !defined(DESKTOP_DIRTY_QUEUE_PROBE) && !defined(DESKTOP_SCHEDULER_PROBE) && \
     !defined(DESKTOP_PUMP_PROBE) && !defined(BOOT_SAFE_LIVE_PROBE)
@@ -1475,6 +1496,18 @@ static void main_loop(void) {
     main_send_cmd(CMD_RENDER_FRAME, 0, 0, 320, 224);
     main_wait_done();
 
+#ifdef FAST_DRAG_REMAP
+    /* Sub stops redrawing a fast-dragged window; move it on Plane A
+     * instead. This runs before the upload so a drag's first frame already
+     * routes the origin's dirty tiles away from the window's pixels. */
+    DRM_ApplyMoveResult(&main_drag_remap,
+                        main_read_result(RESULT_MOVE_KIND_ID),
+                        main_read_result(RESULT_MOVE_ORIGIN_XY),
+                        main_read_result(RESULT_MOVE_ORIGIN_END),
+                        main_read_result(RESULT_MOVE_DELTA),
+                        DRM_VdpNametableSink, (void *)0);
+#endif
+
     /* Convert the returned framebuffer from linear 4bpp to VDP tile format. */
     if (main_upload_frame_budgeted(WRAM_BANK0_MAIN)) {
       /* Return Word RAM only after the uploaded frame's final slice. */
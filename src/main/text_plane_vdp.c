@@ -0,0 +1,73 @@
+/*
+ * text_plane_vdp.c - Main-side applier for the tile-mapped text console.
+ *
+ * Sub publishes changed console cells as (Plane B address, entry) pairs in a
+ * TextPlanePage after the framebuffer in Word RAM; each one becomes a single
+ * 2-byte VRAM write here. The glyph tiles are copied into VRAM once.
+ */
+
+#include "text_plane.h"
+
+#ifndef FB_HOST_TEST
+#include "vdp.h"
+
+static uint8_t tpv_glyphs_loaded;
+#endif
+
+uint16_t TPV_ApplyPage(const TextPlanePage *page, TPV_CellSink sink,
+                       void *user) {
+  uint16_t count;
+  uint16_t i;
+
+  if (!page || !sink || page->magic != TP_PAGE_MAGIC)
+    return 0;
+
+  count = page->count;
+  if (count > TP_MAX_COLS * TP_MAX_ROWS)
+    count = TP_MAX_COLS * TP_MAX_ROWS;
+
+  for (i = 0; i < count; i++) {
+    uint16_t addr = page->cells[i].vramAddr;
+
+    /* Only console plane cells; never let a stale page touch other tables. */
+    if (addr < TP_PLANE_ADDR ||
+        addr >= TP_PLANE_ADDR + (TP_PLANE_CELLS_X * TP_MAX_ROWS * 2U) ||
+        (addr & 1U))
+      continue;
+    if (!sink(addr, page->cells[i].entry, user))
+      return i;
+  }
+
+  return count;
+}
+
+#ifndef FB_HOST_TEST
+uint8_t TPV_VdpCellSink(uint16_t vramAddr, uint16_t entry, void *user) {
+  (void)user;
+
+  VDP_VRAM_WRITE(vramAddr);
+  VDP_DATA_PORT = entry;
+  return 1;
+}
+
+/* Copy the Sub-built glyph tiles below Plane A the first time they appear. */
+uint8_t TPV_UploadGlyphs(const TextPlanePage *page) {
+  const volatile uint16_t *src;
+  uint16_t i;
+
+  if (tpv_glyphs_loaded)
+    return 1;
+  if (!page || page->glyphMagic != TP_GLYPH_MAGIC)
+    return 0;
+
+  src = (const volatile uint16_t *)page->glyphTiles;
+  VDP_WaitDMA();
+  VDP_SET_REG(VDP_REG_AUTOINC, 2);
+  VDP_VRAM_WRITE(TP_GLYPH_TILE * TP_GLYPH_BYTES);
+  for (i = 0; i < (TP_GLYPH_COUNT * TP_GLYPH_BYTES) / 2U; i++)
+    VDP_DATA_PORT = src[i];
+
+  tpv_glyphs_loaded = 1;
+  return 1;
+}
+#endif /* FB_HOST_TEST */
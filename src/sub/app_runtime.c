@@ -51,8 +51,13 @@ void APP_RT_Init(AppRuntime *runtime) {
   runtime->context.services = (const AppRuntimeServices *)0;
   runtime->context.catalog = (const AppCatalogEntry *)0;
   runtime->context.appState = (void *)0;
+  runtime->context.arena = (MemArena *)0;
   runtime->context.windowId = 0;
   runtime->definition = (const AppDefinition *)0;
+  runtime->arena.base = (uint8_t *)0;
+  runtime->arena.size = 0;
+  runtime->arena.used = 0;
+  runtime->arena.highWater = 0;
 }
 
 uint8_t APP_RT_IsRunning(const AppRuntime *runtime) {
@@ -127,6 +132,8 @@ AppRuntimeStatus APP_RT_Start(AppRuntime *runtime,
                               const AppRuntimeServices *services,
                               const AppCatalogEntry *catalog,
                               const AppDefinition *definition) {
+  uint32_t arenaBytes;
+
   if (!runtime || !catalog) {
     return APP_RT_BAD_ARGUMENT;
   }
@@ -152,14 +159,24 @@ AppRuntimeStatus APP_RT_Start(AppRuntime *runtime,
     return APP_RT_RESOURCE_LIMIT;
   }
 
+  /* Everything the app allocates comes from one arena, so stopping it
+   * returns one block to the heap whatever the app did */
+  arenaBytes = (uint32_t)services->limits.scratchBytes +
+               services->limits.maxDocumentBytes;
+  if (arenaBytes && MEM_ArenaCreate(&runtime->arena, arenaBytes) != 0) {
+    return APP_RT_RESOURCE_LIMIT;
+  }
+
   runtime->activeCatalog = *catalog;
   runtime->definition = definition;
   runtime->context.services = services;
   runtime->context.catalog = &runtime->activeCatalog;
   runtime->context.appState = definition->appState;
+  runtime->context.arena = arenaBytes ? &runtime->arena : (MemArena *)0;
   runtime->context.windowId = 0;
 
   if (!definition->init(&runtime->context)) {
+    MEM_ArenaDestroy(&runtime->arena);
     APP_RT_Init(runtime);
     return APP_RT_INIT_FAILED;
   }
@@ -219,6 +236,14 @@ AppRuntimeStatus APP_RT_Stop(AppRuntime *runtime) {
   if (!runtime->definition->exit(&runtime->context)) {
     return APP_RT_EXIT_FAILED;
   }
+  MEM_ArenaDestroy(&runtime->arena);
   APP_RT_Init(runtime);
   return APP_RT_OK;
 }
+
+void *APP_RT_Alloc(AppRuntimeContext *ctx, uint32_t bytes) {
+  if (!ctx || !ctx->arena) {
+    return (void *)0;
+  }
+  return MEM_ArenaAlloc(ctx->arena, bytes);
+}
@@ -71,6 +71,7 @@ static const BasicKeyword basicKeywords[] = {
 
 static BasicLine basScratchLines[BAS_MAX_PROGRAM_LINES];
 static uint8_t basScratchStorage[BAS_MAX_PROGRAM_STORAGE];
+static uint8_t basScratchCode[BAS_MAX_PROGRAM_CODE];
 
 static BasicToken bas_detect_token(const char **body) {
   uint8_t i;
@@ -91,31 +92,27 @@ static BasicToken bas_detect_token(const char **body) {
   return BAS_TOK_RAW;
 }
 
-static uint8_t bas_find_line(const BasicProgram *program, uint16_t number,
-                             uint8_t *indexOut) {
-  uint8_t i;
+/*
+ * Binary search of the sorted line table. On a miss *indexOut is where the
+ * number would be inserted.
+ */
+static uint8_t bas_find_line(const BasicLine *lines, uint8_t lineCount,
+                             uint16_t number, uint8_t *indexOut) {
+  uint8_t low = 0;
+  uint8_t high = lineCount;
 
-  if (indexOut)
-    *indexOut = 0;
-  if (!program)
-    return 0;
+  while (low < high) {
+    uint8_t mid = (uint8_t)((low + high) / 2U);
 
-  for (i = 0; i < program->lineCount; i++) {
-    if (program->lines[i].number == number) {
-      if (indexOut)
-        *indexOut = i;
-      return 1;
-    }
-    if (program->lines[i].number > number) {
-      if (indexOut)
-        *indexOut = i;
-      return 0;
-    }
+    if (lines[mid].number < number)
+      low = (uint8_t)(mid + 1U);
+    else
+      high = mid;
   }
 
   if (indexOut)
-    *indexOut = program->lineCount;
-  return 0;
+    *indexOut = low;
+  return (uint8_t)(low < lineCount && lines[low].number == number);
 }
 
 static uint8_t bas_command_equals(const char *input, const char *command) {
@@ -212,45 +209,121 @@ uint8_t BAS_RuntimeGetInteger(const BasicRuntime *runtime, char name,
   return 1;
 }
 
-static uint8_t bas_parse_integer_term_with_runtime(
-    const char **cursor, const BasicRuntime *runtime, int16_t *out,
-    uint8_t *undefinedVariable) {
-  const char *p;
+/*
+ * Compiled lines
+ *
+ * Every stored line is compiled into a short stack bytecode kept in the
+ * program's code buffer, beside the text. Expression ops push and combine
+ * int16 values and each line ends in one statement op, so RUN never
+ * re-parses text. Jump targets are resolved to line indices as the program
+ * is compiled; every edit recompiles, so they never go stale and a jump is
+ * a plain index load. A syntax error compiles to BAS_OP_FAIL after the ops
+ * for the text read before it, which keeps run-time errors in the order
+ * the text evaluator used to find them.
+ */
+typedef enum {
+  BAS_OP_INT = 1,   /* hi lo: push a constant            */
+  BAS_OP_VAR,       /* slot: push a variable             */
+  BAS_OP_NEG,       /* Negate the top value              */
+  BAS_OP_ADD,
+  BAS_OP_SUB,
+  BAS_OP_PRINT,     /* Pop and print                     */
+  BAS_OP_PRINT_STR, /* offset length: print payload text */
+  BAS_OP_LET,       /* slot: pop into a variable         */
+  BAS_OP_INPUT,     /* slot: read a variable             */
+  BAS_OP_IF,        /* relation index: jump when true    */
+  BAS_OP_GOTO,      /* index: target line                */
+  BAS_OP_GOSUB,     /* index                             */
+  BAS_OP_RETURN,
+  BAS_OP_FOR,       /* slot: pop start, limit and step   */
+  BAS_OP_NEXT,      /* slot, or BAS_ANY_VARIABLE         */
+  BAS_OP_END,
+  BAS_OP_FAIL /* status: stop with a BasicRunStatus */
+} BasicOp;
+
+typedef enum {
+  BAS_REL_NONZERO = 0,
+  BAS_REL_EQ,
+  BAS_REL_NE,
+  BAS_REL_LT,
+  BAS_REL_GT,
+  BAS_REL_LE,
+  BAS_REL_GE
+} BasicRelation;
+
+#define BAS_EXPR_STACK_DEPTH 4U /* FOR start and limit plus a term pair */
+#define BAS_NO_LINE 0xFFU      /* Jump target not in the program */
+#define BAS_ANY_VARIABLE 0xFFU /* Bare NEXT closes the innermost loop */
+#define BAS_EXPR_CODE_BYTES (BAS_MAX_PAYLOAD_TEXT * 2U + 8U)
+
+typedef struct {
+  uint8_t *code;
+  uint16_t used;
+  uint16_t capacity;
+  uint8_t overflow;
+  const BasicLine *lines; /* Jump targets resolve against these */
+  uint8_t lineCount;
+} BasicEmitter;
+
+static uint8_t basExprCode[BAS_EXPR_CODE_BYTES];
+
+static void bas_init_emitter(BasicEmitter *e, uint8_t *code,
+                             uint16_t capacity) {
+  e->code = code;
+  e->used = 0;
+  e->capacity = capacity;
+  e->overflow = 0;
+  e->lines = (const BasicLine *)0;
+  e->lineCount = 0;
+}
+
+static void bas_emit(BasicEmitter *e, uint8_t byte) {
+  if (e->used >= e->capacity) {
+    e->overflow = 1;
+    return;
+  }
+  e->code[e->used++] = byte;
+}
+
+static void bas_emit_u16(BasicEmitter *e, uint8_t op, uint16_t value) {
+  bas_emit(e, op);
+  bas_emit(e, (uint8_t)(value >> 8));
+  bas_emit(e, (uint8_t)(value & 0xffU));
+}
+
+static void bas_emit_fail(BasicEmitter *e, BasicRunStatus status) {
+  bas_emit(e, BAS_OP_FAIL);
+  bas_emit(e, (uint8_t)status);
+}
+
+static uint8_t bas_resolve_target(const BasicEmitter *e, uint16_t number) {
+  uint8_t index;
+
+  if (!bas_find_line(e->lines, e->lineCount, number, &index))
+    return BAS_NO_LINE;
+  return index;
+}
+
+static uint8_t bas_compile_term(const char **cursor, BasicEmitter *e) {
+  const char *p = bas_skip_spaces(*cursor);
   uint8_t negative = 0;
   uint8_t digitSeen = 0;
+  uint8_t index;
   uint32_t magnitude = 0;
   uint32_t limit;
 
-  if (!cursor || !*cursor || !out)
-    return 0;
-
-  p = bas_skip_spaces(*cursor);
   if (*p == '+' || *p == '-') {
     negative = (uint8_t)(*p == '-');
     p++;
   }
 
-  {
-    uint8_t index;
-
-    if (bas_variable_index(*p, &index)) {
-      int32_t value;
-
-      if (!runtime || !runtime->integerDefined[index]) {
-        if (undefinedVariable)
-          *undefinedVariable = 1;
-        return 0;
-      }
-
-      value = runtime->integerValues[index];
-      if (negative)
-        value = -value;
-      if (value < -32768L || value > 32767L)
-        return 0;
-      *out = (int16_t)value;
-      *cursor = p + 1;
-      return 1;
-    }
+  if (bas_variable_index(*p, &index)) {
+    bas_emit(e, BAS_OP_VAR);
+    bas_emit(e, index);
+    if (negative)
+      bas_emit(e, BAS_OP_NEG);
+    *cursor = p + 1;
+    return 1;
   }
 
   limit = negative ? 32768UL : 32767UL;
@@ -265,78 +338,80 @@ static uint8_t bas_parse_integer_term_with_runtime(
   if (!digitSeen)
     return 0;
 
-  *out = negative ? (int16_t)(-((int32_t)magnitude)) : (int16_t)magnitude;
+  bas_emit_u16(e, BAS_OP_INT,
+               (uint16_t)(negative ? 0UL - magnitude : magnitude));
   *cursor = p;
   return 1;
 }
 
-static uint8_t bas_eval_integer_expression_with_runtime(
-    const char *source, const BasicRuntime *runtime, BasicValue *out,
-    uint8_t *undefinedVariable) {
-  const char *p = source;
-  int16_t term;
-  int32_t total;
-
-  if (undefinedVariable)
-    *undefinedVariable = 0;
-
-  if (!bas_parse_integer_term_with_runtime(&p, runtime, &term,
-                                           undefinedVariable))
-    return 0;
-  total = term;
-
-  while (1) {
-    char op;
-
-    p = bas_skip_spaces(p);
-    if (*p == 0)
-      break;
-    if (*p != '+' && *p != '-')
-      return 0;
-    op = *p++;
-
-    if (!bas_parse_integer_term_with_runtime(&p, runtime, &term,
-                                             undefinedVariable))
-      return 0;
-    if (op == '+')
-      total += term;
-    else
-      total -= term;
-    if (total < -32768L || total > 32767L)
-      return 0;
-  }
-
-  out->kind = BAS_VALUE_INTEGER;
-  out->integer = (int16_t)total;
-  return 1;
-}
-
-static uint8_t bas_eval_string_literal(const char *source, BasicValue *out) {
+static uint8_t bas_compile_string_literal(const char *source,
+                                          const char *base, uint8_t *offset,
+                                          uint8_t *length) {
   const char *p = bas_skip_spaces(source);
+  const char *start;
   uint16_t len = 0;
 
   if (*p != '"')
     return 0;
-  p++;
+  start = ++p;
 
   while (*p && *p != '"') {
     if (len >= BAS_MAX_STRING_VALUE)
       return 0;
-    out->string[len++] = *p++;
+    len++;
+    p++;
   }
   if (*p != '"')
     return 0;
-  p++;
-  p = bas_skip_spaces(p);
-  if (*p != 0)
+  p = bas_skip_spaces(p + 1);
+  if (*p != 0 || start - base > 0xff)
     return 0;
 
-  out->string[len] = 0;
-  out->stringLength = len;
-  out->kind = BAS_VALUE_STRING;
+  *offset = (uint8_t)(start - base);
+  *length = (uint8_t)len;
   return 1;
 }
 
+/*
+ * Compile one expression. An integer expression emits its ops; a string
+ * literal emits nothing and reports where its text sits in 'base'. On a
+ * syntax error the ops read so far stay emitted and BAS_VALUE_NONE is
+ * returned.
+ */
+static BasicValueKind bas_compile_expression(const char *source,
+                                             const char *base,
+                                             BasicEmitter *e, uint8_t *offset,
+                                             uint8_t *length) {
+  const char *p = bas_skip_spaces(source);
+
+  if (*p == 0)
+    return BAS_VALUE_NONE;
+  if (*p == '"')
+    return bas_compile_string_literal(p, base, offset, length)
+               ? BAS_VALUE_STRING
+               : BAS_VALUE_NONE;
+
+  if (!bas_compile_term(&p, e))
+    return BAS_VALUE_NONE;
+
+  while (1) {
+    char op;
+
+    p = bas_skip_spaces(p);
+    if (*p == 0)
+      break;
+    if (*p != '+' && *p != '-')
+      return BAS_VALUE_NONE;
+    op = *p++;
+
+    if (!bas_compile_term(&p, e))
+      return BAS_VALUE_NONE;
+    bas_emit(e, op == '+' ? BAS_OP_ADD : BAS_OP_SUB);
+  }
+
+  return BAS_VALUE_INTEGER;
+}
+
 static uint8_t bas_write_int16(char *out, uint16_t outBytes, int16_t value) {
   uint16_t pos = 0;
   uint16_t divisor = 10000U;
@@ -377,24 +452,6 @@ static uint8_t bas_write_int16(char *out, uint16_t outBytes, int16_t value) {
   return 1;
 }
 
-static uint8_t bas_copy_payload_to_buffer(const uint8_t *bytes,
-                                          uint16_t lineLength, char *out,
-                                          uint16_t outBytes) {
-  uint16_t payloadLength;
-
-  if (!bytes || !out || outBytes == 0 || lineLength == 0)
-    return 0;
-
-  payloadLength = (uint16_t)(lineLength - 1U);
-  if (payloadLength + 1U > outBytes)
-    return 0;
-  for (uint16_t i = 0; i < payloadLength; i++) {
-    out[i] = (char)bytes[1U + i];
-  }
-  out[payloadLength] = 0;
-  return 1;
-}
-
 static uint8_t bas_parse_line_target(const char *source, uint16_t *target) {
   const char *p = bas_skip_spaces(source);
   uint32_t number = 0;
@@ -453,21 +510,6 @@ static char *bas_find_standalone_keyword(char *source, const char *keyword) {
   return (char *)0;
 }
 
-static uint8_t bas_eval_integer_condition_value(
-    const char *source, const BasicRuntime *runtime, int16_t *out,
-    uint8_t *undefinedVariable) {
-  BasicValue value;
-
-  if (!bas_evaluate_expression_internal(source, runtime, &value,
-                                        undefinedVariable))
-    return 0;
-  if (value.kind != BAS_VALUE_INTEGER)
-    return 0;
-
-  *out = value.integer;
-  return 1;
-}
-
 static char *bas_find_condition_operator(char *source, uint8_t *operatorLen) {
   char *p = source;
 
@@ -497,186 +539,403 @@ static char *bas_find_condition_operator(char *source, uint8_t *operatorLen) {
   return (char *)0;
 }
 
-static uint8_t bas_compare_condition_values(int16_t left, int16_t right,
-                                            const char *op,
-                                            uint8_t operatorLen,
-                                            uint8_t *truth) {
-  if (!op || !truth)
+static uint8_t bas_parse_if_target(const char *source, uint16_t *target) {
+  const char *p = bas_skip_spaces(source);
+
+  if (bas_starts_with_keyword(p, "GOTO"))
+    p = bas_skip_spaces(p + 4);
+  return bas_parse_line_target(p, target);
+}
+
+static uint8_t bas_line_payload_length(const BasicParsedLine *parsed) {
+  return (uint8_t)(1U + parsed->payloadLength);
+}
+
+static uint8_t bas_write_replacement_line(BasicLine *lines, uint8_t *storage,
+                                          uint8_t *outCount, uint16_t *used,
+                                          uint16_t storageCapacity,
+                                          const BasicParsedLine *replacement) {
+  uint16_t len = bas_line_payload_length(replacement);
+
+  if ((uint32_t)*used + len > storageCapacity)
     return 0;
 
-  if (operatorLen == 1 && op[0] == '=') {
-    *truth = (uint8_t)(left == right);
-    return 1;
-  }
-  if (operatorLen == 1 && op[0] == '<') {
-    *truth = (uint8_t)(left < right);
-    return 1;
-  }
-  if (operatorLen == 1 && op[0] == '>') {
-    *truth = (uint8_t)(left > right);
-    return 1;
-  }
-  if (operatorLen == 2 && op[0] == '<' && op[1] == '=') {
-    *truth = (uint8_t)(left <= right);
-    return 1;
-  }
-  if (operatorLen == 2 && op[0] == '>' && op[1] == '=') {
-    *truth = (uint8_t)(left >= right);
-    return 1;
-  }
-  if (operatorLen == 2 && op[0] == '<' && op[1] == '>') {
-    *truth = (uint8_t)(left != right);
-    return 1;
+  storage[*used] = (uint8_t)replacement->token;
+  for (uint16_t j = 0; j < replacement->payloadLength; j++) {
+    storage[*used + 1U + j] = (uint8_t)replacement->payload[j];
   }
+  lines[*outCount].number = replacement->number;
+  lines[*outCount].offset = *used;
+  lines[*outCount].length = len;
+  *used = (uint16_t)(*used + len);
+  *outCount = (uint8_t)(*outCount + 1U);
+  return 1;
+}
+
+static void bas_write_u16_be(uint8_t *out, uint16_t value) {
+  out[0] = (uint8_t)(value >> 8);
+  out[1] = (uint8_t)(value & 0xffU);
+}
 
+static uint16_t bas_read_u16_be(const uint8_t *in) {
+  return (uint16_t)(((uint16_t)in[0] << 8) | in[1]);
+}
+
+static uint8_t bas_parse_lone_variable(const char *source, uint8_t *indexOut) {
+  const char *p = bas_skip_spaces(source);
+
+  if (!p || !bas_variable_index(*p, indexOut))
+    return 0;
+
+  p++;
+  p = bas_skip_spaces(p);
+  return (uint8_t)(*p == 0);
+}
+
+static BasicRelation bas_condition_relation(const char *op,
+                                            uint8_t operatorLen) {
+  if (operatorLen == 2) {
+    if (op[1] == '=')
+      return op[0] == '<' ? BAS_REL_LE : BAS_REL_GE;
+    return BAS_REL_NE;
+  }
+  if (op[0] == '<')
+    return BAS_REL_LT;
+  if (op[0] == '>')
+    return BAS_REL_GT;
+  return BAS_REL_EQ;
+}
+
+static uint8_t bas_compile_integer_value(BasicEmitter *e, const char *source,
+                                         const char *base) {
+  uint8_t offset;
+  uint8_t length;
+
+  if (bas_compile_expression(source, base, e, &offset, &length) ==
+      BAS_VALUE_INTEGER)
+    return 1;
+  bas_emit_fail(e, BAS_RUN_BAD_EXPRESSION);
   return 0;
 }
 
-static uint8_t bas_eval_if_condition(char *source, const BasicRuntime *runtime,
-                                     uint8_t *truth,
-                                     BasicRunStatus *status) {
+static void bas_compile_if(BasicEmitter *e, char *text) {
+  char *thenKeyword = bas_find_standalone_keyword(text, "THEN");
+  char *condition;
   char *conditionEnd;
   char *op;
   uint8_t operatorLen = 0;
-  uint8_t undefinedVariable = 0;
-  char operatorText[2];
-  int16_t left;
-  int16_t right;
+  BasicRelation relation = BAS_REL_NONZERO;
+  uint16_t target;
 
-  if (status)
-    *status = BAS_RUN_BAD_EXPRESSION;
-  if (!source || !truth)
-    return 0;
+  if (!thenKeyword) {
+    bas_emit_fail(e, BAS_RUN_BAD_EXPRESSION);
+    return;
+  }
 
-  source = (char *)bas_skip_spaces(source);
-  conditionEnd = (char *)bas_trim_end(source, source + bas_strlen_limited(
-                                                    source,
-                                                    BAS_MAX_PAYLOAD_TEXT));
+  *thenKeyword = 0;
+  condition = (char *)bas_skip_spaces(text);
+  conditionEnd = (char *)bas_trim_end(
+      condition,
+      condition + bas_strlen_limited(condition, BAS_MAX_PAYLOAD_TEXT));
   *conditionEnd = 0;
-  if (*source == 0)
-    return 0;
-
-  op = bas_find_condition_operator(source, &operatorLen);
-  if (!op) {
-    if (!bas_eval_integer_condition_value(source, runtime, &left,
-                                          &undefinedVariable)) {
-      if (status && undefinedVariable)
-        *status = BAS_RUN_UNDEFINED_VARIABLE;
-      return 0;
-    }
-    *truth = (uint8_t)(left != 0);
-    return 1;
+  if (*condition == 0) {
+    bas_emit_fail(e, BAS_RUN_BAD_EXPRESSION);
+    return;
   }
 
-  operatorText[0] = op[0];
-  operatorText[1] = (operatorLen == 2) ? op[1] : 0;
-  *op = 0;
-  if (!bas_eval_integer_condition_value(source, runtime, &left,
-                                        &undefinedVariable)) {
-    if (status && undefinedVariable)
-      *status = BAS_RUN_UNDEFINED_VARIABLE;
-    return 0;
-  }
-  if (!bas_eval_integer_condition_value(op + operatorLen, runtime, &right,
-                                        &undefinedVariable)) {
-    if (status && undefinedVariable)
-      *status = BAS_RUN_UNDEFINED_VARIABLE;
-    return 0;
+  op = bas_find_condition_operator(condition, &operatorLen);
+  if (op) {
+    relation = bas_condition_relation(op, operatorLen);
+    *op = 0;
+    if (!bas_compile_integer_value(e, condition, text) ||
+        !bas_compile_integer_value(e, op + operatorLen, text))
+      return;
+  } else if (!bas_compile_integer_value(e, condition, text)) {
+    return;
   }
 
-  return bas_compare_condition_values(left, right, operatorText, operatorLen,
-                                      truth);
+  if (!bas_parse_if_target(thenKeyword + 4, &target)) {
+    bas_emit_fail(e, BAS_RUN_BAD_TARGET);
+    return;
+  }
+  bas_emit(e, BAS_OP_IF);
+  bas_emit(e, (uint8_t)relation);
+  bas_emit(e, bas_resolve_target(e, target));
 }
 
-static uint8_t bas_parse_if_target(const char *source, uint16_t *target) {
-  const char *p = bas_skip_spaces(source);
-
-  if (bas_starts_with_keyword(p, "GOTO"))
-    p = bas_skip_spaces(p + 4);
-  return bas_parse_line_target(p, target);
-}
+static void bas_compile_for(BasicEmitter *e, char *text) {
+  const char *p = bas_skip_spaces(text);
+  char *toKeyword;
+  char *stepKeyword;
+  uint8_t index;
 
-static uint8_t bas_execute_if(char *source, const BasicRuntime *runtime,
-                              uint8_t *truth, uint16_t *target,
-                              BasicRunStatus *status) {
-  char *thenKeyword;
-  char *targetText;
+  if (!bas_variable_index(*p, &index)) {
+    bas_emit_fail(e, BAS_RUN_BAD_ASSIGNMENT);
+    return;
+  }
+  p = bas_skip_spaces(p + 1);
+  if (*p != '=') {
+    bas_emit_fail(e, BAS_RUN_BAD_ASSIGNMENT);
+    return;
+  }
 
-  if (status)
-    *status = BAS_RUN_BAD_EXPRESSION;
-  if (!source || !truth || !target)
-    return 0;
+  toKeyword = bas_find_standalone_keyword((char *)p + 1, "TO");
+  if (!toKeyword) {
+    bas_emit_fail(e, BAS_RUN_BAD_EXPRESSION);
+    return;
+  }
+  *toKeyword = 0;
+  stepKeyword = bas_find_standalone_keyword(toKeyword + 2, "STEP");
+  if (stepKeyword)
+    *stepKeyword = 0;
 
-  thenKeyword = bas_find_standalone_keyword(source, "THEN");
-  if (!thenKeyword)
-    return 0;
+  if (!bas_compile_integer_value(e, p + 1, text) ||
+      !bas_compile_integer_value(e, toKeyword + 2, text))
+    return;
+  if (!stepKeyword)
+    bas_emit_u16(e, BAS_OP_INT, 1);
+  else if (!bas_compile_integer_value(e, stepKeyword + 4, text))
+    return;
+  bas_emit(e, BAS_OP_FOR);
+  bas_emit(e, index);
+}
 
-  *thenKeyword = 0;
-  targetText = thenKeyword + 4;
-  if (!bas_eval_if_condition(source, runtime, truth, status))
-    return 0;
+static void bas_compile_let(BasicEmitter *e, const char *text) {
+  const char *p = bas_skip_spaces(text);
+  uint8_t index;
+  uint8_t offset;
+  uint8_t length;
 
-  if (!bas_parse_if_target(targetText, target)) {
-    if (status)
-      *status = BAS_RUN_BAD_TARGET;
-    return 0;
+  if (!bas_variable_index(*p, &index)) {
+    bas_emit_fail(e, BAS_RUN_BAD_ASSIGNMENT);
+    return;
+  }
+  p = bas_skip_spaces(p + 1);
+  if (*p != '=') {
+    bas_emit_fail(e, BAS_RUN_BAD_ASSIGNMENT);
+    return;
   }
 
-  return 1;
+  if (bas_compile_expression(p + 1, text, e, &offset, &length) !=
+      BAS_VALUE_INTEGER) {
+    bas_emit_fail(e, BAS_RUN_BAD_ASSIGNMENT);
+    return;
+  }
+  bas_emit(e, BAS_OP_LET);
+  bas_emit(e, index);
 }
 
-static uint8_t bas_value_to_line(const BasicValue *value, char *out,
-                                 uint16_t outBytes) {
-  if (!value || !out || outBytes == 0)
-    return 0;
-
-  if (value->kind == BAS_VALUE_INTEGER)
-    return bas_write_int16(out, outBytes, value->integer);
+static void bas_compile_statement(BasicEmitter *e, BasicToken token,
+                                  char *text) {
+  BasicValueKind kind;
+  uint8_t offset;
+  uint8_t length;
+  uint8_t index;
+  uint16_t target;
 
-  if (value->kind == BAS_VALUE_STRING) {
-    if (value->stringLength + 1U > outBytes)
-      return 0;
-    for (uint16_t i = 0; i <= value->stringLength; i++) {
-      out[i] = value->string[i];
+  switch (token) {
+  case BAS_TOK_PRINT:
+    kind = bas_compile_expression(text, text, e, &offset, &length);
+    if (kind == BAS_VALUE_STRING) {
+      bas_emit(e, BAS_OP_PRINT_STR);
+      bas_emit(e, offset);
+      bas_emit(e, length);
+    } else if (kind == BAS_VALUE_INTEGER) {
+      bas_emit(e, BAS_OP_PRINT);
+    } else {
+      bas_emit_fail(e, BAS_RUN_BAD_EXPRESSION);
     }
-    return 1;
+    break;
+  case BAS_TOK_LET:
+    bas_compile_let(e, text);
+    break;
+  case BAS_TOK_INPUT:
+    if (bas_parse_lone_variable(text, &index)) {
+      bas_emit(e, BAS_OP_INPUT);
+      bas_emit(e, index);
+    } else {
+      bas_emit_fail(e, BAS_RUN_BAD_ASSIGNMENT);
+    }
+    break;
+  case BAS_TOK_IF:
+    bas_compile_if(e, text);
+    break;
+  case BAS_TOK_GOTO:
+  case BAS_TOK_GOSUB:
+    if (!bas_parse_line_target(text, &target)) {
+      bas_emit_fail(e, BAS_RUN_BAD_TARGET);
+    } else if ((index = bas_resolve_target(e, target)) == BAS_NO_LINE) {
+      bas_emit_fail(e, BAS_RUN_MISSING_LINE);
+    } else {
+      bas_emit(e, token == BAS_TOK_GOTO ? BAS_OP_GOTO : BAS_OP_GOSUB);
+      bas_emit(e, index);
+    }
+    break;
+  case BAS_TOK_RETURN:
+    bas_emit(e, BAS_OP_RETURN);
+    break;
+  case BAS_TOK_FOR:
+    bas_compile_for(e, text);
+    break;
+  case BAS_TOK_NEXT:
+    if (*bas_skip_spaces(text) == 0) {
+      bas_emit(e, BAS_OP_NEXT);
+      bas_emit(e, BAS_ANY_VARIABLE);
+    } else if (bas_parse_lone_variable(text, &index)) {
+      bas_emit(e, BAS_OP_NEXT);
+      bas_emit(e, index);
+    } else {
+      bas_emit_fail(e, BAS_RUN_BAD_EXPRESSION);
+    }
+    break;
+  case BAS_TOK_END:
+    bas_emit(e, BAS_OP_END);
+    break;
+  default:
+    bas_emit_fail(e, BAS_RUN_UNSUPPORTED_STATEMENT);
+    break;
   }
-
-  return 0;
 }
 
-static uint8_t bas_line_payload_length(const BasicParsedLine *parsed) {
-  return (uint8_t)(1U + parsed->payloadLength);
-}
+static void bas_compile_line(BasicEmitter *e, const uint8_t *bytes,
+                             uint16_t length) {
+  char text[BAS_MAX_PAYLOAD_TEXT + 1U];
+  uint16_t payloadLength = (uint16_t)(length - 1U);
 
-static uint8_t bas_write_replacement_line(BasicLine *lines, uint8_t *storage,
-                                          uint8_t *outCount, uint16_t *used,
-                                          uint16_t storageCapacity,
-                                          const BasicParsedLine *replacement) {
-  uint16_t len = bas_line_payload_length(replacement);
+  if (payloadLength > BAS_MAX_PAYLOAD_TEXT) {
+    bas_emit_fail(e, BAS_RUN_BUFFER_TOO_SMALL);
+    return;
+  }
 
-  if ((uint32_t)*used + len > storageCapacity)
-    return 0;
+  for (uint16_t i = 0; i < payloadLength; i++) {
+    text[i] = (char)bytes[1U + i];
+  }
+  text[payloadLength] = 0;
+  bas_compile_statement(e, (BasicToken)bytes[0], text);
+}
 
-  storage[*used] = (uint8_t)replacement->token;
-  for (uint16_t j = 0; j < replacement->payloadLength; j++) {
-    storage[*used + 1U + j] = (uint8_t)replacement->payload[j];
+/*
+ * Compile every line into basScratchCode. Fails when the code does not fit
+ * in 'capacity', which cannot happen for a BAS_CODE_CAPACITY() buffer.
+ */
+static uint8_t bas_compile_program(BasicLine *lines, uint8_t lineCount,
+                                   const uint8_t *storage, uint16_t capacity,
+                                   uint16_t *codeUsed) {
+  BasicEmitter e;
+
+  if (capacity > BAS_MAX_PROGRAM_CODE)
+    capacity = BAS_MAX_PROGRAM_CODE;
+  bas_init_emitter(&e, basScratchCode, capacity);
+  e.lines = lines;
+  e.lineCount = lineCount;
+  for (uint8_t i = 0; i < lineCount; i++) {
+    lines[i].code = e.used;
+    bas_compile_line(&e, storage + lines[i].offset, lines[i].length);
   }
-  lines[*outCount].number = replacement->number;
-  lines[*outCount].offset = *used;
-  lines[*outCount].length = len;
-  *used = (uint16_t)(*used + len);
-  *outCount = (uint8_t)(*outCount + 1U);
+  if (e.overflow)
+    return 0;
+
+  *codeUsed = e.used;
   return 1;
 }
 
-static void bas_write_u16_be(uint8_t *out, uint16_t value) {
-  out[0] = (uint8_t)(value >> 8);
-  out[1] = (uint8_t)(value & 0xffU);
+static void bas_commit_scratch(BasicProgram *program, uint8_t lineCount,
+                               uint16_t textUsed, uint16_t codeUsed) {
+  for (uint16_t i = 0; i < textUsed; i++) {
+    program->storage[i] = basScratchStorage[i];
+  }
+  for (uint16_t i = 0; i < codeUsed; i++) {
+    program->code[i] = basScratchCode[i];
+  }
+  for (uint8_t i = 0; i < lineCount; i++) {
+    program->lines[i] = basScratchLines[i];
+  }
+  program->lineCount = lineCount;
+  program->storageUsed = textUsed;
+  program->codeUsed = codeUsed;
 }
 
-static uint16_t bas_read_u16_be(const uint8_t *in) {
-  return (uint16_t)(((uint16_t)in[0] << 8) | in[1]);
+/*
+ * Run expression ops from *cursor until the line's statement op, leaving
+ * *cursor on it. Fails on an undefined variable (flagged) or overflow.
+ */
+static uint8_t bas_run_expression(const uint8_t **cursor,
+                                  const BasicRuntime *runtime, int16_t *stack,
+                                  uint8_t *depth, uint8_t *undefinedVariable) {
+  const uint8_t *code = *cursor;
+  uint8_t sp = *depth;
+  int32_t value;
+
+  while (1) {
+    switch (code[0]) {
+    case BAS_OP_INT:
+      if (sp >= BAS_EXPR_STACK_DEPTH)
+        return 0;
+      stack[sp++] = (int16_t)bas_read_u16_be(&code[1]);
+      code += 3;
+      break;
+    case BAS_OP_VAR:
+      if (!runtime || !runtime->integerDefined[code[1]]) {
+        *undefinedVariable = 1;
+        return 0;
+      }
+      if (sp >= BAS_EXPR_STACK_DEPTH)
+        return 0;
+      stack[sp++] = runtime->integerValues[code[1]];
+      code += 2;
+      break;
+    case BAS_OP_NEG:
+      if (stack[sp - 1U] == -32768)
+        return 0;
+      stack[sp - 1U] = (int16_t)-stack[sp - 1U];
+      code++;
+      break;
+    case BAS_OP_ADD:
+    case BAS_OP_SUB:
+      value = stack[sp - 2U];
+      if (code[0] == BAS_OP_ADD)
+        value += stack[sp - 1U];
+      else
+        value -= stack[sp - 1U];
+      if (value < -32768L || value > 32767L)
+        return 0;
+      sp--;
+      stack[sp - 1U] = (int16_t)value;
+      code++;
+      break;
+    default:
+      *cursor = code;
+      *depth = sp;
+      return 1;
+    }
+  }
+}
+
+static uint8_t bas_relation_holds(BasicRelation relation, const int16_t *stack,
+                                  uint8_t depth) {
+  int16_t left;
+  int16_t right;
+
+  if (relation == BAS_REL_NONZERO)
+    return (uint8_t)(stack[depth - 1U] != 0);
+
+  left = stack[depth - 2U];
+  right = stack[depth - 1U];
+  switch (relation) {
+  case BAS_REL_EQ:
+    return (uint8_t)(left == right);
+  case BAS_REL_NE:
+    return (uint8_t)(left != right);
+  case BAS_REL_LT:
+    return (uint8_t)(left < right);
+  case BAS_REL_GT:
+    return (uint8_t)(left > right);
+  case BAS_REL_LE:
+    return (uint8_t)(left <= right);
+  case BAS_REL_GE:
+  default:
+    return (uint8_t)(left >= right);
+  }
 }
 
 static uint8_t bas_repack_lines(BasicProgram *program,
@@ -685,6 +944,7 @@ static uint8_t bas_repack_lines(BasicProgram *program,
                                 uint8_t insertReplacement,
                                 uint16_t deleteNumber) {
   uint16_t used = 0;
+  uint16_t codeUsed = 0;
   uint8_t outCount = 0;
   uint8_t i;
   uint8_t inserted = 0;
@@ -734,20 +994,18 @@ static uint8_t bas_repack_lines(BasicProgram *program,
     }
   }
 
-  for (i = 0; i < used; i++) {
-    program->storage[i] = basScratchStorage[i];
-  }
-  for (i = 0; i < outCount; i++) {
-    program->lines[i] = basScratchLines[i];
-  }
-  program->lineCount = outCount;
-  program->storageUsed = used;
+  if (!bas_compile_program(basScratchLines, outCount, basScratchStorage,
+                           program->codeCapacity, &codeUsed))
+    return 0;
+
+  bas_commit_scratch(program, outCount, used, codeUsed);
   return 1;
 }
 
 void BAS_InitProgram(BasicProgram *program, BasicLine *lines,
                      uint8_t lineCapacity, uint8_t *storage,
-                     uint16_t storageCapacity) {
+                     uint16_t storageCapacity, uint8_t *code,
+                     uint16_t codeCapacity) {
   if (!program)
     return;
 
@@ -757,6 +1015,9 @@ void BAS_InitProgram(BasicProgram *program, BasicLine *lines,
   program->storage = storage;
   program->storageCapacity = storageCapacity;
   program->storageUsed = 0;
+  program->code = code;
+  program->codeCapacity = code ? codeCapacity : 0;
+  program->codeUsed = 0;
 }
 
 void BAS_ClearProgram(BasicProgram *program) {
@@ -764,6 +1025,7 @@ void BAS_ClearProgram(BasicProgram *program) {
     return;
   program->lineCount = 0;
   program->storageUsed = 0;
+  program->codeUsed = 0;
 }
 
 uint8_t BAS_ParseSourceLine(const char *source, BasicParsedLine *out) {
@@ -826,7 +1088,8 @@ uint8_t BAS_StoreSourceLine(BasicProgram *program, const char *source) {
   if (!BAS_ParseSourceLine(source, &parsed))
     return 0;
 
-  exists = bas_find_line(program, parsed.number, &index);
+  exists = bas_find_line(program->lines, program->lineCount, parsed.number,
+                         &index);
   if (!parsed.hasBody) {
     if (!exists)
       return 1;
@@ -901,6 +1164,7 @@ uint8_t BAS_ImportProgramImage(BasicProgram *program, const uint8_t *image,
   uint16_t expectedOffset = 0;
   uint16_t previousNumber = 0;
   uint16_t storagePos;
+  uint16_t codeUsed = 0;
 
   if (!program || !program->lines || !program->storage || !image ||
       imageBytes < 8)
@@ -940,18 +1204,21 @@ uint8_t BAS_ImportProgramImage(BasicProgram *program, const uint8_t *image,
 
   storagePos = (uint16_t)(8U + ((uint16_t)lineCount * 6U));
   for (uint16_t i = 0; i < storageUsed; i++) {
-    program->storage[i] = image[storagePos + i];
+    basScratchStorage[i] = image[storagePos + i];
   }
 
   pos = 8;
   for (uint8_t i = 0; i < lineCount; i++) {
-    program->lines[i].number = bas_read_u16_be(&image[pos]);
-    program->lines[i].offset = bas_read_u16_be(&image[pos + 2U]);
-    program->lines[i].length = bas_read_u16_be(&image[pos + 4U]);
+    basScratchLines[i].number = bas_read_u16_be(&image[pos]);
+    basScratchLines[i].offset = bas_read_u16_be(&image[pos + 2U]);
+    basScratchLines[i].length = bas_read_u16_be(&image[pos + 4U]);
     pos = (uint16_t)(pos + 6U);
   }
-  program->lineCount = lineCount;
-  program->storageUsed = storageUsed;
+  if (!bas_compile_program(basScratchLines, lineCount, basScratchStorage,
+                           program->codeCapacity, &codeUsed))
+    return 0;
+
+  bas_commit_scratch(program, lineCount, storageUsed, codeUsed);
   return 1;
 }
 
@@ -1205,7 +1472,14 @@ static uint8_t bas_evaluate_expression_internal(const char *source,
                                                 const BasicRuntime *runtime,
                                                 BasicValue *out,
                                                 uint8_t *undefinedVariable) {
-  const char *p;
+  BasicEmitter e;
+  BasicValueKind kind;
+  const uint8_t *code = basExprCode;
+  int16_t stack[BAS_EXPR_STACK_DEPTH];
+  uint8_t depth = 0;
+  uint8_t offset = 0;
+  uint8_t length = 0;
+  uint8_t undefined = 0;
 
   if (undefinedVariable)
     *undefinedVariable = 0;
@@ -1213,15 +1487,32 @@ static uint8_t bas_evaluate_expression_internal(const char *source,
     return 0;
 
   bas_clear_value(out);
-  p = bas_skip_spaces(source);
-  if (*p == 0)
-    return 0;
+  bas_init_emitter(&e, basExprCode, sizeof(basExprCode));
+  kind = bas_compile_expression(source, source, &e, &offset, &length);
+  if (kind == BAS_VALUE_STRING) {
+    for (uint8_t i = 0; i < length; i++) {
+      out->string[i] = source[offset + i];
+    }
+    out->string[length] = 0;
+    out->stringLength = length;
+    out->kind = BAS_VALUE_STRING;
+    return 1;
+  }
 
-  if (*p == '"')
-    return bas_eval_string_literal(p, out);
+  bas_emit(&e, BAS_OP_END);
+  if (e.overflow)
+    return 0;
+  if (!bas_run_expression(&code, runtime, stack, &depth, &undefined)) {
+    if (undefinedVariable)
+      *undefinedVariable = undefined;
+    return 0;
+  }
+  if (kind != BAS_VALUE_INTEGER)
+    return 0;
 
-  return bas_eval_integer_expression_with_runtime(p, runtime, out,
-                                                 undefinedVariable);
+  out->kind = BAS_VALUE_INTEGER;
+  out->integer = stack[0];
+  return 1;
 }
 
 uint8_t BAS_EvaluateExpression(const char *source, BasicValue *out) {
@@ -1235,82 +1526,257 @@ uint8_t BAS_EvaluateExpressionWithRuntime(const char *source,
   return bas_evaluate_expression_internal(source, runtime, out, (uint8_t *)0);
 }
 
-static uint8_t bas_execute_let(BasicRuntime *runtime, const char *source,
-                               BasicRunStatus *status) {
-  const char *p = bas_skip_spaces(source);
-  uint8_t index;
-  BasicValue value;
-  uint8_t undefinedVariable = 0;
+static BasicRunStatus bas_run_print(const uint8_t *code, const uint8_t *text,
+                                    int16_t value, BasicLineSink sink,
+                                    void *user, char *lineBuffer,
+                                    uint16_t lineBufferBytes) {
+  if (code[0] == BAS_OP_PRINT_STR) {
+    uint8_t length = code[2];
+
+    if (length + 1U > lineBufferBytes)
+      return BAS_RUN_BUFFER_TOO_SMALL;
+    for (uint8_t i = 0; i < length; i++) {
+      lineBuffer[i] = (char)text[code[1] + i];
+    }
+    lineBuffer[length] = 0;
+  } else if (!bas_write_int16(lineBuffer, lineBufferBytes, value)) {
+    return BAS_RUN_BUFFER_TOO_SMALL;
+  }
 
-  if (status)
-    *status = BAS_RUN_BAD_ASSIGNMENT;
-  if (!runtime || !p || !bas_variable_index(*p, &index))
-    return 0;
+  if (sink && !sink(lineBuffer, user))
+    return BAS_RUN_OUTPUT_REJECTED;
+  return BAS_RUN_COMPLETE;
+}
 
-  p++;
-  p = bas_skip_spaces(p);
-  if (*p != '=')
-    return 0;
-  p++;
+static BasicRunStatus bas_run_input(BasicRuntime *runtime, uint8_t index,
+                                    BasicInputSource input, void *user,
+                                    char *lineBuffer,
+                                    uint16_t lineBufferBytes) {
+  BasicValue value;
 
-  if (!bas_evaluate_expression_internal(p, runtime, &value,
-                                        &undefinedVariable)) {
-    if (status && undefinedVariable)
-      *status = BAS_RUN_UNDEFINED_VARIABLE;
-    return 0;
-  }
-  if (value.kind != BAS_VALUE_INTEGER)
-    return 0;
+  if (!input)
+    return BAS_RUN_INPUT_UNAVAILABLE;
+  if (!input(lineBuffer, lineBufferBytes, user))
+    return BAS_RUN_WAITING_INPUT;
+  if (!BAS_EvaluateExpression(lineBuffer, &value) ||
+      value.kind != BAS_VALUE_INTEGER)
+    return BAS_RUN_BAD_INPUT;
 
   runtime->integerDefined[index] = 1;
   runtime->integerValues[index] = value.integer;
-  return 1;
+  return BAS_RUN_COMPLETE;
 }
 
-static uint8_t bas_parse_input_target(const char *source, uint8_t *indexOut) {
-  const char *p = bas_skip_spaces(source);
+static BasicRunStatus bas_run_for(BasicExecState *state, uint8_t slot,
+                                  const int16_t *stack, uint8_t depth) {
+  BasicForFrame *frame;
 
-  if (!p || !bas_variable_index(*p, indexOut))
-    return 0;
+  state->runtime->integerDefined[slot] = 1;
+  state->runtime->integerValues[slot] = stack[depth - 3U];
 
-  p++;
-  p = bas_skip_spaces(p);
-  return (uint8_t)(*p == 0);
+  /* Re-entering a loop drops its old frame and any nested inside it */
+  for (uint8_t i = 0; i < state->forDepth; i++) {
+    if (state->forStack[i].slot == slot) {
+      state->forDepth = i;
+      break;
+    }
+  }
+  if (state->forDepth >= BAS_FOR_STACK_DEPTH)
+    return BAS_RUN_FOR_STACK_OVERFLOW;
+
+  frame = &state->forStack[state->forDepth++];
+  frame->slot = slot;
+  frame->body = (uint8_t)(state->pc + 1U);
+  frame->limit = stack[depth - 2U];
+  frame->step = stack[depth - 1U];
+  state->pc++;
+  return BAS_RUN_COMPLETE;
 }
 
-static uint8_t bas_execute_input(BasicRuntime *runtime, const char *targetText,
-                                 BasicInputSource input, void *user,
-                                 char *lineBuffer, uint16_t lineBufferBytes,
-                                 BasicRunStatus *status) {
-  uint8_t index;
-  BasicValue value;
+static BasicRunStatus bas_run_next(BasicExecState *state, uint8_t slot) {
+  BasicForFrame *frame;
+  int32_t value;
 
-  if (status)
-    *status = BAS_RUN_BAD_ASSIGNMENT;
-  if (!runtime || !bas_parse_input_target(targetText, &index))
-    return 0;
+  if (state->forDepth == 0)
+    return BAS_RUN_NEXT_WITHOUT_FOR;
+  frame = &state->forStack[state->forDepth - 1U];
 
-  if (!input) {
-    if (status)
-      *status = BAS_RUN_INPUT_UNAVAILABLE;
-    return 0;
-  }
-  if (!input(lineBuffer, lineBufferBytes, user)) {
-    if (status)
-      *status = BAS_RUN_INPUT_UNAVAILABLE;
-    return 0;
+  /* NEXT of an outer variable closes the loops nested inside it */
+  while (slot != BAS_ANY_VARIABLE && frame->slot != slot) {
+    if (--state->forDepth == 0)
+      return BAS_RUN_NEXT_WITHOUT_FOR;
+    frame--;
   }
 
-  if (!BAS_EvaluateExpression(lineBuffer, &value) ||
-      value.kind != BAS_VALUE_INTEGER) {
-    if (status)
-      *status = BAS_RUN_BAD_INPUT;
-    return 0;
+  value = (int32_t)state->runtime->integerValues[frame->slot] + frame->step;
+  if (value >= -32768L && value <= 32767L)
+    state->runtime->integerValues[frame->slot] = (int16_t)value;
+  if (frame->step >= 0 ? value <= frame->limit : value >= frame->limit) {
+    state->pc = frame->body;
+  } else {
+    state->forDepth--;
+    state->pc++;
   }
+  return BAS_RUN_COMPLETE;
+}
 
-  runtime->integerDefined[index] = 1;
-  runtime->integerValues[index] = value.integer;
-  return 1;
+void BAS_ExecInit(BasicExecState *state, const BasicProgram *program,
+                  BasicRuntime *runtime, BasicLineSink sink,
+                  BasicInputSource input, void *user, char *lineBuffer,
+                  uint16_t lineBufferBytes) {
+  if (!state)
+    return;
+
+  state->program = program;
+  state->runtime = runtime;
+  state->sink = sink;
+  state->input = input;
+  state->user = user;
+  state->lineBuffer = lineBuffer;
+  state->lineBufferBytes = lineBufferBytes;
+  state->pc = 0;
+  state->returnDepth = 0;
+  state->forDepth = 0;
+  state->waitingInput = 0;
+  state->statementsExecuted = 0;
+  state->linesEmitted = 0;
+  state->errorLine = 0;
+  state->status = BAS_RUN_YIELDED;
+  if (!program || !lineBuffer || lineBufferBytes == 0)
+    state->status = BAS_RUN_BUFFER_TOO_SMALL;
+  else if (!runtime)
+    state->status = BAS_RUN_UNDEFINED_VARIABLE;
+}
+
+BasicRunStatus BAS_Step(BasicExecState *state, uint16_t budget) {
+  const BasicProgram *program;
+  BasicRuntime *runtime;
+
+  if (!state)
+    return BAS_RUN_BUFFER_TOO_SMALL;
+  if (state->status != BAS_RUN_YIELDED &&
+      state->status != BAS_RUN_WAITING_INPUT)
+    return state->status;
+
+  program = state->program;
+  runtime = state->runtime;
+  while (1) {
+    const BasicLine *line;
+    const uint8_t *code;
+    int16_t stack[BAS_EXPR_STACK_DEPTH];
+    uint8_t depth = 0;
+    uint8_t undefinedVariable = 0;
+    BasicRunStatus status = BAS_RUN_COMPLETE;
+
+    if (state->pc >= program->lineCount) {
+      state->status = BAS_RUN_COMPLETE;
+      return state->status;
+    }
+    if (budget == 0) {
+      state->status = BAS_RUN_YIELDED;
+      return state->status;
+    }
+    budget--;
+
+    line = &program->lines[state->pc];
+    if (line->code >= program->codeUsed) {
+      state->status = BAS_RUN_UNSUPPORTED_STATEMENT;
+      return state->status;
+    }
+
+    code = &program->code[line->code];
+    state->statementsExecuted++;
+
+    if (!bas_run_expression(&code, runtime, stack, &depth,
+                            &undefinedVariable)) {
+      if (undefinedVariable)
+        status = BAS_RUN_UNDEFINED_VARIABLE;
+      else if (program->storage[line->offset] == BAS_TOK_LET)
+        status = BAS_RUN_BAD_ASSIGNMENT;
+      else
+        status = BAS_RUN_BAD_EXPRESSION;
+    } else {
+      switch (code[0]) {
+      case BAS_OP_PRINT:
+      case BAS_OP_PRINT_STR:
+        status = bas_run_print(code, &program->storage[line->offset + 1U],
+                               depth ? stack[depth - 1U] : 0, state->sink,
+                               state->user, state->lineBuffer,
+                               state->lineBufferBytes);
+        if (status == BAS_RUN_COMPLETE) {
+          state->linesEmitted++;
+          state->pc++;
+        }
+        break;
+      case BAS_OP_LET:
+        runtime->integerDefined[code[1]] = 1;
+        runtime->integerValues[code[1]] = stack[depth - 1U];
+        state->pc++;
+        break;
+      case BAS_OP_INPUT:
+        status = bas_run_input(runtime, code[1], state->input, state->user,
+                               state->lineBuffer, state->lineBufferBytes);
+        if (status == BAS_RUN_WAITING_INPUT) {
+          /* Park on this line; the next slice asks for input again */
+          state->statementsExecuted--;
+          state->waitingInput = 1;
+          state->status = BAS_RUN_WAITING_INPUT;
+          return state->status;
+        }
+        state->waitingInput = 0;
+        if (status == BAS_RUN_COMPLETE)
+          state->pc++;
+        break;
+      case BAS_OP_IF:
+        if (!bas_relation_holds((BasicRelation)code[1], stack, depth))
+          state->pc++;
+        else if (code[2] == BAS_NO_LINE)
+          status = BAS_RUN_MISSING_LINE;
+        else
+          state->pc = code[2];
+        break;
+      case BAS_OP_GOTO:
+        state->pc = code[1];
+        break;
+      case BAS_OP_GOSUB:
+        if (state->returnDepth >= BAS_GOSUB_STACK_DEPTH) {
+          status = BAS_RUN_GOSUB_STACK_OVERFLOW;
+        } else {
+          state->returnStack[state->returnDepth++] =
+              (uint8_t)(state->pc + 1U);
+          state->pc = code[1];
+        }
+        break;
+      case BAS_OP_RETURN:
+        if (state->returnDepth == 0)
+          status = BAS_RUN_RETURN_WITHOUT_GOSUB;
+        else
+          state->pc = state->returnStack[--state->returnDepth];
+        break;
+      case BAS_OP_FOR:
+        status = bas_run_for(state, code[1], stack, depth);
+        break;
+      case BAS_OP_NEXT:
+        status = bas_run_next(state, code[1]);
+        break;
+      case BAS_OP_END:
+        state->status = BAS_RUN_HALTED;
+        return state->status;
+      case BAS_OP_FAIL:
+        status = (BasicRunStatus)code[1];
+        break;
+      default:
+        status = BAS_RUN_UNSUPPORTED_STATEMENT;
+        break;
+      }
+    }
+
+    if (status != BAS_RUN_COMPLETE) {
+      state->errorLine = line->number;
+      state->status = status;
+      return state->status;
+    }
+  }
 }
 
 uint8_t BAS_RunProgram(const BasicProgram *program, BasicLineSink sink,
@@ -1337,222 +1803,25 @@ uint8_t BAS_RunProgramWithIO(const BasicProgram *program, BasicRuntime *runtime,
                              void *user, char *lineBuffer,
                              uint16_t lineBufferBytes,
                              BasicRunResult *result) {
-  uint8_t statementsExecuted = 0;
-  uint8_t linesEmitted = 0;
-  uint8_t pc = 0;
-  uint8_t returnStack[BAS_GOSUB_STACK_DEPTH];
-  uint8_t returnDepth = 0;
-
-  bas_set_run_result(result, BAS_RUN_COMPLETE, 0, 0, 0);
-  if (!program || !lineBuffer || lineBufferBytes == 0) {
-    bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL, 0, 0, 0);
-    return 0;
-  }
-  if (!runtime) {
-    bas_set_run_result(result, BAS_RUN_UNDEFINED_VARIABLE, 0, 0, 0);
-    return 0;
-  }
-
-  while (pc < program->lineCount) {
-    const BasicLine *line;
-    const uint8_t *bytes;
-    BasicToken token;
-
-    if (statementsExecuted >= BAS_RUN_MAX_STEPS) {
-      line = BAS_GetLine(program, pc);
-      bas_set_run_result(result, BAS_RUN_STEP_LIMIT, statementsExecuted,
-                         linesEmitted, line ? line->number : 0);
-      return 0;
-    }
-
-    line = BAS_GetLine(program, pc);
-    bytes = BAS_GetLineBytes(program, line);
-    if (!line || !bytes || line->length == 0) {
-      bas_set_run_result(result, BAS_RUN_UNSUPPORTED_STATEMENT,
-                         statementsExecuted, linesEmitted, 0);
-      return 0;
-    }
-
-    token = (BasicToken)bytes[0];
-    statementsExecuted++;
-
-    if (token == BAS_TOK_END) {
-      bas_set_run_result(result, BAS_RUN_HALTED, statementsExecuted,
-                         linesEmitted, 0);
-      return 1;
-    }
-
-    if (token == BAS_TOK_PRINT) {
-      BasicValue value;
-      uint8_t undefinedVariable = 0;
-
-      if (!bas_copy_payload_to_buffer(bytes, line->length, lineBuffer,
-                                      lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_evaluate_expression_internal(lineBuffer, runtime, &value,
-                                            &undefinedVariable)) {
-        bas_set_run_result(result,
-                           undefinedVariable ? BAS_RUN_UNDEFINED_VARIABLE
-                                             : BAS_RUN_BAD_EXPRESSION,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_value_to_line(&value, lineBuffer, lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (sink && !sink(lineBuffer, user)) {
-        bas_set_run_result(result, BAS_RUN_OUTPUT_REJECTED,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      linesEmitted++;
-      pc++;
-      continue;
-    }
-
-    if (token == BAS_TOK_INPUT) {
-      BasicRunStatus inputStatus = BAS_RUN_BAD_ASSIGNMENT;
-
-      if (!bas_copy_payload_to_buffer(bytes, line->length, lineBuffer,
-                                      lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_execute_input(runtime, lineBuffer, input, user, lineBuffer,
-                             lineBufferBytes, &inputStatus)) {
-        bas_set_run_result(result, inputStatus, statementsExecuted,
-                           linesEmitted, line->number);
-        return 0;
-      }
-      pc++;
-      continue;
-    }
-
-    if (token == BAS_TOK_LET) {
-      BasicRunStatus assignmentStatus = BAS_RUN_BAD_ASSIGNMENT;
-
-      if (!bas_copy_payload_to_buffer(bytes, line->length, lineBuffer,
-                                      lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_execute_let(runtime, lineBuffer, &assignmentStatus)) {
-        bas_set_run_result(result, assignmentStatus, statementsExecuted,
-                           linesEmitted, line->number);
-        return 0;
-      }
-      pc++;
-      continue;
+  BasicExecState state;
+  BasicRunStatus status;
+
+  BAS_ExecInit(&state, program, runtime, sink, input, user, lineBuffer,
+               lineBufferBytes);
+  status = BAS_Step(&state, BAS_RUN_MAX_STEPS);
+
+  /* One slice is all a blocking run gets */
+  if (status == BAS_RUN_YIELDED || status == BAS_RUN_WAITING_INPUT) {
+    state.errorLine = program->lines[state.pc].number;
+    if (status == BAS_RUN_YIELDED) {
+      status = BAS_RUN_STEP_LIMIT;
+    } else {
+      status = BAS_RUN_INPUT_UNAVAILABLE;
+      state.statementsExecuted++;
     }
-
-    if (token == BAS_TOK_IF) {
-      BasicRunStatus ifStatus = BAS_RUN_BAD_EXPRESSION;
-      uint8_t truth = 0;
-      uint16_t target;
-
-      if (!bas_copy_payload_to_buffer(bytes, line->length, lineBuffer,
-                                      lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_execute_if(lineBuffer, runtime, &truth, &target, &ifStatus)) {
-        bas_set_run_result(result, ifStatus, statementsExecuted, linesEmitted,
-                           line->number);
-        return 0;
-      }
-      if (truth) {
-        uint8_t targetIndex = 0;
-
-        if (!bas_find_line(program, target, &targetIndex)) {
-          bas_set_run_result(result, BAS_RUN_MISSING_LINE, statementsExecuted,
-                             linesEmitted, line->number);
-          return 0;
-        }
-        pc = targetIndex;
-      } else {
-        pc++;
-      }
-      continue;
-    }
-
-    if (token == BAS_TOK_GOTO) {
-      uint16_t target;
-      uint8_t targetIndex = 0;
-
-      if (!bas_copy_payload_to_buffer(bytes, line->length, lineBuffer,
-                                      lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_parse_line_target(lineBuffer, &target)) {
-        bas_set_run_result(result, BAS_RUN_BAD_TARGET, statementsExecuted,
-                           linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_find_line(program, target, &targetIndex)) {
-        bas_set_run_result(result, BAS_RUN_MISSING_LINE, statementsExecuted,
-                           linesEmitted, line->number);
-        return 0;
-      }
-      pc = targetIndex;
-      continue;
-    }
-
-    if (token == BAS_TOK_GOSUB) {
-      uint16_t target;
-      uint8_t targetIndex = 0;
-
-      if (!bas_copy_payload_to_buffer(bytes, line->length, lineBuffer,
-                                      lineBufferBytes)) {
-        bas_set_run_result(result, BAS_RUN_BUFFER_TOO_SMALL,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_parse_line_target(lineBuffer, &target)) {
-        bas_set_run_result(result, BAS_RUN_BAD_TARGET, statementsExecuted,
-                           linesEmitted, line->number);
-        return 0;
-      }
-      if (!bas_find_line(program, target, &targetIndex)) {
-        bas_set_run_result(result, BAS_RUN_MISSING_LINE, statementsExecuted,
-                           linesEmitted, line->number);
-        return 0;
-      }
-      if (returnDepth >= BAS_GOSUB_STACK_DEPTH) {
-        bas_set_run_result(result, BAS_RUN_GOSUB_STACK_OVERFLOW,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      returnStack[returnDepth++] = (uint8_t)(pc + 1U);
-      pc = targetIndex;
-      continue;
-    }
-
-    if (token == BAS_TOK_RETURN) {
-      if (returnDepth == 0) {
-        bas_set_run_result(result, BAS_RUN_RETURN_WITHOUT_GOSUB,
-                           statementsExecuted, linesEmitted, line->number);
-        return 0;
-      }
-      pc = returnStack[--returnDepth];
-      continue;
-    }
-
-    bas_set_run_result(result, BAS_RUN_UNSUPPORTED_STATEMENT,
-                       statementsExecuted, linesEmitted, line->number);
-    return 0;
   }
 
-  bas_set_run_result(result, BAS_RUN_COMPLETE, statementsExecuted,
-                     linesEmitted, 0);
-  return 1;
+  bas_set_run_result(result, status, (uint8_t)state.statementsExecuted,
+                     (uint8_t)state.linesEmitted, state.errorLine);
+  return (uint8_t)(status == BAS_RUN_COMPLETE || status == BAS_RUN_HALTED);
 }
@@ -10,7 +10,9 @@ static BasicStorageIO smokeIo;
 static BasicLine smokeSourceLines[4];
 static BasicLine smokeLoadedLines[4];
 static uint8_t smokeSourceStorage[256];
+static uint8_t smokeSourceCode[BAS_CODE_CAPACITY(256, 4)];
 static uint8_t smokeLoadedStorage[256];
+static uint8_t smokeLoadedCode[BAS_CODE_CAPACITY(256, 4)];
 static uint8_t smokeIoBuffer[STG_INTERNAL_BASIC_LIMIT_BYTES];
 static uint8_t smokeBeforeImage[STG_INTERNAL_BASIC_LIMIT_BYTES];
 static uint8_t smokeAfterImage[STG_INTERNAL_BASIC_LIMIT_BYTES];
@@ -94,9 +96,11 @@ uint8_t BAS_RunBramSmoke(BasicBramSmokeResult *result, const BramBiosOps *ops,
   bas_smoke_copy_probe(result, &smokeBramStorage);
 
   BAS_InitProgram(&sourceProgram, smokeSourceLines, 4, smokeSourceStorage,
-                  sizeof(smokeSourceStorage));
+                  sizeof(smokeSourceStorage), smokeSourceCode,
+                  sizeof(smokeSourceCode));
   BAS_InitProgram(&loadedProgram, smokeLoadedLines, 4, smokeLoadedStorage,
-                  sizeof(smokeLoadedStorage));
+                  sizeof(smokeLoadedStorage), smokeLoadedCode,
+                  sizeof(smokeLoadedCode));
 
   if (!BAS_StoreSourceLine(&sourceProgram, "10 PRINT \"BRAM OK\"") ||
       !BAS_StoreSourceLine(&sourceProgram, "20 END") ||
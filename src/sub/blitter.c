@@ -21,6 +21,13 @@ static BlitMode curMode; /* Current video mode          */
 static uint16_t bpr;     /* Bytes per row (current mode)*/
 static uint32_t fbSize;  /* Framebuf size (current mode)*/
 
+#ifdef BLT_HOST_TEST
+static uint32_t pixelWrites; /* Overdraw measurement, host builds only */
+#define COUNT_WRITES(n) (pixelWrites += (uint32_t)(n))
+#else
+#define COUNT_WRITES(n) ((void)0)
+#endif
+
 /* ============================================================
  * Built-in Patterns (1-bit masks, expanded at draw time)
  * ============================================================ */
@@ -184,6 +191,7 @@ void BLT_SetPixel(int16_t x, int16_t y, uint8_t color) {
 
   if (!fb || !clip_point(x, y))
     return;
+  COUNT_WRITES(1);
 
   if (curMode == BLT_MODE_2BIT) {
     /* 2bpp: 4 pixels per byte, MSB-first */
@@ -234,6 +242,7 @@ void BLT_DrawHLine(int16_t x, int16_t y, int16_t w, uint8_t color) {
     return;
   if (!clip_hspan(&x, y, &w))
     return;
+  COUNT_WRITES(w);
 
   x1 = x + w;
 
@@ -334,6 +343,7 @@ void BLT_DrawVLine(int16_t x, int16_t y, int16_t h, uint8_t color) {
   y1 = min16(y + h, clipRect.bottom);
   if (y0 >= y1)
     return;
+  COUNT_WRITES(y1 - y0);
 
   if (curMode == BLT_MODE_2BIT) {
     int16_t byteCol = x >> 2;
@@ -477,39 +487,174 @@ void BLT_FillRectPattern2(const Rect *r, const Pattern *pat, uint8_t fgColor,
   }
 }
 
+/* XOR pixels [x0, x1) of row y with `pattern` (a fill byte). Edge bytes
+ * go through a mask; whole aligned byte pairs go as one word. */
+static void xor_span(int16_t y, int16_t x0, int16_t x1, uint8_t pattern) {
+  uint8_t ppb = (curMode == BLT_MODE_2BIT) ? 4 : 2;
+  uint8_t bits = (uint8_t)(8 / ppb);
+  uint16_t first = (uint16_t)(x0 / ppb);
+  uint16_t last = (uint16_t)((x1 - 1) / ppb);
+  uint8_t headMask = (uint8_t)(0xFFU >> (bits * (x0 % ppb)));
+  uint8_t tailMask =
+      (uint8_t)(0xFFU << (8 - bits * (((x1 - 1) % ppb) + 1)));
+  uint16_t pattern16 = (uint16_t)(((uint16_t)pattern << 8) | pattern);
+  uint32_t off = (uint32_t)y * bpr + first;
+  uint16_t n = (uint16_t)(last - first + 1);
+  uint16_t i = 0;
+
+  while (i < n) {
+    uint8_t mask = 0xFF;
+
+    if (i == 0)
+      mask &= headMask;
+    if (i == n - 1)
+      mask &= tailMask;
+
+    if (mask == 0xFF && i + 1 < n - 1 && ((off + i) & 1) == 0) {
+      volatile uint16_t *words = (volatile uint16_t *)fb;
+      words[(off + i) >> 1] ^= pattern16;
+      i += 2;
+      continue;
+    }
+
+    fb_write_byte(off + i,
+                  (uint8_t)(fb_read_byte(off + i) ^ (pattern & mask)));
+    i++;
+  }
+}
+
+void BLT_XorRect(const Rect *r, uint8_t color) {
+  int16_t y, x0, x1;
+  uint8_t pattern = fill_byte(color);
+
+  if (!fb || !r || pattern == 0)
+    return;
+
+  x0 = max16(r->left, clipRect.left);
+  x1 = min16(r->right, clipRect.right);
+  if (x0 >= x1)
+    return;
+
+  for (y = max16(r->top, clipRect.top); y < min16(r->bottom, clipRect.bottom);
+       y++)
+    xor_span(y, x0, x1, pattern);
+}
+
+void BLT_InvertRect(const Rect *r) {
+  BLT_XorRect(r, (uint8_t)(BLT_GetBlack() ^ BLT_GetWhite()));
+}
+
+void BLT_InvertFrame(const Rect *r) {
+  Rect edge;
+
+  if (!r || r->left >= r->right || r->top >= r->bottom)
+    return;
+
+  /* Each pixel flips once, so a second call erases the frame exactly */
+  edge = *r;
+  edge.bottom = (int16_t)(r->top + 1);
+  BLT_InvertRect(&edge);
+  if (r->bottom - r->top < 2)
+    return;
+  edge.top = (int16_t)(r->bottom - 1);
+  edge.bottom = r->bottom;
+  BLT_InvertRect(&edge);
+
+  edge.top = (int16_t)(r->top + 1);
+  edge.bottom = (int16_t)(r->bottom - 1);
+  edge.right = (int16_t)(r->left + 1);
+  BLT_InvertRect(&edge);
+  if (r->right - r->left < 2)
+    return;
+  edge.left = (int16_t)(r->right - 1);
+  edge.right = r->right;
+  BLT_InvertRect(&edge);
+}
+
 /* ============================================================
  * Bitmap Blitting
  * ============================================================ */
 
+/* Source pixels [sx, sx + 8) of a 1-bit row, MSB first. sx may start up
+ * to a byte left of the row; pixels outside it read as clear. */
+static uint8_t bitmap1_bits(const uint8_t *row, int16_t sx, int16_t rowBytes) {
+  uint16_t window;
+  int16_t i;
+
+  if (sx < 0)
+    return (uint8_t)(bitmap1_bits(row, 0, rowBytes) >> -sx);
+
+  i = (int16_t)(sx >> 3);
+  window = (uint16_t)((i < rowBytes ? row[i] : 0) << 8);
+  if (i + 1 < rowBytes)
+    window |= row[i + 1];
+  return (uint8_t)((uint16_t)(window << (sx & 7)) >> 8);
+}
+
+/* One set bit per pixel -> that pixel's framebuffer bits */
+static const uint8_t bitmap1Expand2[4] = {0x00, 0x0F, 0xF0, 0xFF};
+static const uint8_t bitmap1Expand4[16] = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF};
+
 /* Blit a 1-bit source bitmap. Set bits draw as 'color',
- * clear bits are transparent (destination unchanged). */
+ * clear bits are transparent (destination unchanged). Like xor_span,
+ * each framebuffer byte takes its source pixels through one lookup and
+ * edge mask; bytes are paired so a fully covered word is one store. */
 void BLT_BlitBitmap1(int16_t dstX, int16_t dstY, const uint8_t *src,
                      int16_t srcW, int16_t srcH, uint8_t color) {
+  volatile uint16_t *words = (volatile uint16_t *)fb;
+  uint8_t ppb = (curMode == BLT_MODE_2BIT) ? 4 : 2;
+  uint8_t bits = (uint8_t)(8 / ppb);
+  uint8_t pattern = fill_byte(color);
+  uint16_t pattern16 = (uint16_t)(((uint16_t)pattern << 8) | pattern);
   int16_t srcBytesPerRow;
-  int16_t y, x;
+  int16_t x0, x1, y;
+  uint16_t first, last;
+  uint8_t headMask, tailMask;
 
   if (!fb || !src)
     return;
 
   srcBytesPerRow = (srcW + 7) / 8;
+  x0 = max16(dstX, clipRect.left);
+  x1 = min16((int16_t)(dstX + srcW), clipRect.right);
+  if (x0 >= x1)
+    return;
 
-  for (y = 0; y < srcH; y++) {
-    int16_t screenY = dstY + y;
-    if (screenY < clipRect.top || screenY >= clipRect.bottom)
-      continue;
-
-    for (x = 0; x < srcW; x++) {
-      int16_t screenX = dstX + x;
-      if (screenX < clipRect.left || screenX >= clipRect.right)
+  first = (uint16_t)(x0 / ppb);
+  last = (uint16_t)((x1 - 1) / ppb);
+  headMask = (uint8_t)(0xFFU >> (bits * (x0 % ppb)));
+  tailMask = (uint8_t)(0xFFU << (8 - bits * (((x1 - 1) % ppb) + 1)));
+
+  for (y = max16(dstY, clipRect.top);
+       y < min16((int16_t)(dstY + srcH), clipRect.bottom); y++) {
+    const uint8_t *row = &src[(y - dstY) * srcBytesPerRow];
+    uint32_t off = (uint32_t)y * bpr + first;
+    uint16_t mask = 0;
+    uint16_t i;
+
+    for (i = first; i <= last; i++, off++) {
+      uint8_t pixels = bitmap1_bits(
+          row, (int16_t)((int16_t)(i * ppb) - dstX), srcBytesPerRow);
+      uint8_t m = (ppb == 2) ? bitmap1Expand2[pixels >> 6]
+                             : bitmap1Expand4[pixels >> 4];
+
+      if (i == first)
+        m &= headMask;
+      if (i == last)
+        m &= tailMask;
+      mask |= (uint16_t)((off & 1) ? m : (uint16_t)m << 8);
+
+      /* Store once both bytes of the word are gathered, or at the end */
+      if (!(off & 1) && i != last)
         continue;
-
-      /* Read 1-bit source */
-      uint8_t srcBit =
-          (src[y * srcBytesPerRow + (x >> 3)] >> (7 - (x & 7))) & 1;
-
-      if (srcBit)
-        BLT_SetPixel(screenX, screenY, color);
-      /* Clear bits are transparent */
+      if (mask == 0xFFFF)
+        words[off >> 1] = pattern16;
+      else if (mask)
+        words[off >> 1] =
+            (uint16_t)((words[off >> 1] & ~mask) | (pattern16 & mask));
+      mask = 0;
     }
   }
 }
@@ -811,8 +956,9 @@ void BLT_DrawTitleBar(const Rect *titleBar, const char *title, uint8_t hilited,
   }
 }
 
-void BLT_DrawWindowFrame(const struct Window *win, const Font *titleFont) {
+void BLT_DrawWindowBody(const struct Window *win) {
   const Window *w = (const Window *)win;
+  Rect body;
 
   if (!w)
     return;
@@ -820,12 +966,6 @@ void BLT_DrawWindowFrame(const struct Window *win, const Font *titleFont) {
   /* Outer frame border */
   BLT_DrawRect(&w->frame, BLT_BLACK);
 
-  /* Title bar */
-  if (w->style != WM_STYLE_PLAIN && w->style != WM_STYLE_SHADOW) {
-    BLT_DrawTitleBar(&w->titleBar, w->title, (w->flags & WF_HILITED) ? 1 : 0,
-                     (w->flags & WF_HAS_CLOSE) ? 1 : 0, titleFont);
-  }
-
   /* Grow box */
   if (w->flags & WF_HAS_GROW) {
     BLT_DrawGrowBox(w->frame.right - 14, w->frame.bottom - 14);
@@ -836,8 +976,40 @@ void BLT_DrawWindowFrame(const struct Window *win, const Font *titleFont) {
     BLT_DrawShadow(&w->frame);
   }
 
-  /* Content area: clear to white */
-  BLT_FillRect(&w->content, BLT_GetWhite());
+  /* Content area and the separator above it: clear to white. The frame is
+   * opaque, so the redraw planner paints nothing beneath it. */
+  body = w->content;
+  if (w->titleBar.bottom > w->frame.top)
+    body.top = w->titleBar.bottom;
+  BLT_FillRect(&body, BLT_GetWhite());
+}
+
+void BLT_DrawWindowTitle(const struct Window *win, const Font *titleFont) {
+  const Window *w = (const Window *)win;
+  Rect clip, bar;
+
+  if (!w || w->style == WM_STYLE_PLAIN || w->style == WM_STYLE_SHADOW)
+    return;
+
+  /* Keep an over-long title inside the bar */
+  clip = clipRect;
+  bar.left = max16(w->titleBar.left, clip.left);
+  bar.top = max16(w->titleBar.top, clip.top);
+  bar.right = min16(w->titleBar.right, clip.right);
+  bar.bottom = min16(w->titleBar.bottom, clip.bottom);
+  if (bar.left >= bar.right || bar.top >= bar.bottom)
+    return;
+
+  clipRect = bar;
+  BLT_DrawTitleBar(&w->titleBar, w->title, (w->flags & WF_HILITED) ? 1 : 0,
+                   (w->flags & WF_HAS_CLOSE) ? 1 : 0, titleFont);
+  clipRect = clip;
+}
+
+void BLT_DrawWindowFrame(const struct Window *win, const Font *titleFont) {
+  /* The title bar shares no pixels with the rest of the frame */
+  BLT_DrawWindowBody(win);
+  BLT_DrawWindowTitle(win, titleFont);
 }
 
 /* ============================================================
@@ -929,3 +1101,242 @@ void BLT_ScrollRect(const Rect *r, int16_t dx, int16_t dy) {
     }
   }
 }
+
+/* Copy one row span of w pixels. `backward` walks right-to-left so a span
+ * shifted right within its own row reads each pixel before overwriting it. */
+static void copy_span(int16_t sx, int16_t sy, int16_t dx, int16_t dy,
+                      int16_t w, uint8_t backward) {
+  uint8_t ppb = (curMode == BLT_MODE_2BIT) ? 4 : 2;
+  int16_t lead, mid, i;
+  uint32_t srcOff, dstOff;
+
+  if (((sx - dx) % ppb) != 0) {
+    /* Sub-byte misalignment: no shared byte grid, copy pixel by pixel */
+    for (i = 0; i < w; i++) {
+      int16_t k = backward ? (int16_t)(w - 1 - i) : i;
+      BLT_SetPixel((int16_t)(dx + k), dy, BLT_GetPixel((int16_t)(sx + k), sy));
+    }
+    return;
+  }
+
+  lead = (int16_t)((ppb - (dx % ppb)) % ppb);
+  if (lead > w)
+    lead = w;
+  mid = (int16_t)((w - lead) / ppb);
+
+  srcOff = (uint32_t)sy * bpr + (uint16_t)((sx + lead) / ppb);
+  dstOff = (uint32_t)dy * bpr + (uint16_t)((dx + lead) / ppb);
+
+  if (!backward) {
+    for (i = 0; i < lead; i++)
+      BLT_SetPixel((int16_t)(dx + i), dy, BLT_GetPixel((int16_t)(sx + i), sy));
+  } else {
+    for (i = (int16_t)(w - 1); i >= lead + (mid * ppb); i--)
+      BLT_SetPixel((int16_t)(dx + i), dy, BLT_GetPixel((int16_t)(sx + i), sy));
+  }
+
+  /* The edges above and below count through BLT_SetPixel() */
+  COUNT_WRITES(mid * ppb);
+  if (mid > 0) {
+    volatile uint16_t *words = (volatile uint16_t *)fb;
+    int16_t head = 0;
+    int16_t nwords = 0;
+    int16_t tail;
+
+    if (((srcOff ^ dstOff) & 1) == 0) {
+      head = (int16_t)(dstOff & 1);
+      if (head > mid)
+        head = mid;
+      nwords = (int16_t)((mid - head) / 2);
+    }
+    tail = (int16_t)(mid - head - (nwords * 2));
+
+    if (!backward) {
+      for (i = 0; i < head; i++)
+        fb_write_byte(dstOff + i, fb_read_byte(srcOff + i));
+      for (i = 0; i < nwords; i++)
+        words[((dstOff + head) >> 1) + i] = words[((srcOff + head) >> 1) + i];
+      for (i = (int16_t)(mid - tail); i < mid; i++)
+        fb_write_byte(dstOff + i, fb_read_byte(srcOff + i));
+    } else {
+      for (i = (int16_t)(mid - 1); i >= mid - tail; i--)
+        fb_write_byte(dstOff + i, fb_read_byte(srcOff + i));
+      for (i = (int16_t)(nwords - 1); i >= 0; i--)
+        words[((dstOff + head) >> 1) + i] = words[((srcOff + head) >> 1) + i];
+      for (i = (int16_t)(head - 1); i >= 0; i--)
+        fb_write_byte(dstOff + i, fb_read_byte(srcOff + i));
+    }
+  }
+
+  if (backward) {
+    for (i = (int16_t)(lead - 1); i >= 0; i--)
+      BLT_SetPixel((int16_t)(dx + i), dy, BLT_GetPixel((int16_t)(sx + i), sy));
+  } else {
+    for (i = (int16_t)(lead + (mid * ppb)); i < w; i++)
+      BLT_SetPixel((int16_t)(dx + i), dy, BLT_GetPixel((int16_t)(sx + i), sy));
+  }
+}
+
+void BLT_CopyRect(const Rect *src, int16_t dstX, int16_t dstY) {
+  Rect s, d;
+  int16_t offX, offY, w, y;
+
+  if (!fb || !src)
+    return;
+
+  offX = (int16_t)(dstX - src->left);
+  offY = (int16_t)(dstY - src->top);
+  if (offX == 0 && offY == 0)
+    return;
+
+  s.left = max16(src->left, 0);
+  s.top = max16(src->top, 0);
+  s.right = min16(src->right, BLT_SCREEN_W);
+  s.bottom = min16(src->bottom, BLT_SCREEN_H);
+
+  d.left = max16((int16_t)(s.left + offX), clipRect.left);
+  d.top = max16((int16_t)(s.top + offY), clipRect.top);
+  d.right = min16((int16_t)(s.right + offX), clipRect.right);
+  d.bottom = min16((int16_t)(s.bottom + offY), clipRect.bottom);
+
+  w = (int16_t)(d.right - d.left);
+  if (w <= 0 || d.bottom <= d.top)
+    return;
+
+  /* Walk rows away from the overlap so no source row is overwritten first */
+  if (offY <= 0) {
+    for (y = d.top; y < d.bottom; y++)
+      copy_span((int16_t)(d.left - offX), (int16_t)(y - offY), d.left, y, w,
+                (uint8_t)(offY == 0 && offX > 0));
+  } else {
+    for (y = (int16_t)(d.bottom - 1); y >= d.top; y--)
+      copy_span((int16_t)(d.left - offX), (int16_t)(y - offY), d.left, y, w,
+                0);
+  }
+}
+
+/* ============================================================
+ * Save-under
+ * ============================================================ */
+
+/* Clip r to the screen and describe its byte columns: first byte, and the
+ * even row stride the saved copy uses so word copies stay aligned. */
+static uint8_t save_geometry(const Rect *r, Rect *c, uint16_t *b0,
+                             uint16_t *stride) {
+  uint8_t ppb = (curMode == BLT_MODE_2BIT) ? 4 : 2;
+  uint16_t bytes;
+
+  if (!r)
+    return 0;
+  c->left = max16(r->left, 0);
+  c->top = max16(r->top, 0);
+  c->right = min16(r->right, BLT_SCREEN_W);
+  c->bottom = min16(r->bottom, BLT_SCREEN_H);
+  if (c->left >= c->right || c->top >= c->bottom)
+    return 0;
+
+  *b0 = (uint16_t)(c->left / ppb);
+  bytes = (uint16_t)(((c->right - 1) / ppb) + 1 - *b0);
+  *stride = (uint16_t)((bytes + 1U) & ~1U);
+  return 1;
+}
+
+uint32_t BLT_SaveUnderSize(const Rect *r) {
+  Rect c;
+  uint16_t b0, stride;
+
+  if (!save_geometry(r, &c, &b0, &stride))
+    return 0;
+  return (uint32_t)stride * (uint32_t)(c.bottom - c.top);
+}
+
+/* Move pixels [x0, x1) of row y between the framebuffer and the saved copy
+ * of `frame`. Edge bytes are merged through a mask so pixels outside the
+ * span keep their value on either side. */
+static void save_span(uint8_t *buf, const Rect *frame, uint16_t b0,
+                      uint16_t stride, int16_t y, int16_t x0, int16_t x1,
+                      uint8_t toFb) {
+  uint8_t ppb = (curMode == BLT_MODE_2BIT) ? 4 : 2;
+  uint8_t bits = (uint8_t)(8 / ppb);
+  uint16_t first = (uint16_t)(x0 / ppb);
+  uint16_t last = (uint16_t)((x1 - 1) / ppb);
+  uint8_t headMask = (uint8_t)(0xFFU >> (bits * (x0 % ppb)));
+  uint8_t tailMask =
+      (uint8_t)(0xFFU << (8 - bits * (((x1 - 1) % ppb) + 1)));
+  uint32_t fbOff = (uint32_t)y * bpr + first;
+  uint8_t *row = buf + (uint32_t)(y - frame->top) * stride + (first - b0);
+  uint16_t n = (uint16_t)(last - first + 1);
+  uint16_t i = 0;
+
+  while (i < n) {
+    uint8_t mask = 0xFF;
+
+    if (i == 0)
+      mask &= headMask;
+    if (i == n - 1)
+      mask &= tailMask;
+
+    /* Whole aligned pairs move as one word */
+    if (mask == 0xFF && i + 1 < n - 1 && ((fbOff + i) & 1) == 0 &&
+        (((uintptr_t)(row + i)) & 1) == 0) {
+      volatile uint16_t *words = (volatile uint16_t *)fb;
+      uint16_t *saved = (uint16_t *)(void *)(row + i);
+
+      if (toFb)
+        words[(fbOff + i) >> 1] = *saved;
+      else
+        *saved = words[(fbOff + i) >> 1];
+      i += 2;
+      continue;
+    }
+
+    if (toFb) {
+      uint8_t cur = fb_read_byte(fbOff + i);
+      fb_write_byte(fbOff + i, (uint8_t)((cur & ~mask) | (row[i] & mask)));
+    } else {
+      row[i] = (uint8_t)((row[i] & ~mask) | (fb_read_byte(fbOff + i) & mask));
+    }
+    i++;
+  }
+}
+
+static void save_rect(const Rect *r, const Rect *part, uint8_t *buf,
+                      uint8_t toFb) {
+  Rect c, p;
+  uint16_t b0, stride;
+  int16_t y;
+
+  if (!fb || !buf || !save_geometry(r, &c, &b0, &stride))
+    return;
+
+  p = c;
+  if (part) {
+    p.left = max16(part->left, c.left);
+    p.top = max16(part->top, c.top);
+    p.right = min16(part->right, c.right);
+    p.bottom = min16(part->bottom, c.bottom);
+    if (p.left >= p.right || p.top >= p.bottom)
+      return;
+  }
+
+  for (y = p.top; y < p.bottom; y++)
+    save_span(buf, &c, b0, stride, y, p.left, p.right, toFb);
+}
+
+void BLT_SaveRect(const Rect *r, const Rect *part, uint8_t *buf) {
+  save_rect(r, part, buf, 0);
+}
+
+void BLT_RestoreRect(const Rect *r, const Rect *part, const uint8_t *buf) {
+  save_rect(r, part, (uint8_t *)buf, 1);
+}
+
+#ifdef BLT_HOST_TEST
+/* ============================================================
+ * Host Statistics
+ * ============================================================ */
+
+uint32_t BLT_GetPixelWrites(void) { return pixelWrites; }
+
+void BLT_ResetPixelWrites(void) { pixelWrites = 0; }
+#endif
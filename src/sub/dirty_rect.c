@@ -1,5 +1,8 @@
 #include "dirty_rect.h"
 
+static DirtyDmaCost drDmaCost = {DR_DMA_SETUP_CYCLES_DEFAULT,
+                                 DR_DMA_CYCLES_PER_BYTE_DEFAULT};
+
 static int16_t dr_max16(int16_t a, int16_t b) { return (a > b) ? a : b; }
 static int16_t dr_min16(int16_t a, int16_t b) { return (a < b) ? a : b; }
 
@@ -322,12 +325,58 @@ Boolean DR_QueueTileRange(DirtyTileQueue *queue, const DirtyTileRange *range,
   return 1;
 }
 
+static Boolean dr_gap_worth_merging(uint32_t gapTiles,
+                                    uint16_t bytesPerTile) {
+  if (gapTiles == 0)
+    return 1;
+  return (gapTiles * bytesPerTile * drDmaCost.cyclesPerByte <
+          drDmaCost.setupCycles)
+             ? 1
+             : 0;
+}
+
+static Boolean dr_queue_each_range(const DirtyRectList *list,
+                                   DirtyTileQueue *queue, uint8_t tileW,
+                                   uint8_t tileH, uint16_t planeTilesX,
+                                   uint16_t bytesPerTile) {
+  DirtyTileRange range;
+  DirtyRect *dirty;
+  uint8_t i;
+
+  for (i = 0; i < list->count; i++) {
+    dirty = &list->items[i];
+    if (!dirty->valid)
+      continue;
+
+    if (!DR_RectToTileRange(&dirty->rect, tileW, tileH, &range))
+      continue;
+
+    if (!DR_QueueTileRange(queue, &range, planeTilesX, bytesPerTile))
+      return 0;
+  }
+
+  return 1;
+}
+
+/*
+ * Walk dirty tiles in VRAM order, one tile row at a time, and keep one pending
+ * span open. Each gap to the next covered run is merged or cut independently,
+ * so taking the cheaper side of every gap gives the minimum modelled cost.
+ */
 Boolean DR_BuildTileQueueFromDirtyList(const DirtyRectList *list,
                                        DirtyTileQueue *queue, uint8_t tileW,
                                        uint8_t tileH, uint16_t planeTilesX,
                                        uint16_t bytesPerTile) {
-  DirtyTileRange range;
-  DirtyRect *dirty;
+  DirtyTileRange ranges[DR_COALESCE_MAX_RECTS];
+  uint16_t rowX0[DR_COALESCE_MAX_RECTS];
+  uint16_t rowX1[DR_COALESCE_MAX_RECTS];
+  uint8_t rangeCount = 0;
+  uint16_t minY = 0xffffU;
+  uint16_t maxY = 0;
+  uint32_t pendingStart = 0;
+  uint32_t pendingEnd = 0;
+  Boolean hasPending = 0;
+  uint16_t y;
   uint8_t i;
 
   if (!queue)
@@ -340,27 +389,681 @@ Boolean DR_BuildTileQueueFromDirtyList(const DirtyRectList *list,
     return 0;
   }
 
+  if (list->count > DR_COALESCE_MAX_RECTS)
+    return dr_queue_each_range(list, queue, tileW, tileH, planeTilesX,
+                               bytesPerTile);
+
   for (i = 0; i < list->count; i++) {
-    dirty = &list->items[i];
-    if (!dirty->valid)
+    DirtyTileRange *range = &ranges[rangeCount];
+
+    if (!list->items[i].valid)
       continue;
+    if (!DR_RectToTileRange(&list->items[i].rect, tileW, tileH, range))
+      continue;
+    if (range->x1 > planeTilesX)
+      return 0;
 
-    if (!DR_RectToTileRange(&dirty->rect, tileW, tileH, &range))
+    if (range->y0 < minY)
+      minY = range->y0;
+    if (range->y1 > maxY)
+      maxY = range->y1;
+    rangeCount++;
+  }
+
+  for (y = minY; rangeCount != 0 && y < maxY; y++) {
+    uint8_t rowCount = 0;
+    uint8_t j;
+
+    /* Insertion-sort this row's covered x-intervals by start column. */
+    for (i = 0; i < rangeCount; i++) {
+      if (y < ranges[i].y0 || y >= ranges[i].y1)
+        continue;
+
+      j = rowCount;
+      while (j > 0 && rowX0[j - 1] > ranges[i].x0) {
+        rowX0[j] = rowX0[j - 1];
+        rowX1[j] = rowX1[j - 1];
+        j--;
+      }
+      rowX0[j] = ranges[i].x0;
+      rowX1[j] = ranges[i].x1;
+      rowCount++;
+    }
+
+    for (j = 0; j < rowCount; j++) {
+      uint32_t start = ((uint32_t)y * planeTilesX) + rowX0[j];
+      uint32_t end = ((uint32_t)y * planeTilesX) + rowX1[j];
+
+      if (hasPending &&
+          (start <= pendingEnd ||
+           dr_gap_worth_merging(start - pendingEnd, bytesPerTile))) {
+        if (end > pendingEnd)
+          pendingEnd = end;
+        continue;
+      }
+
+      if (hasPending &&
+          !dr_queue_tile_span(queue, pendingStart, pendingEnd - pendingStart,
+                              bytesPerTile)) {
+        return 0;
+      }
+      pendingStart = start;
+      pendingEnd = end;
+      hasPending = 1;
+    }
+  }
+
+  if (hasPending)
+    return dr_queue_tile_span(queue, pendingStart, pendingEnd - pendingStart,
+                              bytesPerTile);
+  return 1;
+}
+
+void DR_ClearTileBitmap(DirtyTileBitmap *map) {
+  uint8_t i;
+
+  if (!map)
+    return;
+
+  for (i = 0; i < DR_TILE_BITMAP_BYTES; i++)
+    map->bits[i] = 0;
+}
+
+/* Set count bits from tile first: partial head byte, whole bytes, tail. */
+static void dr_bitmap_set_run(uint8_t *bits, uint16_t first, uint16_t count) {
+  uint16_t byte = (uint16_t)(first >> 3);
+  uint8_t bit = (uint8_t)(first & 7U);
+
+  if (bit != 0) {
+    uint8_t take = (uint8_t)(8U - bit);
+    uint8_t mask;
+
+    if (take > count)
+      take = (uint8_t)count;
+    mask = (uint8_t)((0xffU >> bit) & (0xffU << (8U - bit - take)));
+    bits[byte++] |= mask;
+    count = (uint16_t)(count - take);
+  }
+  while (count >= 8U) {
+    bits[byte++] = 0xffU;
+    count = (uint16_t)(count - 8U);
+  }
+  if (count != 0)
+    bits[byte] |= (uint8_t)(0xffU << (8U - count));
+}
+
+Boolean DR_MarkTileBitmap(DirtyTileBitmap *map, const Rect *r) {
+  Rect screen;
+  Rect clipped;
+  DirtyTileRange range;
+  uint16_t y;
+
+  if (!map || !r)
+    return 0;
+
+  screen.top = 0;
+  screen.left = 0;
+  screen.bottom = (int16_t)(DR_TILE_BITMAP_TILES_Y * 8U);
+  screen.right = (int16_t)(DR_TILE_BITMAP_TILES_X * 8U);
+  if (!DR_RectIntersect(r, &screen, &clipped) ||
+      !DR_RectToTileRange(&clipped, 8, 8, &range))
+    return 0;
+
+  /* Full-width ranges are one contiguous run in tile order */
+  if (range.x0 == 0 && range.x1 == DR_TILE_BITMAP_TILES_X) {
+    dr_bitmap_set_run(map->bits,
+                      (uint16_t)(range.y0 * DR_TILE_BITMAP_TILES_X),
+                      (uint16_t)((range.y1 - range.y0) *
+                                 DR_TILE_BITMAP_TILES_X));
+    return 1;
+  }
+
+  for (y = range.y0; y < range.y1; y++)
+    dr_bitmap_set_run(map->bits,
+                      (uint16_t)((y * DR_TILE_BITMAP_TILES_X) + range.x0),
+                      (uint16_t)(range.x1 - range.x0));
+  return 1;
+}
+
+Boolean DR_TileBitmapTest(const DirtyTileBitmap *map, uint16_t tile) {
+  if (!map || tile >= DR_TILE_BITMAP_TILES)
+    return 0;
+  return (map->bits[tile >> 3] & (0x80U >> (tile & 7U))) ? 1 : 0;
+}
+
+uint16_t DR_TileBitmapCount(const DirtyTileBitmap *map) {
+  uint16_t count = 0;
+  uint8_t i;
+
+  if (!map)
+    return 0;
+
+  for (i = 0; i < DR_TILE_BITMAP_BYTES; i++) {
+    uint8_t b = map->bits[i];
+
+    while (b) {
+      b &= (uint8_t)(b - 1U);
+      count++;
+    }
+  }
+  return count;
+}
+
+/* First tile at or after tile whose bit equals set; whole bytes of the other
+ * value are skipped eight tiles at a time. */
+static uint16_t dr_bitmap_scan(const uint8_t *bits, uint16_t tile,
+                               uint8_t set) {
+  uint8_t skip = set ? 0x00U : 0xffU;
+
+  while (tile < DR_TILE_BITMAP_TILES) {
+    uint8_t b = bits[tile >> 3];
+
+    if ((tile & 7U) == 0 && b == skip) {
+      tile = (uint16_t)(tile + 8U);
       continue;
+    }
+    if (((b & (0x80U >> (tile & 7U))) ? 1U : 0U) == set)
+      return tile;
+    tile++;
+  }
+  return DR_TILE_BITMAP_TILES;
+}
 
-    if (!DR_QueueTileRange(queue, &range, planeTilesX, bytesPerTile))
+/*
+ * Bitmap sibling of DR_BuildTileQueueFromDirtyList(): runs of set bits are
+ * already in VRAM order, so each one is a span and gaps go through the same
+ * DMA cost model.
+ */
+Boolean DR_BuildTileQueueFromBitmap(const DirtyTileBitmap *map,
+                                    DirtyTileQueue *queue,
+                                    uint16_t bytesPerTile) {
+  uint16_t pendingStart = 0;
+  uint16_t pendingEnd = 0;
+  Boolean hasPending = 0;
+  uint16_t tile = 0;
+
+  if (!queue)
+    return 0;
+
+  DR_ClearTileQueue(queue);
+
+  if (!map || bytesPerTile == 0)
+    return 0;
+
+  for (;;) {
+    uint16_t start = dr_bitmap_scan(map->bits, tile, 1);
+    uint16_t end;
+
+    if (start >= DR_TILE_BITMAP_TILES)
+      break;
+    end = dr_bitmap_scan(map->bits, start, 0);
+    tile = end;
+
+    if (hasPending &&
+        dr_gap_worth_merging((uint32_t)(start - pendingEnd), bytesPerTile)) {
+      pendingEnd = end;
+      continue;
+    }
+    if (hasPending &&
+        !dr_queue_tile_span(queue, pendingStart,
+                            (uint32_t)(pendingEnd - pendingStart),
+                            bytesPerTile)) {
       return 0;
+    }
+    pendingStart = start;
+    pendingEnd = end;
+    hasPending = 1;
+  }
+
+  if (hasPending)
+    return dr_queue_tile_span(queue, pendingStart,
+                              (uint32_t)(pendingEnd - pendingStart),
+                              bytesPerTile);
+  return 1;
+}
+
+/* ============================================================
+ * Banded regions
+ * ============================================================ */
+
+#define DR_OP_UNION 0
+#define DR_OP_INTERSECT 1
+#define DR_OP_SUBTRACT 2
+
+void DR_InitRegion(DirtyRegion *rgn, Rect *storage, uint16_t capacity) {
+  if (!rgn)
+    return;
+
+  rgn->rects = storage;
+  rgn->capacity = storage ? capacity : 0;
+  DR_RegionClear(rgn);
+}
+
+void DR_RegionClear(DirtyRegion *rgn) {
+  if (!rgn)
+    return;
+
+  rgn->count = 0;
+  rgn->overflow = 0;
+}
+
+Boolean DR_RegionSetRect(DirtyRegion *rgn, const Rect *r) {
+  if (!rgn)
+    return 0;
+
+  DR_RegionClear(rgn);
+  if (!r || DR_RectIsEmpty(r))
+    return 1;
+  if (rgn->capacity == 0) {
+    rgn->overflow = 1;
+    return 0;
+  }
+  rgn->rects[0] = *r;
+  rgn->count = 1;
+  return 1;
+}
+
+Boolean DR_RegionCopy(DirtyRegion *out, const DirtyRegion *src) {
+  uint16_t i;
+
+  if (!out || !src)
+    return 0;
+
+  DR_RegionClear(out);
+  if (src->count > out->capacity) {
+    out->overflow = 1;
+    return 0;
+  }
+  for (i = 0; i < src->count; i++)
+    out->rects[i] = src->rects[i];
+  out->count = src->count;
+  return 1;
+}
+
+Boolean DR_RegionIsEmpty(const DirtyRegion *rgn) {
+  return (!rgn || rgn->count == 0) ? 1 : 0;
+}
+
+uint32_t DR_RegionArea(const DirtyRegion *rgn) {
+  uint32_t area = 0;
+  uint16_t i;
+
+  if (!rgn)
+    return 0;
+
+  for (i = 0; i < rgn->count; i++)
+    area += (uint32_t)(rgn->rects[i].right - rgn->rects[i].left) *
+            (uint32_t)(rgn->rects[i].bottom - rgn->rects[i].top);
+  return area;
+}
+
+/* Index of the first rect after the band starting at index. */
+static uint16_t dr_band_end(const DirtyRegion *rgn, uint16_t index) {
+  int16_t top = rgn->rects[index].top;
+
+  while (index < rgn->count && rgn->rects[index].top == top)
+    index++;
+  return index;
+}
+
+static Boolean dr_op_keeps(uint8_t op, Boolean inA, Boolean inB) {
+  if (op == DR_OP_UNION)
+    return (inA || inB) ? 1 : 0;
+  if (op == DR_OP_INTERSECT)
+    return (inA && inB) ? 1 : 0;
+  return (inA && !inB) ? 1 : 0;
+}
+
+/*
+ * Combine the x-spans of one band from each input over [top, bottom) and
+ * append the result. aCount or bCount is 0 when that input has no band here.
+ */
+static Boolean dr_band_op(DirtyRegion *out, const Rect *a, uint16_t aCount,
+                          const Rect *b, uint16_t bCount, int16_t top,
+                          int16_t bottom, uint8_t op) {
+  uint16_t i = 0;
+  uint16_t j = 0;
+  int16_t x;
+  int16_t xEnd;
+  uint16_t bandStart = out->count;
+
+  if (aCount == 0 && bCount == 0)
+    return 1;
+  if (aCount && (!bCount || a[0].left < b[0].left))
+    x = a[0].left;
+  else
+    x = b[0].left;
+
+  while (i < aCount || j < bCount) {
+    Boolean inA = (i < aCount && a[i].left <= x) ? 1 : 0;
+    Boolean inB = (j < bCount && b[j].left <= x) ? 1 : 0;
+
+    xEnd = 0x7fff;
+    if (i < aCount)
+      xEnd = dr_min16(xEnd, inA ? a[i].right : a[i].left);
+    if (j < bCount)
+      xEnd = dr_min16(xEnd, inB ? b[j].right : b[j].left);
+
+    if (dr_op_keeps(op, inA, inB)) {
+      if (out->count > bandStart && out->rects[out->count - 1].right == x) {
+        out->rects[out->count - 1].right = xEnd;
+      } else {
+        if (out->count >= out->capacity) {
+          out->overflow = 1;
+          return 0;
+        }
+        out->rects[out->count].top = top;
+        out->rects[out->count].bottom = bottom;
+        out->rects[out->count].left = x;
+        out->rects[out->count].right = xEnd;
+        out->count++;
+      }
+    }
+
+    x = xEnd;
+    if (i < aCount && a[i].right <= x)
+      i++;
+    if (j < bCount && b[j].right <= x)
+      j++;
   }
+  return 1;
+}
+
+/* Fold the band just emitted at bandStart into the previous band when it
+ * continues it with the same spans. */
+static void dr_coalesce_band(DirtyRegion *out, uint16_t prevStart,
+                             uint16_t bandStart) {
+  uint16_t prevCount = (uint16_t)(bandStart - prevStart);
+  uint16_t i;
 
+  if (bandStart == prevStart || out->count - bandStart != prevCount)
+    return;
+  if (out->rects[prevStart].bottom != out->rects[bandStart].top)
+    return;
+  for (i = 0; i < prevCount; i++) {
+    if (out->rects[prevStart + i].left != out->rects[bandStart + i].left ||
+        out->rects[prevStart + i].right != out->rects[bandStart + i].right)
+      return;
+  }
+  for (i = 0; i < prevCount; i++)
+    out->rects[prevStart + i].bottom = out->rects[bandStart + i].bottom;
+  out->count = bandStart;
+}
+
+/*
+ * Walk the y-edges of both inputs once. Between consecutive edges each input
+ * has at most one band, so every slab is a single band_op over two sorted
+ * span lists.
+ */
+static Boolean dr_region_op(DirtyRegion *out, const DirtyRegion *a,
+                            const DirtyRegion *b, uint8_t op) {
+  uint16_t ai = 0;
+  uint16_t bi = 0;
+  uint16_t aEnd;
+  uint16_t bEnd;
+  uint16_t prevStart = 0;
+  uint16_t bandStart;
+  int16_t y;
+  int16_t yEnd;
+
+  if (!out || !a || !b || out == a || out == b)
+    return 0;
+
+  DR_RegionClear(out);
+  if (a->count == 0 && b->count == 0)
+    return 1;
+  if (a->count && (!b->count || a->rects[0].top < b->rects[0].top))
+    y = a->rects[0].top;
+  else
+    y = b->rects[0].top;
+
+  while (ai < a->count || bi < b->count) {
+    Boolean inA;
+    Boolean inB;
+
+    while (ai < a->count && a->rects[ai].bottom <= y)
+      ai = dr_band_end(a, ai);
+    while (bi < b->count && b->rects[bi].bottom <= y)
+      bi = dr_band_end(b, bi);
+    if (ai >= a->count && bi >= b->count)
+      break;
+
+    inA = (ai < a->count && a->rects[ai].top <= y) ? 1 : 0;
+    inB = (bi < b->count && b->rects[bi].top <= y) ? 1 : 0;
+    yEnd = 0x7fff;
+    if (ai < a->count)
+      yEnd = dr_min16(yEnd, inA ? a->rects[ai].bottom : a->rects[ai].top);
+    if (bi < b->count)
+      yEnd = dr_min16(yEnd, inB ? b->rects[bi].bottom : b->rects[bi].top);
+
+    if (inA || inB) {
+      aEnd = inA ? dr_band_end(a, ai) : ai;
+      bEnd = inB ? dr_band_end(b, bi) : bi;
+      bandStart = out->count;
+      if (!dr_band_op(out, &a->rects[ai], (uint16_t)(aEnd - ai),
+                      &b->rects[bi], (uint16_t)(bEnd - bi), y, yEnd, op))
+        return 0;
+      if (out->count != bandStart) {
+        dr_coalesce_band(out, prevStart, bandStart);
+        if (out->count != bandStart)
+          prevStart = bandStart;
+      }
+    }
+    y = yEnd;
+  }
   return 1;
 }
 
+Boolean DR_RegionUnion(DirtyRegion *out, const DirtyRegion *a,
+                       const DirtyRegion *b) {
+  return dr_region_op(out, a, b, DR_OP_UNION);
+}
+
+Boolean DR_RegionIntersect(DirtyRegion *out, const DirtyRegion *a,
+                           const DirtyRegion *b) {
+  return dr_region_op(out, a, b, DR_OP_INTERSECT);
+}
+
+Boolean DR_RegionSubtract(DirtyRegion *out, const DirtyRegion *a,
+                          const DirtyRegion *b) {
+  return dr_region_op(out, a, b, DR_OP_SUBTRACT);
+}
+
+/* Tiles touched by the region, as upload spans in VRAM order. */
+Boolean DR_BuildTileQueueFromRegion(const DirtyRegion *rgn,
+                                    DirtyTileQueue *queue,
+                                    uint16_t bytesPerTile) {
+  DirtyTileBitmap map;
+  uint16_t i;
+
+  if (!queue)
+    return 0;
+  if (!rgn) {
+    DR_ClearTileQueue(queue);
+    return 0;
+  }
+
+  DR_ClearTileBitmap(&map);
+  for (i = 0; i < rgn->count; i++)
+    DR_MarkTileBitmap(&map, &rgn->rects[i]);
+  return DR_BuildTileQueueFromBitmap(&map, queue, bytesPerTile);
+}
+
 DirtyTileUpload *DR_GetTileUpload(DirtyTileQueue *queue, uint8_t index) {
   if (!queue || !queue->items || index >= queue->count)
     return (DirtyTileUpload *)0;
   return &queue->items[index];
 }
 
+void DR_InitFillList(DirtyFillList *fills, DirtyTileFill *storage,
+                     uint8_t capacity) {
+  if (!fills)
+    return;
+
+  fills->items = storage;
+  fills->capacity = capacity;
+  DR_ClearFillList(fills);
+}
+
+void DR_ClearFillList(DirtyFillList *fills) {
+  if (!fills)
+    return;
+
+  fills->count = 0;
+  fills->tileCount = 0;
+  fills->overflow = 0;
+  fills->_pad = 0;
+}
+
+/* Read Word RAM 16 bits at a time on target, like the Main tile converter. */
+static uint16_t dr_read_fb_word(const uint8_t *p) {
+#if defined(SUB_CPU) || defined(MAIN_CPU)
+  return *(volatile const uint16_t *)p;
+#else
+  return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+#endif
+}
+
+/* Returns the tile's colour index, or 0xff when the 8x8 4bpp tile mixes
+ * colours. */
+static uint8_t dr_tile_solid_color(const uint8_t *linear, uint16_t bytesPerRow,
+                                   uint16_t planeTilesX, uint16_t tile) {
+  const uint8_t *row = linear +
+                       ((uint32_t)(tile / planeTilesX) * 8U * bytesPerRow) +
+                       ((uint32_t)(tile % planeTilesX) * 4U);
+  uint16_t first = dr_read_fb_word(row);
+  uint8_t r;
+
+  if (first != (uint16_t)((first & 0x000fU) * 0x1111U))
+    return 0xffU;
+
+  for (r = 0; r < 8; r++) {
+    if (dr_read_fb_word(row) != first || dr_read_fb_word(row + 2) != first)
+      return 0xffU;
+    row += bytesPerRow;
+  }
+
+  return (uint8_t)(first & 0x000fU);
+}
+
+static Boolean dr_push_fill(DirtyFillList *fills, uint16_t firstTile,
+                            uint16_t tileCount, uint8_t colorIndex) {
+  DirtyTileFill *last;
+
+  if (fills->count > 0) {
+    last = &fills->items[fills->count - 1];
+    if (last->colorIndex == colorIndex &&
+        (uint16_t)(last->firstTile + last->tileCount) == firstTile) {
+      last->tileCount = (uint16_t)(last->tileCount + tileCount);
+      fills->tileCount = (uint16_t)(fills->tileCount + tileCount);
+      return 1;
+    }
+  }
+
+  if (!fills->items || fills->count >= fills->capacity) {
+    fills->overflow = 1;
+    return 0;
+  }
+
+  last = &fills->items[fills->count++];
+  last->firstTile = firstTile;
+  last->tileCount = tileCount;
+  last->colorIndex = colorIndex;
+  last->_pad = 0;
+  fills->tileCount = (uint16_t)(fills->tileCount + tileCount);
+  return 1;
+}
+
+/*
+ * Split queued copy spans of a linear 4bpp framebuffer into solid-colour fill
+ * runs and the remaining copy spans. Runs shorter than minRunTiles stay copies
+ * because a fill pays the same DMA setup as a transfer. A full fill list also
+ * falls back to copies, so every input tile is still covered exactly once.
+ */
+Boolean DR_SplitSolidTileRuns(const DirtyTileQueue *in, const uint8_t *linear,
+                              uint16_t bytesPerRow, uint16_t planeTilesX,
+                              uint8_t minRunTiles, DirtyTileQueue *copies,
+                              DirtyFillList *fills) {
+  uint8_t i;
+
+  if (!copies || !fills)
+    return 0;
+
+  DR_ClearTileQueue(copies);
+  DR_ClearFillList(fills);
+
+  if (!in || !linear || bytesPerRow == 0 || planeTilesX == 0)
+    return 0;
+  if (in->count != 0 && !in->items)
+    return 0;
+  if (minRunTiles == 0)
+    minRunTiles = 1;
+
+  for (i = 0; i < in->count; i++) {
+    uint16_t tile = in->items[i].firstTile;
+    uint16_t end = (uint16_t)(tile + in->items[i].tileCount);
+    uint16_t copyStart = tile;
+
+    while (tile < end) {
+      uint8_t color =
+          dr_tile_solid_color(linear, bytesPerRow, planeTilesX, tile);
+      uint16_t runEnd = (uint16_t)(tile + 1U);
+
+      if (color == 0xffU) {
+        tile = runEnd;
+        continue;
+      }
+
+      while (runEnd < end && dr_tile_solid_color(linear, bytesPerRow,
+                                                 planeTilesX, runEnd) == color)
+        runEnd++;
+
+      if ((uint16_t)(runEnd - tile) >= minRunTiles &&
+          dr_push_fill(fills, tile, (uint16_t)(runEnd - tile), color)) {
+        if (copyStart < tile &&
+            !dr_queue_tile_span(copies, copyStart,
+                                (uint32_t)(tile - copyStart), 32U))
+          return 0;
+        copyStart = runEnd;
+      }
+      tile = runEnd;
+    }
+
+    if (copyStart < end &&
+        !dr_queue_tile_span(copies, copyStart, (uint32_t)(end - copyStart),
+                            32U))
+      return 0;
+  }
+
+  return 1;
+}
+
+void DR_SetDmaCost(const DirtyDmaCost *cost) {
+  if (!cost) {
+    drDmaCost.setupCycles = DR_DMA_SETUP_CYCLES_DEFAULT;
+    drDmaCost.cyclesPerByte = DR_DMA_CYCLES_PER_BYTE_DEFAULT;
+    return;
+  }
+
+  drDmaCost = *cost;
+}
+
+void DR_GetDmaCost(DirtyDmaCost *out) {
+  if (out)
+    *out = drDmaCost;
+}
+
+uint32_t DR_TileQueueCost(const DirtyTileQueue *queue,
+                          const DirtyDmaCost *cost) {
+  const DirtyDmaCost *model = cost ? cost : &drDmaCost;
+
+  if (!queue)
+    return 0;
+
+  return ((uint32_t)queue->count * model->setupCycles) +
+         ((uint32_t)queue->byteCount * model->cyclesPerByte);
+}
+
 void DR_PlanRootRedraw(const Rect *dirty, int16_t menuBarHeight,
                        DirtyRootRedraw *out) {
   Rect part;
@@ -424,25 +1127,50 @@ void DR_PlanWindowRedraw(const Rect *dirty, const Rect *windowBounds,
   }
 }
 
-static Boolean dr_rect_can_merge(const Rect *a, const Rect *b) {
+static uint32_t dr_rect_area(const Rect *r) {
+  return (uint32_t)(r->right - r->left) * (uint32_t)(r->bottom - r->top);
+}
+
+/* Area the union adds beyond the two inputs; negative when they overlap. */
+static int32_t dr_merge_waste(const Rect *a, const Rect *b) {
+  Rect merged;
+
+  DR_RectUnion(a, b, &merged);
+  return (int32_t)dr_rect_area(&merged) -
+         (int32_t)(dr_rect_area(a) + dr_rect_area(b));
+}
+
+static Boolean dr_rect_can_merge(const DirtyRectList *list, const Rect *a,
+                                 const Rect *b) {
   Boolean horizontalOverlap;
   Boolean verticalOverlap;
   Boolean horizontalTouch;
   Boolean verticalTouch;
+  int32_t waste;
 
   if (!a || !b)
     return 0;
 
-  if (DR_RectIntersect(a, b, (Rect *)0))
-    return 1;
-
   horizontalOverlap = (a->left < b->right && b->left < a->right) ? 1 : 0;
   verticalOverlap = (a->top < b->bottom && b->top < a->bottom) ? 1 : 0;
   horizontalTouch = (a->right == b->left || b->right == a->left) ? 1 : 0;
   verticalTouch = (a->bottom == b->top || b->bottom == a->top) ? 1 : 0;
 
-  return ((verticalOverlap && horizontalTouch) ||
-          (horizontalOverlap && verticalTouch))
+  if (!(horizontalOverlap && verticalOverlap) &&
+      !(verticalOverlap && horizontalTouch) &&
+      !(horizontalOverlap && verticalTouch))
+    return 0;
+
+  if (list->mergeWaste == DR_MERGE_WASTE_ANY)
+    return 1;
+
+  waste = dr_merge_waste(a, b);
+  if (waste <= 0)
+    return 1;
+  if (list->mergeWaste == 0)
+    return 0;
+  return ((uint32_t)waste * 100U / list->mergeWaste <=
+          dr_rect_area(a) + dr_rect_area(b))
              ? 1
              : 0;
 }
@@ -462,24 +1190,75 @@ static void dr_remove_at(DirtyRectList *list, uint8_t index) {
   }
 }
 
-static void dr_collapse_to_union(DirtyRectList *list, const Rect *r) {
-  Rect merged;
-  uint8_t i;
+/* Fold every rect that can now merge with items[index] into it. Returns the
+ * merged rect's index, which shifts down as earlier entries are removed. */
+static uint8_t dr_absorb_neighbours(DirtyRectList *list, uint8_t index) {
+  Boolean merged = 1;
+
+  while (merged) {
+    uint8_t j = 0;
+
+    merged = 0;
+    while (j < list->count) {
+      if (j != index && list->items[j].valid &&
+          dr_rect_can_merge(list, &list->items[index].rect,
+                            &list->items[j].rect)) {
+        DR_RectUnion(&list->items[index].rect, &list->items[j].rect,
+                     &list->items[index].rect);
+        dr_remove_at(list, j);
+        if (j < index)
+          index--;
+        merged = 1;
+      } else {
+        j++;
+      }
+    }
+  }
+  return index;
+}
 
-  if (!list || !list->items || list->capacity == 0 || !r)
-    return;
+/*
+ * The list is full and r merges with nothing: merge whichever pair, r
+ * included, grows the covered area least, instead of collapsing everything
+ * into one bounding box.
+ */
+static void dr_merge_cheapest_pair(DirtyRectList *list, const Rect *r) {
+  int32_t best;
+  int32_t waste;
+  uint8_t bestA = 0;
+  uint8_t bestB = list->count; /* count stands for r itself */
+  uint8_t i;
+  uint8_t j;
 
-  merged = *r;
+  best = dr_merge_waste(&list->items[0].rect, r);
   for (i = 0; i < list->count; i++) {
-    if (list->items[i].valid) {
-      DR_RectUnion(&merged, &list->items[i].rect, &merged);
+    waste = dr_merge_waste(&list->items[i].rect, r);
+    if (waste < best) {
+      best = waste;
+      bestA = i;
+      bestB = list->count;
+    }
+    for (j = (uint8_t)(i + 1); j < list->count; j++) {
+      waste = dr_merge_waste(&list->items[i].rect, &list->items[j].rect);
+      if (waste < best) {
+        best = waste;
+        bestA = i;
+        bestB = j;
+      }
     }
   }
 
-  DR_ClearList(list);
-  list->items[0].rect = merged;
-  list->items[0].valid = 1;
-  list->count = 1;
+  if (bestB == list->count) {
+    DR_RectUnion(&list->items[bestA].rect, r, &list->items[bestA].rect);
+  } else {
+    DR_RectUnion(&list->items[bestA].rect, &list->items[bestB].rect,
+                 &list->items[bestA].rect);
+    dr_remove_at(list, bestB);
+    list->items[list->count].rect = *r;
+    list->items[list->count].valid = 1;
+    list->count++;
+  }
+  dr_absorb_neighbours(list, bestA);
 }
 
 void DR_InitList(DirtyRectList *list, DirtyRect *storage, uint8_t capacity,
@@ -490,6 +1269,7 @@ void DR_InitList(DirtyRectList *list, DirtyRect *storage, uint8_t capacity,
   list->items = storage;
   list->capacity = capacity;
   list->count = 0;
+  list->mergeWaste = DR_MERGE_WASTE_DEFAULT;
   if (bounds) {
     list->bounds = *bounds;
   } else {
@@ -526,23 +1306,9 @@ Boolean DR_AddRect(DirtyRectList *list, const Rect *r) {
 
   for (i = 0; i < list->count; i++) {
     if (list->items[i].valid &&
-        dr_rect_can_merge(&list->items[i].rect, &clipped)) {
-      uint8_t j;
+        dr_rect_can_merge(list, &list->items[i].rect, &clipped)) {
       DR_RectUnion(&list->items[i].rect, &clipped, &list->items[i].rect);
-
-      j = 0;
-      while (j < list->count) {
-        if (j != i && list->items[j].valid &&
-            dr_rect_can_merge(&list->items[i].rect, &list->items[j].rect)) {
-          DR_RectUnion(&list->items[i].rect, &list->items[j].rect,
-                       &list->items[i].rect);
-          dr_remove_at(list, j);
-          if (j < i)
-            i--;
-        } else {
-          j++;
-        }
-      }
+      dr_absorb_neighbours(list, i);
       return 1;
     }
   }
@@ -554,10 +1320,15 @@ Boolean DR_AddRect(DirtyRectList *list, const Rect *r) {
     return 1;
   }
 
-  dr_collapse_to_union(list, &clipped);
+  dr_merge_cheapest_pair(list, &clipped);
   return 1;
 }
 
+void DR_SetMergeWaste(DirtyRectList *list, uint16_t wastePercent) {
+  if (list)
+    list->mergeWaste = wastePercent;
+}
+
 uint8_t DR_GetCount(const DirtyRectList *list) {
   if (!list)
     return 0;
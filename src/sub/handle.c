@@ -0,0 +1,256 @@
+/*
+ * handle.c - Relocatable Handles
+ *
+ * Master pointers live in a fixed table so a Handle never changes while
+ * the block it names moves. Every handle block begins with a back-link
+ * to its master pointer: MEM_Compact() offers each block to
+ * hnd_relocate(), which moves it only if that link leads to a master
+ * pointer aimed right back at the block and the handle is unlocked.
+ */
+
+#include "handle.h"
+
+/* Hidden back-link in front of each handle's data */
+#define HND_PREFIX ((uint32_t)sizeof(MasterPointer *))
+#define HND_BACKLINK(data) (*(MasterPointer **)(data))
+
+static struct {
+  MasterPointer masters[HND_MASTER_COUNT];
+  uint32_t compactions;
+  uint32_t bytesMoved;
+  uint32_t purged;
+} hnd;
+
+/* ============================================================
+ * Internal: Master pointers
+ * ============================================================ */
+
+/* The table entry a pointer names, or NULL if it names none */
+static MasterPointer *hnd_entry(const void *p) {
+  uintptr_t offset = (uintptr_t)p - (uintptr_t)hnd.masters;
+
+  if ((uintptr_t)p < (uintptr_t)hnd.masters ||
+      offset >= sizeof(hnd.masters) || offset % sizeof(MasterPointer))
+    return (MasterPointer *)0;
+  return &hnd.masters[offset / sizeof(MasterPointer)];
+}
+
+static MasterPointer *hnd_live(Handle h) {
+  MasterPointer *mp = hnd_entry(h);
+
+  if (!mp || !(mp->flags & HND_FLAG_USED))
+    return (MasterPointer *)0;
+  return mp;
+}
+
+static uint8_t *hnd_block(const MasterPointer *mp) {
+  return (uint8_t *)mp->ptr - HND_PREFIX;
+}
+
+/* Give an entry a fresh block of 'size' bytes */
+static int8_t hnd_fill(MasterPointer *mp, uint32_t size) {
+  uint8_t *data = (uint8_t *)MEM_Alloc(size + HND_PREFIX);
+
+  if (!data)
+    return -1;
+  HND_BACKLINK(data) = mp;
+  mp->ptr = data + HND_PREFIX;
+  mp->size = size;
+  return 0;
+}
+
+static void hnd_empty(MasterPointer *mp) {
+  if (mp->ptr)
+    MEM_Free(hnd_block(mp));
+  mp->ptr = (void *)0;
+  mp->size = 0;
+}
+
+/* ============================================================
+ * Internal: Heap hooks
+ * ============================================================ */
+
+static uint8_t hnd_relocate(void *data, void *newData, void *user) {
+  MasterPointer *mp = hnd_entry(HND_BACKLINK(data));
+
+  (void)user;
+  if (!mp || !(mp->flags & HND_FLAG_USED) ||
+      mp->ptr != (uint8_t *)data + HND_PREFIX ||
+      (mp->flags & HND_FLAG_LOCKED))
+    return 0;
+
+  mp->ptr = (uint8_t *)newData + HND_PREFIX;
+  return 1;
+}
+
+/* Compact first; purge caches only if that left no room */
+static uint8_t hnd_grow_zone(uint32_t size, void *user) {
+  MemStats stats;
+  uint32_t moved;
+  uint32_t purged;
+
+  (void)user;
+  moved = HND_Compact();
+  MEM_GetStats(&stats);
+  if (stats.largestFree >= size)
+    return 1;
+
+  purged = HND_Purge();
+  if (purged)
+    HND_Compact();
+  return (uint8_t)(moved || purged);
+}
+
+/* ============================================================
+ * Public API
+ * ============================================================ */
+
+void HND_Init(void) {
+  uint16_t i;
+
+  for (i = 0; i < HND_MASTER_COUNT; i++) {
+    hnd.masters[i].ptr = (void *)0;
+    hnd.masters[i].size = 0;
+    hnd.masters[i].flags = 0;
+  }
+  hnd.compactions = 0;
+  hnd.bytesMoved = 0;
+  hnd.purged = 0;
+  MEM_SetGrowZone(hnd_grow_zone, (void *)0);
+}
+
+Handle HND_New(uint32_t size) {
+  MasterPointer *mp = (MasterPointer *)0;
+  uint16_t i;
+
+  if (size == 0)
+    return (Handle)0;
+
+  for (i = 0; i < HND_MASTER_COUNT; i++) {
+    if (!(hnd.masters[i].flags & HND_FLAG_USED)) {
+      mp = &hnd.masters[i];
+      break;
+    }
+  }
+  if (!mp || hnd_fill(mp, size) != 0)
+    return (Handle)0;
+
+  mp->flags = HND_FLAG_USED;
+  return &mp->ptr;
+}
+
+void HND_Dispose(Handle h) {
+  MasterPointer *mp = hnd_live(h);
+
+  if (!mp)
+    return;
+  hnd_empty(mp);
+  mp->flags = 0;
+}
+
+uint32_t HND_GetSize(Handle h) {
+  MasterPointer *mp = hnd_live(h);
+
+  return mp ? mp->size : 0;
+}
+
+int8_t HND_SetSize(Handle h, uint32_t size) {
+  MasterPointer *mp = hnd_live(h);
+  uint8_t wasLocked;
+  uint8_t *data;
+
+  if (!mp)
+    return -1;
+  if (size == 0) {
+    hnd_empty(mp);
+    return 0;
+  }
+  if (!mp->ptr)
+    return hnd_fill(mp, size);
+
+  /* Lock across the resize: the grow zone may compact, and the block
+   * being copied from must not move underneath MEM_Realloc() */
+  wasLocked = mp->flags & HND_FLAG_LOCKED;
+  mp->flags |= HND_FLAG_LOCKED;
+  data = (uint8_t *)MEM_Realloc(hnd_block(mp), size + HND_PREFIX);
+  if (!wasLocked)
+    mp->flags &= (uint8_t)~HND_FLAG_LOCKED;
+  if (!data)
+    return -1;
+
+  mp->ptr = data + HND_PREFIX;
+  mp->size = size;
+  return 0;
+}
+
+void HND_Lock(Handle h) {
+  MasterPointer *mp = hnd_live(h);
+
+  if (mp)
+    mp->flags |= HND_FLAG_LOCKED;
+}
+
+void HND_Unlock(Handle h) {
+  MasterPointer *mp = hnd_live(h);
+
+  if (mp)
+    mp->flags &= (uint8_t)~HND_FLAG_LOCKED;
+}
+
+void HND_SetPurgeable(Handle h, uint8_t purgeable) {
+  MasterPointer *mp = hnd_live(h);
+
+  if (!mp)
+    return;
+  if (purgeable)
+    mp->flags |= HND_FLAG_PURGEABLE;
+  else
+    mp->flags &= (uint8_t)~HND_FLAG_PURGEABLE;
+}
+
+uint32_t HND_Compact(void) {
+  uint32_t moved = MEM_Compact(hnd_relocate, (void *)0);
+
+  hnd.compactions++;
+  hnd.bytesMoved += moved;
+  return moved;
+}
+
+uint32_t HND_Purge(void) {
+  uint32_t released = 0;
+  uint16_t i;
+
+  for (i = 0; i < HND_MASTER_COUNT; i++) {
+    MasterPointer *mp = &hnd.masters[i];
+
+    if ((mp->flags & (HND_FLAG_USED | HND_FLAG_LOCKED |
+                      HND_FLAG_PURGEABLE)) !=
+            (HND_FLAG_USED | HND_FLAG_PURGEABLE) ||
+        !mp->ptr)
+      continue;
+    released += mp->size;
+    hnd_empty(mp);
+    hnd.purged++;
+  }
+  return released;
+}
+
+void HND_GetStats(HndStats *stats) {
+  uint16_t i;
+
+  if (!stats)
+    return;
+
+  stats->handles = 0;
+  stats->locked = 0;
+  for (i = 0; i < HND_MASTER_COUNT; i++) {
+    if (hnd.masters[i].flags & HND_FLAG_USED) {
+      stats->handles++;
+      if (hnd.masters[i].flags & HND_FLAG_LOCKED)
+        stats->locked++;
+    }
+  }
+  stats->compactions = hnd.compactions;
+  stats->bytesMoved = hnd.bytesMoved;
+  stats->purged = hnd.purged;
+}
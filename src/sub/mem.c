@@ -1,25 +1,39 @@
 /*
- * mem.c - First-Fit Free List Memory Allocator
+ * mem.c - Segregated-Fit Memory Allocator
  *
  * Manages a contiguous heap region in PRG-RAM.
- * Adjacent free blocks are coalesced on every free().
+ * Free blocks are kept on one list per size class; a first-level bitmap
+ * (one bit per power of two) and second-level bitmaps (one bit per class)
+ * locate the smallest non-empty class that fits without walking lists.
+ * Lists are doubly linked and free blocks carry size footers, so freeing
+ * merges with both physical neighbours and unlinks them in constant time.
  * All allocations are 4-byte aligned.
  */
 
 #include "mem.h"
-#include <string.h> /* memset, memcpy */
+#include <string.h> /* memset, memcpy, memmove */
 
 /* ============================================================
  * Heap State
  * ============================================================ */
 static struct {
-  BlockHeader *freeList; /* Head of the free list           */
-  uint8_t *heapStart;    /* First byte of heap              */
-  uint8_t *heapEnd;      /* One past last byte of heap      */
-  uint32_t heapSize;     /* Total heap size                 */
-  uint32_t freeBytes;    /* Current free bytes (fast query) */
+  BlockHeader *classes[MEM_FL_COUNT][MEM_SL_COUNT]; /* Free lists */
+  uint32_t flBitmap;                 /* Bit n: class row n non-empty */
+  uint8_t slBitmap[MEM_FL_COUNT];    /* Bit m: classes[n][m] non-empty */
+  uint8_t *heapStart;                /* First byte of heap              */
+  uint8_t *heapEnd;                  /* One past last byte of heap      */
+  uint32_t heapSize;                 /* Total heap size                 */
+  uint32_t freeBytes;                /* Current free bytes (fast query) */
   uint32_t totalAllocs;
   uint32_t totalFrees;
+  uint32_t searchSteps;
+  uint32_t usedBytes; /* Telemetry, see MemTelemetry */
+  uint32_t highWater;
+  uint32_t failedAllocs;
+  uint32_t sizeHistogram[MEM_HIST_BINS];
+  MemGrowZoneFn growZone; /* Called before MEM_Alloc() fails  */
+  void *growZoneUser;
+  uint8_t inGrowZone;
   uint8_t initialized;
 } heap;
 
@@ -30,6 +44,176 @@ static uint32_t align_up(uint32_t size) {
   return (size + (MEM_ALIGN - 1)) & ~(MEM_ALIGN - 1);
 }
 
+/* ============================================================
+ * Internal: Size classes
+ * ============================================================ */
+
+/* Index of the highest set bit of a non-zero value. The 68000 has no
+ * bit-scan instruction, so this is a fixed five-step binary search. */
+static uint8_t msb32(uint32_t x) {
+  uint8_t n = 0;
+
+  if (x & 0xFFFF0000UL) {
+    n += 16;
+    x >>= 16;
+  }
+  if (x & 0xFF00U) {
+    n += 8;
+    x >>= 8;
+  }
+  if (x & 0xF0U) {
+    n += 4;
+    x >>= 4;
+  }
+  if (x & 0x0CU) {
+    n += 2;
+    x >>= 2;
+  }
+  if (x & 0x02U)
+    n += 1;
+  return n;
+}
+
+/* Index of the lowest set bit of a non-zero value */
+static uint8_t lsb32(uint32_t x) { return msb32(x & (~x + 1U)); }
+
+static void size_class(uint32_t size, uint8_t *fl, uint8_t *sl) {
+  if (size < MEM_SMALL_BLOCK) {
+    *fl = 0;
+    *sl = (uint8_t)(size / (MEM_SMALL_BLOCK / MEM_SL_COUNT));
+  } else {
+    uint8_t top = msb32(size);
+    *fl = (uint8_t)(top - MEM_FL_SHIFT + 1);
+    *sl = (uint8_t)((size >> (top - MEM_SL_LOG2)) & (MEM_SL_COUNT - 1));
+  }
+}
+
+/* Round a request up to the next class boundary, so every block filed
+ * in the class it maps to is big enough */
+static uint32_t class_round_up(uint32_t size) {
+  if (size < MEM_SMALL_BLOCK)
+    return size + (MEM_SMALL_BLOCK / MEM_SL_COUNT - 1);
+  return size + (1UL << (msb32(size) - MEM_SL_LOG2)) - 1;
+}
+
+/* Telemetry histogram bin of a requested size */
+static uint8_t size_bin(uint32_t size) {
+  uint8_t top;
+
+  if (size < 16)
+    return 0;
+  top = msb32(size);
+  return (uint8_t)(top - 3 < MEM_HIST_BINS ? top - 3 : MEM_HIST_BINS - 1);
+}
+
+static void note_used(uint32_t before, uint32_t after) {
+  heap.usedBytes = heap.usedBytes - before + after;
+  if (heap.usedBytes > heap.highWater)
+    heap.highWater = heap.usedBytes;
+}
+
+/* ============================================================
+ * Internal: Boundary tags
+ * ============================================================ */
+
+/* Tag a block free: footer, and the prev-free bit of the block after it */
+static void tag_free(BlockHeader *blk) {
+  BlockHeader *after = BLK_NEXT_ADJ(blk);
+
+  BLK_SET_FREE(blk);
+  BLK_FOOTER(blk) = BLK_SIZE(blk);
+  if ((uint8_t *)after < heap.heapEnd)
+    after->sizeAndFlags |= MEM_FLAG_PREV_FREE;
+}
+
+static void tag_used(BlockHeader *blk) {
+  BlockHeader *after = BLK_NEXT_ADJ(blk);
+
+  BLK_SET_USED(blk);
+  if ((uint8_t *)after < heap.heapEnd)
+    after->sizeAndFlags &= ~(uint32_t)MEM_FLAG_PREV_FREE;
+}
+
+/* ============================================================
+ * Internal: Class lists
+ * ============================================================ */
+
+static void class_insert(BlockHeader *blk) {
+  BlockHeader *head;
+  uint8_t fl, sl;
+
+  size_class(BLK_SIZE(blk), &fl, &sl);
+  head = heap.classes[fl][sl];
+  blk->next = head;
+  BLK_PREV_LINK(blk) = (BlockHeader *)0;
+  if (head)
+    BLK_PREV_LINK(head) = blk;
+  heap.classes[fl][sl] = blk;
+  heap.flBitmap |= 1UL << fl;
+  heap.slBitmap[fl] |= (uint8_t)(1U << sl);
+}
+
+/* Take a free block off classes[fl][sl] */
+static BlockHeader *class_unlink(BlockHeader *blk, uint8_t fl, uint8_t sl) {
+  BlockHeader *before = BLK_PREV_LINK(blk);
+
+  if (before)
+    before->next = blk->next;
+  else
+    heap.classes[fl][sl] = blk->next;
+  if (blk->next)
+    BLK_PREV_LINK(blk->next) = before;
+  blk->next = (BlockHeader *)0;
+
+  if (!heap.classes[fl][sl]) {
+    heap.slBitmap[fl] &= (uint8_t)~(1U << sl);
+    if (!heap.slBitmap[fl])
+      heap.flBitmap &= ~(1UL << fl);
+  }
+  return blk;
+}
+
+/* Take a known free block off its class list */
+static void class_remove(BlockHeader *blk) {
+  uint8_t fl, sl;
+
+  size_class(BLK_SIZE(blk), &fl, &sl);
+  class_unlink(blk, fl, sl);
+}
+
+/* Unlink and return a free block of at least `needed` bytes */
+static BlockHeader *class_find(uint32_t needed) {
+  BlockHeader *blk;
+  uint8_t fl, sl;
+
+  size_class(class_round_up(needed), &fl, &sl);
+  if (fl < MEM_FL_COUNT) {
+    uint32_t slMap = heap.slBitmap[fl] & (0xFFU << sl);
+
+    if (!slMap) {
+      uint32_t flMap = heap.flBitmap & ~((2UL << fl) - 1);
+      if (flMap) {
+        fl = lsb32(flMap);
+        slMap = heap.slBitmap[fl];
+      }
+    }
+    if (slMap) {
+      sl = lsb32(slMap);
+      return class_unlink(heap.classes[fl][sl], fl, sl);
+    }
+  }
+
+  /* Nothing in a larger class; the request's own class may still hold a
+   * block that fits */
+  size_class(needed, &fl, &sl);
+  for (blk = heap.classes[fl][sl]; blk; blk = blk->next) {
+    heap.searchSteps++;
+    if (BLK_SIZE(blk) >= needed)
+      return class_unlink(blk, fl, sl);
+  }
+  return (BlockHeader *)0;
+}
+
 /* ============================================================
  * MEM_Init
  * ============================================================ */
@@ -42,29 +226,42 @@ int8_t MEM_Init(void *heapStart, void *heapEnd) {
 
   /* Align start up, end down */
   heap.heapStart =
-      (uint8_t *)(((uint32_t)heapStart + (MEM_ALIGN - 1)) & ~(MEM_ALIGN - 1));
-  heap.heapEnd = (uint8_t *)((uint32_t)heapEnd & ~(MEM_ALIGN - 1));
+      (uint8_t *)(((uintptr_t)heapStart + (MEM_ALIGN - 1)) & ~(MEM_ALIGN - 1));
+  heap.heapEnd = (uint8_t *)((uintptr_t)heapEnd & ~(MEM_ALIGN - 1));
 
   if (heap.heapEnd <= heap.heapStart)
     return -1;
 
   totalSize = (uint32_t)(heap.heapEnd - heap.heapStart);
 
-  /* Need at least one header + MEM_MIN_SPLIT usable bytes */
-  if (totalSize < sizeof(BlockHeader) + MEM_MIN_SPLIT)
+  /* Need at least one header + MEM_MIN_SPLIT usable bytes, and every
+   * block size must map to a class */
+  if (totalSize < sizeof(BlockHeader) + MEM_MIN_SPLIT ||
+      totalSize >= (1UL << (MEM_FL_SHIFT + MEM_FL_COUNT - 1)))
     return -1;
 
   heap.heapSize = totalSize;
+  memset(heap.classes, 0, sizeof(heap.classes));
+  memset(heap.slBitmap, 0, sizeof(heap.slBitmap));
+  heap.flBitmap = 0;
 
   /* Create one big free block spanning the entire heap */
   first = (BlockHeader *)heap.heapStart;
   first->sizeAndFlags = totalSize; /* All flag bits clear = free */
-  first->next = (BlockHeader *)0;
+  tag_free(first);
+  class_insert(first);
 
-  heap.freeList = first;
   heap.freeBytes = totalSize - sizeof(BlockHeader);
   heap.totalAllocs = 0;
   heap.totalFrees = 0;
+  heap.searchSteps = 0;
+  heap.usedBytes = 0;
+  heap.highWater = 0;
+  heap.failedAllocs = 0;
+  memset(heap.sizeHistogram, 0, sizeof(heap.sizeHistogram));
+  heap.growZone = (MemGrowZoneFn)0;
+  heap.growZoneUser = (void *)0;
+  heap.inGrowZone = 0;
   heap.initialized = 1;
 
   return 0;
@@ -74,70 +271,55 @@ int8_t MEM_Init(void *heapStart, void *heapEnd) {
  * MEM_Alloc
  * ============================================================ */
 void *MEM_Alloc(uint32_t size) {
-  BlockHeader *curr, *prev;
+  BlockHeader *blk;
   uint32_t needed;
+  uint32_t remainder;
 
   if (!heap.initialized || size == 0)
     return (void *)0;
+  if (size >= heap.heapSize) {
+    heap.failedAllocs++;
+    return (void *)0;
+  }
 
   /* Align requested size, add header overhead */
   needed = align_up(size) + sizeof(BlockHeader);
-  if (needed < sizeof(BlockHeader) + MEM_ALIGN)
-    needed = sizeof(BlockHeader) + MEM_ALIGN;
-
-  /* First-fit: walk the free list */
-  prev = (BlockHeader *)0;
-  curr = heap.freeList;
-
-  while (curr) {
-    uint32_t blockSize = BLK_SIZE(curr);
-
-    if (blockSize >= needed) {
-      /* Check if we can split this block */
-      uint32_t remainder = blockSize - needed;
-
-      if (remainder >= sizeof(BlockHeader) + MEM_MIN_SPLIT) {
-        /* Split: create a new free block after the allocation */
-        BlockHeader *newFree = (BlockHeader *)((uint8_t *)curr + needed);
-        newFree->sizeAndFlags = remainder; /* flags = 0 = free */
-        newFree->next = curr->next;
-
-        /* Update current block to allocated size */
-        curr->sizeAndFlags = needed;
-        BLK_SET_USED(curr);
-        curr->next = (BlockHeader *)0;
-
-        /* Replace curr with newFree in free list */
-        if (prev)
-          prev->next = newFree;
-        else
-          heap.freeList = newFree;
-
-        heap.freeBytes -= needed;
-      } else {
-        /* Use entire block (no split) */
-        BLK_SET_USED(curr);
-
-        /* Remove from free list */
-        if (prev)
-          prev->next = curr->next;
-        else
-          heap.freeList = curr->next;
-        curr->next = (BlockHeader *)0;
-
-        heap.freeBytes -= blockSize;
-      }
-
-      heap.totalAllocs++;
-      return BLK_DATA(curr);
-    }
+  if (needed < MEM_MIN_BLOCK)
+    needed = align_up(MEM_MIN_BLOCK);
+
+  blk = class_find(needed);
+  if (!blk && heap.growZone && !heap.inGrowZone) {
+    uint8_t retry;
+
+    heap.inGrowZone = 1;
+    retry = heap.growZone(size, heap.growZoneUser);
+    heap.inGrowZone = 0;
+    if (retry)
+      blk = class_find(needed);
+  }
+  if (!blk) {
+    heap.failedAllocs++;
+    return (void *)0;
+  }
 
-    prev = curr;
-    curr = curr->next;
+  heap.freeBytes -= BLK_SIZE(blk) - sizeof(BlockHeader);
+
+  /* Split off the tail if it can stand as a block of its own */
+  remainder = BLK_SIZE(blk) - needed;
+  if (remainder >= sizeof(BlockHeader) + MEM_MIN_SPLIT) {
+    BlockHeader *rest = (BlockHeader *)((uint8_t *)blk + needed);
+    BLK_SET_SIZE(blk, needed);
+    rest->sizeAndFlags = remainder;
+    tag_free(rest);
+    class_insert(rest);
+    heap.freeBytes += remainder - sizeof(BlockHeader);
   }
 
-  /* No suitable block found */
-  return (void *)0;
+  tag_used(blk);
+  heap.totalAllocs++;
+  heap.sizeHistogram[size_bin(size)]++;
+  note_used(0, BLK_SIZE(blk));
+  return BLK_DATA(blk);
 }
 
 /* ============================================================
@@ -162,9 +344,9 @@ void *MEM_AllocZero(uint32_t count, uint32_t size) {
  * MEM_Free
  * ============================================================ */
 void MEM_Free(void *ptr) {
-  BlockHeader *block, *curr, *prev;
+  BlockHeader *block;
   BlockHeader *adjNext;
-  uint8_t *blockEnd;
+  BlockHeader *adjPrev;
 
   if (!ptr || !heap.initialized)
     return;
@@ -177,50 +359,30 @@ void MEM_Free(void *ptr) {
     return; /* Bad pointer or double-free */
   }
 
-  /* Mark as free */
-  BLK_SET_FREE(block);
-  heap.freeBytes += BLK_SIZE(block);
+  heap.freeBytes += BLK_SIZE(block) - sizeof(BlockHeader);
   heap.totalFrees++;
-
-  /* Insert into free list in address order (needed for coalescing).
-   * Walk the list to find the correct insertion point. */
-  prev = (BlockHeader *)0;
-  curr = heap.freeList;
-
-  while (curr && curr < block) {
-    prev = curr;
-    curr = curr->next;
-  }
-
-  /* Insert block between prev and curr */
-  block->next = curr;
-  if (prev)
-    prev->next = block;
-  else
-    heap.freeList = block;
+  note_used(BLK_SIZE(block), 0);
 
   /* Coalesce with next adjacent block if it's free */
-  blockEnd = (uint8_t *)block + BLK_SIZE(block);
-  if (blockEnd < heap.heapEnd) {
-    adjNext = (BlockHeader *)blockEnd;
-    if (BLK_IS_FREE(adjNext) && adjNext == curr) {
-      /* Merge block with curr */
-      BLK_SET_SIZE(block, BLK_SIZE(block) + BLK_SIZE(adjNext));
-      block->next = adjNext->next;
-      heap.freeBytes += sizeof(BlockHeader); /* Reclaim header */
-    }
+  adjNext = BLK_NEXT_ADJ(block);
+  if ((uint8_t *)adjNext < heap.heapEnd && BLK_IS_FREE(adjNext)) {
+    class_remove(adjNext);
+    BLK_SET_SIZE(block, BLK_SIZE(block) + BLK_SIZE(adjNext));
+    heap.freeBytes += sizeof(BlockHeader); /* Reclaim header */
   }
 
-  /* Coalesce with previous adjacent block if it's free */
-  if (prev) {
-    uint8_t *prevEnd = (uint8_t *)prev + BLK_SIZE(prev);
-    if (prevEnd == (uint8_t *)block) {
-      /* Merge prev with block */
-      BLK_SET_SIZE(prev, BLK_SIZE(prev) + BLK_SIZE(block));
-      prev->next = block->next;
-      heap.freeBytes += sizeof(BlockHeader); /* Reclaim header */
-    }
+  /* Coalesce with previous adjacent block, found through its footer */
+  if (BLK_PREV_IS_FREE(block)) {
+    adjPrev = BLK_PREV_ADJ(block);
+    class_remove(adjPrev);
+    BLK_SET_SIZE(adjPrev, BLK_SIZE(adjPrev) + BLK_SIZE(block));
+    heap.freeBytes += sizeof(BlockHeader); /* Reclaim header */
+    block = adjPrev;
   }
+
+  /* Mark as free */
+  tag_free(block);
+  class_insert(block);
 }
 
 /* ============================================================
@@ -249,58 +411,33 @@ void *MEM_Realloc(void *ptr, uint32_t newSize) {
 
   /* Try to expand into adjacent free block */
   {
-    uint8_t *blockEnd = (uint8_t *)block + BLK_SIZE(block);
-    if (blockEnd < heap.heapEnd) {
-      BlockHeader *adjNext = (BlockHeader *)blockEnd;
-      if (BLK_IS_FREE(adjNext)) {
-        uint32_t combined = BLK_SIZE(block) + BLK_SIZE(adjNext);
-        uint32_t needed = align_up(newSize) + sizeof(BlockHeader);
-
-        if (combined >= needed) {
-          /* Remove adjNext from free list */
-          BlockHeader *fprev = (BlockHeader *)0;
-          BlockHeader *fcurr = heap.freeList;
-          while (fcurr && fcurr != adjNext) {
-            fprev = fcurr;
-            fcurr = fcurr->next;
-          }
-          if (fcurr == adjNext) {
-            if (fprev)
-              fprev->next = adjNext->next;
-            else
-              heap.freeList = adjNext->next;
-          }
-
-          heap.freeBytes -= BLK_SIZE(adjNext);
-
-          /* Check if we should split the combined block */
-          uint32_t remainder = combined - needed;
-          if (remainder >= sizeof(BlockHeader) + MEM_MIN_SPLIT) {
-            BLK_SET_SIZE(block, needed);
-            BlockHeader *split = (BlockHeader *)((uint8_t *)block + needed);
-            split->sizeAndFlags = remainder;
-            split->next = (BlockHeader *)0;
-
-            /* Insert split block into free list */
-            BlockHeader *sp = (BlockHeader *)0;
-            BlockHeader *sc = heap.freeList;
-            while (sc && sc < split) {
-              sp = sc;
-              sc = sc->next;
-            }
-            split->next = sc;
-            if (sp)
-              sp->next = split;
-            else
-              heap.freeList = split;
-
-            heap.freeBytes += remainder;
-          } else {
-            BLK_SET_SIZE(block, combined);
-          }
-
-          return ptr; /* Same address, block is now bigger */
+    BlockHeader *adjNext = BLK_NEXT_ADJ(block);
+    if ((uint8_t *)adjNext < heap.heapEnd && BLK_IS_FREE(adjNext)) {
+      uint32_t combined = BLK_SIZE(block) + BLK_SIZE(adjNext);
+      uint32_t needed = align_up(newSize) + sizeof(BlockHeader);
+
+      if (combined >= needed) {
+        uint32_t remainder = combined - needed;
+        uint32_t oldSize = BLK_SIZE(block);
+
+        class_remove(adjNext);
+        heap.freeBytes -= BLK_SIZE(adjNext) - sizeof(BlockHeader);
+
+        /* Check if we should split the combined block */
+        if (remainder >= sizeof(BlockHeader) + MEM_MIN_SPLIT) {
+          BlockHeader *split = (BlockHeader *)((uint8_t *)block + needed);
+          BLK_SET_SIZE(block, needed);
+          split->sizeAndFlags = remainder;
+          tag_free(split);
+          class_insert(split);
+          heap.freeBytes += remainder - sizeof(BlockHeader);
+        } else {
+          BLK_SET_SIZE(block, combined);
+          tag_used(block);
         }
+        note_used(oldSize, BLK_SIZE(block));
+
+        return ptr; /* Same address, block is now bigger */
       }
     }
   }
@@ -330,6 +467,7 @@ void MEM_GetStats(MemStats *stats) {
   stats->heapSize = heap.heapSize;
   stats->totalAllocs = heap.totalAllocs;
   stats->totalFrees = heap.totalFrees;
+  stats->searchSteps = heap.searchSteps;
 
   if (!heap.initialized)
     return;
@@ -362,12 +500,16 @@ void MEM_GetStats(MemStats *stats) {
 int8_t MEM_Validate(void) {
   BlockHeader *blk;
   uint32_t totalSize = 0;
+  uint32_t freeData = 0;
+  uint32_t usedSize = 0;
   uint16_t freeCount = 0;
+  uint8_t prevFree = 0;
+  uint8_t fl, sl;
 
   if (!heap.initialized)
     return -1;
 
-  /* Walk all blocks checking size chains */
+  /* Walk all blocks checking size chains and boundary tags */
   blk = (BlockHeader *)heap.heapStart;
   while ((uint8_t *)blk < heap.heapEnd) {
     uint32_t size = BLK_SIZE(blk);
@@ -384,31 +526,67 @@ int8_t MEM_Validate(void) {
     if (size < sizeof(BlockHeader))
       return -1;
 
-    if (BLK_IS_FREE(blk))
+    /* The prev-free bit must match the block before */
+    if ((BLK_PREV_IS_FREE(blk) ? 1 : 0) != prevFree)
+      return -1;
+
+    if (BLK_IS_FREE(blk)) {
+      /* Footer must repeat the size, and free() leaves no two free
+       * blocks side by side */
+      if (size < MEM_MIN_BLOCK || BLK_FOOTER(blk) != size || prevFree)
+        return -1;
       freeCount++;
+      freeData += size - sizeof(BlockHeader);
+    } else {
+      usedSize += size;
+    }
+    prevFree = BLK_IS_FREE(blk) ? 1 : 0;
 
     totalSize += size;
     blk = (BlockHeader *)((uint8_t *)blk + size);
   }
 
   /* Total sizes must equal heap size */
-  if (totalSize != heap.heapSize)
+  if (totalSize != heap.heapSize || freeData != heap.freeBytes ||
+      usedSize != heap.usedBytes)
     return -1;
 
-  /* Verify free list: each entry must be within heap and marked free */
-  blk = heap.freeList;
-  while (blk) {
-    if ((uint8_t *)blk < heap.heapStart || (uint8_t *)blk >= heap.heapEnd)
+  /* Verify class lists: each entry within heap, free and filed under its
+   * own class, and the bitmaps marking exactly the non-empty lists */
+  for (fl = 0; fl < MEM_FL_COUNT; fl++) {
+    if (((heap.flBitmap >> fl) & 1U) != (heap.slBitmap[fl] ? 1U : 0U))
       return -1;
 
-    if (BLK_IS_USED(blk))
-      return -1;
+    for (sl = 0; sl < MEM_SL_COUNT; sl++) {
+      if (((heap.slBitmap[fl] >> sl) & 1U) !=
+          (heap.classes[fl][sl] ? 1U : 0U))
+        return -1;
+
+      BlockHeader *before = (BlockHeader *)0;
 
-    freeCount--;
-    blk = blk->next;
+      for (blk = heap.classes[fl][sl]; blk; blk = blk->next) {
+        uint8_t blkFl, blkSl;
+
+        if ((uint8_t *)blk < heap.heapStart ||
+            (uint8_t *)blk >= heap.heapEnd)
+          return -1;
+
+        if (BLK_IS_USED(blk) || BLK_PREV_LINK(blk) != before)
+          return -1;
+        before = blk;
+
+        size_class(BLK_SIZE(blk), &blkFl, &blkSl);
+        if (blkFl != fl || blkSl != sl)
+          return -1;
+
+        if (freeCount == 0)
+          return -1; /* Listed more often than free, or a cycle */
+        freeCount--;
+      }
+    }
   }
 
-  /* Free list count must match linear walk count */
+  /* Class list count must match linear walk count */
   if (freeCount != 0)
     return -1;
 
@@ -419,3 +597,170 @@ int8_t MEM_Validate(void) {
  * MEM_GetFreeBytes
  * ============================================================ */
 uint32_t MEM_GetFreeBytes(void) { return heap.freeBytes; }
+
+/* ============================================================
+ * MEM_GetTelemetry
+ * ============================================================ */
+void MEM_GetTelemetry(MemTelemetry *telemetry) {
+  BlockHeader *blk;
+  uint32_t largest = 0;
+
+  if (!telemetry)
+    return;
+
+  /* Every block in the top non-empty class outsizes every other free
+   * block, so only that one list is walked */
+  if (heap.initialized && heap.flBitmap) {
+    uint8_t fl = msb32(heap.flBitmap);
+    uint8_t sl = msb32(heap.slBitmap[fl]);
+
+    for (blk = heap.classes[fl][sl]; blk; blk = blk->next) {
+      if (BLK_SIZE(blk) > largest)
+        largest = BLK_SIZE(blk);
+    }
+    largest -= sizeof(BlockHeader);
+  }
+
+  telemetry->heapSize = heap.heapSize;
+  telemetry->usedBytes = heap.usedBytes;
+  telemetry->highWater = heap.highWater;
+  telemetry->largestFree = largest;
+  telemetry->failedAllocs = heap.failedAllocs;
+  memcpy(telemetry->sizeHistogram, heap.sizeHistogram,
+         sizeof(heap.sizeHistogram));
+}
+
+/* ============================================================
+ * MEM_PackTelemetry
+ * ============================================================ */
+static void pack32(uint16_t *words, uint32_t value) {
+  words[0] = (uint16_t)(value >> 16);
+  words[1] = (uint16_t)value;
+}
+
+void MEM_PackTelemetry(const MemTelemetry *telemetry, uint16_t *words) {
+  uint8_t i;
+
+  if (!telemetry || !words)
+    return;
+
+  words[MEM_TM_VERSION] = MEM_TELEMETRY_VERSION;
+  pack32(&words[MEM_TM_HEAP_SIZE], telemetry->heapSize);
+  pack32(&words[MEM_TM_USED], telemetry->usedBytes);
+  pack32(&words[MEM_TM_HIGH_WATER], telemetry->highWater);
+  pack32(&words[MEM_TM_LARGEST_FREE], telemetry->largestFree);
+  pack32(&words[MEM_TM_FAILED], telemetry->failedAllocs);
+  for (i = 0; i < MEM_HIST_BINS; i++) {
+    uint32_t count = telemetry->sizeHistogram[i];
+    words[MEM_TM_HISTOGRAM + i] =
+        (uint16_t)(count > 0xFFFFU ? 0xFFFFU : count);
+  }
+}
+
+/* ============================================================
+ * MEM_Compact
+ * ============================================================ */
+uint32_t MEM_Compact(MemRelocateFn relocate, void *user) {
+  BlockHeader *blk;
+  uint32_t moved = 0;
+
+  if (!heap.initialized || !relocate)
+    return 0;
+
+  blk = (BlockHeader *)heap.heapStart;
+  while ((uint8_t *)blk < heap.heapEnd) {
+    if (BLK_IS_USED(blk) && BLK_PREV_IS_FREE(blk)) {
+      BlockHeader *gap = BLK_PREV_ADJ(blk);
+
+      if (relocate(BLK_DATA(blk), BLK_DATA(gap), user)) {
+        uint32_t size = BLK_SIZE(blk);
+        uint32_t gapSize = BLK_SIZE(gap);
+        BlockHeader *after;
+
+        /* Swap places: the block moves to the gap's start (whose lower
+         * neighbour is used, as no two free blocks touch) and the gap
+         * reappears above it, merged with any free block there */
+        class_remove(gap);
+        memmove(gap, blk, size);
+        gap->sizeAndFlags = size | MEM_FLAG_USED;
+        blk = (BlockHeader *)((uint8_t *)gap + size);
+        blk->sizeAndFlags = gapSize;
+
+        after = BLK_NEXT_ADJ(blk);
+        if ((uint8_t *)after < heap.heapEnd && BLK_IS_FREE(after)) {
+          class_remove(after);
+          BLK_SET_SIZE(blk, gapSize + BLK_SIZE(after));
+          heap.freeBytes += sizeof(BlockHeader); /* Reclaim header */
+        }
+        tag_free(blk);
+        class_insert(blk);
+        moved += size;
+      }
+    }
+    blk = BLK_NEXT_ADJ(blk);
+  }
+  return moved;
+}
+
+/* ============================================================
+ * MEM_SetGrowZone
+ * ============================================================ */
+void MEM_SetGrowZone(MemGrowZoneFn growZone, void *user) {
+  heap.growZone = growZone;
+  heap.growZoneUser = user;
+}
+
+/* ============================================================
+ * Arenas
+ * ============================================================ */
+int8_t MEM_ArenaCreate(MemArena *arena, uint32_t size) {
+  if (!arena)
+    return -1;
+
+  arena->size = 0;
+  arena->used = 0;
+  arena->highWater = 0;
+  arena->base = (uint8_t *)0;
+  if (size == 0)
+    return -1;
+
+  size = (size + MEM_ALIGN - 1) & ~(uint32_t)(MEM_ALIGN - 1);
+  arena->base = (uint8_t *)MEM_Alloc(size);
+  if (!arena->base)
+    return -1;
+  arena->size = size;
+  return 0;
+}
+
+void *MEM_ArenaAlloc(MemArena *arena, uint32_t size) {
+  void *ptr;
+
+  if (!arena || !arena->base || size == 0)
+    return (void *)0;
+
+  size = (size + MEM_ALIGN - 1) & ~(uint32_t)(MEM_ALIGN - 1);
+  if (size > arena->size - arena->used)
+    return (void *)0;
+
+  ptr = arena->base + arena->used;
+  arena->used += size;
+  if (arena->used > arena->highWater)
+    arena->highWater = arena->used;
+  return ptr;
+}
+
+void MEM_ArenaReset(MemArena *arena) {
+  if (arena)
+    arena->used = 0;
+}
+
+void MEM_ArenaDestroy(MemArena *arena) {
+  if (!arena)
+    return;
+
+  MEM_Free(arena->base);
+  arena->base = (uint8_t *)0;
+  arena->size = 0;
+  arena->used = 0;
+  arena->highWater = 0;
+}
@@ -9,6 +9,7 @@
 #include "blitter.h"
 #include "sega_os.h"
 #include "sysfont.h"
+#include "wm.h"
 
 
 #include <string.h>
@@ -18,6 +19,15 @@
  * ============================================================ */
 static MenuBar menuBar;
 
+/* Swaps the menu's white (0) and black (1) */
+#define MENU_INVERT (0 ^ 1)
+
+/* Pixels under the open dropdown, put back when it closes or moves. While
+ * the copy is held the dropdown stays drawn, so only changes are redrawn. */
+static int8_t dropSaveUnder = -1;
+static Rect dropSaved;
+static int8_t dropDrawnItem = -1; /* Item highlighted in the framebuffer */
+
 /* ============================================================
  * Init
  * ============================================================ */
@@ -25,6 +35,45 @@ void MenuBar_Init(void) {
   memset(&menuBar, 0, sizeof(MenuBar));
   menuBar.activeMenu = -1;
   menuBar.activeItem = -1;
+  dropSaveUnder = -1;
+}
+
+/* ============================================================
+ * Layout
+ * ============================================================ */
+
+/* Measure the dropdown once: width from the widest item, each item's top,
+ * and the row table hit-testing reads */
+static void layout_menu(Menu *m) {
+  int16_t maxW = MENU_MIN_WIDTH;
+  int16_t y = MENU_PADDING_Y;
+  uint8_t i;
+  uint8_t row;
+
+  memset(m->rowItem, MENU_NO_ITEM, sizeof(m->rowItem));
+  for (i = 0; i < m->itemCount; i++) {
+    const MenuItem *item = &m->items[i];
+    int16_t h =
+        (item->flags & MIF_SEPARATOR) ? MENU_SEPARATOR_H : MENU_ITEM_HEIGHT;
+
+    m->itemTop[i] = y;
+    if (!(item->flags & MIF_SEPARATOR) && item->text) {
+      int16_t w = SysFont_StringWidth(item->text) + MENU_PADDING_X * 2;
+      if (item->flags & MIF_CHECKED)
+        w += MENU_CHECK_W;
+      if (w > maxW)
+        maxW = w;
+    }
+    if (!(item->flags & (MIF_SEPARATOR | MIF_DISABLED))) {
+      for (row = (uint8_t)(y / MENU_HIT_ROW_H);
+           row < (y + h) / MENU_HIT_ROW_H; row++)
+        m->rowItem[row] = i;
+    }
+    y += h;
+  }
+  m->itemTop[m->itemCount] = y;
+  m->dropWidth = maxW;
+  m->dropHeight = y + MENU_PADDING_Y;
 }
 
 /* ============================================================
@@ -47,6 +96,7 @@ int8_t MenuBar_AddMenu(const char *title) {
     m->titleX = prev->titleX + prev->titleWidth + MENUBAR_PADDING;
   }
   m->titleWidth = SysFont_StringWidth(title) + MENUBAR_PADDING;
+  layout_menu(m);
 
   return (int8_t)idx;
 }
@@ -65,6 +115,7 @@ int8_t MenuBar_AddItem(uint8_t menuIndex, const char *text, uint16_t commandID,
   item->flags = flags;
   item->shortcutKey = 0;
   item->commandID = commandID;
+  layout_menu(m);
 
   return (int8_t)idx;
 }
@@ -86,6 +137,7 @@ void MenuBar_SetItemEnabled(uint8_t menuIndex, uint8_t itemIndex,
   } else {
     m->items[itemIndex].flags |= MIF_DISABLED;
   }
+  layout_menu(m);
 }
 
 void MenuBar_SetItemChecked(uint8_t menuIndex, uint8_t itemIndex,
@@ -101,44 +153,13 @@ void MenuBar_SetItemChecked(uint8_t menuIndex, uint8_t itemIndex,
   } else {
     m->items[itemIndex].flags &= ~MIF_CHECKED;
   }
+  layout_menu(m);
 }
 
 /* ============================================================
  * Rendering
  * ============================================================ */
 
-/* Compute dropdown width for a menu (widest item + padding) */
-static int16_t compute_dropdown_width(const Menu *m) {
-  int16_t maxW = MENU_MIN_WIDTH;
-  for (uint8_t i = 0; i < m->itemCount; i++) {
-    if (m->items[i].flags & MIF_SEPARATOR)
-      continue;
-    if (!m->items[i].text)
-      continue;
-    int16_t w = SysFont_StringWidth(m->items[i].text) + MENU_PADDING_X * 2;
-    /* Add space for checkmark if needed */
-    if (m->items[i].flags & MIF_CHECKED) {
-      w += 10; /* Checkmark width */
-    }
-    if (w > maxW)
-      maxW = w;
-  }
-  return maxW;
-}
-
-/* Compute total dropdown height */
-static int16_t compute_dropdown_height(const Menu *m) {
-  int16_t h = MENU_PADDING_Y * 2;
-  for (uint8_t i = 0; i < m->itemCount; i++) {
-    if (m->items[i].flags & MIF_SEPARATOR) {
-      h += MENU_SEPARATOR_H;
-    } else {
-      h += MENU_ITEM_HEIGHT;
-    }
-  }
-  return h;
-}
-
 void MenuBar_Draw(void) {
   /* Bar background: white rect with black border at bottom */
   Rect barRect;
@@ -164,8 +185,8 @@ void MenuBar_Draw(void) {
       titleRect.top = 1;
       titleRect.right = m->titleX + m->titleWidth;
       titleRect.bottom = MENUBAR_HEIGHT - 1;
-      BLT_FillRect(&titleRect, 1); /* Black fill */
-      SysFont_DrawString(m->titleX, MENUBAR_TEXT_Y, m->title, 0);
+      SysFont_DrawString(m->titleX, MENUBAR_TEXT_Y, m->title, 1);
+      BLT_XorRect(&titleRect, MENU_INVERT);
     } else {
       /* Normal title: black on white */
       SysFont_DrawString(m->titleX, MENUBAR_TEXT_Y, m->title, 1);
@@ -173,15 +194,33 @@ void MenuBar_Draw(void) {
   }
 }
 
-void MenuBar_DrawDropdown(void) {
-  if (!menuBar.isOpen || menuBar.activeMenu < 0)
-    return;
+/* Item highlight rect, or 0 for separators and out-of-range items */
+static uint8_t item_rect(const Menu *m, int8_t index, Rect *out) {
+  if (index < 0 || index >= (int8_t)m->itemCount)
+    return 0;
+  if (m->items[index].flags & MIF_SEPARATOR)
+    return 0;
 
-  const Menu *m = &menuBar.menus[menuBar.activeMenu];
+  out->left = m->titleX - 4 + 1;
+  out->top = MENUBAR_HEIGHT + m->itemTop[index];
+  out->right = m->titleX - 4 + m->dropWidth - 1;
+  out->bottom = MENUBAR_HEIGHT + m->itemTop[index + 1];
+  return 1;
+}
+
+/* Flip an item between normal and highlighted */
+static void invert_item(const Menu *m, int8_t index) {
+  Rect hl;
+
+  if (item_rect(m, index, &hl))
+    BLT_XorRect(&hl, MENU_INVERT);
+}
+
+static void draw_dropdown(const Menu *m) {
   int16_t dropX = m->titleX - 4;
   int16_t dropY = MENUBAR_HEIGHT;
-  int16_t dropW = compute_dropdown_width(m);
-  int16_t dropH = compute_dropdown_height(m);
+  int16_t dropW = m->dropWidth;
+  int16_t dropH = m->dropHeight;
 
   /* Drop shadow (2px offset, drawn first) */
   Rect shadowRect;
@@ -206,28 +245,17 @@ void MenuBar_DrawDropdown(void) {
   BLT_DrawVLine(dropX + dropW - 1, dropY, dropH, 1);
 
   /* Draw items */
-  int16_t itemY = dropY + MENU_PADDING_Y;
   for (uint8_t i = 0; i < m->itemCount; i++) {
     const MenuItem *item = &m->items[i];
+    int16_t itemY = dropY + m->itemTop[i];
 
     if (item->flags & MIF_SEPARATOR) {
       /* Dashed separator line */
       int16_t sepY = itemY + MENU_SEPARATOR_H / 2;
       BLT_DrawHLine(dropX + 2, sepY, dropW - 4, 1);
-      itemY += MENU_SEPARATOR_H;
       continue;
     }
 
-    /* Highlight if this is the active item */
-    if (menuBar.activeItem == (int8_t)i) {
-      Rect hlRect;
-      hlRect.left = dropX + 1;
-      hlRect.top = itemY;
-      hlRect.right = dropX + dropW - 1;
-      hlRect.bottom = itemY + MENU_ITEM_HEIGHT;
-      BLT_FillRect(&hlRect, 1); /* Black highlight */
-    }
-
     if (item->text) {
       int16_t textX = dropX + MENU_PADDING_X;
       int16_t textY = itemY + 2;
@@ -235,9 +263,8 @@ void MenuBar_DrawDropdown(void) {
       /* Checkmark */
       if (item->flags & MIF_CHECKED) {
         /* Simple checkmark: draw a small "v" */
-        uint8_t color = (menuBar.activeItem == (int8_t)i) ? 0 : 1;
-        SysFont_DrawString(textX, textY, "\x1A", color);
-        textX += 10;
+        SysFont_DrawString(textX, textY, "\x1A", 1);
+        textX += MENU_CHECK_W;
       }
 
       if (item->flags & MIF_DISABLED) {
@@ -252,13 +279,68 @@ void MenuBar_DrawDropdown(void) {
         grayRect.bottom = textY + 10;
         BLT_FillRectPattern(&grayRect, &PAT_GRAY_50);
       } else {
-        uint8_t color = (menuBar.activeItem == (int8_t)i) ? 0 : 1;
-        SysFont_DrawString(textX, textY, item->text, color);
+        SysFont_DrawString(textX, textY, item->text, 1);
       }
     }
+  }
+
+  /* Highlight the active item: white on black */
+  invert_item(m, menuBar.activeItem);
+}
 
-    itemY += MENU_ITEM_HEIGHT;
+void MenuBar_DrawDropdown(void) {
+  if (!menuBar.isOpen || menuBar.activeMenu < 0)
+    return;
+
+  const Menu *m = &menuBar.menus[menuBar.activeMenu];
+  uint8_t full = 1;
+
+  /* Save what the dropdown and its shadow cover before drawing over it; the
+   * layers below have already painted this frame's dirty areas */
+  Rect covered;
+  covered.left = m->titleX - 4;
+  covered.top = MENUBAR_HEIGHT;
+  covered.right = covered.left + m->dropWidth + MENU_SHADOW_SIZE;
+  covered.bottom = MENUBAR_HEIGHT + m->dropHeight + MENU_SHADOW_SIZE;
+  if (dropSaveUnder >= 0 &&
+      (covered.left != dropSaved.left || covered.top != dropSaved.top ||
+       covered.right != dropSaved.right ||
+       covered.bottom != dropSaved.bottom)) {
+    WM_RestoreUnder(dropSaveUnder);
+    dropSaveUnder = -1;
   }
+  if (dropSaveUnder < 0) {
+    dropSaveUnder = WM_SaveUnder(&covered);
+    dropSaved = covered;
+  } else {
+    WM_RefreshSaveUnder(dropSaveUnder);
+    full = 0;
+  }
+
+  if (full) {
+    draw_dropdown(m);
+    dropDrawnItem = menuBar.activeItem;
+    return;
+  }
+
+  /* Still on screen from last frame: flip only the highlight that moved... */
+  if (dropDrawnItem != menuBar.activeItem) {
+    invert_item(m, dropDrawnItem);
+    invert_item(m, menuBar.activeItem);
+    dropDrawnItem = menuBar.activeItem;
+  }
+
+  /* ...and redraw it where the layers below just repainted */
+  uint8_t count = WM_GetDirtyCount();
+  for (uint8_t i = 0; i < count; i++) {
+    DirtyRect *dr = WM_GetDirtyRect(i);
+    Rect hit;
+    if (dr && dr->valid && DR_RectIntersect(&dr->rect, &covered, &hit)) {
+      BLT_SetClipRect(&hit);
+      draw_dropdown(m);
+    }
+  }
+  BLT_ResetClip();
 }
 
 /* ============================================================
@@ -308,36 +390,19 @@ void MenuBar_HandleMouseMove(int16_t x, int16_t y) {
     return;
   }
 
-  /* Check if mouse is in dropdown area */
+  /* Inside the dropdown the row table names the item under the mouse */
   const Menu *m = &menuBar.menus[menuBar.activeMenu];
   int16_t dropX = m->titleX - 4;
-  int16_t dropW = compute_dropdown_width(m);
-  int16_t dropY = MENUBAR_HEIGHT;
+  int16_t row = (y - MENUBAR_HEIGHT) / MENU_HIT_ROW_H;
 
-  if (x < dropX || x >= dropX + dropW) {
+  if (x < dropX || x >= dropX + m->dropWidth ||
+      y >= MENUBAR_HEIGHT + m->dropHeight) {
     menuBar.activeItem = -1;
     return;
   }
 
-  /* Find which item the mouse is over */
-  int16_t itemY = dropY + MENU_PADDING_Y;
-  for (uint8_t i = 0; i < m->itemCount; i++) {
-    const MenuItem *item = &m->items[i];
-    int16_t itemH =
-        (item->flags & MIF_SEPARATOR) ? MENU_SEPARATOR_H : MENU_ITEM_HEIGHT;
-
-    if (y >= itemY && y < itemY + itemH) {
-      if ((item->flags & MIF_SEPARATOR) || (item->flags & MIF_DISABLED)) {
-        menuBar.activeItem = -1;
-      } else {
-        menuBar.activeItem = (int8_t)i;
-      }
-      return;
-    }
-    itemY += itemH;
-  }
-
-  menuBar.activeItem = -1;
+  menuBar.activeItem =
+      (m->rowItem[row] == MENU_NO_ITEM) ? -1 : (int8_t)m->rowItem[row];
 }
 
 MenuSelection MenuBar_HandleMouseUp(int16_t x, int16_t y) {
@@ -365,6 +430,14 @@ MenuSelection MenuBar_HandleMouseUp(int16_t x, int16_t y) {
 }
 
 void MenuBar_Close(void) {
+  /* One blit puts back what the dropdown covered; without a copy the area
+   * is simply invalidated */
+  if (dropSaveUnder >= 0) {
+    WM_RestoreUnder(dropSaveUnder);
+    dropSaveUnder = -1;
+  } else if (menuBar.isOpen) {
+    WM_InvalidateRect(&dropSaved);
+  }
   menuBar.activeMenu = -1;
   menuBar.activeItem = -1;
   menuBar.isOpen = 0;
@@ -0,0 +1,91 @@
+/*
+ * pool.c - Fixed-Size Object Pools
+ *
+ * Free slots form a singly linked list through pool->next, threaded in
+ * index order at init; alloc pops the head and free pushes the slot back,
+ * so neither scans. pool->occupied mirrors which slots are out.
+ */
+
+#include "pool.h"
+
+void POOL_Init(Pool *pool, void *slots, uint16_t slotBytes, uint8_t count) {
+  uint8_t i;
+
+  if (!pool)
+    return;
+  if (count > POOL_MAX_SLOTS)
+    count = POOL_MAX_SLOTS;
+
+  pool->slots = (uint8_t *)slots;
+  pool->slotBytes = slotBytes;
+  pool->count = slots ? count : 0;
+  pool->used = 0;
+  pool->highWater = 0;
+  pool->failures = 0;
+  pool->occupied = 0;
+  for (i = 0; i < pool->count; i++)
+    pool->next[i] = (uint8_t)(i + 1 < pool->count ? i + 1 : POOL_NONE);
+  pool->freeHead = pool->count ? 0 : POOL_NONE;
+}
+
+void *POOL_Alloc(Pool *pool) {
+  uint8_t index;
+
+  if (!pool)
+    return (void *)0;
+  if (pool->freeHead == POOL_NONE) {
+    pool->failures++;
+    return (void *)0;
+  }
+
+  index = pool->freeHead;
+  pool->freeHead = pool->next[index];
+  pool->occupied |= 1UL << index;
+  pool->used++;
+  if (pool->used > pool->highWater)
+    pool->highWater = pool->used;
+  return pool->slots + (uint32_t)index * pool->slotBytes;
+}
+
+void POOL_Free(Pool *pool, void *slot) {
+  int16_t index = POOL_Index(pool, slot);
+
+  if (index < 0 || !(pool->occupied & (1UL << index)))
+    return;
+
+  pool->occupied &= ~(1UL << index);
+  pool->next[index] = pool->freeHead;
+  pool->freeHead = (uint8_t)index;
+  pool->used--;
+}
+
+int16_t POOL_Index(const Pool *pool, const void *slot) {
+  uintptr_t offset;
+
+  if (!pool || !slot || !pool->count)
+    return -1;
+
+  offset = (uintptr_t)slot - (uintptr_t)pool->slots;
+  if ((uintptr_t)slot < (uintptr_t)pool->slots ||
+      offset >= (uint32_t)pool->count * pool->slotBytes ||
+      offset % pool->slotBytes)
+    return -1;
+  return (int16_t)(offset / pool->slotBytes);
+}
+
+void *POOL_At(const Pool *pool, uint8_t index) {
+  if (!pool || index >= pool->count || !(pool->occupied & (1UL << index)))
+    return (void *)0;
+  return pool->slots + (uint32_t)index * pool->slotBytes;
+}
+
+void POOL_GetStats(const Pool *pool, PoolStats *stats) {
+  if (!pool || !stats)
+    return;
+
+  stats->count = pool->count;
+  stats->used = pool->used;
+  stats->highWater = pool->highWater;
+  stats->failures = pool->failures;
+  stats->bytes = (uint32_t)pool->count * pool->slotBytes;
+}
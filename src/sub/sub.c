@@ -32,6 +32,7 @@
 #ifndef BOOT_SAFE_DESKTOP
 #include "calc.h"
 #endif
+#include "handle.h"
 #include "input.h"
 #include "mem.h"
 #ifndef BOOT_SAFE_DESKTOP
@@ -59,6 +60,9 @@ static Window *dragWindow = (Window *)0;
 static int16_t dragOffsetX = 0;
 static int16_t dragOffsetY = 0;
 
+/* Heap telemetry snapshot paged out by CMD_HEAP_TELEMETRY */
+static uint16_t heapTelemetryWords[MEM_TELEMETRY_WORDS];
+
 #ifndef BOOT_SAFE_DESKTOP
 /* Counter for auto-naming windows */
 static uint8_t windowCounter = 0;
@@ -539,6 +543,33 @@ static void render_boot_safe_desktop(void) {
 }
 #endif
 
+#ifndef BOOT_SAFE_DESKTOP
+/* Report the frame's window move in RESULT_MOVE_* (see common.h). */
+static void publish_move_event(void) {
+  const WindowMoveEvent *evt = WM_GetPublishedMoveEvent();
+  int16_t x0, y0, x1, y1;
+
+  if (!evt) {
+    sub_write_result(RESULT_MOVE_KIND_ID, 0xFFFF);
+    return;
+  }
+
+  x0 = (int16_t)(evt->from.left >> 3);
+  y0 = (int16_t)(evt->from.top >> 3);
+  x1 = (int16_t)((evt->from.right + 7) >> 3);
+  y1 = (int16_t)((evt->from.bottom + 7) >> 3);
+  sub_write_result(RESULT_MOVE_KIND_ID,
+                   (uint16_t)(((uint16_t)evt->kind << 8) | evt->windowId));
+  sub_write_result(RESULT_MOVE_ORIGIN_XY, (uint16_t)((x0 << 8) | y0));
+  sub_write_result(RESULT_MOVE_ORIGIN_END, (uint16_t)((x1 << 8) | y1));
+  sub_write_result(
+      RESULT_MOVE_DELTA,
+      (uint16_t)(((uint16_t)(uint8_t)((evt->to.left - evt->from.left) >> 3)
+                  << 8) |
+                 (uint8_t)((evt->to.top - evt->from.top) >> 3)));
+}
+#endif
+
 static void os_init(void) {
   sub_write_result(7, 0x7301);
   /* Initialize blitter with the verified 1M bank-0 Word RAM base address. */
@@ -547,6 +578,17 @@ static void os_init(void) {
   BLT_SetMode(BLT_MODE_4BIT); /* Match Main CPU framebuffer pipeline */
   sub_write_result(7, 0x7303);
 
+  /* Initialize memory manager before anything can start an app: each
+   * app's arena comes from this heap.
+   * Heap region is defined by linker script symbols.
+   * _heap_start = end of BSS, _heap_end = start of stack area. */
+  {
+    extern uint8_t _heap_start;
+    extern uint8_t _heap_end;
+    MEM_Init(&_heap_start, &_heap_end);
+  }
+  HND_Init(); /* Compact and purge handles before an allocation fails */
+
 #ifdef BOOT_SAFE_DESKTOP
   BLT_Init((uint8_t *)0x0C0000);
   sub_write_result(7, 0x73f1);
@@ -556,6 +598,12 @@ static void os_init(void) {
 #else
   /* Initialize Window Manager */
   WM_Init();
+#ifdef FAST_DRAG_REMAP
+  WM_SetFastDrag(1);
+#endif
+#ifdef OUTLINE_DRAG
+  WM_SetOutlineDrag(1);
+#endif
   sub_write_result(7, 0x7304);
 
   /* Draw initial desktop (gray pattern + menu bar) */
@@ -599,14 +647,6 @@ static void os_init(void) {
   }
 #endif
 
-  /* Initialize memory manager.
-   * Heap region is defined by linker script symbols.
-   * _heap_start = end of BSS, _heap_end = start of stack area. */
-  {
-    extern uint8_t _heap_start;
-    extern uint8_t _heap_end;
-    MEM_Init(&_heap_start, &_heap_end);
-  }
   sub_write_result(7, 0x73fe);
 
   /* TODO: Initialize file system (ISO 9660 reader, BRAM wrappers) */
@@ -677,8 +717,10 @@ static void process_command(uint8_t cmd) {
     sub_done();
     break;
 #else
+    static WMRedrawPlan redrawPlan;
     Window *win;
     uint8_t i;
+    uint8_t p;
 
     sub_write_result(0, SUB_STATE_RENDERING);
     sub_wait_wram();
@@ -693,25 +735,30 @@ static void process_command(uint8_t cmd) {
       if (!dr || !dr->valid)
         continue;
 
-      /* 1. Clip blitter to this dirty rect */
-      BLT_SetClipRect(&dr->rect);
+      /* 1. Plan front to back so each damaged pixel is painted once */
+      WM_PlanRedraw(&dr->rect, &redrawPlan);
 
-      /* 2. Redraw root desktop/menu pixels inside this dirty region */
-      WM_DrawDesktopInRect(&dr->rect);
+      /* 2. Paint the pieces back to front: desktop/menu pixels, then each
+       * window's frame and content clipped to the part it owns */
+      for (p = 0; p < redrawPlan.count; p++) {
+        WMRedrawPiece *piece = &redrawPlan.pieces[p];
 
-      /* 3. Walk window list back-to-front (painter's algorithm) */
-      for (win = WM_GetBottomWindow(); win; win = win->above) {
-        if (win->flags & WF_VISIBLE) {
-          BLT_DrawWindowFrame(win, SysFont_Get());
-          /* Call app's draw callback for content */
-          if (win->drawProc) {
-            win->drawProc(win);
-          }
+        BLT_SetClipRect(&piece->clip);
+        if (!piece->win) {
+          WM_DrawDesktopInRect(&piece->clip);
+          continue;
+        }
+
+        win = piece->win;
+        WM_DrawWindowFrame(win, SysFont_Get());
+        /* Call app's draw callback for content */
+        if (win->drawProc) {
+          win->drawProc(win);
         }
       }
     }
 
-    /* 4. Draw menu bar (always on top of windows) */
+    /* 3. Draw menu bar (always on top of windows) */
     BLT_ResetClip();
 #ifndef BOOT_SAFE_DESKTOP
     MenuBar_Draw();
@@ -720,9 +767,15 @@ static void process_command(uint8_t cmd) {
     }
 #endif
 
-    /* 5. Draw mouse cursor last (on top of everything) */
-    BLT_BlitBitmap1(cursorX, cursorY, cursorBitmap, 11, 16, BLT_BLACK);
+    /* 4. Draw mouse cursor (on top of everything) */
+    BLT_BlitBitmap1(cursorX, cursorY, cursorBitmap, WM_CURSOR_W, WM_CURSOR_H,
+                    BLT_BLACK);
+
+    /* 5. XOR the drag outline over the finished frame; the next update
+     * erases it before anything else draws */
+    WM_DrawDragOutline();
 
+    publish_move_event();
     WM_EndUpdate();
 
     /* Give the finished Word RAM framebuffer to Main CPU. */
@@ -777,6 +830,27 @@ static void process_command(uint8_t cmd) {
   }
 #endif
 
+  case CMD_HEAP_TELEMETRY: {
+    uint16_t first = sub_read_param(0);
+    uint8_t i;
+
+    if (first == 0) {
+      MemTelemetry telemetry;
+      MEM_GetTelemetry(&telemetry);
+      MEM_PackTelemetry(&telemetry, heapTelemetryWords);
+    }
+    sub_write_result(RESULT_TELEMETRY_HEADER,
+                     (uint16_t)(((first & 0xFFU) << 8) | MEM_TELEMETRY_WORDS));
+    for (i = 0; i < RESULT_TELEMETRY_PAGE_WORDS; i++) {
+      uint16_t index = (uint16_t)(first + i);
+      sub_write_result((uint8_t)(i + 1), index < MEM_TELEMETRY_WORDS
+                                             ? heapTelemetryWords[index]
+                                             : 0);
+    }
+    sub_done();
+    break;
+  }
+
   case CMD_OPEN_WINDOW: {
     /* Params: x, y, w, h from CMD registers */
     uint16_t x = sub_read_param(0);
@@ -834,15 +908,16 @@ static void process_command(uint8_t cmd) {
     Rect dirtyOld, dirtyNew;
     dirtyOld.left = prevCursorX;
     dirtyOld.top = prevCursorY;
-    dirtyOld.right = prevCursorX + 11;
-    dirtyOld.bottom = prevCursorY + 16;
+    dirtyOld.right = prevCursorX + WM_CURSOR_W;
+    dirtyOld.bottom = prevCursorY + WM_CURSOR_H;
     WM_AddDirtyRect(&dirtyOld);
 
     dirtyNew.left = cursorX;
     dirtyNew.top = cursorY;
-    dirtyNew.right = cursorX + 11;
-    dirtyNew.bottom = cursorY + 16;
+    dirtyNew.right = cursorX + WM_CURSOR_W;
+    dirtyNew.bottom = cursorY + WM_CURSOR_H;
     WM_AddDirtyRect(&dirtyNew);
+    WM_SetCursorPos(cursorX, cursorY);
 
     /* Process mouse events through Window Manager */
     if (evt.type == INPUT_EVT_MOUSE_DOWN) {
@@ -869,6 +944,8 @@ static void process_command(uint8_t cmd) {
           dragWindow = hit.window;
           dragOffsetX = evt.x - hit.window->frame.left;
           dragOffsetY = evt.y - hit.window->frame.top;
+          if (!WM_BeginFastDrag(hit.window))
+            WM_BeginOutlineDrag(hit.window);
         }
         break;
       case WM_HIT_CLOSE:
@@ -969,7 +1046,18 @@ static void process_command(uint8_t cmd) {
         }
       }
 #endif
-      /* Release drag */
+      /* Release drag, re-rendering a fast-dragged window where it landed
+       * or moving an outline-dragged one to where its outline was */
+      if (dragWindow &&
+          (WM_IsFastDragging() || WM_IsOutlineDragging())) {
+        int16_t dropY = evt.y - dragOffsetY;
+        if (dropY < WM_MENUBAR_H)
+          dropY = WM_MENUBAR_H;
+        if (WM_IsFastDragging())
+          WM_EndFastDrag(evt.x - dragOffsetX, dropY);
+        else
+          WM_EndOutlineDrag(evt.x - dragOffsetX, dropY);
+      }
       dragWindow = (Window *)0;
     }
 
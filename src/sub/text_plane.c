@@ -0,0 +1,230 @@
+/*
+ * text_plane.c - Sub-side model for the tile-mapped text console.
+ *
+ * Characters are stored as finished Plane B nametable entries. Each change is
+ * logged by cell index so a frame publishes only what moved; scrolling or a
+ * full log falls back to republishing every console cell.
+ */
+
+#include "text_plane.h"
+
+static void tp_set_cell(TextPlane *tp, uint16_t index, uint16_t entry) {
+  if (tp->cells[index] == entry)
+    return;
+
+  tp->cells[index] = entry;
+  if (tp->full)
+    return;
+  if (tp->logCount >= TP_LOG_MAX) {
+    tp->full = 1;
+    return;
+  }
+  tp->log[tp->logCount++] = index;
+}
+
+static void tp_fill(TextPlane *tp, uint16_t entry) {
+  uint16_t count = (uint16_t)(tp->cols * tp->rows);
+  uint16_t i;
+
+  for (i = 0; i < count; i++)
+    tp->cells[i] = entry;
+  tp->full = 1;
+  tp->logCount = 0;
+}
+
+static void tp_scroll(TextPlane *tp) {
+  uint16_t keep = (uint16_t)(tp->cols * (tp->rows - 1U));
+  uint16_t blank = TP_EntryForChar(tp, ' ');
+  uint16_t i;
+
+  for (i = 0; i < keep; i++)
+    tp->cells[i] = tp->cells[i + tp->cols];
+  for (; i < (uint16_t)(tp->cols * tp->rows); i++)
+    tp->cells[i] = blank;
+
+  /* Every visible cell moved; a plane scroll register would avoid this. */
+  tp->full = 1;
+  tp->logCount = 0;
+}
+
+static void tp_newline(TextPlane *tp) {
+  tp->curX = 0;
+  if (tp->curY + 1U < tp->rows) {
+    tp->curY++;
+  } else {
+    tp_scroll(tp);
+  }
+}
+
+uint8_t TP_Init(TextPlane *tp, uint8_t x0, uint8_t y0, uint8_t cols,
+                uint8_t rows) {
+  if (!tp || cols == 0 || rows == 0)
+    return 0;
+  if ((uint16_t)x0 + cols > TP_MAX_COLS || (uint16_t)y0 + rows > TP_MAX_ROWS)
+    return 0;
+
+  tp->x0 = x0;
+  tp->y0 = y0;
+  tp->cols = cols;
+  tp->rows = rows;
+  tp->attr = TP_ATTR_PRIORITY;
+  TP_Clear(tp);
+  return 1;
+}
+
+void TP_Clear(TextPlane *tp) {
+  if (!tp)
+    return;
+
+  tp_fill(tp, TP_EntryForChar(tp, ' '));
+  tp->curX = 0;
+  tp->curY = 0;
+}
+
+void TP_Close(TextPlane *tp) {
+  if (!tp)
+    return;
+
+  /* Entry 0 is low priority, so Plane A shows through again. */
+  tp_fill(tp, 0);
+  tp->curX = 0;
+  tp->curY = 0;
+}
+
+uint16_t TP_EntryForChar(const TextPlane *tp, char ch) {
+  uint8_t c = (uint8_t)ch;
+
+  if (c < TP_GLYPH_FIRST || c >= TP_GLYPH_FIRST + TP_GLYPH_COUNT)
+    c = '?';
+  return (uint16_t)(tp->attr | (TP_GLYPH_TILE + (c - TP_GLYPH_FIRST)));
+}
+
+void TP_PutChar(TextPlane *tp, char ch) {
+  if (!tp || tp->cols == 0)
+    return;
+
+  if (ch == '\n') {
+    tp_newline(tp);
+    return;
+  }
+  if (ch == '\r') {
+    tp->curX = 0;
+    return;
+  }
+  if (ch == '\b') {
+    if (tp->curX > 0) {
+      tp->curX--;
+      tp_set_cell(tp, (uint16_t)((tp->curY * tp->cols) + tp->curX),
+                  TP_EntryForChar(tp, ' '));
+    }
+    return;
+  }
+
+  if (tp->curX >= tp->cols)
+    tp_newline(tp);
+  tp_set_cell(tp, (uint16_t)((tp->curY * tp->cols) + tp->curX),
+              TP_EntryForChar(tp, ch));
+  tp->curX++;
+}
+
+void TP_Write(TextPlane *tp, const char *str) {
+  if (!tp || !str)
+    return;
+
+  while (*str)
+    TP_PutChar(tp, *str++);
+}
+
+/* BasicLineSink: one BASIC output line per console line. */
+uint8_t TP_BasicLineSink(const char *line, void *user) {
+  TextPlane *tp = (TextPlane *)user;
+
+  if (!tp || !line)
+    return 0;
+
+  if (tp->curX != 0)
+    tp_newline(tp);
+  TP_Write(tp, line);
+  tp_newline(tp);
+  return 1;
+}
+
+void TP_BuildGlyphTile(const uint8_t rows[8], uint8_t ink, uint8_t paper,
+                       uint8_t *out) {
+  uint8_t r;
+  uint8_t px;
+
+  for (r = 0; r < 8; r++) {
+    for (px = 0; px < 8; px += 2) {
+      uint8_t hi = (rows[r] & (0x80U >> px)) ? ink : paper;
+      uint8_t lo = (rows[r] & (0x40U >> px)) ? ink : paper;
+      out[(r * 4U) + (px >> 1)] = (uint8_t)((hi << 4) | (lo & 0x0fU));
+    }
+  }
+}
+
+uint8_t TP_BuildGlyphTiles(const Font *font, uint8_t ink, uint8_t paper,
+                           uint8_t *out) {
+  static const uint8_t blank[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  uint8_t i;
+
+  if (!font || !font->glyphs || !out)
+    return 0;
+
+  for (i = 0; i < TP_GLYPH_COUNT; i++) {
+    uint8_t ch = (uint8_t)(TP_GLYPH_FIRST + i);
+    const uint8_t *rows = blank;
+
+    if (ch >= font->firstChar && ch <= font->lastChar) {
+      const Glyph *glyph = &font->glyphs[ch - font->firstChar];
+      if (glyph->data && glyph->width == 8 && glyph->height == 8)
+        rows = glyph->data;
+    }
+    TP_BuildGlyphTile(rows, ink, paper, out + ((uint16_t)i * TP_GLYPH_BYTES));
+  }
+  return 1;
+}
+
+static uint16_t tp_cell_addr(const TextPlane *tp, uint16_t index) {
+  uint16_t x = (uint16_t)(tp->x0 + (index % tp->cols));
+  uint16_t y = (uint16_t)(tp->y0 + (index / tp->cols));
+
+  return (uint16_t)(TP_PLANE_ADDR + (((y * TP_PLANE_CELLS_X) + x) * 2U));
+}
+
+/*
+ * Copy the changes since the last publish into a Word RAM page and reset the
+ * log. Glyph tiles are written once per bank; Word RAM keeps them across
+ * swaps. Returns the number of cells published.
+ */
+uint16_t TP_Publish(TextPlane *tp, TextPlanePage *page, const Font *font) {
+  uint16_t count = 0;
+  uint16_t i;
+
+  if (!tp || !page)
+    return 0;
+
+  if (font && page->glyphMagic != TP_GLYPH_MAGIC &&
+      TP_BuildGlyphTiles(font, TP_INK, TP_PAPER, page->glyphTiles))
+    page->glyphMagic = TP_GLYPH_MAGIC;
+
+  if (tp->full) {
+    for (i = 0; i < (uint16_t)(tp->cols * tp->rows); i++) {
+      page->cells[i].vramAddr = tp_cell_addr(tp, i);
+      page->cells[i].entry = tp->cells[i];
+    }
+    count = i;
+  } else {
+    for (i = 0; i < tp->logCount; i++) {
+      page->cells[i].vramAddr = tp_cell_addr(tp, tp->log[i]);
+      page->cells[i].entry = tp->cells[tp->log[i]];
+    }
+    count = tp->logCount;
+  }
+
+  page->count = count;
+  page->magic = TP_PAGE_MAGIC;
+  tp->full = 0;
+  tp->logCount = 0;
+  return count;
+}
@@ -171,7 +171,7 @@ void VKBD_Draw(Window *win) {
       if (ch == VKBD_KEY_CAPS && vkbdState.capsLock)
         inverted = 1;
 
-      BLT_FillRect(&keyRect, inverted ? 1 : 0);
+      BLT_FillRect(&keyRect, 0);
 
       /* Border */
       BLT_DrawHLine(kx, ky, kw, 1);
@@ -183,7 +183,17 @@ void VKBD_Draw(Window *win) {
       const char *label = get_key_label(r, c, labelBuf);
       if (label[0]) {
         int16_t tw = SysFont_StringWidth(label);
-        SysFont_DrawString(kx + (kw - tw) / 2, ky + 3, label, inverted ? 0 : 1);
+        SysFont_DrawString(kx + (kw - tw) / 2, ky + 3, label, 1);
+      }
+
+      /* Active modifier: flip the face to white on black (0 <-> 1) */
+      if (inverted) {
+        Rect face;
+        face.left = kx + 1;
+        face.top = ky + 1;
+        face.right = kx + kw - 1;
+        face.bottom = ky + VKBD_KEY_H - 1;
+        BLT_XorRect(&face, 0 ^ 1);
       }
     }
   }
@@ -45,6 +45,9 @@ static void compute_window_rects(Window *win) {
 #define CLOSE_SIZE 12 /* Close box size                   */
 #define SHADOW_W 1    /* Drop shadow width                */
 
+  /* Geometry changed: visible regions must be rebuilt */
+  wm.visStale = 1;
+
   /* Title bar */
   win->titleBar.left = win->frame.left + BORDER_W;
   win->titleBar.top = win->frame.top + BORDER_W;
@@ -68,29 +71,21 @@ static void compute_window_rects(Window *win) {
 
 /* Allocate a window from the static pool */
 static Window *pool_alloc(void) {
-  uint8_t i;
-  for (i = 0; i < WM_MAX_WINDOWS; i++) {
-    if (!wm.poolUsed[i]) {
-      wm.poolUsed[i] = 1;
-      wm.windowCount++;
-      memset(&wm.pool[i], 0, sizeof(Window));
-      wm.pool[i].id = i;
-      return &wm.pool[i];
-    }
-  }
-  return (Window *)0; /* Pool exhausted */
+  Window *win = POOL_ALLOC(&wm.windowPool, Window);
+
+  if (!win)
+    return (Window *)0; /* Pool exhausted */
+  memset(win, 0, sizeof(Window));
+  win->id = (uint8_t)POOL_Index(&wm.windowPool, win);
+  return win;
 }
 
 /* Return a window to the pool */
-static void pool_free(Window *win) {
-  if (win && win->id < WM_MAX_WINDOWS) {
-    wm.poolUsed[win->id] = 0;
-    wm.windowCount--;
-  }
-}
+static void pool_free(Window *win) { POOL_Free(&wm.windowPool, win); }
 
 /* Unlink a window from the Z-order list */
 static void zorder_unlink(Window *win) {
+  wm.visStale = 1;
   if (win->above) {
     win->above->below = win->below;
   } else {
@@ -111,6 +106,7 @@ static void zorder_unlink(Window *win) {
 
 /* Link a window at the top of the Z-order */
 static void zorder_push_top(Window *win) {
+  wm.visStale = 1;
   win->above = (Window *)0;
   win->below = wm.topWindow;
 
@@ -124,6 +120,890 @@ static void zorder_push_top(Window *win) {
   }
 }
 
+/* Expand a pixel rect outward to whole 8x8 tiles */
+static void rect_tile_align(const Rect *r, Rect *out) {
+  out->left = (int16_t)(r->left & ~7);
+  out->top = (int16_t)(r->top & ~7);
+  out->right = (int16_t)((r->right + 7) & ~7);
+  out->bottom = (int16_t)((r->bottom + 7) & ~7);
+}
+
+/* Round a pixel delta to the nearest whole tile */
+static int16_t snap_to_tile(int16_t d) {
+  if (d >= 0)
+    return (int16_t)(((d + 4) / 8) * 8);
+  return (int16_t)(-(((-d + 4) / 8) * 8));
+}
+
+/* Place a frame at (x, y) keeping its size, then clip to the screen */
+static void frame_move_to(Rect *frame, const Rect *from, int16_t x,
+                          int16_t y) {
+  frame->left = x;
+  frame->top = y;
+  frame->right = (int16_t)(x + (from->right - from->left));
+  frame->bottom = (int16_t)(y + (from->bottom - from->top));
+  rect_clip_to_screen(frame);
+}
+
+/* Record a move, folding repeated moves of one window into one event */
+static void move_event_record(Window *win, uint8_t kind, const Rect *from,
+                              const Rect *to) {
+  WindowMoveEvent *evt;
+
+  if (wm.moveEventCount > 0) {
+    evt = &wm.moveEvents[wm.moveEventCount - 1];
+    if (evt->windowId == win->id && evt->kind == kind &&
+        kind != WM_MOVE_DROP) {
+      evt->to = *to;
+      return;
+    }
+  }
+
+  if (wm.moveEventCount >= WM_MAX_MOVE_EVENTS) {
+    memmove(&wm.moveEvents[0], &wm.moveEvents[1],
+            sizeof(WindowMoveEvent) * (WM_MAX_MOVE_EVENTS - 1));
+    wm.moveEventCount--;
+  }
+
+  evt = &wm.moveEvents[wm.moveEventCount++];
+  evt->windowId = win->id;
+  evt->kind = kind;
+  evt->from = *from;
+  evt->to = *to;
+}
+
+/* Frame plus the drop shadow BLT_DrawWindowFrame paints outside it */
+static void window_paint_bounds(const Window *win, const Rect *frame,
+                                Rect *out) {
+  *out = *frame;
+  if (win->style == WM_STYLE_SHADOW || win->style == WM_STYLE_DIALOG) {
+    out->right += SHADOW_W;
+    out->bottom += SHADOW_W;
+    rect_clip_to_screen(out);
+  }
+}
+
+/* Rects a window paints completely: its frame and, for shadowed styles, the
+ * two 1px shadow strips (BLT_DrawShadow skips the outer corners). */
+static uint8_t window_opaque_rects(const Window *win, const Rect *frame,
+                                   Rect *out) {
+  uint8_t count = 0;
+
+  if (!DR_RectIsEmpty(frame))
+    out[count++] = *frame;
+
+  if (win->style == WM_STYLE_SHADOW || win->style == WM_STYLE_DIALOG) {
+    out[count].left = frame->right;
+    out[count].top = (int16_t)(frame->top + SHADOW_W);
+    out[count].right = (int16_t)(frame->right + SHADOW_W);
+    out[count].bottom = (int16_t)(frame->bottom + SHADOW_W);
+    rect_clip_to_screen(&out[count]);
+    if (!DR_RectIsEmpty(&out[count]))
+      count++;
+
+    out[count].left = (int16_t)(frame->left + SHADOW_W);
+    out[count].top = frame->bottom;
+    out[count].right = frame->right;
+    out[count].bottom = (int16_t)(frame->bottom + SHADOW_W);
+    rect_clip_to_screen(&out[count]);
+    if (!DR_RectIsEmpty(&out[count]))
+      count++;
+  }
+
+  return count;
+}
+
+/* ============================================================
+ * Save-under
+ * ============================================================ */
+
+/* Word-sized so every saved copy starts word-aligned */
+static uint16_t wmSaveUnderPool[WM_SAVE_UNDER_BYTES / 2];
+
+/* Set while a window's own frame is invalidated: its contents changed, not
+ * the pixels beneath it */
+static Window *suQuietOwner;
+
+static uint8_t *su_buffer(const WMSaveUnder *su) {
+  return (uint8_t *)wmSaveUnderPool + su->offset;
+}
+
+static void su_cursor_rect(Rect *r) {
+  r->left = wm.cursorPos.x;
+  r->top = wm.cursorPos.y;
+  r->right = (int16_t)(wm.cursorPos.x + WM_CURSOR_W);
+  r->bottom = (int16_t)(wm.cursorPos.y + WM_CURSOR_H);
+}
+
+static void su_add_stale(WMSaveUnder *su, const Rect *r) {
+  Rect hit;
+
+  if (DR_RectIntersect(r, &su->rect, &hit))
+    DR_AddRect(&su->stale, &hit);
+}
+
+/* Lowest pool offset where `size` bytes miss every live copy */
+static Boolean su_place(uint16_t size, uint16_t *offset) {
+  uint16_t at = 0;
+  Boolean bumped = 1;
+  uint8_t i;
+
+  while (bumped) {
+    bumped = 0;
+    if ((uint32_t)at + size > WM_SAVE_UNDER_BYTES)
+      return 0;
+    for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++) {
+      const WMSaveUnder *su = &wm.saveUnders[i];
+      if (su->state == WM_SU_FREE)
+        continue;
+      if (at < su->offset + su->size && su->offset < at + size) {
+        at = (uint16_t)(su->offset + su->size);
+        bumped = 1;
+      }
+    }
+  }
+  *offset = at;
+  return 1;
+}
+
+static int8_t su_reserve(const Rect *r, Window *owner) {
+  WMSaveUnder *su;
+  Rect screen;
+  uint32_t size;
+  uint16_t offset;
+  int8_t slot = -1;
+  uint8_t i;
+
+  if (!r || !BLT_GetFramebuffer())
+    return -1;
+  size = BLT_SaveUnderSize(r);
+  if (size == 0 || size > WM_SAVE_UNDER_BYTES)
+    return -1;
+  for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++) {
+    if (wm.saveUnders[i].state == WM_SU_FREE) {
+      slot = (int8_t)i;
+      break;
+    }
+  }
+  if (slot < 0 || !su_place((uint16_t)size, &offset))
+    return -1;
+
+  screen.top = 0;
+  screen.left = 0;
+  screen.bottom = WM_SCREEN_H;
+  screen.right = WM_SCREEN_W;
+
+  su = &wm.saveUnders[slot];
+  su->rect = *r;
+  rect_clip_to_screen(&su->rect);
+  su->owner = owner;
+  su->offset = offset;
+  su->size = (uint16_t)size;
+  su->state = WM_SU_PENDING;
+  DR_InitList(&su->stale, su->staleRects, WM_SAVE_UNDER_STALE, &screen);
+
+  /* Outside an update the copy is taken before anything repaints, so areas
+   * already waiting to redraw hold old pixels */
+  if (!wm.inUpdate) {
+    uint8_t count = DR_GetCount(&wm.dirtyList);
+    for (i = 0; i < count; i++) {
+      DirtyRect *dr = DR_GetRect(&wm.dirtyList, i);
+      if (dr && dr->valid)
+        su_add_stale(su, &dr->rect);
+    }
+  }
+  return slot;
+}
+
+/* Copy the pixels now beneath the surface. `fresh` means the layers below
+ * have already painted this frame's dirty areas. */
+static void su_capture(WMSaveUnder *su, Boolean fresh) {
+  Rect cursor;
+  Boolean covered = 0;
+  uint8_t count = DR_GetCount(&wm.dirtyList);
+  uint8_t i;
+
+  BLT_SaveRect(&su->rect, (const Rect *)0, su_buffer(su));
+  su->state = WM_SU_SAVED;
+  su->seq = ++wm.saveUnderSeq;
+
+  /* The cursor is drawn last, so unless its rect was just repainted the
+   * copy holds cursor pixels */
+  su_cursor_rect(&cursor);
+  for (i = 0; fresh && i < count; i++) {
+    DirtyRect *dr = DR_GetRect(&wm.dirtyList, i);
+    if (dr && dr->valid && dr->rect.left <= cursor.left &&
+        dr->rect.top <= cursor.top && dr->rect.right >= cursor.right &&
+        dr->rect.bottom >= cursor.bottom)
+      covered = 1;
+  }
+  if (!covered)
+    su_add_stale(su, &cursor);
+}
+
+static void su_release(int8_t slot) {
+  WMSaveUnder *su = &wm.saveUnders[slot];
+
+  if (su->owner)
+    su->owner->saveUnder = 0;
+  su->owner = (Window *)0;
+  su->state = WM_SU_FREE;
+}
+
+/* Blit the copy back, free the slot, then redraw what it could not hold.
+ * `late` means this update's dirty rects are already painted, so the redraw
+ * waits for the next frame. */
+static void su_restore(int8_t slot, Boolean late) {
+  WMSaveUnder *su = &wm.saveUnders[slot];
+  uint8_t count;
+  uint8_t i;
+
+  BLT_RestoreRect(&su->rect, (const Rect *)0, su_buffer(su));
+  su_release(slot);
+
+  count = DR_GetCount(&su->stale);
+  for (i = 0; i < count; i++) {
+    DirtyRect *dr = DR_GetRect(&su->stale, i);
+    if (!dr || !dr->valid)
+      continue;
+    if (late)
+      DR_AddRect(&wm.lateList, &dr->rect);
+    else
+      WM_InvalidateRect(&dr->rect);
+  }
+}
+
+/* Deferred restores, newest copy first so overlapping copies unwind */
+static void su_restore_deferred(void) {
+  for (;;) {
+    int8_t newest = -1;
+    uint8_t i;
+
+    for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++) {
+      if (wm.saveUnders[i].state != WM_SU_RESTORE)
+        continue;
+      if (newest < 0 || (int8_t)(wm.saveUnders[i].seq -
+                                 wm.saveUnders[newest].seq) > 0)
+        newest = (int8_t)i;
+    }
+    if (newest < 0)
+      return;
+    su_restore(newest, 0);
+  }
+}
+
+static void su_capture_pending(void) {
+  uint8_t i;
+
+  for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++)
+    if (wm.saveUnders[i].state == WM_SU_PENDING)
+      su_capture(&wm.saveUnders[i], 0);
+}
+
+/* Alerts and dialogs keep what they cover while visible */
+static void window_reserve_save_under(Window *win) {
+  Rect paint;
+  int8_t slot;
+
+  if (win->saveUnder || !(win->flags & WF_VISIBLE))
+    return;
+  if (win->style != WM_STYLE_ALERT && win->style != WM_STYLE_DIALOG)
+    return;
+
+  window_paint_bounds(win, &win->frame, &paint);
+  slot = su_reserve(&paint, win);
+  if (slot >= 0)
+    win->saveUnder = (uint8_t)(slot + 1);
+}
+
+/* Drop the window's save-under, restoring it when asked and possible.
+ * Returns 1 when the restore replaces invalidating the frame. */
+static Boolean window_release_save_under(Window *win, Boolean restore) {
+  WMSaveUnder *su;
+  Window *above;
+  Rect hit;
+  int8_t slot;
+
+  if (!win->saveUnder)
+    return 0;
+  slot = (int8_t)(win->saveUnder - 1);
+  su = &wm.saveUnders[slot];
+  if (!restore || su->state != WM_SU_SAVED) {
+    su_release(slot);
+    return 0;
+  }
+
+  /* The restore writes over windows stacked above this one */
+  for (above = win->above; above; above = above->above) {
+    if (!(above->flags & WF_VISIBLE))
+      continue;
+    window_paint_bounds(above, &above->frame, &hit);
+    su_add_stale(su, &hit);
+  }
+  WM_RestoreUnder(slot);
+  return 1;
+}
+
+/* XOR the last drawn drag outline away. Nothing has drawn since it went
+ * in (it is the frame's last step), so this restores the pixels exactly. */
+static void outline_erase(void) {
+  Rect savedClip;
+
+  if (!wm.outlineDrawn)
+    return;
+
+  wm.outlineDrawn = 0;
+  BLT_GetClipRect(&savedClip);
+  BLT_ResetClip();
+  BLT_InvertFrame(&wm.outlineShown);
+  BLT_SetClipRect(&savedClip);
+}
+
+/* Give up on a pending blit move: redraw both positions instead */
+static void blit_move_cancel(void) {
+  Window *win = wm.blitWindow;
+  Rect r;
+
+  if (!win)
+    return;
+
+  wm.blitWindow = (Window *)0;
+  window_paint_bounds(win, &wm.blitFrom, &r);
+  WM_InvalidateRect(&r);
+  window_paint_bounds(win, &win->frame, &r);
+  WM_InvalidateRect(&r);
+}
+
+/* Invalidate the part of `r` inside `from`, carried along by the blit */
+static void invalidate_shifted(const Rect *r, const Rect *from, int16_t dx,
+                               int16_t dy) {
+  Rect hit;
+
+  if (!DR_RectIntersect(r, from, &hit))
+    return;
+
+  hit.left += dx;
+  hit.right += dx;
+  hit.top += dy;
+  hit.bottom += dy;
+  WM_InvalidateRect(&hit);
+}
+
+/* Copy the moved window's last-drawn pixels to its new position, then
+ * invalidate only what the copy leaves wrong. */
+static void blit_move_apply(void) {
+  Window *win = wm.blitWindow;
+  Window *above;
+  Rect from;
+  Rect to;
+  Rect bar;
+  Rect hit;
+  Rect savedClip;
+  Rect strips[4];
+  Rect pending[WM_MAX_DIRTY_RECTS];
+  uint8_t pendingCount = 0;
+  uint8_t count;
+  uint8_t i;
+  int16_t dx;
+  int16_t dy;
+
+  if (!win)
+    return;
+  if (!BLT_GetFramebuffer()) {
+    blit_move_cancel();
+    return;
+  }
+
+  wm.blitWindow = (Window *)0;
+  window_paint_bounds(win, &wm.blitFrom, &from);
+  window_paint_bounds(win, &win->frame, &to);
+  dx = (int16_t)(to.left - from.left);
+  dy = (int16_t)(to.top - from.top);
+  if (dx == 0 && dy == 0)
+    return;
+
+  /* Regions already dirty inside the old frame hold stale pixels */
+  count = DR_GetCount(&wm.dirtyList);
+  for (i = 0; i < count; i++) {
+    DirtyRect *dr = DR_GetRect(&wm.dirtyList, i);
+    if (dr && dr->valid)
+      pending[pendingCount++] = dr->rect;
+  }
+
+  BLT_GetClipRect(&savedClip);
+  BLT_ResetClip();
+  BLT_CopyRect(&from, to.left, to.top);
+  BLT_SetClipRect(&savedClip);
+
+  count = DR_RectSubtract(&from, &to, strips, 4);
+  for (i = 0; i < count; i++)
+    WM_InvalidateRect(&strips[i]);
+
+  /* The shadow leaves its outer corners unpainted; the copy brought along
+   * whatever was behind the old ones */
+  if (win->style == WM_STYLE_SHADOW || win->style == WM_STYLE_DIALOG) {
+    hit.left = (int16_t)(to.right - 1);
+    hit.top = to.top;
+    hit.right = to.right;
+    hit.bottom = (int16_t)(to.top + 1);
+    WM_InvalidateRect(&hit);
+    hit.left = to.left;
+    hit.top = (int16_t)(to.bottom - 1);
+    hit.right = (int16_t)(to.left + 1);
+    hit.bottom = to.bottom;
+    WM_InvalidateRect(&hit);
+  }
+
+  for (i = 0; i < pendingCount; i++)
+    invalidate_shifted(&pending[i], &from, dx, dy);
+
+  /* Saved copies no longer match what lies beneath them. A surface drawn
+   * over everything was also carried along and re-copies its dirty areas. */
+  for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++) {
+    WMSaveUnder *su = &wm.saveUnders[i];
+    if (su->state != WM_SU_SAVED)
+      continue;
+    if (su->owner) {
+      su_add_stale(su, &from);
+      su_add_stale(su, &to);
+    } else {
+      if (DR_RectIntersect(&su->rect, &to, &hit))
+        WM_InvalidateRect(&hit);
+      invalidate_shifted(&su->rect, &from, dx, dy);
+    }
+  }
+
+  /* The menu bar is painted over windows, so it never held window pixels */
+  bar.left = 0;
+  bar.top = 0;
+  bar.right = WM_SCREEN_W;
+  bar.bottom = WM_MENUBAR_H;
+  invalidate_shifted(&bar, &from, dx, dy);
+
+  /* Windows above covered part of the old frame and are now overwritten */
+  for (above = win->above; above; above = above->above) {
+    if (!(above->flags & WF_VISIBLE))
+      continue;
+    window_paint_bounds(above, &above->frame, &hit);
+    invalidate_shifted(&hit, &from, dx, dy);
+    if (DR_RectIntersect(&hit, &to, &hit))
+      WM_InvalidateRect(&hit);
+  }
+}
+
+/* ============================================================
+ * Chrome cache
+ * ============================================================ */
+
+/* Word-sized so every copy starts word-aligned */
+static uint16_t wmChromePool[WM_CHROME_BYTES / 2];
+
+static uint8_t *chrome_buffer(const WMChromeEntry *e) {
+  return (uint8_t *)wmChromePool + e->offset;
+}
+
+/* Where the bar sits on the 8x8 stripe pattern grid; this also fixes its
+ * pixel offset within a framebuffer byte, which sets the copy's layout */
+static uint8_t chrome_phase(const Rect *bar) {
+  return (uint8_t)((bar->left & 7) | ((bar->top & 7) << 3));
+}
+
+/* A copy's layout follows the rect it was taken from, so only title bars
+ * wholly on screen are cached */
+static Boolean chrome_cacheable(const Window *win) {
+  const Rect *bar = &win->titleBar;
+
+  return BLT_GetFramebuffer() && !DR_RectIsEmpty(bar) && bar->left >= 0 &&
+         bar->top >= 0 && bar->right <= WM_SCREEN_W &&
+         bar->bottom <= WM_SCREEN_H;
+}
+
+static WMChromeEntry *chrome_find(const Window *win, const Font *font) {
+  uint8_t hilited = (win->flags & WF_HILITED) ? 1 : 0;
+  uint8_t i;
+
+  for (i = 0; i < WM_CHROME_SLOTS; i++) {
+    WMChromeEntry *e = &wm.chrome[i];
+    if (e->windowId == (uint8_t)(win->id + 1) && e->hilited == hilited &&
+        e->font == font && e->mode == (uint8_t)BLT_GetMode() &&
+        e->width == win->titleBar.right - win->titleBar.left &&
+        e->phase == chrome_phase(&win->titleBar))
+      return e;
+  }
+  return (WMChromeEntry *)0;
+}
+
+/* Drop every copy of `win`'s title bar */
+static void chrome_flush(const Window *win) {
+  uint8_t i;
+
+  for (i = 0; i < WM_CHROME_SLOTS; i++) {
+    if (wm.chrome[i].windowId == (uint8_t)(win->id + 1))
+      wm.chrome[i].windowId = 0;
+  }
+}
+
+/* Lowest pool offset where `size` bytes miss every cached copy */
+static Boolean chrome_place(uint16_t size, uint16_t *offset) {
+  uint16_t at = 0;
+  Boolean bumped = 1;
+  uint8_t i;
+
+  while (bumped) {
+    bumped = 0;
+    if ((uint32_t)at + size > WM_CHROME_BYTES)
+      return 0;
+    for (i = 0; i < WM_CHROME_SLOTS; i++) {
+      const WMChromeEntry *e = &wm.chrome[i];
+      if (!e->windowId)
+        continue;
+      if (at < e->offset + e->size && e->offset < at + size) {
+        at = (uint16_t)(e->offset + e->size);
+        bumped = 1;
+      }
+    }
+  }
+  *offset = at;
+  return 1;
+}
+
+/* A free entry with `size` pool bytes, evicting the least recently used
+ * copies until one fits */
+static WMChromeEntry *chrome_alloc(uint16_t size) {
+  for (;;) {
+    WMChromeEntry *unused = (WMChromeEntry *)0;
+    WMChromeEntry *oldest = (WMChromeEntry *)0;
+    uint16_t offset;
+    uint8_t i;
+
+    for (i = 0; i < WM_CHROME_SLOTS; i++) {
+      WMChromeEntry *e = &wm.chrome[i];
+      if (!e->windowId) {
+        if (!unused)
+          unused = e;
+      } else if (!oldest || (uint16_t)(wm.chromeClock - e->lastUse) >
+                                (uint16_t)(wm.chromeClock - oldest->lastUse)) {
+        oldest = e;
+      }
+    }
+
+    if (unused && chrome_place(size, &offset)) {
+      unused->offset = offset;
+      unused->size = size;
+      return unused;
+    }
+    if (!oldest)
+      return (WMChromeEntry *)0;
+    oldest->windowId = 0;
+  }
+}
+
+/* Scratch banded regions shared by visible-region and redraw planning */
+#define WM_REGION_MAX_RECTS 64
+#define WM_OPAQUE_MAX_RECTS 4
+
+static Rect wmRegionStore[2][WM_REGION_MAX_RECTS];
+static Rect wmOpaqueStore[2][WM_OPAQUE_MAX_RECTS];
+
+/* The window's opaque rects as a banded region in `out` */
+static Boolean window_opaque_region(const Window *win, DirtyRegion *out) {
+  Rect rects[3];
+  Rect one[1];
+  DirtyRegion piece;
+  DirtyRegion tmp;
+  uint8_t count = window_opaque_rects(win, &win->frame, rects);
+  uint8_t i;
+
+  DR_InitRegion(out, wmOpaqueStore[0], WM_OPAQUE_MAX_RECTS);
+  DR_InitRegion(&tmp, wmOpaqueStore[1], WM_OPAQUE_MAX_RECTS);
+  DR_InitRegion(&piece, one, 1);
+  if (count == 0)
+    return 1;
+
+  DR_RegionSetRect(out, &rects[0]);
+  for (i = 1; i < count; i++) {
+    DR_RegionSetRect(&piece, &rects[i]);
+    if (!DR_RegionUnion(&tmp, out, &piece) || !DR_RegionCopy(out, &tmp))
+      return 0;
+  }
+  return 1;
+}
+
+/* Opaque area of `win` minus the windows above it, into visRects */
+static Boolean vis_region_build(Window *win) {
+  DirtyRegion cur;
+  DirtyRegion next;
+  DirtyRegion cut;
+  DirtyRegion swap;
+  Window *above;
+  uint16_t i;
+
+  DR_InitRegion(&cur, wmRegionStore[0], WM_REGION_MAX_RECTS);
+  DR_InitRegion(&next, wmRegionStore[1], WM_REGION_MAX_RECTS);
+  if (!window_opaque_region(win, &cut) || !DR_RegionCopy(&cur, &cut))
+    return 0;
+
+  for (above = win->above; above && cur.count; above = above->above) {
+    if (!(above->flags & WF_VISIBLE))
+      continue;
+    if (!window_opaque_region(above, &cut) ||
+        !DR_RegionSubtract(&next, &cur, &cut))
+      return 0;
+    swap = cur;
+    cur = next;
+    next = swap;
+  }
+
+  if (cur.count > WM_VIS_MAX_RECTS)
+    return 0;
+  for (i = 0; i < cur.count; i++)
+    win->visRects[i] = cur.rects[i];
+  win->visCount = (uint8_t)cur.count;
+  return 1;
+}
+
+/* Rebuild one window's visible region from the windows above it */
+static void vis_compute(Window *win) {
+  win->visCount = 0;
+  win->visOverflow = 0;
+  if (!(win->flags & WF_VISIBLE))
+    return;
+
+  if (!vis_region_build(win)) {
+    /* Too fragmented to cache; fall back to the whole painted area */
+    win->visCount = window_opaque_rects(win, &win->frame, win->visRects);
+    win->visOverflow = 1;
+  }
+}
+
+void WM_UpdateVisibleRegions(void) {
+  Window *win;
+
+  if (!wm.visStale)
+    return;
+
+  for (win = wm.topWindow; win; win = win->below)
+    vis_compute(win);
+  wm.visStale = 0;
+}
+
+uint8_t WM_GetVisibleRectCount(Window *win) {
+  if (!win)
+    return 0;
+  WM_UpdateVisibleRegions();
+  return win->visCount;
+}
+
+const Rect *WM_GetVisibleRect(Window *win, uint8_t index) {
+  if (!win)
+    return (const Rect *)0;
+  WM_UpdateVisibleRegions();
+  if (index >= win->visCount)
+    return (const Rect *)0;
+  return &win->visRects[index];
+}
+
+uint8_t WM_GetVisiblePieces(Window *win, const Rect *dirty, Rect *out,
+                            uint8_t maxOut) {
+  uint8_t count = 0;
+  uint8_t i;
+
+  if (!win || !dirty || !out)
+    return 0;
+
+  WM_UpdateVisibleRegions();
+  for (i = 0; i < win->visCount && count < maxOut; i++) {
+    if (DR_RectIntersect(&win->visRects[i], dirty, &out[count]))
+      count++;
+  }
+  return count;
+}
+
+/* Invalidate the parts of `win` the windows above it hide. Call before
+ * restacking: it reads the current visible region. */
+static void window_invalidate_covered(Window *win) {
+  DirtyRegion opaque;
+  DirtyRegion vis;
+  DirtyRegion covered;
+  uint16_t i;
+
+  WM_UpdateVisibleRegions();
+  DR_InitRegion(&vis, win->visRects, WM_VIS_MAX_RECTS);
+  vis.count = win->visCount;
+  DR_InitRegion(&covered, wmRegionStore[0], WM_REGION_MAX_RECTS);
+
+  suQuietOwner = win;
+  if (win->visOverflow || !window_opaque_region(win, &opaque) ||
+      !DR_RegionSubtract(&covered, &opaque, &vis)) {
+    WM_InvalidateRect(&win->frame);
+  } else {
+    for (i = 0; i < covered.count; i++)
+      WM_InvalidateRect(&covered.rects[i]);
+  }
+  suQuietOwner = (Window *)0;
+}
+
+static void window_invalidate_title(Window *win) {
+  if (!(win->flags & WF_VISIBLE) || DR_RectIsEmpty(&win->titleBar))
+    return;
+  suQuietOwner = win;
+  WM_InvalidateRect(&win->titleBar);
+  suQuietOwner = (Window *)0;
+}
+
+static uint32_t rect_area(const Rect *r) {
+  return (uint32_t)(r->right - r->left) * (uint32_t)(r->bottom - r->top);
+}
+
+static Boolean plan_push(WMRedrawPlan *plan, Window *win, const Rect *clip) {
+  if (plan->count >= WM_PLAN_MAX_PIECES)
+    return 0;
+  plan->pieces[plan->count].win = win;
+  plan->pieces[plan->count].clip = *clip;
+  plan->count++;
+  return 1;
+}
+
+/* Front to back: each window claims what it paints of the remaining damage */
+static Boolean plan_front_to_back(const Rect *damage, WMRedrawPlan *plan) {
+  static Rect hitStore[WM_PLAN_MAX_PIECES];
+  DirtyRegion remaining;
+  DirtyRegion next;
+  DirtyRegion cut;
+  DirtyRegion hit;
+  DirtyRegion swap;
+  uint16_t r;
+  Window *win;
+
+  DR_InitRegion(&remaining, wmRegionStore[0], WM_REGION_MAX_RECTS);
+  DR_InitRegion(&next, wmRegionStore[1], WM_REGION_MAX_RECTS);
+  DR_InitRegion(&hit, hitStore, WM_PLAN_MAX_PIECES);
+  DR_RegionSetRect(&remaining, damage);
+
+  for (win = wm.topWindow; win && remaining.count; win = win->below) {
+    if (!(win->flags & WF_VISIBLE))
+      continue;
+
+    if (!window_opaque_region(win, &cut) ||
+        !DR_RegionIntersect(&hit, &remaining, &cut))
+      return 0;
+    for (r = 0; r < hit.count; r++) {
+      if (!plan_push(plan, win, &hit.rects[r]))
+        return 0;
+    }
+    if (hit.count == 0)
+      continue;
+    if (!DR_RegionSubtract(&next, &remaining, &cut))
+      return 0;
+    swap = remaining;
+    remaining = next;
+    next = swap;
+  }
+
+  for (r = 0; r < remaining.count; r++) {
+    if (!plan_push(plan, (Window *)0, &remaining.rects[r]))
+      return 0;
+  }
+
+  /* Reverse into painter's order: desktop first, front window last */
+  for (r = 0; r < plan->count / 2; r++) {
+    WMRedrawPiece tmp = plan->pieces[r];
+    plan->pieces[r] = plan->pieces[plan->count - 1 - r];
+    plan->pieces[plan->count - 1 - r] = tmp;
+  }
+  return 1;
+}
+
+Boolean WM_PlanRedraw(const Rect *dirty, WMRedrawPlan *plan) {
+  Rect screen;
+  Rect damage;
+  Rect bounds;
+  Window *win;
+
+  if (!dirty || !plan)
+    return 0;
+
+  plan->count = 0;
+  plan->overflow = 0;
+  screen.left = 0;
+  screen.top = 0;
+  screen.right = WM_SCREEN_W;
+  screen.bottom = WM_SCREEN_H;
+  if (!DR_RectIntersect(dirty, &screen, &damage))
+    return 1;
+
+  wm.stats.plans++;
+  wm.stats.pixelsDamaged += rect_area(&damage);
+
+  if (!plan_front_to_back(&damage, plan)) {
+    /* Too fragmented: paint desktop and whole windows back to front */
+    plan->count = 0;
+    plan->overflow = 1;
+    wm.stats.planOverflows++;
+    plan_push(plan, (Window *)0, &damage);
+    for (win = wm.bottomWindow; win; win = win->above) {
+      if (!(win->flags & WF_VISIBLE))
+        continue;
+      window_paint_bounds(win, &win->frame, &bounds);
+      if (DR_RectIntersect(&bounds, &damage, &bounds))
+        plan_push(plan, win, &bounds);
+    }
+  }
+  return 1;
+}
+
+void WM_GetStats(WMStats *out) {
+  if (!out)
+    return;
+  *out = wm.stats;
+#ifdef BLT_HOST_TEST
+  out->pixelsPainted = BLT_GetPixelWrites();
+#endif
+}
+
+void WM_ResetStats(void) {
+  memset(&wm.stats, 0, sizeof(wm.stats));
+#ifdef BLT_HOST_TEST
+  BLT_ResetPixelWrites();
+#endif
+}
+
+/* Point is on the window's frame and not covered by a window above */
+static Boolean window_hit(Window *win, Point pt) {
+  uint8_t i;
+
+  if (!rect_contains_point(&win->frame, pt))
+    return 0;
+  for (i = 0; i < win->visCount; i++) {
+    if (rect_contains_point(&win->visRects[i], pt))
+      return 1;
+  }
+  return 0;
+}
+
+/* Invalidate the part of the drag-origin tiles that the window covered at
+ * `shown` but no longer covers at `next`. Everything outside the origin still
+ * holds pre-drag pixels, and everything inside `next` is remapped by Main. */
+static void fast_drag_invalidate_exposed(const Rect *shown, const Rect *next) {
+  Rect origin;
+  Rect was;
+  Rect now;
+  Rect covered;
+  Rect strips[4];
+  uint8_t count;
+  uint8_t i;
+
+  rect_tile_align(&wm.fastDragOrigin, &origin);
+  rect_tile_align(shown, &was);
+  rect_tile_align(next, &now);
+  if (!DR_RectIntersect(&was, &origin, &covered))
+    return;
+
+  count = DR_RectSubtract(&covered, &now, strips, 4);
+  for (i = 0; i < count; i++)
+    WM_InvalidateRect(&strips[i]);
+}
+
 /* ============================================================
  * Public API - Initialization
  * ============================================================ */
@@ -137,10 +1017,14 @@ void WM_Init(void) {
   screen.bottom = WM_SCREEN_H;
   screen.right = WM_SCREEN_W;
   DR_InitList(&wm.dirtyList, wm.dirtyRects, WM_MAX_DIRTY_RECTS, &screen);
+  DR_InitList(&wm.lateList, wm.lateRects, WM_SAVE_UNDER_STALE, &screen);
+  POOL_INIT(&wm.windowPool, wm.windows);
   wm.desktopPattern = 1; /* Gray pattern by default */
   wm.cursorPos.x = WM_SCREEN_W / 2;
   wm.cursorPos.y = WM_SCREEN_H / 2;
   wm.cursorVisible = 1;
+  wm.visStale = 1;
+  suQuietOwner = (Window *)0;
 }
 
 /* ============================================================
@@ -193,6 +1077,7 @@ Window *WM_NewWindow(Rect *bounds, const char *title, WindowStyle style,
 
   /* Mark as visible and dirty */
   if (flags & WF_VISIBLE) {
+    window_reserve_save_under(win);
     WM_InvalidateWindow(win);
   }
 
@@ -203,8 +1088,15 @@ void WM_DisposeWindow(Window *win) {
   if (!win)
     return;
 
-  /* Invalidate the area it occupied */
-  WM_InvalidateRect(&win->frame);
+  if (win == wm.fastDragWindow)
+    WM_EndFastDrag(win->frame.left, win->frame.top);
+  if (win == wm.outlineWindow)
+    wm.outlineWindow = (Window *)0;
+  blit_move_cancel();
+
+  /* Put back what it covered, or invalidate the area it occupied */
+  if (!window_release_save_under(win, 1))
+    WM_InvalidateRect(&win->frame);
 
   /* Unlink from Z-order */
   zorder_unlink(win);
@@ -218,6 +1110,7 @@ void WM_DisposeWindow(Window *win) {
   }
 
   /* Return to pool */
+  chrome_flush(win);
   pool_free(win);
 }
 
@@ -229,10 +1122,17 @@ void WM_SelectWindow(Window *win) {
   if (!win || win == wm.topWindow)
     return;
 
+  /* The pending blit assumed the old stacking order */
+  blit_move_cancel();
+
+  /* Only the title bars change with the hilite (each a chrome cache blit);
+   * the rest of the raised window repaints where it was covered */
+  window_invalidate_covered(win);
+
   /* Deactivate old front window */
   if (wm.activeWindow) {
     wm.activeWindow->flags &= ~WF_HILITED;
-    WM_InvalidateWindow(wm.activeWindow);
+    window_invalidate_title(wm.activeWindow);
   }
 
   /* Move to front */
@@ -242,13 +1142,15 @@ void WM_SelectWindow(Window *win) {
   /* Activate */
   wm.activeWindow = win;
   win->flags |= WF_HILITED;
-  WM_InvalidateWindow(win);
+  window_invalidate_title(win);
 }
 
 void WM_SendToBack(Window *win) {
   if (!win || win == wm.bottomWindow)
     return;
 
+  blit_move_cancel();
+  window_release_save_under(win, 0);
   zorder_unlink(win);
 
   /* Link at bottom */
@@ -274,15 +1176,21 @@ void WM_SendToBack(Window *win) {
 void WM_ShowWindow(Window *win) {
   if (!win || (win->flags & WF_VISIBLE))
     return;
+  blit_move_cancel();
   win->flags |= WF_VISIBLE;
+  wm.visStale = 1;
+  window_reserve_save_under(win);
   WM_InvalidateWindow(win);
 }
 
 void WM_HideWindow(Window *win) {
   if (!win || !(win->flags & WF_VISIBLE))
     return;
+  blit_move_cancel();
   win->flags &= ~WF_VISIBLE;
-  WM_InvalidateRect(&win->frame);
+  wm.visStale = 1;
+  if (!window_release_save_under(win, 1))
+    WM_InvalidateRect(&win->frame);
 }
 
 /* ============================================================
@@ -292,13 +1200,37 @@ void WM_HideWindow(Window *win) {
 void WM_MoveWindow(Window *win, int16_t x, int16_t y) {
   Rect oldFrame;
   int16_t dx, dy;
+  Boolean sameSize;
 
   if (!win)
     return;
 
+  if (win == wm.outlineWindow) {
+    frame_move_to(&wm.outlineFrame, &win->frame, x, y);
+    return;
+  }
+
+  /* The copy beneath belongs to the old position */
+  window_release_save_under(win, 0);
+
   /* Save old position for dirty marking */
   oldFrame = win->frame;
 
+  if (win == wm.fastDragWindow) {
+    /* Snap relative to the drag origin so Main can reuse whole tiles */
+    frame_move_to(&win->frame, &wm.fastDragOrigin,
+                  (int16_t)(wm.fastDragOrigin.left +
+                            snap_to_tile((int16_t)(x - wm.fastDragOrigin.left))),
+                  (int16_t)(wm.fastDragOrigin.top +
+                            snap_to_tile((int16_t)(y - wm.fastDragOrigin.top))));
+    compute_window_rects(win);
+
+    fast_drag_invalidate_exposed(&wm.fastDragShown, &win->frame);
+    wm.fastDragShown = win->frame;
+    move_event_record(win, WM_MOVE_DRAG, &wm.fastDragOrigin, &win->frame);
+    return;
+  }
+
   /* Calculate delta */
   dx = x - win->frame.left;
   dy = y - win->frame.top;
@@ -315,9 +1247,128 @@ void WM_MoveWindow(Window *win, int16_t x, int16_t y) {
   /* Recompute sub-rects */
   compute_window_rects(win);
 
-  /* Dirty both old and new positions */
-  WM_InvalidateRect(&oldFrame);
+  /* One blit per update: an earlier move of this window keeps its source */
+  sameSize = (win->frame.right - win->frame.left ==
+                  oldFrame.right - oldFrame.left &&
+              win->frame.bottom - win->frame.top ==
+                  oldFrame.bottom - oldFrame.top)
+                 ? 1
+                 : 0;
+  if (wm.blitWindow && (wm.blitWindow != win || !sameSize))
+    blit_move_cancel();
+
+  if ((win->flags & WF_VISIBLE) && sameSize) {
+    if (!wm.blitWindow) {
+      wm.blitWindow = win;
+      wm.blitFrom = oldFrame;
+    }
+  } else {
+    /* Dirty both old and new positions */
+    Rect paint;
+    window_paint_bounds(win, &oldFrame, &paint);
+    WM_InvalidateRect(&paint);
+    window_paint_bounds(win, &win->frame, &paint);
+    WM_InvalidateRect(&paint);
+  }
+  move_event_record(win, WM_MOVE_PLAIN, &oldFrame, &win->frame);
+}
+
+void WM_SetFastDrag(Boolean enabled) {
+  if (!enabled && wm.fastDragWindow)
+    WM_EndFastDrag(wm.fastDragWindow->frame.left,
+                   wm.fastDragWindow->frame.top);
+  wm.fastDragEnabled = enabled ? 1 : 0;
+}
+
+Boolean WM_BeginFastDrag(Window *win) {
+  Rect tiles;
+  uint16_t tileCount;
+
+  if (!wm.fastDragEnabled || !win || wm.fastDragWindow)
+    return 0;
+  /* Remapped tiles are drawn over everything, so only the front window */
+  if (win != wm.topWindow || !(win->flags & WF_VISIBLE))
+    return 0;
+
+  rect_tile_align(&win->frame, &tiles);
+  tileCount = (uint16_t)(((tiles.right - tiles.left) >> 3) *
+                         ((tiles.bottom - tiles.top) >> 3));
+  if (tileCount > WM_FAST_DRAG_MAX_TILES)
+    return 0;
+
+  /* Main reuses the uploaded tiles, so they must already show the window */
+  blit_move_cancel();
+  wm.fastDragWindow = win;
+  wm.fastDragOrigin = win->frame;
+  wm.fastDragShown = win->frame;
+  return 1;
+}
+
+void WM_EndFastDrag(int16_t x, int16_t y) {
+  Window *win = wm.fastDragWindow;
+  Rect tiles;
+
+  if (!win)
+    return;
+
+  wm.fastDragWindow = (Window *)0;
+  frame_move_to(&win->frame, &wm.fastDragOrigin, x, y);
+  compute_window_rects(win);
+
+  /* Main restores the identity nametable; redraw everything it touched */
+  rect_tile_align(&wm.fastDragOrigin, &tiles);
+  WM_InvalidateRect(&tiles);
+  rect_tile_align(&wm.fastDragShown, &tiles);
+  WM_InvalidateRect(&tiles);
   WM_InvalidateWindow(win);
+  move_event_record(win, WM_MOVE_DROP, &wm.fastDragOrigin, &win->frame);
+}
+
+Boolean WM_IsFastDragging(void) { return wm.fastDragWindow ? 1 : 0; }
+
+void WM_SetOutlineDrag(Boolean enabled) {
+  if (!enabled && wm.outlineWindow)
+    WM_EndOutlineDrag(wm.outlineFrame.left, wm.outlineFrame.top);
+  wm.outlineDragEnabled = enabled ? 1 : 0;
+}
+
+Boolean WM_BeginOutlineDrag(Window *win) {
+  if (!wm.outlineDragEnabled || !win || wm.outlineWindow ||
+      wm.fastDragWindow)
+    return 0;
+  if (!(win->flags & WF_VISIBLE) || !BLT_GetFramebuffer())
+    return 0;
+
+  wm.outlineWindow = win;
+  wm.outlineFrame = win->frame;
+  return 1;
+}
+
+void WM_EndOutlineDrag(int16_t x, int16_t y) {
+  Window *win = wm.outlineWindow;
+
+  if (!win)
+    return;
+
+  /* The outline is erased at the next update; the window moves as usual */
+  wm.outlineWindow = (Window *)0;
+  WM_MoveWindow(win, x, y);
+}
+
+Boolean WM_IsOutlineDragging(void) { return wm.outlineWindow ? 1 : 0; }
+
+void WM_DrawDragOutline(void) {
+  Rect savedClip;
+
+  if (!wm.outlineWindow || wm.outlineDrawn)
+    return;
+
+  BLT_GetClipRect(&savedClip);
+  BLT_ResetClip();
+  BLT_InvertFrame(&wm.outlineFrame);
+  BLT_SetClipRect(&savedClip);
+  wm.outlineShown = wm.outlineFrame;
+  wm.outlineDrawn = 1;
 }
 
 void WM_SizeWindow(Window *win, int16_t w, int16_t h) {
@@ -326,6 +1377,9 @@ void WM_SizeWindow(Window *win, int16_t w, int16_t h) {
   if (!win)
     return;
 
+  blit_move_cancel();
+  window_release_save_under(win, 0);
+  chrome_flush(win);
   oldFrame = win->frame;
 
   win->frame.right = win->frame.left + w;
@@ -348,9 +1402,65 @@ void WM_SetTitle(Window *win, const char *title) {
     win->title[i] = title[i];
   }
   win->title[i] = '\0';
+  chrome_flush(win);
 
   /* Only the title bar needs redraw */
+  suQuietOwner = win;
   WM_InvalidateRect(&win->titleBar);
+  suQuietOwner = (Window *)0;
+}
+
+void WM_DrawWindowFrame(Window *win, const Font *titleFont) {
+  WMChromeEntry *e;
+  Rect clip;
+  Rect part;
+  uint32_t size;
+
+  if (!win)
+    return;
+
+  BLT_DrawWindowBody(win);
+  if (win->style == WM_STYLE_PLAIN || win->style == WM_STYLE_SHADOW)
+    return;
+
+  BLT_GetClipRect(&clip);
+  if (!DR_RectIntersect(&win->titleBar, &clip, &part))
+    return;
+  if (!chrome_cacheable(win)) {
+    BLT_DrawWindowTitle(win, titleFont);
+    return;
+  }
+
+  e = chrome_find(win, titleFont);
+  if (e) {
+    e->lastUse = ++wm.chromeClock;
+    BLT_RestoreRect(&win->titleBar, &part, chrome_buffer(e));
+    wm.stats.chromeHits++;
+    return;
+  }
+
+  BLT_DrawWindowTitle(win, titleFont);
+  wm.stats.chromeMisses++;
+
+  /* Only a title bar drawn whole is worth keeping */
+  if (part.left != win->titleBar.left || part.top != win->titleBar.top ||
+      part.right != win->titleBar.right || part.bottom != win->titleBar.bottom)
+    return;
+  size = BLT_SaveUnderSize(&win->titleBar);
+  if (size == 0 || size > WM_CHROME_BYTES)
+    return;
+  e = chrome_alloc((uint16_t)size);
+  if (!e)
+    return;
+
+  e->windowId = (uint8_t)(win->id + 1);
+  e->hilited = (win->flags & WF_HILITED) ? 1 : 0;
+  e->phase = chrome_phase(&win->titleBar);
+  e->mode = (uint8_t)BLT_GetMode();
+  e->font = titleFont;
+  e->width = (int16_t)(win->titleBar.right - win->titleBar.left);
+  e->lastUse = ++wm.chromeClock;
+  BLT_SaveRect(&win->titleBar, (const Rect *)0, chrome_buffer(e));
 }
 
 /* ============================================================
@@ -367,12 +1477,13 @@ WindowPart WM_FindWindow(Point pt, Window **outWin) {
     return WM_PART_MENUBAR;
   }
 
-  /* Walk Z-order front to back */
+  /* Walk Z-order front to back; fully covered windows have no pieces */
+  WM_UpdateVisibleRegions();
   for (win = wm.topWindow; win; win = win->below) {
-    if (!(win->flags & WF_VISIBLE))
+    if (!win->visCount)
       continue;
 
-    if (rect_contains_point(&win->frame, pt)) {
+    if (window_hit(win, pt)) {
       *outWin = win;
 
       /* Check close box (top-left of title bar) */
@@ -425,15 +1536,31 @@ WindowPart WM_FindWindow(Point pt, Window **outWin) {
  * ============================================================ */
 
 void WM_InvalidateRect(Rect *r) {
+  uint8_t i;
+
   if (!r)
     return;
 
   DR_AddRect(&wm.dirtyList, r);
+  DR_MarkTileBitmap(&wm.dirtyTiles, r);
+
+  /* Whatever redraws beneath a window's save-under is newer than the copy.
+   * A copy yet to be taken misses it too: it is taken before the redraw. */
+  for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++) {
+    WMSaveUnder *su = &wm.saveUnders[i];
+    if (su->owner && su->owner == suQuietOwner)
+      continue;
+    if (su->state == WM_SU_PENDING ||
+        (su->state == WM_SU_SAVED && su->owner))
+      su_add_stale(su, r);
+  }
 }
 
 void WM_InvalidateWindow(Window *win) {
   if (win) {
+    suQuietOwner = win;
     WM_InvalidateRect(&win->frame);
+    suQuietOwner = (Window *)0;
   }
 }
 
@@ -448,6 +1575,11 @@ void WM_ValidateRect(Rect *r) {
 
 uint8_t WM_BeginUpdate(void) {
   /* Returns the number of dirty rects to process */
+  wm.inUpdate = 1;
+  outline_erase();
+  su_restore_deferred();
+  blit_move_apply();
+  su_capture_pending();
   return DR_GetCount(&wm.dirtyList);
 }
 
@@ -455,9 +1587,116 @@ DirtyRect *WM_GetDirtyRect(uint8_t index) {
   return DR_GetRect(&wm.dirtyList, index);
 }
 
+uint8_t WM_GetDirtyCount(void) { return DR_GetCount(&wm.dirtyList); }
+
+const DirtyTileBitmap *WM_GetDirtyTiles(void) { return &wm.dirtyTiles; }
+
 void WM_EndUpdate(void) {
+  uint8_t count = DR_GetCount(&wm.lateList);
+  uint8_t i;
+
   DR_ClearList(&wm.dirtyList);
+  DR_ClearTileBitmap(&wm.dirtyTiles);
   wm.menuBarDirty = 0;
+  wm.moveEventCount = 0;
+  wm.inUpdate = 0;
+
+  /* Restored mid-update, after this frame's repaint */
+  for (i = 0; i < count; i++) {
+    DirtyRect *dr = DR_GetRect(&wm.lateList, i);
+    if (dr && dr->valid)
+      WM_InvalidateRect(&dr->rect);
+  }
+  DR_ClearList(&wm.lateList);
+}
+
+int8_t WM_SaveUnder(const Rect *r) {
+  int8_t slot = su_reserve(r, (Window *)0);
+
+  if (slot >= 0 && wm.inUpdate)
+    su_capture(&wm.saveUnders[slot], 1);
+  return slot;
+}
+
+void WM_RefreshSaveUnder(int8_t handle) {
+  WMSaveUnder *su;
+  uint8_t count;
+  uint8_t i;
+
+  if (handle < 0 || handle >= WM_SAVE_UNDER_SLOTS)
+    return;
+  su = &wm.saveUnders[handle];
+  if (su->state != WM_SU_SAVED || !wm.inUpdate)
+    return;
+
+  count = DR_GetCount(&wm.dirtyList);
+  for (i = 0; i < count; i++) {
+    DirtyRect *dr = DR_GetRect(&wm.dirtyList, i);
+    if (dr && dr->valid)
+      BLT_SaveRect(&su->rect, &dr->rect, su_buffer(su));
+  }
+}
+
+void WM_RestoreUnder(int8_t handle) {
+  WMSaveUnder *su;
+  Rect r;
+
+  if (handle < 0 || handle >= WM_SAVE_UNDER_SLOTS)
+    return;
+  su = &wm.saveUnders[handle];
+
+  switch (su->state) {
+  case WM_SU_PENDING:
+    /* Never captured: fall back to redrawing the area */
+    r = su->rect;
+    su_release(handle);
+    WM_InvalidateRect(&r);
+    break;
+  case WM_SU_SAVED:
+    if (wm.inUpdate) {
+      /* This frame's repaints beneath a surface drawn over everything are
+       * newer than its copy */
+      if (!su->owner)
+        WM_RefreshSaveUnder(handle);
+      su_restore(handle, 1);
+    } else {
+      /* Word RAM belongs to Main until the next update */
+      if (su->owner)
+        su->owner->saveUnder = 0;
+      su->owner = (Window *)0;
+      su->state = WM_SU_RESTORE;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void WM_SetCursorPos(int16_t x, int16_t y) {
+  wm.cursorPos.x = x;
+  wm.cursorPos.y = y;
+}
+
+uint8_t WM_GetMoveEventCount(void) { return wm.moveEventCount; }
+
+const WindowMoveEvent *WM_GetMoveEvent(uint8_t index) {
+  if (index >= wm.moveEventCount)
+    return (const WindowMoveEvent *)0;
+  return &wm.moveEvents[index];
+}
+
+/* The one event a frame reports to Main: the newest drag/drop if there is
+ * one, since a missed drop would leave Plane A remapped; otherwise the newest
+ * plain move. */
+const WindowMoveEvent *WM_GetPublishedMoveEvent(void) {
+  uint8_t i = wm.moveEventCount;
+
+  while (i > 0) {
+    i--;
+    if (wm.moveEvents[i].kind != WM_MOVE_PLAIN)
+      return &wm.moveEvents[i];
+  }
+  return WM_GetMoveEvent((uint8_t)(wm.moveEventCount - 1));
 }
 
 /* ============================================================
@@ -543,17 +1782,18 @@ void WM_SetDesktopPattern(uint8_t pattern) {
  * ============================================================ */
 
 Window *WM_GetWindowById(uint8_t id) {
-  if (id < WM_MAX_WINDOWS && wm.poolUsed[id]) {
-    return &wm.pool[id];
-  }
-  return (Window *)0;
+  return POOL_AT(&wm.windowPool, Window, id);
 }
 
 /* ============================================================
  * Public API - Debug
  * ============================================================ */
 
-uint8_t WM_GetWindowCount(void) { return wm.windowCount; }
+uint8_t WM_GetWindowCount(void) { return wm.windowPool.used; }
+
+void WM_GetWindowPoolStats(PoolStats *out) {
+  POOL_GetStats(&wm.windowPool, out);
+}
 
 /* ============================================================
  * Public API - HitTest Wrapper
@@ -17,6 +17,7 @@ typedef struct DesktopHostFixture {
 } DesktopHostFixture;
 
 static int failures;
+static uint32_t heapStore[16384 / 4];
 
 static void expect_true(uint8_t value, const char *name) {
   if (!value) {
@@ -215,6 +216,7 @@ static void redraws_after_event_close_and_reopen(void) {
 }
 
 int main(void) {
+  MEM_Init(heapStore, heapStore + sizeof(heapStore) / 4);
   hosts_text_app_with_desktop_callbacks();
   reports_desktop_callback_failures();
   redraws_after_event_close_and_reopen();
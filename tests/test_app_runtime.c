@@ -20,6 +20,7 @@ typedef struct RuntimeFixture {
 } RuntimeFixture;
 
 static int failures;
+static uint32_t heapStore[16384 / 4];
 
 static void expect_true(uint8_t value, const char *name) {
   if (!value) {
@@ -341,11 +342,50 @@ static void prevents_overlapping_apps(void) {
   expect_status(APP_RT_Stop(&runtime), APP_RT_OK, "stop first app");
 }
 
+static void releases_app_arena_on_stop(void) {
+  RuntimeFixture fixture = {0};
+  AppRuntime runtime;
+  AppCatalogEntry entry = make_text_entry();
+  AppRuntimeServices services = make_services(&fixture);
+  AppDefinition app = make_text_definition(&fixture);
+  uint32_t freeBefore = MEM_GetFreeBytes();
+  uint16_t i;
+
+  APP_RT_Init(&runtime);
+  expect_true(APP_RT_Alloc(&runtime.context, 4) == 0, "no arena when idle");
+  expect_status(APP_RT_Start(&runtime, &services, &entry, &app), APP_RT_OK,
+                "start with arena");
+  expect_true(runtime.context.arena == &runtime.arena, "context arena");
+  expect_true(runtime.arena.size == 4096 + 512, "arena sized from limits");
+
+  /* Piecemeal allocations, none freed by the app */
+  for (i = 0; i < 64; i++) {
+    expect_true(APP_RT_Alloc(&runtime.context, 72) != 0, "app allocation");
+  }
+  expect_true(APP_RT_Alloc(&runtime.context, 72) == 0, "arena exhausted");
+  expect_status(APP_RT_Stop(&runtime), APP_RT_OK, "stop releases arena");
+  expect_true(MEM_GetFreeBytes() == freeBefore, "heap restored by stop");
+
+  fixture.failInit = 1;
+  expect_status(APP_RT_Start(&runtime, &services, &entry, &app),
+                APP_RT_INIT_FAILED, "init failure");
+  expect_true(MEM_GetFreeBytes() == freeBefore, "heap restored on failure");
+
+  fixture.failInit = 0;
+  services.limits.maxDocumentBytes = sizeof(heapStore);
+  expect_status(APP_RT_Start(&runtime, &services, &entry, &app),
+                APP_RT_RESOURCE_LIMIT, "arena larger than heap");
+  expect_u16(fixture.initCalls, 2, "init skipped without arena");
+  expect_true(MEM_Validate() == 0, "heap valid after app runs");
+}
+
 int main(void) {
+  MEM_Init(heapStore, heapStore + sizeof(heapStore) / 4);
   runs_app_lifecycle_through_services();
   rejects_bad_runtime_boundaries();
   reports_lifecycle_failures();
   prevents_overlapping_apps();
+  releases_app_arena_on_stop();
 
   if (failures) {
     printf("app runtime tests failed: %d\n", failures);
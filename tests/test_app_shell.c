@@ -15,6 +15,7 @@ typedef struct ShellFixture {
 } ShellFixture;
 
 static int failures;
+static uint32_t heapStore[16384 / 4];
 
 static void expect_true(uint8_t value, const char *name) {
   if (!value) {
@@ -208,6 +209,7 @@ static void rejects_missing_apps_and_reopens_after_close(void) {
 }
 
 int main(void) {
+  MEM_Init(heapStore, heapStore + sizeof(heapStore) / 4);
   launches_text_app_through_shell_services();
   rejects_missing_apps_and_reopens_after_close();
 
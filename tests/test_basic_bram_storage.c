@@ -290,7 +290,9 @@ static void shell_save_and_load_route_through_internal_bram_bridge(void) {
   BasicLine sourceLines[4];
   BasicLine destLines[4];
   uint8_t sourceStorage[96];
+  uint8_t sourceCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t destStorage[96];
+  uint8_t destCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t scratch[192];
   BasicProgram source;
   BasicProgram dest;
@@ -318,9 +320,10 @@ static void shell_save_and_load_route_through_internal_bram_bridge(void) {
   expect_true(BAS_StorageBindIO(&adapter, scratch, sizeof(scratch), &io),
               "bind BASIC BRAM storage IO");
 
-  BAS_InitProgram(&source, sourceLines, 4, sourceStorage,
-                  sizeof(sourceStorage));
-  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage));
+  BAS_InitProgram(&source, sourceLines, 4, sourceStorage, sizeof(sourceStorage),
+                  sourceCode, sizeof(sourceCode));
+  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage),
+                  destCode, sizeof(destCode));
   expect_true(BAS_StoreSourceLine(&source, "10 PRINT \"BRAM\""),
               "store source before BRAM SAVE");
   expect_true(BAS_SubmitConsoleLineWithStorage(
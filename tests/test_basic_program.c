@@ -1,6 +1,7 @@
 #include "basic.h"
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 static int failures;
 static char listedLines[4][48];
@@ -175,9 +176,11 @@ static void parse_print_line_tokenizes_keyword(void) {
 static void program_stores_lines_sorted(void) {
   BasicLine lines[4];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 4)];
   BasicProgram program;
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "20 GOTO 10"), "store line 20");
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"HELLO\""),
               "store line 10");
@@ -199,10 +202,12 @@ static void keyword_prefix_stays_raw(void) {
 static void replacing_line_compacts_storage(void) {
   BasicLine lines[4];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 4)];
   BasicProgram program;
   char out[40];
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"HELLO\""),
               "store original line");
   expect_true(BAS_StoreSourceLine(&program, "20 END"), "store end line");
@@ -220,9 +225,11 @@ static void replacing_line_compacts_storage(void) {
 static void empty_body_deletes_line(void) {
   BasicLine lines[4];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 4)];
   BasicProgram program;
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"HELLO\""),
               "store line before delete");
   expect_true(BAS_StoreSourceLine(&program, "10"), "delete line");
@@ -235,16 +242,19 @@ static void program_image_round_trips_tokenized_program(void) {
   BasicLine lines[4];
   BasicLine importedLines[4];
   uint8_t storage[128];
+  uint8_t code[BAS_CODE_CAPACITY(128, 4)];
   uint8_t importedStorage[128];
+  uint8_t importedCode[BAS_CODE_CAPACITY(128, 4)];
   uint8_t image[192];
   BasicProgram program;
   BasicProgram imported;
   uint16_t written = 0;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitProgram(&imported, importedLines, 4, importedStorage,
-                  sizeof(importedStorage));
+                  sizeof(importedStorage), importedCode, sizeof(importedCode));
   clear_list_capture();
 
   expect_true(BAS_StoreSourceLine(&program, "20 GOTO 40"),
@@ -279,11 +289,13 @@ static void program_image_round_trips_tokenized_program(void) {
 static void program_image_reports_required_export_size(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   uint8_t image[4];
   BasicProgram program;
   uint16_t written = 0;
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 END"),
               "store small image program");
 
@@ -298,16 +310,19 @@ static void program_image_rejects_bad_magic_without_clearing_program(void) {
   BasicLine lines[1];
   BasicLine importedLines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   uint8_t importedStorage[32];
+  uint8_t importedCode[BAS_CODE_CAPACITY(32, 1)];
   uint8_t image[64];
   BasicProgram program;
   BasicProgram imported;
   uint16_t written = 0;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitProgram(&imported, importedLines, 1, importedStorage,
-                  sizeof(importedStorage));
+                  sizeof(importedStorage), importedCode, sizeof(importedCode));
   clear_list_capture();
 
   expect_true(BAS_StoreSourceLine(&program, "10 END"),
@@ -332,9 +347,11 @@ static void rejects_invalid_or_oversized_source(void) {
   BasicParsedLine parsed;
   BasicLine lines[1];
   uint8_t storage[4];
+  uint8_t code[BAS_CODE_CAPACITY(4, 1)];
   BasicProgram program;
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
 
   expect_false(BAS_ParseSourceLine("PRINT \"NO LINE\"", &parsed),
                "reject missing line number");
@@ -348,11 +365,13 @@ static void rejects_invalid_or_oversized_source(void) {
 static void shell_stores_lines_and_lists_program(void) {
   BasicLine lines[4];
   uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 4)];
   BasicProgram program;
   BasicCommandResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   clear_list_capture();
 
   expect_true(BAS_SubmitConsoleLine(&program, "20 GOTO 10", capture_list_line,
@@ -378,11 +397,13 @@ static void shell_stores_lines_and_lists_program(void) {
 static void shell_new_clears_program(void) {
   BasicLine lines[4];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 4)];
   BasicProgram program;
   BasicCommandResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"HELLO\""),
               "store before NEW");
   expect_true(BAS_SubmitConsoleLine(&program, "NEW", capture_list_line, 0,
@@ -397,11 +418,13 @@ static void shell_new_clears_program(void) {
 static void shell_run_executes_print_program(void) {
   BasicLine lines[4];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 4)];
   BasicProgram program;
   BasicCommandResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   clear_run_capture();
 
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"HELLO\""),
@@ -424,6 +447,7 @@ static void shell_run_executes_print_program(void) {
 static void shell_save_exports_program_image_to_storage_callback(void) {
   BasicLine lines[4];
   uint8_t storageBytes[96];
+  uint8_t codeBytes[BAS_CODE_CAPACITY(96, 4)];
   uint8_t imageScratch[192];
   BasicProgram program;
   BasicStorageFixture storage = {0};
@@ -431,7 +455,8 @@ static void shell_save_exports_program_image_to_storage_callback(void) {
   BasicCommandResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 4, storageBytes, sizeof(storageBytes));
+  BAS_InitProgram(&program, lines, 4, storageBytes, sizeof(storageBytes),
+                  codeBytes, sizeof(codeBytes));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"SAVE\""),
               "store line before shell SAVE");
   expect_true(BAS_StoreSourceLine(&program, "20 END"),
@@ -463,7 +488,9 @@ static void shell_load_imports_program_image_from_storage_callback(void) {
   BasicLine sourceLines[4];
   BasicLine destLines[4];
   uint8_t sourceStorage[96];
+  uint8_t sourceCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t destStorage[96];
+  uint8_t destCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t imageScratch[192];
   BasicProgram source;
   BasicProgram dest;
@@ -473,9 +500,10 @@ static void shell_load_imports_program_image_from_storage_callback(void) {
   uint16_t written = 0;
   char lineBuffer[48];
 
-  BAS_InitProgram(&source, sourceLines, 4, sourceStorage,
-                  sizeof(sourceStorage));
-  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage));
+  BAS_InitProgram(&source, sourceLines, 4, sourceStorage, sizeof(sourceStorage),
+                  sourceCode, sizeof(sourceCode));
+  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage),
+                  destCode, sizeof(destCode));
   clear_list_capture();
 
   expect_true(BAS_StoreSourceLine(&source, "10 PRINT \"LOAD\""),
@@ -515,6 +543,7 @@ static void shell_load_imports_program_image_from_storage_callback(void) {
 static void shell_load_failure_preserves_existing_program(void) {
   BasicLine destLines[4];
   uint8_t destStorage[96];
+  uint8_t destCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t imageScratch[192];
   BasicProgram dest;
   BasicStorageFixture storage = {0};
@@ -522,7 +551,8 @@ static void shell_load_failure_preserves_existing_program(void) {
   BasicCommandResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage));
+  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage),
+                  destCode, sizeof(destCode));
   clear_list_capture();
   expect_true(BAS_StoreSourceLine(&dest, "10 PRINT \"KEEP\""),
               "store old line before failed LOAD");
@@ -604,11 +634,13 @@ static void rejects_bad_expressions(void) {
 static void runner_reports_unsupported_statement_line(void) {
   BasicLine lines[2];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 2)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 REM NOT YET"),
               "store unsupported runner line");
 
@@ -623,11 +655,13 @@ static void runner_reports_unsupported_statement_line(void) {
 static void runner_goto_jumps_to_target_line(void) {
   BasicLine lines[5];
   uint8_t storage[128];
+  uint8_t code[BAS_CODE_CAPACITY(128, 5)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 5, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 5, storage, sizeof(storage), code,
+                  sizeof(code));
   clear_run_capture();
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"A\""),
               "store goto first print");
@@ -651,11 +685,13 @@ static void runner_goto_jumps_to_target_line(void) {
 static void runner_reports_missing_goto_target(void) {
   BasicLine lines[2];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 2)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 GOTO 999"),
               "store missing goto target");
 
@@ -669,11 +705,13 @@ static void runner_reports_missing_goto_target(void) {
 static void runner_gosub_returns_to_next_line(void) {
   BasicLine lines[6];
   uint8_t storage[160];
+  uint8_t code[BAS_CODE_CAPACITY(160, 6)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage), code,
+                  sizeof(code));
   clear_run_capture();
 
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"A\""),
@@ -701,11 +739,13 @@ static void runner_gosub_returns_to_next_line(void) {
 static void runner_reports_missing_gosub_target(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 GOSUB 999"),
               "store missing gosub target");
 
@@ -719,11 +759,13 @@ static void runner_reports_missing_gosub_target(void) {
 static void runner_reports_return_without_gosub(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 RETURN"),
               "store stray RETURN");
 
@@ -738,11 +780,13 @@ static void runner_reports_return_without_gosub(void) {
 static void runner_reports_gosub_stack_overflow(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 GOSUB 10"),
               "store recursive GOSUB");
 
@@ -757,12 +801,14 @@ static void runner_reports_gosub_stack_overflow(void) {
 static void runner_if_then_jumps_when_comparison_true(void) {
   BasicLine lines[6];
   uint8_t storage[160];
+  uint8_t code[BAS_CODE_CAPACITY(160, 6)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   clear_run_capture();
 
@@ -789,12 +835,14 @@ static void runner_if_then_jumps_when_comparison_true(void) {
 static void runner_if_then_falls_through_when_comparison_false(void) {
   BasicLine lines[6];
   uint8_t storage[160];
+  uint8_t code[BAS_CODE_CAPACITY(160, 6)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   clear_run_capture();
 
@@ -822,12 +870,14 @@ static void runner_if_then_falls_through_when_comparison_false(void) {
 static void runner_if_then_accepts_goto_target(void) {
   BasicLine lines[6];
   uint8_t storage[160];
+  uint8_t code[BAS_CODE_CAPACITY(160, 6)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 6, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   clear_run_capture();
 
@@ -855,12 +905,14 @@ static void runner_if_then_accepts_goto_target(void) {
 static void runner_if_then_handles_relational_operators(void) {
   BasicLine lines[13];
   uint8_t storage[320];
+  uint8_t code[BAS_CODE_CAPACITY(320, 13)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 13, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 13, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   clear_run_capture();
 
@@ -903,11 +955,13 @@ static void runner_if_then_handles_relational_operators(void) {
 static void runner_if_then_reports_missing_target(void) {
   BasicLine lines[1];
   uint8_t storage[48];
+  uint8_t code[BAS_CODE_CAPACITY(48, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 IF 1 THEN 999"),
               "store missing IF target");
 
@@ -921,11 +975,13 @@ static void runner_if_then_reports_missing_target(void) {
 static void runner_if_then_reports_bad_condition(void) {
   BasicLine lines[2];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 2)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[48];
 
-  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 IF \"X\" THEN 20"),
               "store bad IF condition");
   expect_true(BAS_StoreSourceLine(&program, "20 END"),
@@ -941,11 +997,13 @@ static void runner_if_then_reports_bad_condition(void) {
 static void runner_stops_goto_loops_at_step_limit(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 GOTO 10"),
               "store infinite goto loop");
 
@@ -961,11 +1019,13 @@ static void runner_stops_goto_loops_at_step_limit(void) {
 static void runner_reports_bad_print_expression_line(void) {
   BasicLine lines[2];
   uint8_t storage[64];
+  uint8_t code[BAS_CODE_CAPACITY(64, 2)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 2, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT 1 + \"X\""),
               "store bad print expression line");
 
@@ -979,13 +1039,15 @@ static void runner_reports_bad_print_expression_line(void) {
 static void runner_let_sets_integer_variable(void) {
   BasicLine lines[3];
   uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 3)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[48];
   int16_t stored = 0;
 
-  BAS_InitProgram(&program, lines, 3, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 3, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   clear_run_capture();
 
@@ -1010,11 +1072,13 @@ static void runner_let_sets_integer_variable(void) {
 static void runner_reports_undefined_variable_line(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT A"),
               "store undefined variable print");
 
@@ -1029,12 +1093,14 @@ static void runner_reports_undefined_variable_line(void) {
 static void runner_rejects_string_assignment(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   expect_true(BAS_StoreSourceLine(&program, "10 LET A = \"X\""),
               "store string assignment");
@@ -1053,13 +1119,15 @@ static void runner_input_assigns_integer_variable(void) {
   BasicInputFixture input = {inputLines, 1, 0};
   BasicLine lines[3];
   uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 3)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[48];
   int16_t stored = 0;
 
-  BAS_InitProgram(&program, lines, 3, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 3, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   clear_run_capture();
 
@@ -1085,11 +1153,13 @@ static void runner_input_assigns_integer_variable(void) {
 static void runner_input_reports_unavailable_source(void) {
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 INPUT A"),
               "store unavailable input statement");
 
@@ -1106,12 +1176,14 @@ static void runner_input_reports_bad_integer(void) {
   BasicInputFixture input = {inputLines, 1, 0};
   BasicLine lines[1];
   uint8_t storage[32];
+  uint8_t code[BAS_CODE_CAPACITY(32, 1)];
   BasicProgram program;
   BasicRuntime runtime;
   BasicRunResult result;
   char lineBuffer[32];
 
-  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 1, storage, sizeof(storage), code,
+                  sizeof(code));
   BAS_InitRuntime(&runtime);
   expect_true(BAS_StoreSourceLine(&program, "10 INPUT A"),
               "store bad input statement");
@@ -1124,6 +1196,504 @@ static void runner_input_reports_bad_integer(void) {
   expect_u16(result.errorLine, 10, "bad input line");
 }
 
+static void full_text_storage_stays_available(void) {
+  BasicLine lines[BAS_MAX_PROGRAM_LINES];
+  BasicLine importedLines[BAS_MAX_PROGRAM_LINES];
+  uint8_t storage[252];
+  uint8_t code[BAS_CODE_CAPACITY(252, BAS_MAX_PROGRAM_LINES)];
+  uint8_t importedStorage[252];
+  uint8_t importedCode[BAS_CODE_CAPACITY(252, BAS_MAX_PROGRAM_LINES)];
+  uint8_t image[8U + 42U * 6U + 252U];
+  BasicProgram program;
+  BasicProgram imported;
+  BasicRuntime runtime;
+  BasicRunResult result;
+  char lineBuffer[32];
+  char source[16];
+  uint16_t written = 0;
+  int16_t value = 0;
+  uint8_t count = 0;
+
+  /* Six text bytes per line; the code buffer must not eat into them */
+  BAS_InitProgram(&program, lines, BAS_MAX_PROGRAM_LINES, storage,
+                  sizeof(storage), code, sizeof(code));
+  while (count < BAS_MAX_PROGRAM_LINES) {
+    snprintf(source, sizeof(source), "%u LET A=A+1", count + 1U);
+    if (!BAS_StoreSourceLine(&program, source))
+      break;
+    count++;
+  }
+  expect_u8(count, 42, "text capacity lines");
+  expect_u16(program.storageUsed, sizeof(storage), "text fills storage");
+
+  /* A full image in the unchanged SBAS format loads into the same size */
+  expect_true(BAS_ExportProgramImage(&program, image, sizeof(image), &written),
+              "export full program");
+  expect_u16(written, sizeof(image), "full image size");
+  BAS_InitProgram(&imported, importedLines, BAS_MAX_PROGRAM_LINES,
+                  importedStorage, sizeof(importedStorage), importedCode,
+                  sizeof(importedCode));
+  expect_true(BAS_ImportProgramImage(&imported, image, written),
+              "import full program");
+  expect_u8(imported.lineCount, 42, "imported full line count");
+
+  BAS_InitRuntime(&runtime);
+  BAS_RuntimeSetInteger(&runtime, 'A', 0);
+  expect_true(BAS_RunProgramWithRuntime(&imported, &runtime, capture_run_output,
+                                        0, lineBuffer, sizeof(lineBuffer),
+                                        &result),
+              "run imported full program");
+  expect_true(BAS_RuntimeGetInteger(&runtime, 'A', &value),
+              "full program variable");
+  expect_u16((uint16_t)value, 42, "full program ran every line");
+}
+
+/*
+ * Run 'program' repeatedly for at least 20000 runs and 0.1s, checking each
+ * run halts after printing 'expected'. Returns statements per second.
+ */
+static double bench_program(const BasicProgram *program, const char *expected,
+                            const char *name) {
+  BasicRuntime runtime;
+  BasicExecState state;
+  char lineBuffer[32];
+  uint32_t statements = 0;
+  uint32_t runs = 0;
+  uint8_t allMatched = 1;
+  clock_t start = clock();
+  double seconds;
+  double rate;
+
+  do {
+    clear_run_capture();
+    BAS_InitRuntime(&runtime);
+    BAS_ExecInit(&state, program, &runtime, capture_run_output, 0, 0,
+                 lineBuffer, sizeof(lineBuffer));
+    if (BAS_Step(&state, 0xFFFFU) != BAS_RUN_HALTED ||
+        runOutputLineCount != 1 || strcmp(runOutputLines[0], expected) != 0)
+      allMatched = 0;
+    statements += state.statementsExecuted;
+    runs++;
+  } while (runs < 20000U || clock() - start < CLOCKS_PER_SEC / 10);
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  rate = seconds > 0 ? (double)statements / seconds : 0.0;
+
+  expect_true(allMatched, name);
+  printf("basic bench: %-22s %lu statements in %.3fs (%.0f statements/s)\n",
+         name, (unsigned long)statements, seconds, rate);
+  return rate;
+}
+
+static void compiled_runner_benchmark(void) {
+  static const char *const source[] = {
+      "10 LET A = 0", "20 LET A = A + 1", "30 IF A < 40 THEN 20",
+      "40 PRINT A - 1 + 1", "50 END"};
+  BasicLine lines[5];
+  BasicLine importedLines[5];
+  uint8_t storage[192];
+  uint8_t code[BAS_CODE_CAPACITY(192, 5)];
+  uint8_t importedStorage[192];
+  uint8_t importedCode[BAS_CODE_CAPACITY(192, 5)];
+  uint8_t image[128];
+  BasicProgram program;
+  BasicProgram imported;
+  BasicRunResult result;
+  char lineBuffer[32];
+  uint16_t written = 0;
+
+  BAS_InitProgram(&program, lines, 5, storage, sizeof(storage), code,
+                  sizeof(code));
+  BAS_InitProgram(&imported, importedLines, 5, importedStorage,
+                  sizeof(importedStorage), importedCode, sizeof(importedCode));
+  for (uint8_t i = 0; i < 5; i++) {
+    expect_true(BAS_StoreSourceLine(&program, source[i]),
+                "store benchmark line");
+  }
+  expect_true(program.codeUsed > 0, "benchmark lines compiled");
+  expect_true(BAS_ExportProgramImage(&program, image, sizeof(image), &written),
+              "export benchmark program");
+  expect_u16(written, (uint16_t)(8U + 5U * 6U + program.storageUsed),
+             "image carries text only");
+  expect_true(BAS_ImportProgramImage(&imported, image, written),
+              "import benchmark program");
+  expect_u16(imported.codeUsed, program.codeUsed, "import recompiles code");
+
+  expect_true(BAS_RunProgram(&program, 0, 0, lineBuffer, sizeof(lineBuffer),
+                             &result),
+              "run benchmark program");
+  expect_u8(result.statementsExecuted, 83, "benchmark statements per run");
+  bench_program(&program, "40", "stored loop");
+  bench_program(&imported, "40", "imported loop");
+}
+
+static void jump_targets_follow_line_edits(void) {
+  BasicLine lines[4];
+  uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 4)];
+  BasicProgram program;
+  BasicRunResult result;
+  char lineBuffer[32];
+
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
+  expect_true(BAS_StoreSourceLine(&program, "10 GOSUB 30"), "store gosub");
+  expect_true(BAS_StoreSourceLine(&program, "20 END"), "store end");
+  expect_true(BAS_StoreSourceLine(&program, "30 PRINT \"SUB\""),
+              "store subroutine");
+  expect_true(BAS_StoreSourceLine(&program, "40 RETURN"), "store return");
+
+  /* Deleting and re-adding lines shifts every index after them */
+  expect_true(BAS_StoreSourceLine(&program, "20"), "delete end");
+  expect_false(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                              sizeof(lineBuffer), &result),
+               "run without end returns into the subroutine");
+  expect_u8(result.status, BAS_RUN_RETURN_WITHOUT_GOSUB,
+            "fall-through status");
+  expect_true(BAS_StoreSourceLine(&program, "20 END"), "re-add end");
+  clear_run_capture();
+  expect_true(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                             sizeof(lineBuffer), &result),
+              "run after re-adding end");
+  expect_u8(result.status, BAS_RUN_HALTED, "re-added end halts");
+  expect_u8(runOutputLineCount, 1, "subroutine ran once");
+
+  expect_true(BAS_StoreSourceLine(&program, "30"), "delete target");
+  expect_false(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                              sizeof(lineBuffer), &result),
+               "run with deleted target");
+  expect_u8(result.status, BAS_RUN_MISSING_LINE, "deleted target status");
+  expect_u16(result.errorLine, 10, "deleted target line");
+
+  expect_true(BAS_StoreSourceLine(&program, "30 PRINT \"BACK\""),
+              "restore target");
+  clear_run_capture();
+  expect_true(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                             sizeof(lineBuffer), &result),
+              "run with restored target");
+  expect_str(runOutputLines[0], "BACK", "restored target output");
+}
+
+static void store_counting_loop(BasicProgram *program, uint16_t base) {
+  char source[40];
+
+  sprintf(source, "%u LET A = A + 1", base);
+  expect_true(BAS_StoreSourceLine(program, source), "store loop body");
+  sprintf(source, "%u IF A < 40 THEN %u", base + 10U, base);
+  expect_true(BAS_StoreSourceLine(program, source), "store loop test");
+  sprintf(source, "%u PRINT A", base + 20U);
+  expect_true(BAS_StoreSourceLine(program, source), "store loop print");
+  sprintf(source, "%u END", base + 30U);
+  expect_true(BAS_StoreSourceLine(program, source), "store loop end");
+}
+
+static void backward_jumps_do_not_scale_with_program_size(void) {
+  static BasicLine smallLines[5];
+  static BasicLine fullLines[BAS_MAX_PROGRAM_LINES];
+  static uint8_t smallStorage[128];
+  static uint8_t smallCode[BAS_CODE_CAPACITY(128, 5)];
+  static uint8_t fullStorage[BAS_MAX_PROGRAM_STORAGE];
+  static uint8_t fullCode[BAS_CODE_CAPACITY(BAS_MAX_PROGRAM_STORAGE,
+                                            BAS_MAX_PROGRAM_LINES)];
+  BasicProgram small;
+  BasicProgram full;
+  char source[40];
+  double smallRate;
+  double fullRate;
+
+  BAS_InitProgram(&small, smallLines, 5, smallStorage, sizeof(smallStorage),
+                  smallCode, sizeof(smallCode));
+  BAS_InitProgram(&full, fullLines, BAS_MAX_PROGRAM_LINES, fullStorage,
+                  sizeof(fullStorage), fullCode, sizeof(fullCode));
+  expect_true(BAS_StoreSourceLine(&small, "5 LET A = 0"), "store small init");
+  store_counting_loop(&small, 10);
+
+  /* The same loop parked behind never-run lines at the end of the table */
+  expect_true(BAS_StoreSourceLine(&full, "5 LET A = 0"), "store full init");
+  expect_true(BAS_StoreSourceLine(&full, "6 GOTO 1000"), "store skip");
+  for (uint16_t i = 0; full.lineCount < BAS_MAX_PROGRAM_LINES - 4U; i++) {
+    sprintf(source, "%u END", 10U + i * 10U);
+    expect_true(BAS_StoreSourceLine(&full, source), "store padding line");
+  }
+  store_counting_loop(&full, 1000);
+  expect_u8(full.lineCount, BAS_MAX_PROGRAM_LINES, "full program");
+
+  smallRate = bench_program(&small, "40", "5-line backward loop");
+  fullRate = bench_program(&full, "40", "64-line backward loop");
+  printf("basic bench: 64-line loop runs at %.0f%% of the 5-line rate\n",
+         smallRate > 0 ? fullRate * 100.0 / smallRate : 0.0);
+}
+
+static void stepped_run_outlasts_the_blocking_slice(void) {
+  BasicLine lines[4];
+  uint8_t storage[128];
+  uint8_t code[BAS_CODE_CAPACITY(128, 4)];
+  BasicProgram program;
+  BasicRuntime runtime;
+  BasicExecState state;
+  BasicRunResult result;
+  BasicRunStatus status = BAS_RUN_YIELDED;
+  char lineBuffer[32];
+  uint16_t frames = 0;
+
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
+  expect_true(BAS_StoreSourceLine(&program, "10 LET A = 0"), "store init");
+  expect_true(BAS_StoreSourceLine(&program, "20 LET A = A + 1"),
+              "store count");
+  expect_true(BAS_StoreSourceLine(&program, "30 IF A < 200 THEN 20"),
+              "store loop");
+  expect_true(BAS_StoreSourceLine(&program, "40 PRINT A"), "store print");
+
+  expect_false(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                              sizeof(lineBuffer), &result),
+               "blocking run stops after one slice");
+  expect_u8(result.status, BAS_RUN_STEP_LIMIT, "blocking run status");
+
+  /* One 16-statement slice per frame, as the render loop would */
+  clear_run_capture();
+  BAS_InitRuntime(&runtime);
+  BAS_ExecInit(&state, &program, &runtime, capture_run_output, 0, 0,
+               lineBuffer, sizeof(lineBuffer));
+  while (status == BAS_RUN_YIELDED && frames < 100) {
+    status = BAS_Step(&state, 16);
+    frames++;
+  }
+
+  expect_u8(status, BAS_RUN_COMPLETE, "stepped run completes");
+  expect_u16((uint16_t)state.statementsExecuted, 402, "stepped statements");
+  expect_u16(frames, 26, "frames to finish");
+  expect_str(runOutputLines[0], "200", "stepped run output");
+  expect_u8(BAS_Step(&state, 16), BAS_RUN_COMPLETE, "finished run stays put");
+  expect_u16((uint16_t)state.statementsExecuted, 402,
+             "finished run executes nothing");
+}
+
+static uint8_t input_after_two_polls(char *out, uint16_t outBytes,
+                                     void *user) {
+  uint8_t *polls = (uint8_t *)user;
+
+  if (++*polls < 3 || outBytes < 2)
+    return 0;
+  out[0] = '7';
+  out[1] = 0;
+  return 1;
+}
+
+static void stepped_run_parks_on_pending_input(void) {
+  BasicLine lines[3];
+  uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 3)];
+  BasicProgram program;
+  BasicRuntime runtime;
+  BasicExecState state;
+  char lineBuffer[32];
+  uint8_t polls = 0;
+
+  BAS_InitProgram(&program, lines, 3, storage, sizeof(storage), code,
+                  sizeof(code));
+  expect_true(BAS_StoreSourceLine(&program, "10 INPUT A"), "store input");
+  expect_true(BAS_StoreSourceLine(&program, "20 PRINT A + 1"),
+              "store input echo");
+  expect_true(BAS_StoreSourceLine(&program, "30 END"), "store input end");
+
+  clear_run_capture();
+  BAS_InitRuntime(&runtime);
+  BAS_ExecInit(&state, &program, &runtime, capture_run_output,
+               input_after_two_polls, &polls, lineBuffer, sizeof(lineBuffer));
+
+  expect_u8(BAS_Step(&state, 16), BAS_RUN_WAITING_INPUT, "first frame waits");
+  expect_true(state.waitingInput, "input pending");
+  expect_u8(state.pc, 0, "parked on INPUT");
+  expect_u8(BAS_Step(&state, 16), BAS_RUN_WAITING_INPUT, "second frame waits");
+  expect_u16((uint16_t)state.statementsExecuted, 0, "waiting costs nothing");
+  expect_u8(BAS_Step(&state, 16), BAS_RUN_HALTED, "third frame finishes");
+  expect_false(state.waitingInput, "input delivered");
+  expect_u16((uint16_t)state.statementsExecuted, 3, "input run statements");
+  expect_u8(runOutputLineCount, 1, "input run output count");
+  expect_str(runOutputLines[0], "8", "input run output");
+}
+
+static void store_source(BasicProgram *program, const char *const *source,
+                         uint8_t count, const char *name) {
+  for (uint8_t i = 0; i < count; i++) {
+    expect_true(BAS_StoreSourceLine(program, source[i]), name);
+  }
+}
+
+static void runner_for_next_counts_with_step(void) {
+  static const char *const source[] = {
+      "10 FOR I = 10 TO 1 STEP -4", "20 PRINT I", "30 NEXT I", "40 PRINT I"};
+  BasicLine lines[4];
+  uint8_t storage[128];
+  uint8_t code[BAS_CODE_CAPACITY(128, 4)];
+  BasicProgram program;
+  BasicRunResult result;
+  char lineBuffer[32];
+
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
+  store_source(&program, source, 4, "store FOR STEP line");
+
+  clear_run_capture();
+  expect_true(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                             sizeof(lineBuffer), &result),
+              "runner executes FOR STEP loop");
+  expect_u8(runOutputLineCount, 4, "FOR STEP output count");
+  expect_str(runOutputLines[0], "10", "FOR STEP first pass");
+  expect_str(runOutputLines[1], "6", "FOR STEP second pass");
+  expect_str(runOutputLines[2], "2", "FOR STEP last pass");
+  expect_str(runOutputLines[3], "-2", "FOR variable steps past limit");
+  expect_u16((uint16_t)result.statementsExecuted, 8, "FOR STEP statements");
+}
+
+static void runner_for_next_nests_and_unwinds(void) {
+  static const char *const nested[] = {
+      "10 LET S = 0",  "20 FOR I = 1 TO 3", "30 FOR J = I TO 3",
+      "40 LET S = S + J", "50 NEXT", "60 NEXT", "70 PRINT S"};
+  static const char *const unwind[] = {
+      "10 FOR I = 1 TO 2", "20 FOR J = 1 TO 5", "30 NEXT I", "40 PRINT J"};
+  static const char *const edge[] = {
+      "10 FOR I = 32766 TO 32767", "20 NEXT", "30 PRINT I"};
+  BasicLine lines[7];
+  uint8_t storage[192];
+  uint8_t code[BAS_CODE_CAPACITY(192, 7)];
+  BasicProgram program;
+  BasicRuntime runtime;
+  BasicExecState state;
+  char lineBuffer[32];
+
+  BAS_InitProgram(&program, lines, 7, storage, sizeof(storage), code,
+                  sizeof(code));
+  store_source(&program, nested, 7, "store nested FOR line");
+  clear_run_capture();
+  BAS_InitRuntime(&runtime);
+  BAS_ExecInit(&state, &program, &runtime, capture_run_output, 0, 0,
+               lineBuffer, sizeof(lineBuffer));
+  expect_u8(BAS_Step(&state, BAS_RUN_MAX_STEPS), BAS_RUN_COMPLETE,
+            "nested FOR completes");
+  expect_str(runOutputLines[0], "14", "bare NEXT closes inner loop first");
+  expect_u8(state.forDepth, 0, "nested loops all closed");
+
+  /* NEXT I drops the open J loop, so J restarts on every I pass */
+  BAS_InitProgram(&program, lines, 7, storage, sizeof(storage), code,
+                  sizeof(code));
+  store_source(&program, unwind, 4, "store unwinding FOR line");
+  clear_run_capture();
+  BAS_InitRuntime(&runtime);
+  BAS_ExecInit(&state, &program, &runtime, capture_run_output, 0, 0,
+               lineBuffer, sizeof(lineBuffer));
+  expect_u8(BAS_Step(&state, BAS_RUN_MAX_STEPS), BAS_RUN_COMPLETE,
+            "unwinding FOR completes");
+  expect_str(runOutputLines[0], "1", "outer NEXT drops inner loop");
+  expect_u8(state.forDepth, 0, "unwound loops closed");
+  expect_u16((uint16_t)state.statementsExecuted, 6, "unwinding statements");
+
+  BAS_InitProgram(&program, lines, 7, storage, sizeof(storage), code,
+                  sizeof(code));
+  store_source(&program, edge, 3, "store edge FOR line");
+  clear_run_capture();
+  BAS_InitRuntime(&runtime);
+  BAS_ExecInit(&state, &program, &runtime, capture_run_output, 0, 0,
+               lineBuffer, sizeof(lineBuffer));
+  expect_u8(BAS_Step(&state, BAS_RUN_MAX_STEPS), BAS_RUN_COMPLETE,
+            "FOR at integer limit completes");
+  expect_str(runOutputLines[0], "32767", "FOR at limit does not wrap");
+}
+
+static void runner_reports_for_next_errors(void) {
+  static const struct {
+    const char *source;
+    BasicRunStatus status;
+  } cases[] = {
+      {"10 NEXT", BAS_RUN_NEXT_WITHOUT_FOR},
+      {"10 NEXT 5", BAS_RUN_BAD_EXPRESSION},
+      {"10 FOR 1 = 1 TO 2", BAS_RUN_BAD_ASSIGNMENT},
+      {"10 FOR I 1 TO 2", BAS_RUN_BAD_ASSIGNMENT},
+      {"10 FOR I = 1 2", BAS_RUN_BAD_EXPRESSION},
+      {"10 FOR I = 1 TO \"A\"", BAS_RUN_BAD_EXPRESSION},
+      {"10 FOR I = 1 TO 2 STEP", BAS_RUN_BAD_EXPRESSION},
+      {"10 FOR I = 1 TO X", BAS_RUN_UNDEFINED_VARIABLE},
+  };
+  static const char *const tooDeep[] = {
+      "10 FOR A = 1 TO 2", "20 FOR B = 1 TO 2", "30 FOR C = 1 TO 2",
+      "40 FOR D = 1 TO 2", "50 FOR E = 1 TO 2", "60 FOR F = 1 TO 2",
+      "70 FOR G = 1 TO 2", "80 FOR H = 1 TO 2", "90 FOR I = 1 TO 2"};
+  static const char *const mismatched[] = {
+      "10 FOR I = 1 TO 2", "20 NEXT J"};
+  BasicLine lines[9];
+  uint8_t storage[320];
+  uint8_t code[BAS_CODE_CAPACITY(320, 9)];
+  BasicProgram program;
+  BasicRunResult result;
+  char lineBuffer[32];
+
+  for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    BAS_InitProgram(&program, lines, 9, storage, sizeof(storage), code,
+                    sizeof(code));
+    expect_true(BAS_StoreSourceLine(&program, cases[i].source),
+                "store bad FOR line");
+    expect_false(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                                sizeof(lineBuffer), &result),
+                 "runner rejects bad FOR line");
+    expect_u8(result.status, cases[i].status, cases[i].source);
+    expect_u16(result.errorLine, 10, "bad FOR line number");
+  }
+
+  BAS_InitProgram(&program, lines, 9, storage, sizeof(storage), code,
+                  sizeof(code));
+  store_source(&program, tooDeep, 9, "store deep FOR line");
+  expect_false(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                              sizeof(lineBuffer), &result),
+               "runner rejects FOR overflow");
+  expect_u8(result.status, BAS_RUN_FOR_STACK_OVERFLOW, "FOR overflow status");
+  expect_u16(result.errorLine, 90, "FOR overflow line");
+
+  BAS_InitProgram(&program, lines, 9, storage, sizeof(storage), code,
+                  sizeof(code));
+  store_source(&program, mismatched, 2, "store mismatched NEXT line");
+  expect_false(BAS_RunProgram(&program, capture_run_output, 0, lineBuffer,
+                              sizeof(lineBuffer), &result),
+               "runner rejects mismatched NEXT");
+  expect_u8(result.status, BAS_RUN_NEXT_WITHOUT_FOR, "mismatched NEXT status");
+  expect_u16(result.errorLine, 20, "mismatched NEXT line");
+}
+
+static void for_next_benchmark(void) {
+  static const char *const forLoop[] = {
+      "5 LET S = 0",       "10 FOR I = 1 TO 10", "20 FOR J = 1 TO 10",
+      "30 LET S = S + 1",  "40 NEXT J",          "50 NEXT I",
+      "60 PRINT S",        "70 END"};
+  static const char *const gotoLoop[] = {
+      "5 LET S = 0",        "10 LET I = 1",          "20 LET J = 1",
+      "30 LET S = S + 1",   "40 LET J = J + 1",      "50 IF J < 11 THEN 30",
+      "60 LET I = I + 1",   "70 IF I < 11 THEN 20",  "80 PRINT S",
+      "90 END"};
+  BasicLine forLines[8];
+  BasicLine gotoLines[10];
+  uint8_t forStorage[256];
+  uint8_t forCode[BAS_CODE_CAPACITY(256, 8)];
+  uint8_t gotoStorage[320];
+  uint8_t gotoCode[BAS_CODE_CAPACITY(320, 10)];
+  BasicProgram forProgram;
+  BasicProgram gotoProgram;
+  double forRuns;
+  double gotoRuns;
+
+  BAS_InitProgram(&forProgram, forLines, 8, forStorage, sizeof(forStorage),
+                  forCode, sizeof(forCode));
+  BAS_InitProgram(&gotoProgram, gotoLines, 10, gotoStorage, sizeof(gotoStorage),
+                  gotoCode, sizeof(gotoCode));
+  store_source(&forProgram, forLoop, 8, "store FOR benchmark line");
+  store_source(&gotoProgram, gotoLoop, 10, "store GOTO benchmark line");
+
+  /* 224 and 334 statements per run for the same 100 iterations */
+  forRuns = bench_program(&forProgram, "100", "nested FOR/NEXT") / 224.0;
+  gotoRuns = bench_program(&gotoProgram, "100", "nested IF/GOTO") / 334.0;
+  printf("basic bench: nested FOR/NEXT %.0f runs/s, IF/GOTO %.0f runs/s "
+         "(%.0f%%)\n",
+         forRuns, gotoRuns, gotoRuns > 0 ? forRuns * 100.0 / gotoRuns : 0.0);
+}
+
 int main(void) {
   parse_print_line_tokenizes_keyword();
   program_stores_lines_sorted();
@@ -1165,6 +1735,16 @@ int main(void) {
   runner_input_assigns_integer_variable();
   runner_input_reports_unavailable_source();
   runner_input_reports_bad_integer();
+  full_text_storage_stays_available();
+  compiled_runner_benchmark();
+  jump_targets_follow_line_edits();
+  backward_jumps_do_not_scale_with_program_size();
+  stepped_run_outlasts_the_blocking_slice();
+  stepped_run_parks_on_pending_input();
+  runner_for_next_counts_with_step();
+  runner_for_next_nests_and_unwinds();
+  runner_reports_for_next_errors();
+  for_next_benchmark();
 
   if (failures) {
     printf("basic program tests failed: %d\n", failures);
@@ -159,6 +159,7 @@ static void shell_save_uses_storage_policy_adapter(void) {
   BasicStorageIO io;
   BasicLine lines[4];
   uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 4)];
   uint8_t scratch[192];
   BasicProgram program;
   BasicCommandResult result;
@@ -172,7 +173,8 @@ static void shell_save_uses_storage_policy_adapter(void) {
   expect_true(BAS_StorageBindIO(&adapter, scratch, sizeof(scratch), &io),
               "bind shell save storage IO");
 
-  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage));
+  BAS_InitProgram(&program, lines, 4, storage, sizeof(storage), code,
+                  sizeof(code));
   expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"CART\""),
               "store program before adapter SAVE");
 
@@ -196,7 +198,9 @@ static void shell_load_uses_external_cart_before_internal(void) {
   BasicLine sourceLines[4];
   BasicLine destLines[4];
   uint8_t sourceStorage[96];
+  uint8_t sourceCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t destStorage[96];
+  uint8_t destCode[BAS_CODE_CAPACITY(96, 4)];
   uint8_t scratch[192];
   BasicProgram source;
   BasicProgram dest;
@@ -212,9 +216,10 @@ static void shell_load_uses_external_cart_before_internal(void) {
   expect_true(BAS_StorageBindIO(&adapter, scratch, sizeof(scratch), &io),
               "bind shell load storage IO");
 
-  BAS_InitProgram(&source, sourceLines, 4, sourceStorage,
-                  sizeof(sourceStorage));
-  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage));
+  BAS_InitProgram(&source, sourceLines, 4, sourceStorage, sizeof(sourceStorage),
+                  sourceCode, sizeof(sourceCode));
+  BAS_InitProgram(&dest, destLines, 4, destStorage, sizeof(destStorage),
+                  destCode, sizeof(destCode));
   expect_true(BAS_StoreSourceLine(&source, "10 PRINT \"LOAD\""),
               "store source before adapter LOAD");
   expect_true(BAS_ExportProgramImage(&source, device.bytes,
@@ -1,5 +1,6 @@
 #include "dirty_rect.h"
 #include <stdio.h>
+#include <string.h>
 
 static int failures;
 
@@ -138,7 +139,7 @@ static void dirty_list_keeps_corner_touching_rects_separate(void) {
                     "corner second rect");
 }
 
-static void dirty_list_overflow_collapses_to_single_bounds(void) {
+static void dirty_list_overflow_merges_cheapest_pair(void) {
   Rect bounds = rect_make(0, 0, 224, 320);
   DirtyRect storage[2];
   DirtyRectList list;
@@ -147,12 +148,62 @@ static void dirty_list_overflow_collapses_to_single_bounds(void) {
   expect_true(DR_AddRect(&list, &((Rect){0, 0, 10, 10})), "overflow first");
   expect_true(DR_AddRect(&list, &((Rect){100, 100, 110, 110})),
               "overflow second");
-  expect_true(DR_AddRect(&list, &((Rect){200, 200, 210, 210})),
+  expect_true(DR_AddRect(&list, &((Rect){112, 112, 120, 120})),
               "overflow third");
 
-  expect_u16(DR_GetCount(&list), 1, "overflow collapsed count");
-  expect_dirty_rect(&list, 0, rect_make(0, 0, 210, 210),
-                    "overflow collapsed rect");
+  expect_u16(DR_GetCount(&list), 2, "overflow merged count");
+  expect_dirty_rect(&list, 0, rect_make(0, 0, 10, 10), "distant rect kept");
+  expect_dirty_rect(&list, 1, rect_make(100, 100, 120, 120),
+                    "nearest pair merged");
+
+  /* The cheapest pair can be two stored rects rather than the new one */
+  DR_InitList(&list, storage, 2, &bounds);
+  DR_AddRect(&list, &((Rect){0, 0, 10, 10}));
+  DR_AddRect(&list, &((Rect){0, 12, 10, 20}));
+  DR_AddRect(&list, &((Rect){200, 200, 210, 210}));
+  expect_u16(DR_GetCount(&list), 2, "stored pair merged count");
+  expect_dirty_rect(&list, 0, rect_make(0, 0, 10, 20), "stored pair merged");
+  expect_dirty_rect(&list, 1, rect_make(200, 200, 210, 210),
+                    "new rect appended");
+}
+
+static void dirty_list_merge_is_bounded_by_waste(void) {
+  Rect bounds = rect_make(0, 0, 224, 320);
+  DirtyRect storage[4];
+  DirtyRectList list;
+
+  /* L-shaped strips uncovered by a diagonal window move */
+  DR_InitList(&list, storage, 4, &bounds);
+  expect_true(DR_AddRect(&list, &((Rect){40, 40, 120, 46})), "L vertical");
+  expect_true(DR_AddRect(&list, &((Rect){40, 46, 42, 160})), "L horizontal");
+  expect_u16(DR_GetCount(&list), 2, "L-shape stays two rects");
+
+  DR_SetMergeWaste(&list, DR_MERGE_WASTE_ANY);
+  DR_ClearList(&list);
+  DR_AddRect(&list, &((Rect){40, 40, 120, 46}));
+  DR_AddRect(&list, &((Rect){40, 46, 42, 160}));
+  expect_u16(DR_GetCount(&list), 1, "unbounded waste merges L-shape");
+  expect_dirty_rect(&list, 0, rect_make(40, 40, 120, 160), "L bounding box");
+
+  /* Two 10x10 rects overlapping in a corner: 19x19 box wastes 161 of 200 */
+  DR_InitList(&list, storage, 4, &bounds);
+  DR_SetMergeWaste(&list, 80);
+  DR_AddRect(&list, &((Rect){0, 0, 10, 10}));
+  DR_AddRect(&list, &((Rect){9, 9, 19, 19}));
+  expect_u16(DR_GetCount(&list), 2, "80% waste limit keeps corner overlap");
+
+  DR_InitList(&list, storage, 4, &bounds);
+  DR_SetMergeWaste(&list, 81);
+  DR_AddRect(&list, &((Rect){0, 0, 10, 10}));
+  DR_AddRect(&list, &((Rect){9, 9, 19, 19}));
+  expect_u16(DR_GetCount(&list), 1, "81% waste limit merges corner overlap");
+
+  /* A rect inside another always merges */
+  DR_InitList(&list, storage, 4, &bounds);
+  DR_SetMergeWaste(&list, 0);
+  DR_AddRect(&list, &((Rect){0, 0, 50, 50}));
+  DR_AddRect(&list, &((Rect){10, 10, 20, 20}));
+  expect_u16(DR_GetCount(&list), 1, "contained rect merges");
 }
 
 static void dirty_rect_maps_to_tile_range(void) {
@@ -299,6 +350,184 @@ static void dirty_tile_queue_builds_from_dirty_rect_list(void) {
   expect_tile_upload(&queue, 1, 122, 2, 64, "dirty-list queue row 1");
 }
 
+static void build_layout_queue(const Rect *rects, uint8_t rectCount,
+                               DirtyTileQueue *queue,
+                               DirtyTileUpload *uploads, uint8_t capacity) {
+  Rect bounds = rect_make(0, 0, 224, 320);
+  DirtyRect dirtyStorage[8];
+  DirtyRectList list;
+  uint8_t i;
+
+  DR_InitList(&list, dirtyStorage, 8, &bounds);
+  for (i = 0; i < rectCount; i++) {
+    DR_AddRect(&list, &rects[i]);
+  }
+  DR_InitTileQueue(queue, uploads, capacity, 0);
+  expect_true(DR_BuildTileQueueFromDirtyList(&list, queue, 8, 8, 40, 32),
+              "build layout queue");
+}
+
+/* Cheapest plan by exhaustive search over every merge/cut choice between the
+ * disjoint per-row spans. */
+static uint32_t brute_force_min_cost(const DirtyTileQueue *base,
+                                     const DirtyDmaCost *cost) {
+  uint32_t best = 0xffffffffU;
+  uint32_t gaps = (base->count > 0) ? (uint32_t)(base->count - 1) : 0;
+  uint32_t mask;
+
+  for (mask = 0; mask < (1UL << gaps); mask++) {
+    uint32_t spans = 1;
+    uint32_t tiles = 0;
+    uint32_t start = base->items[0].firstTile;
+    uint32_t i;
+    uint32_t total;
+
+    for (i = 0; i < gaps; i++) {
+      if (!(mask & (1UL << i))) {
+        tiles += base->items[i].firstTile + base->items[i].tileCount - start;
+        start = base->items[i + 1].firstTile;
+        spans++;
+      }
+    }
+    tiles += base->items[gaps].firstTile + base->items[gaps].tileCount - start;
+
+    total = (spans * cost->setupCycles) + (tiles * 32U * cost->cyclesPerByte);
+    if (total < best)
+      best = total;
+  }
+
+  return best;
+}
+
+static void dma_cost_merges_wide_window_rows(void) {
+  DirtyTileUpload uploads[32];
+  DirtyTileQueue queue;
+  Rect wide = rect_make(40, 8, 80, 312);
+
+  DR_SetDmaCost((const DirtyDmaCost *)0);
+  build_layout_queue(&wide, 1, &queue, uploads, 32);
+
+  expect_u16(queue.count, 1, "wide window rows coalesce");
+  expect_tile_upload(&queue, 0, 201, 198, 6336, "wide window single span");
+}
+
+static void dma_cost_keeps_narrow_window_rows_split(void) {
+  DirtyTileUpload uploads[32];
+  DirtyTileQueue queue;
+  Rect narrow = rect_make(40, 16, 64, 48);
+
+  DR_SetDmaCost((const DirtyDmaCost *)0);
+  build_layout_queue(&narrow, 1, &queue, uploads, 32);
+
+  expect_u16(queue.count, 3, "narrow window keeps row spans");
+  expect_u16(queue.byteCount, 384, "narrow window sends no gap tiles");
+  expect_tile_upload(&queue, 0, 202, 4, 128, "narrow row 0");
+  expect_tile_upload(&queue, 2, 282, 4, 128, "narrow row 2");
+}
+
+static void dma_cost_merges_side_by_side_and_overlapping_ranges(void) {
+  DirtyTileUpload uploads[32];
+  DirtyTileQueue queue;
+  Rect layout[3];
+
+  layout[0] = rect_make(40, 16, 48, 64);  /* tiles 2..8, row 5 */
+  layout[1] = rect_make(40, 72, 48, 120); /* tiles 9..15, one-tile gap */
+  layout[2] = rect_make(41, 60, 47, 75);  /* rounds into both ranges */
+
+  DR_SetDmaCost((const DirtyDmaCost *)0);
+  build_layout_queue(layout, 3, &queue, uploads, 32);
+
+  expect_u16(queue.count, 1, "side-by-side spans coalesce");
+  expect_tile_upload(&queue, 0, 202, 13, 416, "side-by-side span");
+}
+
+static void dma_cost_threshold_is_tunable_at_runtime(void) {
+  DirtyTileUpload uploads[32];
+  DirtyTileQueue queue;
+  DirtyDmaCost cost;
+  Rect wide = rect_make(40, 8, 80, 312);
+  Rect narrow = rect_make(40, 16, 64, 48);
+
+  cost.setupCycles = 0;
+  cost.cyclesPerByte = DR_DMA_CYCLES_PER_BYTE_DEFAULT;
+  DR_SetDmaCost(&cost);
+  build_layout_queue(&wide, 1, &queue, uploads, 32);
+  expect_u16(queue.count, 5, "zero setup keeps wide rows split");
+
+  cost.setupCycles = 8000;
+  DR_SetDmaCost(&cost);
+  build_layout_queue(&narrow, 1, &queue, uploads, 32);
+  expect_u16(queue.count, 1, "expensive setup merges narrow rows");
+  expect_tile_upload(&queue, 0, 202, 84, 2688, "expensive setup span");
+
+  DR_GetDmaCost(&cost);
+  expect_u16(cost.setupCycles, 8000, "dma cost readback");
+  DR_SetDmaCost((const DirtyDmaCost *)0);
+  DR_GetDmaCost(&cost);
+  expect_u16(cost.setupCycles, DR_DMA_SETUP_CYCLES_DEFAULT,
+             "dma cost default restored");
+}
+
+static void dma_cost_plan_is_minimal_for_window_layouts(void) {
+  static const Rect layouts[4][4] = {
+      /* Document window plus cursor. */
+      {{34, 40, 153, 258}, {100, 150, 116, 161}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+      /* Two overlapping document windows. */
+      {{30, 30, 110, 190}, {60, 150, 140, 300}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+      /* Menu title, dropdown, and a near-full-width body. */
+      {{0, 0, 20, 96}, {20, 40, 90, 140}, {120, 8, 160, 312}, {0, 0, 0, 0}},
+      /* Calculator keypad cells. */
+      {{50, 200, 62, 216}, {50, 224, 62, 240}, {66, 200, 78, 216},
+       {66, 224, 78, 240}}};
+  static const uint8_t counts[4] = {2, 2, 3, 4};
+  static const uint16_t setups[3] = {128, 512, 2048};
+  DirtyTileUpload baseUploads[64];
+  DirtyTileUpload uploads[64];
+  DirtyTileQueue base;
+  DirtyTileQueue queue;
+  DirtyDmaCost cost;
+  DirtyDmaCost split;
+  uint8_t layout;
+  uint8_t s;
+
+  for (layout = 0; layout < 4; layout++) {
+    for (s = 0; s < 3; s++) {
+      cost.setupCycles = setups[s];
+      cost.cyclesPerByte = DR_DMA_CYCLES_PER_BYTE_DEFAULT;
+      split.setupCycles = 0;
+      split.cyclesPerByte = cost.cyclesPerByte;
+
+      DR_SetDmaCost(&split);
+      build_layout_queue(layouts[layout], counts[layout], &base, baseUploads,
+                         64);
+      if (base.count == 0 || base.count > 20) {
+        printf("FAIL: layout %u base span count %u\n", layout, base.count);
+        failures++;
+        continue;
+      }
+
+      DR_SetDmaCost(&cost);
+      build_layout_queue(layouts[layout], counts[layout], &queue, uploads, 64);
+
+      if (DR_TileQueueCost(&queue, &cost) !=
+          brute_force_min_cost(&base, &cost)) {
+        printf("FAIL: layout %u setup %u cost %lu expected %lu\n", layout,
+               cost.setupCycles,
+               (unsigned long)DR_TileQueueCost(&queue, &cost),
+               (unsigned long)brute_force_min_cost(&base, &cost));
+        failures++;
+      }
+      if (DR_TileQueueCost(&queue, &cost) > DR_TileQueueCost(&base, &cost)) {
+        printf("FAIL: layout %u coalesced plan costs more than split\n",
+               layout);
+        failures++;
+      }
+    }
+  }
+
+  DR_SetDmaCost((const DirtyDmaCost *)0);
+}
+
 static void root_redraw_splits_menu_and_desktop(void) {
   DirtyRootRedraw plan;
   Rect dirty = rect_make(10, 5, 30, 50);
@@ -373,13 +602,571 @@ static void window_redraw_rejects_non_overlapping_regions(void) {
   expect_false(plan.hasWindow, "window redraw no intersection");
 }
 
+#define TEST_FB_BPR 160U
+#define TEST_FB_TILES_X 40U
+
+static uint8_t solidFb[TEST_FB_BPR * 224U];
+
+static void paint_test_tile(uint16_t tile, uint8_t packed) {
+  uint16_t tx = (uint16_t)(tile % TEST_FB_TILES_X);
+  uint16_t ty = (uint16_t)(tile / TEST_FB_TILES_X);
+  uint8_t row;
+
+  for (row = 0; row < 8; row++)
+    memset(&solidFb[((uint32_t)(ty * 8U + row) * TEST_FB_BPR) + tx * 4U],
+           packed, 4);
+}
+
+static void expect_fill(DirtyFillList *fills, uint8_t index, uint16_t firstTile,
+                        uint16_t tileCount, uint8_t colorIndex,
+                        const char *name) {
+  if (index >= fills->count) {
+    printf("FAIL: %s missing fill %u\n", name, index);
+    failures++;
+    return;
+  }
+  expect_u16(fills->items[index].firstTile, firstTile, name);
+  expect_u16(fills->items[index].tileCount, tileCount, name);
+  expect_u16(fills->items[index].colorIndex, colorIndex, name);
+}
+
+static void solid_runs_split_from_copy_spans(void) {
+  DirtyTileUpload inItems[2];
+  DirtyTileUpload copyItems[8];
+  DirtyTileFill fillItems[4];
+  DirtyTileQueue in;
+  DirtyTileQueue copies;
+  DirtyFillList fills;
+  DirtyTileRange range = {0, 0, 10, 1};
+  uint16_t tile;
+
+  memset(solidFb, 0x12, sizeof(solidFb));
+  for (tile = 2; tile < 7; tile++)
+    paint_test_tile(tile, 0x77);
+  solidFb[(3U * TEST_FB_BPR) + 6U * 4U + 1U] = 0x78; /* tile 6 not solid */
+  paint_test_tile(7, 0xff);
+  paint_test_tile(8, 0xff);
+  paint_test_tile(9, 0x33);
+
+  DR_InitTileQueue(&in, inItems, 2, 0);
+  DR_InitTileQueue(&copies, copyItems, 8, 0);
+  DR_InitFillList(&fills, fillItems, 4);
+  expect_true(DR_QueueTileRange(&in, &range, TEST_FB_TILES_X, 32),
+              "solid split input queues");
+
+  expect_true(DR_SplitSolidTileRuns(&in, solidFb, TEST_FB_BPR,
+                                    TEST_FB_TILES_X, DR_FILL_MIN_RUN_TILES,
+                                    &copies, &fills),
+              "solid split succeeds");
+  expect_u16(fills.count, 2, "solid split fill count");
+  expect_fill(&fills, 0, 2, 4, 0x7, "solid split grey run");
+  expect_fill(&fills, 1, 7, 2, 0xf, "solid split white run");
+  expect_u16(fills.tileCount, 6, "solid split fill tiles");
+  expect_u16(copies.count, 3, "solid split copy count");
+  expect_tile_upload(&copies, 0, 0, 2, 64, "solid split leading copy");
+  expect_tile_upload(&copies, 1, 6, 1, 32, "solid split mixed tile copy");
+  expect_tile_upload(&copies, 2, 9, 1, 32, "solid split short run copy");
+}
+
+static void solid_runs_cover_full_screen_clear_with_one_fill(void) {
+  DirtyTileUpload inItems[1];
+  DirtyTileUpload copyItems[1];
+  DirtyTileFill fillItems[1];
+  DirtyTileQueue in;
+  DirtyTileQueue copies;
+  DirtyFillList fills;
+  DirtyTileRange range = {0, 0, 40, 28};
+
+  memset(solidFb, 0x77, sizeof(solidFb));
+  DR_InitTileQueue(&in, inItems, 1, 0);
+  DR_InitTileQueue(&copies, copyItems, 1, 0);
+  DR_InitFillList(&fills, fillItems, 1);
+  expect_true(DR_QueueTileRange(&in, &range, TEST_FB_TILES_X, 32),
+              "clear input queues");
+
+  expect_true(DR_SplitSolidTileRuns(&in, solidFb, TEST_FB_BPR,
+                                    TEST_FB_TILES_X, DR_FILL_MIN_RUN_TILES,
+                                    &copies, &fills),
+              "clear split succeeds");
+  expect_u16(fills.count, 1, "clear fill count");
+  expect_fill(&fills, 0, 0, 1120, 0x7, "clear fill run");
+  expect_u16(copies.count, 0, "clear has no copies");
+  expect_u16(copies.byteCount, 0, "clear copy bytes");
+}
+
+static void solid_run_overflow_falls_back_to_copies(void) {
+  DirtyTileUpload inItems[1];
+  DirtyTileUpload copyItems[4];
+  DirtyTileFill fillItems[1];
+  DirtyTileQueue in;
+  DirtyTileQueue copies;
+  DirtyFillList fills;
+  DirtyTileRange range = {0, 0, 6, 1};
+
+  memset(solidFb, 0x12, sizeof(solidFb));
+  paint_test_tile(0, 0x44);
+  paint_test_tile(1, 0x44);
+  paint_test_tile(2, 0x99);
+  paint_test_tile(3, 0x99);
+  paint_test_tile(4, 0x99);
+
+  DR_InitTileQueue(&in, inItems, 1, 0);
+  DR_InitTileQueue(&copies, copyItems, 4, 0);
+  DR_InitFillList(&fills, fillItems, 1);
+  expect_true(DR_QueueTileRange(&in, &range, TEST_FB_TILES_X, 32),
+              "overflow input queues");
+
+  expect_true(DR_SplitSolidTileRuns(&in, solidFb, TEST_FB_BPR,
+                                    TEST_FB_TILES_X, DR_FILL_MIN_RUN_TILES,
+                                    &copies, &fills),
+              "overflow split succeeds");
+  expect_true(fills.overflow, "fill list overflow flagged");
+  expect_u16(fills.count, 1, "overflow keeps first fill");
+  expect_fill(&fills, 0, 0, 2, 0x4, "overflow first run");
+  expect_u16(copies.count, 1, "overflow copy count");
+  expect_tile_upload(&copies, 0, 2, 4, 128, "overflow remainder copies");
+}
+
+static Boolean queue_covers_tile(const DirtyTileQueue *queue, uint16_t tile) {
+  uint8_t i;
+
+  for (i = 0; i < queue->count; i++) {
+    if (tile >= queue->items[i].firstTile &&
+        tile < queue->items[i].firstTile + queue->items[i].tileCount)
+      return 1;
+  }
+  return 0;
+}
+
+static void tile_bitmap_marks_exact_tiles(void) {
+  DirtyTileBitmap map;
+  DirtyTileUpload uploads[4];
+  DirtyTileQueue queue;
+
+  DR_ClearTileBitmap(&map);
+  expect_u16(DR_TileBitmapCount(&map), 0, "bitmap starts clean");
+
+  /* Columns 3..12 of row 1 straddle three bitmap bytes */
+  expect_true(DR_MarkTileBitmap(&map, &((Rect){8, 24, 16, 104})),
+              "mark straddling run");
+  expect_u16(DR_TileBitmapCount(&map), 10, "straddling run tiles");
+  expect_false(DR_TileBitmapTest(&map, 42), "tile before run clean");
+  expect_true(DR_TileBitmapTest(&map, 43), "run head tile");
+  expect_true(DR_TileBitmapTest(&map, 52), "run tail tile");
+  expect_false(DR_TileBitmapTest(&map, 53), "tile after run clean");
+
+  expect_true(DR_MarkTileBitmap(&map, &((Rect){-20, 300, 4, 400})),
+              "mark clipped corner");
+  expect_u16(DR_TileBitmapCount(&map), 13, "clipped corner adds 3 tiles");
+  expect_false(DR_MarkTileBitmap(&map, &((Rect){230, 0, 240, 10})),
+               "offscreen rect ignored");
+
+  DR_InitTileQueue(&queue, uploads, 4, 0);
+  expect_true(DR_BuildTileQueueFromBitmap(&map, &queue, 32),
+              "build bitmap queue");
+  /* The 3-tile gap costs less to resend than a second DMA setup */
+  expect_u16(queue.count, 1, "bitmap queue coalesces gap");
+  expect_tile_upload(&queue, 0, 37, 16, 512, "corner and row span");
+
+  /* Full screen is one run, sliced only by the byte budget */
+  DR_MarkTileBitmap(&map, &((Rect){0, 0, 224, 320}));
+  expect_u16(DR_TileBitmapCount(&map), 1120, "full screen tiles");
+  DR_InitTileQueue(&queue, uploads, 4, 0);
+  expect_true(DR_BuildTileQueueFromBitmap(&map, &queue, 32),
+              "build full bitmap queue");
+  expect_u16(queue.count, 1, "full screen one span");
+  expect_u16(queue.byteCount, 35840, "full screen bytes");
+}
+
+typedef struct {
+  uint32_t listBytes;
+  uint32_t bitmapBytes;
+  uint16_t frames;
+} TraceTotals;
+
+static uint32_t trace_seed;
+
+static int16_t trace_rand(int16_t limit) {
+  trace_seed = (trace_seed * 1103515245UL) + 12345UL;
+  return (int16_t)((trace_seed >> 16) % (uint32_t)limit);
+}
+
+/* Replay one frame of invalidations through both trackers and compare. */
+static void replay_frame(const Rect *rects, uint8_t count, TraceTotals *totals,
+                         const char *name) {
+  static DirtyTileUpload listUploads[200];
+  static DirtyTileUpload mapUploads[200];
+  Rect bounds = rect_make(0, 0, 224, 320);
+  DirtyRect dirtyStorage[32];
+  DirtyRectList list;
+  DirtyTileBitmap map;
+  DirtyTileQueue listQueue;
+  DirtyTileQueue mapQueue;
+  uint16_t tile;
+  uint8_t i;
+  int before = failures;
+
+  DR_InitList(&list, dirtyStorage, 32, &bounds);
+  DR_ClearTileBitmap(&map);
+  for (i = 0; i < count; i++) {
+    DR_AddRect(&list, &rects[i]);
+    DR_MarkTileBitmap(&map, &rects[i]);
+  }
+
+  DR_InitTileQueue(&listQueue, listUploads, 200, 0);
+  DR_InitTileQueue(&mapQueue, mapUploads, 200, 0);
+  expect_true(DR_BuildTileQueueFromDirtyList(&list, &listQueue, 8, 8, 40, 32),
+              name);
+  expect_true(DR_BuildTileQueueFromBitmap(&map, &mapQueue, 32), name);
+
+  for (tile = 0; tile < 1120 && failures == before; tile++) {
+    int16_t x = (int16_t)((tile % 40U) * 8U);
+    int16_t y = (int16_t)((tile / 40U) * 8U);
+    Rect cell = rect_make(y, x, (int16_t)(y + 8), (int16_t)(x + 8));
+    Rect hit;
+    Boolean touched = 0;
+
+    for (i = 0; i < count && !touched; i++)
+      touched = DR_RectIntersect(&rects[i], &cell, &hit);
+    if (DR_TileBitmapTest(&map, tile) != touched) {
+      printf("FAIL: %s tile %u bitmap mismatch\n", name, tile);
+      failures++;
+    }
+    if (touched && !queue_covers_tile(&mapQueue, tile)) {
+      printf("FAIL: %s tile %u missing from bitmap queue\n", name, tile);
+      failures++;
+    }
+    if (touched && !queue_covers_tile(&listQueue, tile)) {
+      printf("FAIL: %s tile %u missing from list queue\n", name, tile);
+      failures++;
+    }
+  }
+
+  if (mapQueue.byteCount > listQueue.byteCount) {
+    printf("FAIL: %s bitmap uploads %u bytes, list %u\n", name,
+           mapQueue.byteCount, listQueue.byteCount);
+    failures++;
+  }
+  totals->listBytes += listQueue.byteCount;
+  totals->bitmapBytes += mapQueue.byteCount;
+  totals->frames++;
+}
+
+static void cursor_rects(int16_t x, int16_t y, int16_t px, int16_t py,
+                         Rect *out) {
+  out[0] = rect_make(py, px, (int16_t)(py + 16), (int16_t)(px + 11));
+  out[1] = rect_make(y, x, (int16_t)(y + 16), (int16_t)(x + 11));
+}
+
+static void tile_bitmap_matches_list_on_cursor_and_drag_traces(void) {
+  TraceTotals totals = {0, 0, 0};
+  Rect frame[6];
+  int16_t step;
+
+  /* Cursor sweep: old and new cursor boxes each frame */
+  for (step = 1; step < 60; step++) {
+    cursor_rects((int16_t)(step * 5), (int16_t)(step * 3),
+                 (int16_t)((step - 1) * 5), (int16_t)((step - 1) * 3), frame);
+    replay_frame(frame, 2, &totals, "cursor trace");
+  }
+
+  /* Window drag: old frame, new frame and cursor, 6 px right and 2 px down */
+  for (step = 1; step < 30; step++) {
+    int16_t left = (int16_t)(20 + step * 6);
+    int16_t top = (int16_t)(30 + step * 2);
+
+    frame[0] = rect_make((int16_t)(top - 2), (int16_t)(left - 6),
+                         (int16_t)(top + 78), (int16_t)(left + 114));
+    frame[1] = rect_make(top, left, (int16_t)(top + 80), (int16_t)(left + 120));
+    cursor_rects((int16_t)(left + 30), (int16_t)(top + 5),
+                 (int16_t)(left + 24), (int16_t)(top + 3), &frame[2]);
+    replay_frame(frame, 4, &totals, "drag trace");
+  }
+
+  expect_true(totals.bitmapBytes <= totals.listBytes,
+              "bitmap never uploads more on cursor and drag");
+}
+
+static void tile_bitmap_avoids_overflow_collapse(void) {
+  TraceTotals totals = {0, 0, 0};
+  Rect frame[40];
+  uint8_t frameIndex;
+  uint8_t i;
+
+  /* Two small distant changes: both trackers keep them apart */
+  frame[0] = rect_make(16, 8, 24, 16);
+  frame[1] = rect_make(200, 296, 208, 304);
+  replay_frame(frame, 2, &totals, "two distant changes");
+  expect_u16((uint16_t)totals.bitmapBytes, 64, "two tiles uploaded");
+
+  /* Scattered blinking carets and clocks overflow the 32-entry list */
+  trace_seed = 34;
+  totals.listBytes = 0;
+  totals.bitmapBytes = 0;
+  for (frameIndex = 0; frameIndex < 8; frameIndex++) {
+    for (i = 0; i < 40; i++) {
+      int16_t x = trace_rand(310);
+      int16_t y = trace_rand(210);
+
+      frame[i] = rect_make(y, x, (int16_t)(y + 2 + trace_rand(8)),
+                           (int16_t)(x + 2 + trace_rand(8)));
+    }
+    replay_frame(frame, 40, &totals, "scatter trace");
+  }
+  expect_true(totals.bitmapBytes < totals.listBytes,
+              "bitmap uploads less than the overflowing list");
+  /* Cheapest-pair overflow keeps the list far from whole-screen uploads */
+  expect_true(totals.listBytes * 2 < 8UL * 35840UL,
+              "overflowing list stays under half the screen");
+}
+
+/* ---- Banded regions against a per-pixel reference ---- */
+
+#define REGION_TEST_W 64
+#define REGION_TEST_H 48
+#define REGION_TEST_RECTS 256
+
+typedef struct {
+  uint8_t px[REGION_TEST_H][REGION_TEST_W];
+} PixelMask;
+
+static Boolean region_has(const DirtyRegion *rgn, int16_t x, int16_t y) {
+  uint16_t i;
+
+  for (i = 0; i < rgn->count; i++) {
+    const Rect *r = &rgn->rects[i];
+    if (x >= r->left && x < r->right && y >= r->top && y < r->bottom)
+      return 1;
+  }
+  return 0;
+}
+
+static void mask_rect(PixelMask *mask, const Rect *r, uint8_t value) {
+  int16_t x;
+  int16_t y;
+
+  for (y = r->top; y < r->bottom; y++)
+    for (x = r->left; x < r->right; x++)
+      mask->px[y][x] = value;
+}
+
+static void expect_banded(const DirtyRegion *rgn, const char *name) {
+  uint16_t i;
+
+  for (i = 0; i < rgn->count; i++) {
+    const Rect *r = &rgn->rects[i];
+    const Rect *prev = (i > 0) ? &rgn->rects[i - 1] : (const Rect *)0;
+
+    if (DR_RectIsEmpty(r)) {
+      printf("FAIL: %s rect %u empty\n", name, i);
+      failures++;
+      return;
+    }
+    if (!prev)
+      continue;
+    if (prev->top == r->top) {
+      /* Same band: same height, sorted, with a gap between spans */
+      if (prev->bottom != r->bottom || prev->right >= r->left) {
+        printf("FAIL: %s band spans out of order at %u\n", name, i);
+        failures++;
+        return;
+      }
+    } else if (r->top < prev->bottom) {
+      printf("FAIL: %s bands overlap at %u\n", name, i);
+      failures++;
+      return;
+    }
+  }
+}
+
+static void expect_region_matches(const DirtyRegion *rgn, const PixelMask *mask,
+                                  const char *name) {
+  uint32_t area = 0;
+  int16_t x;
+  int16_t y;
+
+  expect_banded(rgn, name);
+  for (y = 0; y < REGION_TEST_H; y++) {
+    for (x = 0; x < REGION_TEST_W; x++) {
+      if (region_has(rgn, x, y) != mask->px[y][x]) {
+        printf("FAIL: %s pixel %d,%d expected %u\n", name, x, y,
+               mask->px[y][x]);
+        failures++;
+        return;
+      }
+      area += mask->px[y][x];
+    }
+  }
+  if (DR_RegionArea(rgn) != area) {
+    printf("FAIL: %s area %lu expected %lu (rects overlap)\n", name,
+           (unsigned long)DR_RegionArea(rgn), (unsigned long)area);
+    failures++;
+  }
+}
+
+static Rect random_region_rect(void) {
+  int16_t left = trace_rand(REGION_TEST_W - 1);
+  int16_t top = trace_rand(REGION_TEST_H - 1);
+  int16_t right = (int16_t)(left + 1 + trace_rand(REGION_TEST_W - left));
+  int16_t bottom = (int16_t)(top + 1 + trace_rand(REGION_TEST_H - top));
+
+  return rect_make(top, left, bottom, right);
+}
+
+/* Grow a region from random rect unions and subtractions. */
+static void build_random_region(DirtyRegion *rgn, DirtyRegion *scratch,
+                                PixelMask *mask) {
+  Rect one[1];
+  DirtyRegion piece;
+  uint8_t steps = (uint8_t)(1 + trace_rand(10));
+  uint8_t i;
+
+  DR_InitRegion(&piece, one, 1);
+  DR_RegionClear(rgn);
+  memset(mask, 0, sizeof(*mask));
+  for (i = 0; i < steps; i++) {
+    Rect r = random_region_rect();
+    Boolean cut = (i > 0 && trace_rand(3) == 0) ? 1 : 0;
+
+    DR_RegionSetRect(&piece, &r);
+    if (cut)
+      DR_RegionSubtract(scratch, rgn, &piece);
+    else
+      DR_RegionUnion(scratch, rgn, &piece);
+    DR_RegionCopy(rgn, scratch);
+    mask_rect(mask, &r, cut ? 0 : 1);
+  }
+}
+
+static void region_ops_match_pixel_reference(void) {
+  static Rect aStore[REGION_TEST_RECTS];
+  static Rect bStore[REGION_TEST_RECTS];
+  static Rect outStore[REGION_TEST_RECTS];
+  static Rect scratchStore[REGION_TEST_RECTS];
+  static PixelMask aMask;
+  static PixelMask bMask;
+  static PixelMask want;
+  DirtyRegion a;
+  DirtyRegion b;
+  DirtyRegion out;
+  DirtyRegion scratch;
+  uint16_t round;
+  int16_t x;
+  int16_t y;
+
+  DR_InitRegion(&a, aStore, REGION_TEST_RECTS);
+  DR_InitRegion(&b, bStore, REGION_TEST_RECTS);
+  DR_InitRegion(&out, outStore, REGION_TEST_RECTS);
+  DR_InitRegion(&scratch, scratchStore, REGION_TEST_RECTS);
+  trace_seed = 36;
+
+  for (round = 0; round < 300; round++) {
+    int before = failures;
+
+    build_random_region(&a, &scratch, &aMask);
+    build_random_region(&b, &scratch, &bMask);
+    expect_region_matches(&a, &aMask, "built region");
+
+    expect_true(DR_RegionUnion(&out, &a, &b), "region union");
+    for (y = 0; y < REGION_TEST_H; y++)
+      for (x = 0; x < REGION_TEST_W; x++)
+        want.px[y][x] = (uint8_t)(aMask.px[y][x] | bMask.px[y][x]);
+    expect_region_matches(&out, &want, "union");
+
+    expect_true(DR_RegionIntersect(&out, &a, &b), "region intersect");
+    for (y = 0; y < REGION_TEST_H; y++)
+      for (x = 0; x < REGION_TEST_W; x++)
+        want.px[y][x] = (uint8_t)(aMask.px[y][x] & bMask.px[y][x]);
+    expect_region_matches(&out, &want, "intersect");
+
+    expect_true(DR_RegionSubtract(&out, &a, &b), "region subtract");
+    for (y = 0; y < REGION_TEST_H; y++)
+      for (x = 0; x < REGION_TEST_W; x++)
+        want.px[y][x] = (uint8_t)(aMask.px[y][x] & !bMask.px[y][x]);
+    expect_region_matches(&out, &want, "subtract");
+
+    if (failures != before) {
+      printf("FAIL: region round %u\n", round);
+      return;
+    }
+  }
+}
+
+static void region_coalesces_bands_and_reports_overflow(void) {
+  Rect aStore[4];
+  Rect bStore[4];
+  Rect outStore[4];
+  Rect tiny[2];
+  DirtyRegion a;
+  DirtyRegion b;
+  DirtyRegion out;
+  DirtyRegion small;
+
+  DR_InitRegion(&a, aStore, 4);
+  DR_InitRegion(&b, bStore, 4);
+  DR_InitRegion(&out, outStore, 4);
+
+  /* Two stacked halves of one box come back as a single rect */
+  DR_RegionSetRect(&a, &((Rect){0, 0, 10, 20}));
+  DR_RegionSetRect(&b, &((Rect){10, 0, 30, 20}));
+  expect_true(DR_RegionUnion(&out, &a, &b), "stacked union");
+  expect_u16(out.count, 1, "stacked halves coalesce");
+  expect_rect(out.rects[0], rect_make(0, 0, 30, 20), "coalesced box");
+
+  /* A hole punched in the middle needs four rects in three bands */
+  DR_RegionSetRect(&a, &((Rect){0, 0, 30, 30}));
+  DR_RegionSetRect(&b, &((Rect){10, 10, 20, 20}));
+  expect_true(DR_RegionSubtract(&out, &a, &b), "punch hole");
+  expect_u16(out.count, 4, "hole rect count");
+  expect_rect(out.rects[1], rect_make(10, 0, 20, 10), "hole left span");
+  expect_rect(out.rects[2], rect_make(10, 20, 20, 30), "hole right span");
+
+  DR_InitRegion(&small, tiny, 2);
+  expect_false(DR_RegionSubtract(&small, &a, &b), "hole overflows 2 rects");
+  expect_true(small.overflow, "overflow flagged");
+  expect_false(DR_RegionUnion(&a, &a, &b), "aliased output rejected");
+}
+
+static void region_converts_to_tile_spans(void) {
+  Rect aStore[8];
+  Rect bStore[2];
+  Rect outStore[8];
+  DirtyRegion a;
+  DirtyRegion b;
+  DirtyRegion out;
+  DirtyTileUpload uploads[8];
+  DirtyTileQueue queue;
+
+  DR_InitRegion(&a, aStore, 8);
+  DR_InitRegion(&b, bStore, 2);
+  DR_InitRegion(&out, outStore, 8);
+
+  /* A 64x16 box with its middle 48 px cut: two 1-tile columns, two rows */
+  DR_RegionSetRect(&a, &((Rect){16, 16, 32, 80}));
+  DR_RegionSetRect(&b, &((Rect){0, 24, 224, 72}));
+  DR_RegionSubtract(&out, &a, &b);
+  expect_u16(out.count, 2, "cut box spans");
+
+  DR_SetDmaCost(&(DirtyDmaCost){0, DR_DMA_CYCLES_PER_BYTE_DEFAULT});
+  DR_InitTileQueue(&queue, uploads, 8, 0);
+  expect_true(DR_BuildTileQueueFromRegion(&out, &queue, 32),
+              "region queue built");
+  expect_u16(queue.count, 4, "one span per column per tile row");
+  expect_tile_upload(&queue, 0, 82, 1, 32, "row 2 left column");
+  expect_tile_upload(&queue, 1, 89, 1, 32, "row 2 right column");
+  expect_tile_upload(&queue, 3, 129, 1, 32, "row 3 right column");
+  DR_SetDmaCost(&(DirtyDmaCost){DR_DMA_SETUP_CYCLES_DEFAULT,
+                                DR_DMA_CYCLES_PER_BYTE_DEFAULT});
+}
+
 int main(void) {
   clips_to_bounds_and_rejects_empty();
   intersection_uses_half_open_edges();
   subtract_splits_cutout_into_strips();
   dirty_list_clips_merges_touching_and_keeps_separate();
   dirty_list_keeps_corner_touching_rects_separate();
-  dirty_list_overflow_collapses_to_single_bounds();
+  dirty_list_overflow_merges_cheapest_pair();
+  dirty_list_merge_is_bounded_by_waste();
   dirty_rect_maps_to_tile_range();
   dirty_tile_budget_counts_partial_row_spans();
   dirty_tile_budget_counts_full_width_as_contiguous_span();
@@ -390,6 +1177,20 @@ int main(void) {
   dirty_tile_queue_stops_when_row_budget_runs_out();
   dirty_tile_queue_reports_storage_overflow();
   dirty_tile_queue_builds_from_dirty_rect_list();
+  dma_cost_merges_wide_window_rows();
+  dma_cost_keeps_narrow_window_rows_split();
+  dma_cost_merges_side_by_side_and_overlapping_ranges();
+  dma_cost_threshold_is_tunable_at_runtime();
+  dma_cost_plan_is_minimal_for_window_layouts();
+  solid_runs_split_from_copy_spans();
+  solid_runs_cover_full_screen_clear_with_one_fill();
+  solid_run_overflow_falls_back_to_copies();
+  tile_bitmap_marks_exact_tiles();
+  tile_bitmap_matches_list_on_cursor_and_drag_traces();
+  tile_bitmap_avoids_overflow_collapse();
+  region_ops_match_pixel_reference();
+  region_coalesces_bands_and_reports_overflow();
+  region_converts_to_tile_spans();
   root_redraw_splits_menu_and_desktop();
   root_redraw_keeps_single_owner_regions();
   root_redraw_rejects_empty_dirty_rects();
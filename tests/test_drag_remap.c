@@ -0,0 +1,263 @@
+#include "drag_remap.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void expect_true(uint8_t value, const char *name) {
+  if (!value) {
+    printf("FAIL: %s expected true\n", name);
+    failures++;
+  }
+}
+
+static void expect_false(uint8_t value, const char *name) {
+  if (value) {
+    printf("FAIL: %s expected false\n", name);
+    failures++;
+  }
+}
+
+static void expect_u16(uint16_t actual, uint16_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %u got %u\n", name, expected, actual);
+    failures++;
+  }
+}
+
+/* Shadow copy of the Plane A cells the sink has written. */
+typedef struct {
+  uint16_t cells[FB_TILES_Y][FB_TILES_X];
+  uint16_t rows;
+  uint16_t bytes;
+} NametableLog;
+
+static void nametable_reset(NametableLog *log) {
+  uint16_t x;
+  uint16_t y;
+
+  for (y = 0; y < FB_TILES_Y; y++)
+    for (x = 0; x < FB_TILES_X; x++)
+      log->cells[y][x] = (uint16_t)((y * FB_TILES_X) + x);
+  log->rows = 0;
+  log->bytes = 0;
+}
+
+static uint8_t record_nametable(uint16_t vramAddr, const uint16_t *entries,
+                                uint8_t count, void *user) {
+  NametableLog *log = (NametableLog *)user;
+  uint16_t cell = (uint16_t)((vramAddr - VRAM_PLANE_A) / 2U);
+  uint16_t x = (uint16_t)(cell % DRM_PLANE_CELLS_X);
+  uint16_t y = (uint16_t)(cell / DRM_PLANE_CELLS_X);
+  uint8_t i;
+
+  if (vramAddr < VRAM_PLANE_A || y >= FB_TILES_Y ||
+      (uint16_t)(x + count) > FB_TILES_X)
+    return 0;
+
+  for (i = 0; i < count; i++)
+    log->cells[y][x + i] = entries[i];
+  log->rows++;
+  log->bytes = (uint16_t)(log->bytes + (count * 2U));
+  return 1;
+}
+
+static void expect_plane_matches_remap(const NametableLog *log,
+                                       const DragRemap *remap,
+                                       const char *name) {
+  uint16_t x;
+  uint16_t y;
+  int before = failures;
+
+  for (y = 0; y < FB_TILES_Y && failures == before; y++)
+    for (x = 0; x < FB_TILES_X && failures == before; x++)
+      expect_u16(log->cells[y][x], DRM_EntryForCell(remap, x, y), name);
+}
+
+static void remap_points_window_cells_at_origin_tiles(void) {
+  DragRemap remap;
+  NametableLog log;
+  DirtyTileRange origin = {5, 5, 20, 15};
+
+  nametable_reset(&log);
+  DRM_Init(&remap);
+  expect_true(DRM_Begin(&remap, &origin), "remap begins");
+  expect_true(DRM_MoveTo(&remap, 2, 1, record_nametable, &log),
+              "remap moves");
+
+  /* New top-left cell shows the window's old top-left tile. */
+  expect_u16(log.cells[6][7], (uint16_t)((5 * FB_TILES_X) + 5),
+             "window cell remapped");
+  /* Uncovered origin cell shows a spare tile, not the window's home tile. */
+  expect_u16(log.cells[5][5], DRM_SPARE_FIRST_TILE, "uncovered uses spare");
+  expect_u16(log.cells[14][6],
+             (uint16_t)(DRM_SPARE_FIRST_TILE + (9 * 15) + 1),
+             "uncovered row spare");
+  /* Cells outside both positions are untouched. */
+  expect_u16(log.cells[0][0], 0, "far cell untouched");
+  expect_u16(log.cells[16][5], (uint16_t)((16 * FB_TILES_X) + 5),
+             "below cell untouched");
+  expect_plane_matches_remap(&log, &remap, "plane after first move");
+
+  /* A drag step costs a few hundred bytes of nametable, not tile data. */
+  expect_true(log.bytes <= 17U * 11U * 2U, "step writes union rows only");
+  expect_u16(log.rows, 11, "step row count");
+}
+
+static void remap_follows_successive_moves_and_restores(void) {
+  DragRemap remap;
+  NametableLog log;
+  DirtyTileRange origin = {10, 8, 22, 18};
+  static const int8_t path[][2] = {{1, 0}, {3, 2}, {-2, 4}, {-4, -3}, {0, 0}};
+  uint8_t i;
+
+  nametable_reset(&log);
+  DRM_Init(&remap);
+  expect_true(DRM_Begin(&remap, &origin), "path remap begins");
+  for (i = 0; i < sizeof(path) / sizeof(path[0]); i++) {
+    expect_true(DRM_MoveTo(&remap, path[i][0], path[i][1], record_nametable,
+                           &log),
+                "path move");
+    expect_plane_matches_remap(&log, &remap, "plane tracks path");
+  }
+
+  expect_true(DRM_MoveTo(&remap, 5, 1, record_nametable, &log),
+              "final path move");
+  expect_true(DRM_End(&remap, record_nametable, &log), "remap ends");
+  expect_false(remap.active, "remap inactive after end");
+  {
+    NametableLog identity;
+    nametable_reset(&identity);
+    expect_true(memcmp(identity.cells, log.cells, sizeof(log.cells)) == 0,
+                "end restores identity nametable");
+  }
+}
+
+static void remap_rejects_origins_larger_than_spare_pool(void) {
+  DragRemap remap;
+  DirtyTileRange tooBig = {0, 0, 40, 9};
+  DirtyTileRange fits = {0, 0, 32, 10};
+
+  /* The pool ends where the text console glyph tiles begin. */
+  expect_u16(DRM_SPARE_FIRST_TILE + DRM_SPARE_TILE_COUNT, TP_GLYPH_TILE,
+             "spare pool stops at glyph tiles");
+
+  DRM_Init(&remap);
+  expect_false(DRM_Begin(&remap, &tooBig), "360 tiles rejected");
+  expect_true(DRM_Begin(&remap, &fits), "320 tiles fit");
+}
+
+typedef struct {
+  uint8_t count;
+  uint16_t firstTile[8];
+  uint16_t tileCount[8];
+  uint16_t vramAddr[8];
+  uint8_t firstByte[8];
+} UploadLog;
+
+static uint8_t record_upload(const uint8_t *tileData, uint16_t firstTile,
+                             uint16_t tileCount, uint16_t vramAddr,
+                             uint16_t wordCount, void *user) {
+  UploadLog *log = (UploadLog *)user;
+
+  if (!log || log->count >= 8 ||
+      wordCount != tileCount * (FB_BYTES_PER_TILE / 2))
+    return 0;
+
+  log->firstTile[log->count] = firstTile;
+  log->tileCount[log->count] = tileCount;
+  log->vramAddr[log->count] = vramAddr;
+  log->firstByte[log->count] = tileData[0];
+  log->count++;
+  return 1;
+}
+
+static void routed_upload_sends_origin_tiles_to_spares(void) {
+  DragRemap remap;
+  DirtyTileRange origin = {5, 5, 20, 15};
+  DragRemapUpload routed;
+  UploadLog log;
+  uint8_t tiles[20 * FB_BYTES_PER_TILE];
+  uint16_t i;
+  uint16_t first = (uint16_t)((6 * FB_TILES_X) + 0);
+
+  for (i = 0; i < 20; i++)
+    tiles[i * FB_BYTES_PER_TILE] = (uint8_t)i;
+  memset(&log, 0, sizeof(log));
+  DRM_Init(&remap);
+  expect_true(DRM_Begin(&remap, &origin), "route remap begins");
+  routed.remap = &remap;
+  routed.upload = record_upload;
+  routed.user = &log;
+
+  /* Row 6, columns 0..19: 5 home tiles then 15 origin tiles. */
+  expect_true(DRM_RoutedUpload(tiles, first, 20,
+                               (uint16_t)(first * FB_BYTES_PER_TILE),
+                               20 * (FB_BYTES_PER_TILE / 2), &routed),
+              "routed upload succeeds");
+  expect_u16(log.count, 2, "routed upload split in two");
+  expect_u16(log.firstTile[0], first, "home piece first tile");
+  expect_u16(log.tileCount[0], 5, "home piece tiles");
+  expect_u16(log.vramAddr[0], (uint16_t)(first * FB_BYTES_PER_TILE),
+             "home piece address");
+  expect_u16(log.tileCount[1], 15, "spare piece tiles");
+  expect_u16(log.vramAddr[1],
+             (uint16_t)((DRM_SPARE_FIRST_TILE + 15) * FB_BYTES_PER_TILE),
+             "spare piece address");
+  expect_u16(log.firstByte[1], 5, "spare piece data offset");
+
+  DRM_Init(&remap);
+  memset(&log, 0, sizeof(log));
+  expect_true(DRM_RoutedUpload(tiles, first, 20,
+                               (uint16_t)(first * FB_BYTES_PER_TILE),
+                               20 * (FB_BYTES_PER_TILE / 2), &routed),
+              "inactive routed upload succeeds");
+  expect_u16(log.count, 1, "inactive upload passes through");
+}
+
+static void move_result_words_drive_drag_and_drop(void) {
+  DragRemap remap;
+  NametableLog log;
+
+  nametable_reset(&log);
+  DRM_Init(&remap);
+
+  expect_true(DRM_ApplyMoveResult(&remap, 0xFFFF, 0, 0, 0, record_nametable,
+                                  &log),
+              "no move is a no-op");
+  expect_false(remap.active, "no move leaves remap idle");
+
+  /* WM_MOVE_DRAG of window 3, origin tiles (5,5)-(20,15), moved -1,+2. */
+  expect_true(DRM_ApplyMoveResult(&remap, (1U << 8) | 3U, 0x0505, 0x140F,
+                                  (uint16_t)(((uint8_t)-1 << 8) | 2U),
+                                  record_nametable, &log),
+              "drag result applies");
+  expect_true(remap.active, "drag result activates remap");
+  expect_u16((uint16_t)(int16_t)remap.dx, (uint16_t)(int16_t)-1,
+             "drag dx decoded");
+  expect_u16((uint16_t)remap.dy, 2, "drag dy decoded");
+  expect_plane_matches_remap(&log, &remap, "plane after drag result");
+
+  /* WM_MOVE_DROP restores the identity map. */
+  expect_true(DRM_ApplyMoveResult(&remap, (2U << 8) | 3U, 0x0505, 0x140F, 0,
+                                  record_nametable, &log),
+              "drop result applies");
+  expect_false(remap.active, "drop deactivates remap");
+  expect_plane_matches_remap(&log, &remap, "plane after drop result");
+}
+
+int main(void) {
+  remap_points_window_cells_at_origin_tiles();
+  remap_follows_successive_moves_and_restores();
+  remap_rejects_origins_larger_than_spare_pool();
+  routed_upload_sends_origin_tiles_to_spares();
+  move_result_words_drive_drag_and_drop();
+
+  if (failures) {
+    printf("%d drag remap test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("drag remap tests passed\n");
+  return 0;
+}
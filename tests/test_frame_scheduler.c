@@ -156,11 +156,86 @@ static void queue_overflow_does_not_advance_cursor(void) {
   expect_true(cursor.active, "overflow cursor still active");
 }
 
+static void fill_runs_cost_less_than_copy_spans(void) {
+  expect_u16(FS_FillRunCost(0, FB_BYTES_PER_TILE), 0, "empty fill is free");
+  expect_u16(FS_FillRunCost(4, FB_BYTES_PER_TILE), 48, "small fill cost");
+  expect_true(FS_FillRunCost(FB_TILE_COUNT, FB_BYTES_PER_TILE) <
+                  (uint16_t)(FB_TILE_COUNT * FB_BYTES_PER_TILE),
+              "full clear fill cheaper than copy");
+}
+
+static void full_screen_fill_slices_across_ntsc_vblank_budget(void) {
+  DirtyTileFill run;
+  DirtyTileFill sliceItems[2];
+  DirtyFillList fills;
+  DirtyFillList slice;
+  FrameFillCursor cursor;
+  uint16_t charged;
+
+  DR_InitFillList(&fills, &run, 1);
+  DR_InitFillList(&slice, sliceItems, 2);
+  run.firstTile = 0;
+  run.tileCount = FB_TILE_COUNT;
+  run.colorIndex = 7;
+  fills.count = 1;
+  FS_ClearFillCursor(&cursor);
+
+  expect_false(FS_PlanFillFrame(&cursor, &fills, &slice, 7524,
+                                FB_BYTES_PER_TILE, &charged),
+               "fill slice 0 incomplete");
+  expect_u8(slice.count, 1, "fill slice 0 count");
+  expect_u16(slice.items[0].firstTile, 0, "fill slice 0 first");
+  expect_u16(slice.items[0].tileCount, 938, "fill slice 0 tiles");
+  expect_u8(slice.items[0].colorIndex, 7, "fill slice 0 colour");
+  expect_true(charged <= 7524, "fill slice 0 within budget");
+  expect_u16(cursor.doneTiles, 938, "fill cursor mid run");
+
+  expect_true(FS_PlanFillFrame(&cursor, &fills, &slice, 7524,
+                               FB_BYTES_PER_TILE, &charged),
+              "fill slice 1 completes");
+  expect_u16(slice.items[0].firstTile, 938, "fill slice 1 first");
+  expect_u16(slice.items[0].tileCount, 182, "fill slice 1 tiles");
+  expect_u16(charged, FS_FillRunCost(182, FB_BYTES_PER_TILE),
+             "fill slice 1 charge");
+}
+
+static void fill_budget_leaves_room_for_copies(void) {
+  DirtyTileFill runs[2];
+  DirtyTileFill sliceItems[2];
+  DirtyFillList fills;
+  DirtyFillList slice;
+  FrameFillCursor cursor;
+  uint16_t charged;
+
+  DR_InitFillList(&fills, runs, 2);
+  DR_InitFillList(&slice, sliceItems, 2);
+  runs[0].firstTile = 40;
+  runs[0].tileCount = 40;
+  runs[0].colorIndex = 15;
+  runs[1].firstTile = 200;
+  runs[1].tileCount = 40;
+  runs[1].colorIndex = 8;
+  fills.count = 2;
+  FS_ClearFillCursor(&cursor);
+
+  expect_true(FS_PlanFillFrame(&cursor, &fills, &slice, 7524,
+                               FB_BYTES_PER_TILE, &charged),
+              "two row fills plan in one frame");
+  expect_u8(slice.count, 2, "two row fills sliced");
+  expect_u16(charged, 2 * FS_FillRunCost(40, FB_BYTES_PER_TILE),
+             "two row fill charge");
+  expect_true((uint16_t)(7524 - charged) >= 6 * 1024,
+              "copy budget left after fills");
+}
+
 int main(void) {
   small_span_finishes_in_one_budgeted_frame();
   full_frame_slices_across_ntsc_vblank_budget();
   inactive_cursor_clears_queue_and_reports_complete();
   queue_overflow_does_not_advance_cursor();
+  fill_runs_cost_less_than_copy_spans();
+  full_screen_fill_slices_across_ntsc_vblank_budget();
+  fill_budget_leaves_room_for_copies();
 
   if (failures) {
     printf("frame scheduler tests failed: %d\n", failures);
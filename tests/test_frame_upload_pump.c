@@ -62,6 +62,81 @@ static uint8_t upload_spy_callback(const DirtyTileQueue *queue, void *user) {
   return 1;
 }
 
+typedef struct {
+  uint8_t calls;
+  uint16_t tiles;
+  uint16_t spans;
+  uint8_t tileHits[FB_TILE_COUNT];
+} SpanUploadSpy;
+
+static uint8_t span_spy_callback(const DirtyTileQueue *queue, void *user) {
+  SpanUploadSpy *spy = (SpanUploadSpy *)user;
+  uint8_t i;
+
+  if (!spy || !queue || queue->count == 0 || !queue->items)
+    return 0;
+
+  spy->calls++;
+  for (i = 0; i < queue->count; i++) {
+    const DirtyTileUpload *upload = &queue->items[i];
+    uint16_t t;
+
+    if (upload->byteCount != upload->tileCount * FB_BYTES_PER_TILE)
+      return 0;
+    for (t = 0; t < upload->tileCount; t++) {
+      uint16_t tile = (uint16_t)(upload->firstTile + t);
+      if (tile < FB_TILE_COUNT && spy->tileHits[tile] < 0xffU)
+        spy->tileHits[tile]++;
+    }
+    spy->tiles = (uint16_t)(spy->tiles + upload->tileCount);
+    spy->spans++;
+  }
+
+  return 1;
+}
+
+static void damage_queue(DirtyTileQueue *queue, DirtyTileUpload *storage,
+                         uint8_t capacity) {
+  uint8_t i;
+
+  queue->items = storage;
+  queue->capacity = capacity;
+  queue->count = 0;
+  queue->maxBytes = 0;
+  queue->byteCount = 0;
+  queue->budgetExceeded = 0;
+  queue->overflow = 0;
+  for (i = 0; i < capacity; i++) {
+    storage[i].firstTile = 0;
+    storage[i].tileCount = 0;
+    storage[i].byteCount = 0;
+  }
+}
+
+static void damage_add(DirtyTileQueue *queue, uint16_t firstTile,
+                       uint16_t tileCount) {
+  queue->items[queue->count].firstTile = firstTile;
+  queue->items[queue->count].tileCount = tileCount;
+  queue->items[queue->count].byteCount =
+      (uint16_t)(tileCount * FB_BYTES_PER_TILE);
+  queue->byteCount =
+      (uint16_t)(queue->byteCount + queue->items[queue->count].byteCount);
+  queue->count++;
+}
+
+static uint8_t pump_drain(FrameUploadPump *pump, SpanUploadSpy *spy,
+                          uint8_t maxTicks) {
+  FrameScheduleResult result;
+  uint8_t ticks = 0;
+
+  while (!FUP_ShouldReturnWordRam(pump) && ticks < maxTicks) {
+    if (!FUP_Tick(pump, span_spy_callback, spy, &result))
+      return 0xffU;
+    ticks++;
+  }
+  return ticks;
+}
+
 static void full_frame_becomes_return_ready_after_budgeted_uploads(void) {
   FrameUploadPump pump;
   UploadSpy spy = {0};
@@ -183,12 +258,156 @@ static void failed_upload_enters_error_without_return_ready(void) {
   expect_u16(FUP_NextTile(&pump), 0, "failed upload rewinds cursor");
 }
 
+static void latest_wins_uploads_single_frame_like_cursor(void) {
+  static FrameUploadPump pump;
+  static SpanUploadSpy spy;
+  DirtyTileUpload damageStorage[2];
+  DirtyTileQueue damage;
+
+  FUP_InitLatestWins(&pump, 7524, FB_BYTES_PER_TILE);
+  damage_queue(&damage, damageStorage, 2);
+  damage_add(&damage, 0, FB_TILE_COUNT);
+
+  expect_true(FUP_OfferFrame(&pump, 1, &damage), "latest offer first frame");
+  expect_u8(pump.state, FUP_STATE_UPLOADING, "latest first frame uploading");
+  expect_u16(FUP_PendingTiles(&pump), FB_TILE_COUNT, "latest first pending");
+  expect_u8(pump_drain(&pump, &spy, 16), 5, "latest single frame ticks");
+  expect_u16(spy.tiles, FB_TILE_COUNT, "latest single frame tiles");
+  expect_true(FUP_ShouldReturnWordRam(&pump), "latest single frame ready");
+  expect_false(FUP_OfferFrame(&pump, 2, &damage),
+               "latest rejects offer while waiting return");
+  expect_true(FUP_MarkWordRamReturned(&pump), "latest ack return");
+  expect_true(FUP_OfferFrame(&pump, 2, &damage), "latest offer after return");
+}
+
+static void latest_wins_carries_over_uncovered_tail_once(void) {
+  static FrameUploadPump pump;
+  static SpanUploadSpy spy;
+  DirtyTileUpload damageStorage[2];
+  DirtyTileQueue damage;
+  FrameScheduleResult result;
+  uint16_t tile;
+  uint8_t duplicateTiles = 0;
+  uint8_t missedTiles = 0;
+
+  FUP_InitLatestWins(&pump, 7524, FB_BYTES_PER_TILE);
+  damage_queue(&damage, damageStorage, 2);
+  damage_add(&damage, 0, FB_TILE_COUNT);
+  expect_true(FUP_OfferFrame(&pump, 1, &damage), "overlap offer frame 1");
+  expect_true(FUP_Tick(&pump, span_spy_callback, &spy, &result),
+              "overlap frame 1 slice 0");
+  expect_u16(FUP_PendingTiles(&pump), FB_TILE_COUNT - 235,
+             "overlap frame 1 pending after slice");
+
+  /* Frame 2 damages a window-sized band inside the unsent tail. */
+  damage_queue(&damage, damageStorage, 2);
+  damage_add(&damage, 300, 100);
+  expect_true(FUP_OfferFrame(&pump, 2, &damage), "overlap offer frame 2");
+  expect_u8(pump.state, FUP_STATE_SUPERSEDED, "overlap superseded state");
+  expect_u16(FUP_FrameSeq(&pump), 2, "overlap frame seq");
+  expect_u8(pump.spanCount, 3, "overlap span count");
+  expect_u16(pump.spans[0].firstTile, 235, "overlap carry head first");
+  expect_u16(pump.spans[0].tileCount, 65, "overlap carry head tiles");
+  expect_u16(pump.spans[0].frameSeq, 1, "overlap carry head seq");
+  expect_u16(pump.spans[1].firstTile, 400, "overlap carry tail first");
+  expect_u16(pump.spans[1].tileCount, 720, "overlap carry tail tiles");
+  expect_u16(pump.spans[2].firstTile, 300, "overlap new damage first");
+  expect_u16(pump.spans[2].frameSeq, 2, "overlap new damage seq");
+  expect_u16(FUP_PendingTiles(&pump), FB_TILE_COUNT - 235,
+             "overlap pending unchanged by covered damage");
+
+  expect_true(FUP_Tick(&pump, span_spy_callback, &spy, &result),
+              "overlap carryover slice");
+  expect_u8(pump.state, FUP_STATE_CARRYOVER, "overlap carryover state");
+  expect_u16(result.queuedTiles, 235, "overlap carryover batches spans");
+  expect_true(FUP_IsUploading(&pump), "overlap carryover is uploading");
+
+  expect_u8(pump_drain(&pump, &spy, 16), 3, "overlap remaining ticks");
+  expect_u16(spy.tiles, FB_TILE_COUNT, "overlap total tiles sent once");
+  for (tile = 0; tile < FB_TILE_COUNT; tile++) {
+    if (spy.tileHits[tile] > 1)
+      duplicateTiles = 1;
+    if (spy.tileHits[tile] == 0)
+      missedTiles = 1;
+  }
+  expect_false(duplicateTiles, "overlap no duplicate tiles");
+  expect_false(missedTiles, "overlap no missed tiles");
+}
+
+static void latest_wins_skips_tail_fully_covered_by_new_frame(void) {
+  static FrameUploadPump pump;
+  static SpanUploadSpy spy;
+  DirtyTileUpload damageStorage[2];
+  DirtyTileQueue damage;
+  FrameScheduleResult result;
+
+  FUP_InitLatestWins(&pump, 7524, FB_BYTES_PER_TILE);
+  damage_queue(&damage, damageStorage, 2);
+  damage_add(&damage, 0, FB_TILE_COUNT);
+  expect_true(FUP_OfferFrame(&pump, 7, &damage), "covered offer frame 7");
+  expect_true(FUP_Tick(&pump, span_spy_callback, &spy, &result),
+              "covered frame 7 slice");
+  expect_true(FUP_OfferFrame(&pump, 8, &damage), "covered offer frame 8");
+  expect_u8(pump.spanCount, 1, "covered drops stale tail");
+  expect_u16(pump.spans[0].frameSeq, 8, "covered only new frame");
+
+  expect_true(FUP_Tick(&pump, span_spy_callback, &spy, &result),
+              "covered frame 8 slice");
+  expect_u8(pump.state, FUP_STATE_UPLOADING, "covered skips carryover");
+  expect_u8(pump_drain(&pump, &spy, 16), 4, "covered remaining ticks");
+  expect_u16(spy.tiles, 235 + FB_TILE_COUNT, "covered restart from zero");
+}
+
+static void latest_wins_rejects_stale_and_wrapped_sequences(void) {
+  static FrameUploadPump pump;
+  DirtyTileUpload damageStorage[1];
+  DirtyTileQueue damage;
+
+  FUP_InitLatestWins(&pump, 7524, FB_BYTES_PER_TILE);
+  damage_queue(&damage, damageStorage, 1);
+  damage_add(&damage, 40, 40);
+  expect_true(FUP_OfferFrame(&pump, 0xfffe, &damage), "seq offer near wrap");
+  expect_false(FUP_OfferFrame(&pump, 0xfffd, &damage), "seq rejects older");
+  expect_false(FUP_OfferFrame(&pump, 0xfffe, &damage), "seq rejects same");
+  expect_true(FUP_OfferFrame(&pump, 1, &damage), "seq accepts wrapped newer");
+  expect_u16(FUP_PendingTiles(&pump), 40, "seq pending after wrap");
+  expect_false(FUP_StartFrame(&pump, 0, 4), "latest mode rejects cursor start");
+}
+
+static void latest_wins_widens_last_span_on_overflow(void) {
+  static FrameUploadPump pump;
+  static SpanUploadSpy spy;
+  DirtyTileUpload damageStorage[FUP_MAX_SPANS + 2];
+  DirtyTileQueue damage;
+  uint8_t i;
+
+  FUP_InitLatestWins(&pump, 7524, FB_BYTES_PER_TILE);
+  damage_queue(&damage, damageStorage, FUP_MAX_SPANS + 2);
+  for (i = 0; i < FUP_MAX_SPANS + 2; i++) {
+    damage_add(&damage, (uint16_t)(i * 80U), 4);
+  }
+
+  expect_true(FUP_OfferFrame(&pump, 1, &damage), "overflow offer");
+  expect_u8(pump.spanCount, FUP_MAX_SPANS, "overflow span cap");
+  expect_u16(pump.spans[FUP_MAX_SPANS - 1].firstTile, 560,
+             "overflow widened first");
+  expect_u16(pump.spans[FUP_MAX_SPANS - 1].tileCount, 164,
+             "overflow widened tiles");
+  expect_u8(pump_drain(&pump, &spy, 4), 1, "overflow drains in one tick");
+  expect_u16(spy.tileHits[720], 1, "overflow keeps last damage tile");
+}
+
 int main(void) {
   full_frame_becomes_return_ready_after_budgeted_uploads();
   compact_queue_planner_matches_budgeted_slices();
   compact_no_result_planner_reaches_return_ready();
   refuses_new_frame_until_return_is_acknowledged();
   failed_upload_enters_error_without_return_ready();
+  latest_wins_uploads_single_frame_like_cursor();
+  latest_wins_carries_over_uncovered_tail_once();
+  latest_wins_skips_tail_fully_covered_by_new_frame();
+  latest_wins_rejects_stale_and_wrapped_sequences();
+  latest_wins_widens_last_span_on_overflow();
 
   if (failures) {
     printf("frame upload pump tests failed: %d\n", failures);
@@ -205,12 +205,90 @@ static void framebuffer_rejects_queue_flush_without_scratch_space(void) {
   expect_u8(log.count, 0, "no uploads with undersized scratch");
 }
 
+typedef struct {
+  uint8_t count;
+  uint16_t firstTile[4];
+  uint16_t vramAddr[4];
+  uint16_t byteCount[4];
+  uint8_t fillByte[4];
+} FillLog;
+
+static uint8_t record_fill(uint16_t firstTile, uint16_t tileCount,
+                           uint16_t vramAddr, uint16_t byteCount,
+                           uint8_t fillByte, void *user) {
+  FillLog *log = (FillLog *)user;
+  uint8_t index;
+
+  if (!log || log->count >= 4 || tileCount == 0)
+    return 0;
+
+  index = log->count;
+  log->firstTile[index] = firstTile;
+  log->vramAddr[index] = vramAddr;
+  log->byteCount[index] = byteCount;
+  log->fillByte[index] = fillByte;
+  log->count++;
+  return 1;
+}
+
+static void framebuffer_flushes_fill_runs_as_packed_vram_fills(void) {
+  DirtyTileFill runs[2];
+  DirtyFillList fills;
+  FillLog log;
+
+  memset(&log, 0, sizeof(log));
+  DR_InitFillList(&fills, runs, 2);
+  runs[0].firstTile = 0;
+  runs[0].tileCount = FB_TILE_COUNT;
+  runs[0].colorIndex = 0x7;
+  runs[1].firstTile = 82;
+  runs[1].tileCount = 3;
+  runs[1].colorIndex = 0xf;
+  fills.count = 2;
+
+  expect_true(FB_FlushFillListWithCallback(&fills, record_fill, &log),
+              "fill flush succeeds");
+  expect_u8(log.count, 2, "fill flush count");
+  expect_u16(log.vramAddr[0], 0, "full clear vram address");
+  expect_u16(log.byteCount[0], FB_TILE_COUNT * FB_BYTES_PER_TILE,
+             "full clear byte count");
+  expect_u8(log.fillByte[0], 0x77, "full clear packed colour");
+  expect_u16(log.firstTile[1], 82, "second fill tile");
+  expect_u16(log.vramAddr[1], 82 * FB_BYTES_PER_TILE, "second fill address");
+  expect_u16(log.byteCount[1], 3 * FB_BYTES_PER_TILE, "second fill bytes");
+  expect_u8(log.fillByte[1], 0xff, "second fill packed colour");
+}
+
+static void framebuffer_rejects_invalid_fill_runs(void) {
+  DirtyTileFill run;
+  DirtyFillList fills;
+  FillLog log;
+
+  memset(&log, 0, sizeof(log));
+  DR_InitFillList(&fills, &run, 1);
+  run.firstTile = FB_TILE_COUNT - 1;
+  run.tileCount = 2;
+  run.colorIndex = 1;
+  fills.count = 1;
+  expect_false(FB_FlushFillListWithCallback(&fills, record_fill, &log),
+               "fill past last tile rejected");
+
+  run.firstTile = 0;
+  run.tileCount = 1;
+  run.colorIndex = 0x10;
+  expect_false(FB_FlushFillListWithCallback(&fills, record_fill, &log),
+               "fill colour above 4bpp rejected");
+  expect_u8(log.count, 0, "no fills issued for invalid runs");
+}
+
 int main(void) {
   framebuffer_converts_single_tile_span();
   framebuffer_converts_span_across_row_boundary();
   framebuffer_rejects_invalid_spans();
   framebuffer_flushes_dirty_queue_in_strip_sized_chunks();
   framebuffer_rejects_queue_flush_without_scratch_space();
+  framebuffer_flushes_fill_runs_as_packed_vram_fills();
+  framebuffer_rejects_invalid_fill_runs();
 
   if (failures) {
     printf("%d framebuffer test(s) failed\n", failures);
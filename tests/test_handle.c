@@ -0,0 +1,197 @@
+#include "handle.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void expect_true(int value, const char *name) {
+  if (!value) {
+    printf("FAIL: %s expected true\n", name);
+    failures++;
+  }
+}
+
+static void expect_u32(uint32_t actual, uint32_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %lu got %lu\n", name, (unsigned long)expected,
+           (unsigned long)actual);
+    failures++;
+  }
+}
+
+#define HEAP_BYTES 8192U
+#define SLOT_BYTES 512U
+#define SLOTS 14
+
+static uint32_t heapStore[HEAP_BYTES / 4];
+
+static void reset_heap(void) {
+  MEM_Init(heapStore, heapStore + HEAP_BYTES / 4);
+  HND_Init();
+}
+
+static void fill(Handle h, uint8_t tag) {
+  memset(*h, tag, HND_GetSize(h));
+}
+
+static int holds(Handle h, uint8_t tag) {
+  const uint8_t *p = (const uint8_t *)*h;
+  uint32_t i;
+
+  if (!p)
+    return 0;
+  for (i = 0; i < HND_GetSize(h); i++) {
+    if (p[i] != tag)
+      return 0;
+  }
+  return 1;
+}
+
+static uint32_t largest_free(void) {
+  MemStats stats;
+
+  MEM_GetStats(&stats);
+  return stats.largestFree;
+}
+
+/* Fill the heap with equal handles, then free every other one: plenty of
+ * free bytes, none of them contiguous */
+static void fragment(Handle *slots) {
+  uint16_t i;
+
+  for (i = 0; i < SLOTS; i++) {
+    slots[i] = HND_New(SLOT_BYTES);
+    expect_true(slots[i] != (Handle)0, "fill handle");
+    fill(slots[i], (uint8_t)(i + 1));
+  }
+  for (i = 0; i < SLOTS; i += 2) {
+    HND_Dispose(slots[i]);
+    slots[i] = (Handle)0;
+  }
+}
+
+static int survivors_intact(Handle *slots) {
+  uint16_t i;
+
+  for (i = 1; i < SLOTS; i += 2) {
+    if (slots[i] && !holds(slots[i], (uint8_t)(i + 1)))
+      return 0;
+  }
+  return 1;
+}
+
+static void compaction_recovers_contiguous_block(void) {
+  Handle slots[SLOTS];
+  Handle big;
+  void *lockedAt;
+  HndStats stats;
+
+  reset_heap();
+  fragment(slots);
+  HND_Lock(slots[5]);
+  lockedAt = *slots[5];
+
+  expect_true(MEM_GetFreeBytes() > 2000, "enough free bytes in total");
+  expect_true(largest_free() < 2000, "but no free block fits");
+
+  big = HND_New(2000);
+  expect_true(big != (Handle)0, "compaction made room");
+  expect_true(*slots[5] == lockedAt, "locked handle stayed put");
+  expect_true(survivors_intact(slots), "moved handles kept their bytes");
+  HND_GetStats(&stats);
+  expect_true(stats.compactions >= 1, "grow zone compacted");
+  expect_true(stats.bytesMoved > 0, "blocks slid down");
+  expect_u32(stats.locked, 1, "one locked handle");
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after compaction");
+
+  /* The locked block splits the free space: a request larger than
+   * either side cannot be met without unlocking */
+  expect_true(HND_New(MEM_GetFreeBytes() - 64) == (Handle)0,
+              "locked handle pins free space");
+  HND_Unlock(slots[5]);
+  HND_Compact();
+  expect_true(largest_free() >= MEM_GetFreeBytes() - 64,
+              "unlocked heap compacts to one free block");
+  expect_true(survivors_intact(slots), "contents kept after full compact");
+}
+
+static void purges_caches_before_failing(void) {
+  Handle slots[SLOTS];
+  Handle big;
+  uint32_t want;
+
+  reset_heap();
+  fragment(slots);
+  HND_Lock(slots[7]);
+
+  /* More than compaction alone can gather beside the locked handle */
+  HND_Compact();
+  want = largest_free() + SLOT_BYTES / 2;
+  expect_true(HND_New(want) == (Handle)0, "compaction alone falls short");
+
+  HND_SetPurgeable(slots[13], 1);
+  big = HND_New(want);
+  expect_true(big != (Handle)0, "purge made room");
+  expect_true(*slots[13] == (void *)0, "cache purged");
+  expect_u32(HND_GetSize(slots[13]), 0, "purged size");
+  expect_true(holds(slots[11], 12), "non-purgeable kept");
+
+  /* The owner rebuilds a purged cache on demand */
+  HND_Dispose(big);
+  expect_u32((uint32_t)HND_SetSize(slots[13], 64), 0, "refill purged");
+  expect_u32(HND_GetSize(slots[13]), 64, "refilled size");
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after purge");
+}
+
+static void plain_blocks_never_move(void) {
+  Handle a;
+  Handle b;
+  uint8_t *fixed;
+  void *bAt;
+  uint32_t i;
+
+  reset_heap();
+  a = HND_New(1000);
+  fixed = (uint8_t *)MEM_Alloc(200);
+  b = HND_New(1000);
+  expect_true(a && fixed && b, "setup");
+  memset(fixed, 0x5A, 200);
+  fill(b, 0xB0);
+  bAt = *b;
+  HND_Dispose(a);
+
+  /* The gap sits under a pointer block, which compaction leaves alone */
+  expect_u32(HND_Compact(), 0, "nothing movable over the gap");
+  expect_true(*b == bAt, "handle above pointer block stayed");
+  for (i = 0; i < 200 && fixed[i] == 0x5A; i++) {
+  }
+  expect_u32(i, 200, "pointer block untouched");
+
+  /* Growing keeps the contents and the handle */
+  expect_u32((uint32_t)HND_SetSize(b, 3000), 0, "handle grows");
+  expect_u32(HND_GetSize(b), 3000, "grown size");
+  for (i = 0; i < 1000 && ((uint8_t *)*b)[i] == 0xB0; i++) {
+  }
+  expect_u32(i, 1000, "grown handle keeps its bytes");
+  expect_true(HND_SetSize(b, HEAP_BYTES) != 0, "oversized grow refused");
+  expect_u32(HND_GetSize(b), 3000, "failed grow leaves size");
+
+  HND_Dispose(b);
+  HND_Dispose((Handle)heapStore); /* Not a master pointer: ignored */
+  MEM_Free(fixed);
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid with pointer blocks");
+}
+
+int main(void) {
+  compaction_recovers_contiguous_block();
+  purges_caches_before_failing();
+  plain_blocks_never_move();
+
+  if (failures) {
+    printf("%d handle test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("handle tests passed\n");
+  return 0;
+}
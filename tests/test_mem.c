@@ -0,0 +1,523 @@
+#include "mem.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void expect_true(int value, const char *name) {
+  if (!value) {
+    printf("FAIL: %s expected true\n", name);
+    failures++;
+  }
+}
+
+static void expect_u32(uint32_t actual, uint32_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %lu got %lu\n", name, (unsigned long)expected,
+           (unsigned long)actual);
+    failures++;
+  }
+}
+
+#define HEAP_BYTES (160UL * 1024UL)
+
+static uint32_t heapStore[HEAP_BYTES / 4];
+
+/* ============================================================
+ * Reference: the first-fit allocator mem.c used before size classes,
+ * counting the free-list links it follows
+ * ============================================================ */
+static struct {
+  uint32_t store[HEAP_BYTES / 4];
+  BlockHeader *freeList;
+  uint8_t *end;
+  uint32_t steps;
+} ref;
+
+static void ref_init(void) {
+  BlockHeader *first = (BlockHeader *)ref.store;
+
+  first->sizeAndFlags = (uint32_t)sizeof(ref.store);
+  first->next = (BlockHeader *)0;
+  ref.freeList = first;
+  ref.end = (uint8_t *)ref.store + sizeof(ref.store);
+  ref.steps = 0;
+}
+
+static void *ref_alloc(uint32_t size) {
+  BlockHeader *curr = ref.freeList;
+  BlockHeader *prev = (BlockHeader *)0;
+  uint32_t needed = ((size + 3U) & ~3U) + sizeof(BlockHeader);
+
+  while (curr) {
+    uint32_t blockSize = BLK_SIZE(curr);
+
+    ref.steps++;
+    if (blockSize >= needed) {
+      BlockHeader *rest = curr->next;
+      uint32_t remainder = blockSize - needed;
+
+      if (remainder >= sizeof(BlockHeader) + MEM_MIN_SPLIT) {
+        rest = (BlockHeader *)((uint8_t *)curr + needed);
+        rest->sizeAndFlags = remainder;
+        rest->next = curr->next;
+        curr->sizeAndFlags = needed;
+      }
+      if (prev)
+        prev->next = rest;
+      else
+        ref.freeList = rest;
+      BLK_SET_USED(curr);
+      return BLK_DATA(curr);
+    }
+    prev = curr;
+    curr = curr->next;
+  }
+  return (void *)0;
+}
+
+static void ref_free(void *ptr) {
+  BlockHeader *block;
+  BlockHeader *curr = ref.freeList;
+  BlockHeader *prev = (BlockHeader *)0;
+
+  if (!ptr)
+    return;
+  block = BLK_FROM_DATA(ptr);
+  BLK_SET_FREE(block);
+
+  while (curr && curr < block) {
+    ref.steps++;
+    prev = curr;
+    curr = curr->next;
+  }
+  block->next = curr;
+  if (prev)
+    prev->next = block;
+  else
+    ref.freeList = block;
+
+  if ((uint8_t *)BLK_NEXT_ADJ(block) < ref.end && BLK_NEXT_ADJ(block) == curr) {
+    BLK_SET_SIZE(block, BLK_SIZE(block) + BLK_SIZE(curr));
+    block->next = curr->next;
+  }
+  if (prev && BLK_NEXT_ADJ(prev) == block) {
+    BLK_SET_SIZE(prev, BLK_SIZE(prev) + BLK_SIZE(block));
+    prev->next = block->next;
+  }
+}
+
+static void ref_stats(MemStats *stats) {
+  BlockHeader *blk;
+
+  memset(stats, 0, sizeof(MemStats));
+  stats->searchSteps = ref.steps;
+  for (blk = ref.freeList; blk; blk = blk->next) {
+    uint32_t data = BLK_SIZE(blk) - sizeof(BlockHeader);
+    stats->freeBlocks++;
+    stats->freeBytes += data;
+    if (data > stats->largestFree)
+      stats->largestFree = data;
+  }
+}
+
+/* ============================================================
+ * Synthetic app open/close workload
+ * ============================================================ */
+#define APP_SLOTS 5
+#define APP_BLOCKS 24
+#define SYSTEM_BLOCKS 32
+
+typedef struct {
+  void *(*alloc)(uint32_t size);
+  void (*release)(void *ptr);
+} Allocator;
+
+typedef struct {
+  uint32_t ops;
+  uint32_t failures;
+  uint32_t corrupt;
+  uint32_t invalid;
+} WorkloadResult;
+
+static uint32_t workload_seed;
+
+static uint32_t workload_rand(uint32_t limit) {
+  workload_seed = workload_seed * 1103515245UL + 12345UL;
+  return (workload_seed >> 16) % limit;
+}
+
+/* Each block is filled with its tag so overlapping blocks show up */
+static void *tagged_alloc(const Allocator *a, uint32_t size, uint8_t tag,
+                          WorkloadResult *result) {
+  uint8_t *p = (uint8_t *)a->alloc(size);
+
+  result->ops++;
+  if (!p) {
+    result->failures++;
+    return (void *)0;
+  }
+  if (((uintptr_t)p & (MEM_ALIGN - 1)) != 0)
+    result->corrupt++;
+  memset(p, tag, size);
+  p[0] = (uint8_t)size;
+  return p;
+}
+
+static void tagged_free(const Allocator *a, void *ptr, uint32_t size,
+                        uint8_t tag, WorkloadResult *result) {
+  uint8_t *p = (uint8_t *)ptr;
+  uint32_t i;
+
+  if (!p)
+    return;
+  if (p[0] != (uint8_t)size)
+    result->corrupt++;
+  for (i = 1; i < size; i++) {
+    if (p[i] != tag) {
+      result->corrupt++;
+      break;
+    }
+  }
+  result->ops++;
+  a->release(p);
+}
+
+/* Apps open with a document buffer plus small objects, grow and shrink
+ * while running, and close releasing everything; the system keeps a set
+ * of longer-lived blocks churning underneath. Decisions never depend on
+ * allocation results, so both allocators see the same request stream.
+ * `closeAll` ends with every block released. */
+static void run_workload(const Allocator *a, uint16_t steps, int closeAll,
+                         WorkloadResult *result) {
+  static void *appPtr[APP_SLOTS][APP_BLOCKS];
+  static uint32_t appSize[APP_SLOTS][APP_BLOCKS];
+  static uint8_t appCount[APP_SLOTS];
+  static void *sysPtr[SYSTEM_BLOCKS];
+  static uint32_t sysSize[SYSTEM_BLOCKS];
+  uint16_t step;
+  uint8_t app;
+  uint8_t i;
+
+  memset(result, 0, sizeof(*result));
+  memset(appCount, 0, sizeof(appCount));
+  memset(sysPtr, 0, sizeof(sysPtr));
+  workload_seed = 2024;
+
+  for (step = 0; step < steps; step++) {
+    uint32_t action = workload_rand(100);
+    uint8_t tag;
+
+    app = (uint8_t)workload_rand(APP_SLOTS);
+    tag = (uint8_t)(0x10 + app);
+
+    if (action < 20) {
+      /* Open an app or close it */
+      if (!appCount[app]) {
+        appSize[app][0] = 2048 + workload_rand(10240);
+        appPtr[app][0] = tagged_alloc(a, appSize[app][0], tag, result);
+        appCount[app] = 1;
+        for (i = 0; i < 4 + workload_rand(8); i++) {
+          appSize[app][appCount[app]] = 16 + workload_rand(300);
+          appPtr[app][appCount[app]] =
+              tagged_alloc(a, appSize[app][appCount[app]], tag, result);
+          appCount[app]++;
+        }
+      } else {
+        while (appCount[app]) {
+          /* Apps release in no particular order */
+          uint8_t pick = (uint8_t)workload_rand(appCount[app]);
+          appCount[app]--;
+          tagged_free(a, appPtr[app][pick], appSize[app][pick], tag, result);
+          appPtr[app][pick] = appPtr[app][appCount[app]];
+          appSize[app][pick] = appSize[app][appCount[app]];
+        }
+      }
+    } else if (action < 60) {
+      /* A running app allocates or frees one object */
+      if (appCount[app] && appCount[app] < APP_BLOCKS &&
+          workload_rand(2) == 0) {
+        appSize[app][appCount[app]] = 16 + workload_rand(600);
+        appPtr[app][appCount[app]] =
+            tagged_alloc(a, appSize[app][appCount[app]], tag, result);
+        appCount[app]++;
+      } else if (appCount[app] > 1) {
+        uint8_t pick = (uint8_t)(1 + workload_rand(appCount[app] - 1));
+        appCount[app]--;
+        tagged_free(a, appPtr[app][pick], appSize[app][pick], tag, result);
+        appPtr[app][pick] = appPtr[app][appCount[app]];
+        appSize[app][pick] = appSize[app][appCount[app]];
+      }
+    } else {
+      /* System churn: caches, event buffers, strings */
+      uint8_t slot = (uint8_t)workload_rand(SYSTEM_BLOCKS);
+      if (sysPtr[slot]) {
+        tagged_free(a, sysPtr[slot], sysSize[slot], 0x7E, result);
+        sysPtr[slot] = (void *)0;
+      } else {
+        sysSize[slot] = 24 + workload_rand(1000);
+        sysPtr[slot] = tagged_alloc(a, sysSize[slot], 0x7E, result);
+      }
+    }
+
+    if (a->alloc == MEM_Alloc && (step & 63) == 0 && MEM_Validate() != 0)
+      result->invalid++;
+  }
+
+  if (!closeAll)
+    return;
+  for (app = 0; app < APP_SLOTS; app++) {
+    while (appCount[app]) {
+      appCount[app]--;
+      tagged_free(a, appPtr[app][appCount[app]], appSize[app][appCount[app]],
+                  (uint8_t)(0x10 + app), result);
+    }
+  }
+  for (i = 0; i < SYSTEM_BLOCKS; i++)
+    tagged_free(a, sysPtr[i], sysSize[i], 0x7E, result);
+}
+
+static const Allocator segregated = {MEM_Alloc, MEM_Free};
+static const Allocator firstFit = {ref_alloc, ref_free};
+
+static uint32_t fragmentation_pct(const MemStats *s) {
+  if (!s->freeBytes)
+    return 0;
+  return 100U - (uint32_t)((uint64_t)s->largestFree * 100U / s->freeBytes);
+}
+
+static void workload_against_first_fit(void) {
+  WorkloadResult newRun;
+  WorkloadResult refRun;
+  MemStats newStats;
+  MemStats refStats;
+
+  expect_u32((uint32_t)MEM_Init(heapStore, heapStore + HEAP_BYTES / 4), 0,
+             "heap init");
+  run_workload(&segregated, 6000, 0, &newRun);
+  MEM_GetStats(&newStats);
+
+  ref_init();
+  run_workload(&firstFit, 6000, 0, &refRun);
+  ref_stats(&refStats);
+
+  printf("mem workload: %lu ops; list steps first-fit %lu, segregated %lu; "
+         "largest free %lu vs %lu; fragmentation %lu%% vs %lu%%\n",
+         (unsigned long)newRun.ops, (unsigned long)refStats.searchSteps,
+         (unsigned long)newStats.searchSteps,
+         (unsigned long)refStats.largestFree,
+         (unsigned long)newStats.largestFree,
+         (unsigned long)fragmentation_pct(&refStats),
+         (unsigned long)fragmentation_pct(&newStats));
+
+  expect_u32(newRun.ops, refRun.ops, "same request stream");
+  expect_u32(newRun.corrupt, 0, "blocks intact and aligned");
+  expect_u32(newRun.invalid, 0, "heap valid throughout");
+  expect_true(newRun.failures <= refRun.failures, "no extra failures");
+  expect_true(newStats.searchSteps * 4 < refStats.searchSteps,
+              "far fewer list steps than first-fit");
+  expect_true(fragmentation_pct(&newStats) <= fragmentation_pct(&refStats) + 10,
+              "fragmentation close to first-fit");
+  expect_u32(MEM_GetFreeBytes(), newStats.freeBytes -
+                                     newStats.freeBlocks * sizeof(BlockHeader),
+             "free bytes tracked");
+}
+
+static void everything_freed_leaves_one_block(void) {
+  WorkloadResult run;
+  MemStats stats;
+  void *all;
+
+  MEM_Init(heapStore, heapStore + HEAP_BYTES / 4);
+  run_workload(&segregated, 3000, 1, &run);
+  expect_u32(run.corrupt, 0, "closed workload intact");
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after close");
+  MEM_GetStats(&stats);
+  expect_u32(stats.usedBlocks, 0, "nothing left allocated");
+  expect_u32(stats.freeBlocks, 1, "free() merged every neighbour");
+  expect_u32(stats.largestFree, HEAP_BYTES - sizeof(BlockHeader),
+             "free block spans the heap");
+
+  all = MEM_Alloc(HEAP_BYTES - sizeof(BlockHeader));
+  expect_true(all != (void *)0, "whole heap allocatable");
+  MEM_Free(all);
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after whole-heap use");
+}
+
+static void free_merges_both_neighbours_through_tags(void) {
+  uint8_t *a;
+  uint8_t *b;
+  uint8_t *c;
+  uint8_t *guard;
+  BlockHeader *blk;
+  MemStats before;
+  MemStats after;
+  uint32_t saved;
+
+  MEM_Init(heapStore, heapStore + HEAP_BYTES / 4);
+  a = (uint8_t *)MEM_Alloc(200);
+  b = (uint8_t *)MEM_Alloc(200);
+  c = (uint8_t *)MEM_Alloc(200);
+  guard = (uint8_t *)MEM_Alloc(200);
+  expect_true(a && b && c && guard, "neighbour allocations");
+
+  /* Free the outer two, then the middle: one block, no list walk */
+  MEM_Free(a);
+  MEM_Free(c);
+  blk = BLK_FROM_DATA(b);
+  expect_true(BLK_PREV_IS_FREE(blk) != 0, "prev-free bit set");
+  expect_u32(BLK_FOOTER(BLK_FROM_DATA(a)), BLK_SIZE(BLK_FROM_DATA(a)),
+             "footer repeats size");
+  MEM_GetStats(&before);
+  MEM_Free(b);
+  MEM_GetStats(&after);
+  expect_u32(after.searchSteps, before.searchSteps, "free walks no list");
+  expect_u32(after.freeBlocks, before.freeBlocks - 1, "three blocks merged");
+  expect_true(MEM_Alloc(600) == a, "merged block reused from the start");
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after merge");
+
+  /* Validate catches a footer or prev-free bit that disagrees */
+  MEM_Free(a);
+  blk = BLK_FROM_DATA(a);
+  saved = BLK_FOOTER(blk);
+  BLK_FOOTER(blk) = saved + MEM_ALIGN;
+  expect_true(MEM_Validate() != 0, "bad footer detected");
+  BLK_FOOTER(blk) = saved;
+  blk = BLK_FROM_DATA(guard);
+  blk->sizeAndFlags &= ~(uint32_t)MEM_FLAG_PREV_FREE;
+  expect_true(MEM_Validate() != 0, "missing prev-free bit detected");
+  blk->sizeAndFlags |= MEM_FLAG_PREV_FREE;
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid once repaired");
+}
+
+static void classes_serve_exact_sizes(void) {
+  uint8_t *a;
+  uint8_t *b;
+  uint8_t *c;
+  uint8_t *grown;
+  MemStats before;
+  MemStats after;
+
+  MEM_Init(heapStore, heapStore + HEAP_BYTES / 4);
+  a = (uint8_t *)MEM_Alloc(100);
+  b = (uint8_t *)MEM_Alloc(100);
+  c = (uint8_t *)MEM_Alloc(40);
+  expect_true(a && b && c, "small allocations");
+
+  /* A freed block is handed straight back to the same size */
+  MEM_Free(b);
+  MEM_GetStats(&before);
+  expect_true(MEM_Alloc(96) == b, "same class reused");
+  MEM_GetStats(&after);
+  expect_u32(after.searchSteps, before.searchSteps, "bitmap lookup walks none");
+
+  /* Growing into a free neighbour keeps the address */
+  MEM_Free(c);
+  grown = (uint8_t *)MEM_Realloc(b, 400);
+  expect_true(grown == b, "realloc grows in place");
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after realloc");
+
+  expect_true(MEM_Alloc(HEAP_BYTES) == (void *)0, "oversized request fails");
+  expect_true(MEM_Init(heapStore, (uint8_t *)heapStore + 8) != 0,
+              "tiny heap rejected");
+}
+
+static void telemetry_matches_heap_walk(void) {
+  WorkloadResult run;
+  MemTelemetry tm;
+  MemStats stats;
+  uint16_t words[MEM_TELEMETRY_WORDS];
+  uint32_t binned = 0;
+  void *peak;
+  uint8_t i;
+
+  MEM_Init(heapStore, heapStore + HEAP_BYTES / 4);
+  run_workload(&segregated, 4000, 0, &run);
+  MEM_GetTelemetry(&tm);
+  MEM_GetStats(&stats);
+  expect_u32(tm.heapSize, HEAP_BYTES, "telemetry heap size");
+  expect_u32(tm.usedBytes, stats.usedBytes, "used bytes kept up to date");
+  expect_u32(tm.largestFree, stats.largestFree, "largest free from classes");
+  expect_u32(tm.failedAllocs, run.failures, "failed allocations counted");
+  for (i = 0; i < MEM_HIST_BINS; i++)
+    binned += tm.sizeHistogram[i];
+  expect_u32(binned, stats.totalAllocs, "every allocation binned");
+  expect_u32(tm.sizeHistogram[0], 0, "no request under 16 bytes");
+  expect_true(tm.sizeHistogram[MEM_HIST_BINS - 1] > 0, "1 KB+ bin used");
+
+  /* High water stays after the peak is released */
+  peak = MEM_Alloc(tm.largestFree);
+  expect_true(peak != (void *)0, "largest free block allocatable");
+  MEM_Free(peak);
+  expect_true(MEM_Alloc(tm.largestFree + 1) == (void *)0,
+              "one byte more fails");
+  MEM_GetTelemetry(&tm);
+  expect_true(tm.highWater >= stats.usedBytes + stats.largestFree,
+              "high water kept");
+  expect_u32(tm.usedBytes, stats.usedBytes, "used bytes back");
+  expect_u32(tm.failedAllocs, run.failures + 1, "failure counted");
+  expect_u32((uint32_t)MEM_Validate(), 0, "validate checks used bytes");
+
+  MEM_PackTelemetry(&tm, words);
+  expect_u32(words[MEM_TM_VERSION], MEM_TELEMETRY_VERSION, "packed version");
+  expect_u32(((uint32_t)words[MEM_TM_USED] << 16) | words[MEM_TM_USED + 1],
+             tm.usedBytes, "packed used bytes");
+  expect_u32(((uint32_t)words[MEM_TM_HIGH_WATER] << 16) |
+                 words[MEM_TM_HIGH_WATER + 1],
+             tm.highWater, "packed high water");
+  expect_u32(words[MEM_TM_HISTOGRAM + 4], tm.sizeHistogram[4],
+             "packed histogram");
+}
+
+static void arena_bumps_and_releases_in_one_go(void) {
+  MemArena arena;
+  uint8_t *a;
+  uint8_t *b;
+  uint32_t freeBefore;
+  MemStats stats;
+
+  MEM_Init(heapStore, heapStore + HEAP_BYTES / 4);
+  freeBefore = MEM_GetFreeBytes();
+  expect_u32((uint32_t)MEM_ArenaCreate(&arena, 102), 0, "arena created");
+  expect_u32(arena.size, 104, "arena size aligned");
+
+  a = (uint8_t *)MEM_ArenaAlloc(&arena, 10);
+  b = (uint8_t *)MEM_ArenaAlloc(&arena, 6);
+  expect_true(a == arena.base, "first allocation at base");
+  expect_true(b == a + 12, "bump keeps alignment");
+  expect_true(MEM_ArenaAlloc(&arena, 85) == (void *)0, "overflow refused");
+  expect_true(MEM_ArenaAlloc(&arena, 84) != (void *)0, "exact fit served");
+  expect_u32(arena.used, arena.size, "arena full");
+
+  MEM_ArenaReset(&arena);
+  expect_true(MEM_ArenaAlloc(&arena, 4) == a, "reset reuses the block");
+  expect_u32(arena.highWater, arena.size, "high water kept over reset");
+
+  /* Many small allocations, one free */
+  MEM_ArenaDestroy(&arena);
+  expect_u32(MEM_GetFreeBytes(), freeBefore, "destroy returns every byte");
+  MEM_GetStats(&stats);
+  expect_u32(stats.freeBlocks, 1, "heap back to one block");
+  expect_true(MEM_ArenaAlloc(&arena, 4) == (void *)0, "destroyed arena empty");
+  expect_true(MEM_ArenaCreate(&arena, HEAP_BYTES) != 0,
+              "oversized arena refused");
+  MEM_ArenaDestroy(&arena);
+  expect_u32((uint32_t)MEM_Validate(), 0, "heap valid after arenas");
+}
+
+int main(void) {
+  classes_serve_exact_sizes();
+  workload_against_first_fit();
+  everything_freed_leaves_one_block();
+  free_merges_both_neighbours_through_tags();
+  arena_bumps_and_releases_in_one_go();
+  telemetry_matches_heap_walk();
+
+  if (failures) {
+    printf("%d mem test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("mem tests passed\n");
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include "menubar.h"
+#include "sysfont.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void expect_u16(uint16_t actual, uint16_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %u got %u\n", name, expected, actual);
+    failures++;
+  }
+}
+
+static void expect_i16(int16_t actual, int16_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %d got %d\n", name, expected, actual);
+    failures++;
+  }
+}
+
+/* The walk MenuBar_HandleMouseMove did before the row table existed */
+static int8_t reference_hit(const Menu *m, int16_t x, int16_t y) {
+  int16_t dropX = m->titleX - 4;
+  int16_t itemY = MENUBAR_HEIGHT + MENU_PADDING_Y;
+  uint8_t i;
+
+  if (x < dropX || x >= dropX + m->dropWidth)
+    return -1;
+  for (i = 0; i < m->itemCount; i++) {
+    const MenuItem *item = &m->items[i];
+    int16_t h =
+        (item->flags & MIF_SEPARATOR) ? MENU_SEPARATOR_H : MENU_ITEM_HEIGHT;
+    if (y >= itemY && y < itemY + h)
+      return (item->flags & (MIF_SEPARATOR | MIF_DISABLED)) ? -1 : (int8_t)i;
+    itemY += h;
+  }
+  return -1;
+}
+
+static int16_t item_width(const char *text) {
+  return (int16_t)(SysFont_StringWidth(text) + MENU_PADDING_X * 2);
+}
+
+static void layout_follows_item_changes(void) {
+  static const char *longItem = "Preferences and Settings";
+  MenuBar *bar;
+  const Menu *m;
+  int8_t file;
+
+  MenuBar_Init();
+  bar = MenuBar_Get();
+  MenuBar_AddMenu("Apple");
+  file = MenuBar_AddMenu("File");
+  m = &bar->menus[file];
+  expect_i16(m->dropWidth, MENU_MIN_WIDTH, "empty menu width");
+  expect_i16(m->dropHeight, MENU_PADDING_Y * 2, "empty menu height");
+
+  MenuBar_AddItem((uint8_t)file, "New", 1, MIF_NONE);
+  MenuBar_AddSeparator((uint8_t)file);
+  MenuBar_AddItem((uint8_t)file, longItem, 2, MIF_NONE);
+  MenuBar_AddItem((uint8_t)file, "Quit", 3, MIF_NONE);
+
+  expect_i16(m->itemTop[1], MENU_PADDING_Y + MENU_ITEM_HEIGHT, "item top");
+  expect_i16(m->itemTop[2],
+             MENU_PADDING_Y + MENU_ITEM_HEIGHT + MENU_SEPARATOR_H,
+             "item after separator");
+  expect_i16(m->dropHeight,
+             MENU_PADDING_Y * 2 + MENU_ITEM_HEIGHT * 3 + MENU_SEPARATOR_H,
+             "dropdown height");
+  expect_i16(m->dropWidth, item_width(longItem), "widest item sets width");
+
+  MenuBar_SetItemChecked((uint8_t)file, 2, 1);
+  expect_i16(m->dropWidth, item_width(longItem) + MENU_CHECK_W,
+             "checkmark widens dropdown");
+  MenuBar_SetItemChecked((uint8_t)file, 2, 0);
+  expect_i16(m->dropWidth, item_width(longItem), "unchecked width");
+}
+
+static void row_table_matches_item_walk(void) {
+  MenuBar *bar;
+  const Menu *m;
+  int8_t edit;
+  uint16_t mismatches = 0;
+  uint8_t pass;
+  int16_t x;
+  int16_t y;
+
+  MenuBar_Init();
+  bar = MenuBar_Get();
+  MenuBar_AddMenu("File");
+  edit = MenuBar_AddMenu("Edit");
+  MenuBar_AddItem((uint8_t)edit, "Undo", 1, MIF_DISABLED);
+  MenuBar_AddSeparator((uint8_t)edit);
+  MenuBar_AddItem((uint8_t)edit, "Cut", 2, MIF_NONE);
+  MenuBar_AddItem((uint8_t)edit, "Copy", 3, MIF_NONE);
+  MenuBar_AddSeparator((uint8_t)edit);
+  MenuBar_AddItem((uint8_t)edit, "Paste", 4, MIF_NONE);
+  m = &bar->menus[edit];
+
+  expect_u16(MenuBar_HandleMouseDown(m->titleX, 5), 1, "title opens menu");
+  expect_i16(bar->activeMenu, edit, "edit menu open");
+
+  /* Every pixel row, before and after enabling an item */
+  for (pass = 0; pass < 2; pass++) {
+    for (y = MENUBAR_HEIGHT; y < MENUBAR_HEIGHT + m->dropHeight + 6; y++) {
+      for (x = m->titleX - 6; x < m->titleX - 4 + m->dropWidth + 2; x += 3) {
+        MenuBar_HandleMouseMove(x, y);
+        if (bar->activeItem != reference_hit(m, x, y))
+          mismatches++;
+      }
+    }
+    MenuBar_SetItemEnabled((uint8_t)edit, 0, 1);
+  }
+  expect_u16(mismatches, 0, "row table hit-test");
+
+  MenuBar_HandleMouseMove(m->titleX, MENUBAR_HEIGHT + m->itemTop[0] + 1);
+  expect_i16(bar->activeItem, 0, "enabled item hoverable");
+  MenuBar_Close();
+}
+
+int main(void) {
+  layout_follows_item_changes();
+  row_table_matches_item_walk();
+
+  if (failures) {
+    printf("%d menubar test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("menubar tests passed\n");
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "pool.h"
+#include <stdio.h>
+
+static int failures;
+
+static void expect_true(int value, const char *name) {
+  if (!value) {
+    printf("FAIL: %s expected true\n", name);
+    failures++;
+  }
+}
+
+static void expect_u16(uint16_t actual, uint16_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %u got %u\n", name, expected, actual);
+    failures++;
+  }
+}
+
+typedef struct {
+  uint32_t id;
+  uint16_t payload[3];
+} Record;
+
+static void hands_out_slots_in_order_then_reuses(void) {
+  static Record records[5];
+  Pool pool;
+  Record *got[5];
+  PoolStats stats;
+  uint8_t i;
+
+  POOL_INIT(&pool, records);
+  for (i = 0; i < 5; i++) {
+    got[i] = POOL_ALLOC(&pool, Record);
+    expect_true(got[i] == &records[i], "fresh pool in index order");
+  }
+  expect_true(POOL_Alloc(&pool) == (void *)0, "full pool refuses");
+
+  POOL_Free(&pool, got[1]);
+  POOL_Free(&pool, got[3]);
+  expect_true(POOL_AT(&pool, Record, 1) == (Record *)0, "freed slot not live");
+  expect_true(POOL_AT(&pool, Record, 2) == got[2], "live slot found");
+  expect_true(POOL_Alloc(&pool) == got[3], "last freed reused first");
+  expect_true(POOL_Alloc(&pool) == got[1], "then the one before");
+
+  POOL_GetStats(&pool, &stats);
+  expect_u16(stats.count, 5, "slot count");
+  expect_u16(stats.used, 5, "slots used");
+  expect_u16(stats.highWater, 5, "high water");
+  expect_u16(stats.failures, 1, "refusals counted");
+  expect_u16((uint16_t)stats.bytes, sizeof(records), "pool bytes");
+}
+
+static void ignores_foreign_and_double_frees(void) {
+  static Record records[4];
+  Record outside;
+  Pool pool;
+  Record *a;
+  Record *b;
+
+  POOL_INIT(&pool, records);
+  a = POOL_ALLOC(&pool, Record);
+  b = POOL_ALLOC(&pool, Record);
+  POOL_Free(&pool, b);
+  POOL_Free(&pool, b);
+  POOL_Free(&pool, &outside);
+  POOL_Free(&pool, (uint8_t *)a + 1);
+  expect_u16(pool.used, 1, "only the real free counted");
+  expect_u16((uint16_t)POOL_Index(&pool, a), 0, "index of slot");
+  expect_true(POOL_Index(&pool, &outside) < 0, "foreign pointer");
+
+  /* The free list still holds each slot once */
+  expect_true(POOL_Alloc(&pool) == b, "freed slot back");
+  expect_true(POOL_Alloc(&pool) != (void *)0, "third slot");
+  expect_true(POOL_Alloc(&pool) != (void *)0, "fourth slot");
+  expect_true(POOL_Alloc(&pool) == (void *)0, "no duplicate slots");
+  expect_u16(pool.highWater, 4, "high water after refill");
+}
+
+int main(void) {
+  hands_out_slots_in_order_then_reuses();
+  ignores_foreign_and_double_frees();
+
+  if (failures) {
+    printf("%d pool test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("pool tests passed\n");
+  return 0;
+}
@@ -0,0 +1,186 @@
+#include "basic.h"
+#include "sysfont.h"
+#include "text_plane.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void expect_true(uint8_t value, const char *name) {
+  if (!value) {
+    printf("FAIL: %s expected true\n", name);
+    failures++;
+  }
+}
+
+static void expect_u16(uint16_t actual, uint16_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %u got %u\n", name, expected, actual);
+    failures++;
+  }
+}
+
+/* Shadow of Plane B as written through the cell sink. */
+typedef struct {
+  uint16_t cells[TP_MAX_ROWS][TP_PLANE_CELLS_X];
+  uint16_t writes;
+} PlaneLog;
+
+static uint8_t record_cell(uint16_t vramAddr, uint16_t entry, void *user) {
+  PlaneLog *log = (PlaneLog *)user;
+  uint16_t cell = (uint16_t)((vramAddr - TP_PLANE_ADDR) / 2U);
+
+  log->cells[cell / TP_PLANE_CELLS_X][cell % TP_PLANE_CELLS_X] = entry;
+  log->writes++;
+  return 1;
+}
+
+static uint16_t glyph_entry(char ch) {
+  return (uint16_t)(TP_ATTR_PRIORITY |
+                    (TP_GLYPH_TILE + ((uint8_t)ch - TP_GLYPH_FIRST)));
+}
+
+static TextPlane plane;
+static TextPlanePage page;
+
+static void printing_a_character_publishes_one_cell(void) {
+  PlaneLog log;
+
+  memset(&log, 0, sizeof(log));
+  memset(&page, 0, sizeof(page));
+  expect_true(TP_Init(&plane, 2, 3, 20, 5), "plane init");
+
+  /* The first publish paints the whole blank console. */
+  expect_u16(TP_Publish(&plane, &page, SysFont_Get()), 100, "initial cells");
+  expect_u16(TPV_ApplyPage(&page, record_cell, &log), 100, "initial apply");
+  expect_u16(log.cells[3][2], glyph_entry(' '), "blank console cell");
+  expect_u16(log.cells[2][2], 0, "cell above console untouched");
+
+  log.writes = 0;
+  TP_Write(&plane, "Hi");
+  expect_u16(TP_Publish(&plane, &page, SysFont_Get()), 2, "two cells logged");
+  expect_u16(TPV_ApplyPage(&page, record_cell, &log), 2, "two cells applied");
+  expect_u16(log.writes, 2, "one write per character");
+  expect_u16(log.cells[3][2], glyph_entry('H'), "H at console origin");
+  expect_u16(log.cells[3][3], glyph_entry('i'), "i follows H");
+
+  /* Rewriting the same character changes nothing. */
+  plane.curX = 0;
+  TP_PutChar(&plane, 'H');
+  expect_u16(TP_Publish(&plane, &page, SysFont_Get()), 0, "unchanged cell");
+}
+
+static void wrap_and_scroll_fall_back_to_full_republish(void) {
+  PlaneLog log;
+  uint8_t i;
+
+  memset(&log, 0, sizeof(log));
+  expect_true(TP_Init(&plane, 0, 0, 4, 2), "small plane init");
+  TP_Publish(&plane, &page, 0);
+
+  TP_Write(&plane, "abcde");
+  expect_u16(plane.curY, 1, "wrap moves to next row");
+  expect_u16(TP_Publish(&plane, &page, 0), 5, "wrap logs cells");
+
+  TP_Write(&plane, "fgh\nxy");
+  expect_u16(TP_Publish(&plane, &page, 0), 8, "scroll republishes all");
+  TPV_ApplyPage(&page, record_cell, &log);
+  expect_u16(log.cells[0][0], glyph_entry('e'), "row scrolled up");
+  expect_u16(log.cells[1][0], glyph_entry('x'), "new bottom row");
+  expect_u16(log.cells[1][2], glyph_entry(' '), "bottom row blanked");
+
+  expect_true(TP_Init(&plane, 0, 0, 40, 2), "wide plane init");
+  TP_Publish(&plane, &page, 0);
+  for (i = 0; i < TP_LOG_MAX + 1U; i++)
+    TP_PutChar(&plane, (char)('A' + (i % 26)));
+  expect_u16(TP_Publish(&plane, &page, 0), 80, "log overflow republishes all");
+}
+
+static void glyph_tiles_expand_sysfont_rows(void) {
+  static const uint8_t rows[8] = {0x81, 0x40, 0, 0, 0, 0, 0, 0xFF};
+  const Font *font = SysFont_Get();
+  const Glyph *a = &font->glyphs['A' - font->firstChar];
+  uint8_t tile[TP_GLYPH_BYTES];
+  uint8_t expect[TP_GLYPH_BYTES];
+
+  TP_BuildGlyphTile(rows, TP_INK, TP_PAPER, tile);
+  expect_u16(tile[0], 0x1F, "left ink pixel");
+  expect_u16(tile[3], 0xF1, "right ink pixel");
+  expect_u16(tile[4], 0xF1, "second pixel of row 1");
+  expect_u16(tile[8], 0xFF, "blank row is paper");
+  expect_u16(tile[31], 0x11, "solid row is ink");
+
+  memset(&page, 0, sizeof(page));
+  TP_Init(&plane, 0, 0, 1, 1);
+  TP_Publish(&plane, &page, font);
+  expect_u16(page.glyphMagic, TP_GLYPH_MAGIC, "glyph tiles published");
+  TP_BuildGlyphTile(a->data, TP_INK, TP_PAPER, expect);
+  expect_true(memcmp(page.glyphTiles + ('A' - TP_GLYPH_FIRST) * TP_GLYPH_BYTES,
+                     expect, sizeof(expect)) == 0,
+              "A tile in page");
+}
+
+static void apply_rejects_foreign_addresses(void) {
+  PlaneLog log;
+
+  memset(&log, 0, sizeof(log));
+  memset(&page, 0, sizeof(page));
+  page.count = 1;
+  page.cells[0].vramAddr = TP_PLANE_ADDR;
+  page.cells[0].entry = 1;
+  expect_u16(TPV_ApplyPage(&page, record_cell, &log), 0, "no magic no apply");
+
+  page.magic = TP_PAGE_MAGIC;
+  page.count = 2;
+  page.cells[1].vramAddr = 0xF800; /* sprite table */
+  expect_u16(TPV_ApplyPage(&page, record_cell, &log), 2, "page applied");
+  expect_u16(log.writes, 1, "foreign address skipped");
+}
+
+static void basic_output_lands_on_console_cells(void) {
+  BasicLine lines[3];
+  uint8_t storage[96];
+  uint8_t code[BAS_CODE_CAPACITY(96, 3)];
+  BasicProgram program;
+  BasicRuntime runtime;
+  BasicRunResult result;
+  char lineBuffer[32];
+  PlaneLog log;
+
+  memset(&log, 0, sizeof(log));
+  expect_true(TP_Init(&plane, 1, 1, 20, 4), "console init");
+  BAS_InitProgram(&program, lines, 3, storage, sizeof(storage), code,
+                  sizeof(code));
+  BAS_InitRuntime(&runtime);
+  expect_true(BAS_StoreSourceLine(&program, "10 PRINT \"HELLO\""),
+              "store hello");
+  expect_true(BAS_StoreSourceLine(&program, "20 PRINT 12 + 30"), "store math");
+
+  expect_true(BAS_RunProgramWithIO(&program, &runtime, TP_BasicLineSink, 0,
+                                   &plane, lineBuffer, sizeof(lineBuffer),
+                                   &result),
+              "BASIC runs into console");
+  TP_Publish(&plane, &page, 0);
+  TPV_ApplyPage(&page, record_cell, &log);
+  expect_u16(log.cells[1][1], glyph_entry('H'), "first line on row 0");
+  expect_u16(log.cells[1][5], glyph_entry('O'), "first line ends");
+  expect_u16(log.cells[2][1], glyph_entry('4'), "second line on row 1");
+  expect_u16(log.cells[2][2], glyph_entry('2'), "second line value");
+  expect_u16(plane.curY, 2, "cursor after two lines");
+}
+
+int main(void) {
+  printing_a_character_publishes_one_cell();
+  wrap_and_scroll_fall_back_to_full_republish();
+  glyph_tiles_expand_sysfont_rows();
+  apply_rejects_foreign_addresses();
+  basic_output_lands_on_console_cells();
+
+  if (failures) {
+    printf("%d text plane test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("text plane tests passed\n");
+  return 0;
+}
@@ -0,0 +1,1070 @@
+#include "blitter.h"
+#include "sysfont.h"
+#include "wm.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static Rect rect_make(int16_t top, int16_t left, int16_t bottom,
+                      int16_t right) {
+  Rect r;
+  r.top = top;
+  r.left = left;
+  r.bottom = bottom;
+  r.right = right;
+  return r;
+}
+
+static void expect_true(Boolean value, const char *name) {
+  if (!value) {
+    printf("FAIL: %s expected true\n", name);
+    failures++;
+  }
+}
+
+static void expect_false(Boolean value, const char *name) {
+  if (value) {
+    printf("FAIL: %s expected false\n", name);
+    failures++;
+  }
+}
+
+static void expect_u16(uint16_t actual, uint16_t expected, const char *name) {
+  if (actual != expected) {
+    printf("FAIL: %s expected %u got %u\n", name, expected, actual);
+    failures++;
+  }
+}
+
+static void expect_rect(Rect actual, Rect expected, const char *name) {
+  if (actual.top != expected.top || actual.left != expected.left ||
+      actual.bottom != expected.bottom || actual.right != expected.right) {
+    printf("FAIL: %s expected {%d,%d,%d,%d} got {%d,%d,%d,%d}\n", name,
+           expected.top, expected.left, expected.bottom, expected.right,
+           actual.top, actual.left, actual.bottom, actual.right);
+    failures++;
+  }
+}
+
+/* Total dirty pixel area; the list keeps its rects disjoint or merged. */
+static uint32_t dirty_area(void) {
+  uint8_t count = WM_BeginUpdate();
+  uint32_t area = 0;
+  uint8_t i;
+
+  for (i = 0; i < count; i++) {
+    DirtyRect *dr = WM_GetDirtyRect(i);
+    if (dr && dr->valid)
+      area += (uint32_t)(dr->rect.right - dr->rect.left) *
+              (uint32_t)(dr->rect.bottom - dr->rect.top);
+  }
+  return area;
+}
+
+static Boolean dirty_covers_point(int16_t x, int16_t y) {
+  uint8_t count = WM_BeginUpdate();
+  uint8_t i;
+
+  for (i = 0; i < count; i++) {
+    DirtyRect *dr = WM_GetDirtyRect(i);
+    if (dr && dr->valid && x >= dr->rect.left && x < dr->rect.right &&
+        y >= dr->rect.top && y < dr->rect.bottom)
+      return 1;
+  }
+  return 0;
+}
+
+static Window *open_test_window(int16_t top, int16_t left, int16_t bottom,
+                                int16_t right) {
+  Rect bounds = rect_make(top, left, bottom, right);
+  Window *win = WM_NewWindow(&bounds, "Test", WM_STYLE_DOCUMENT, WF_VISIBLE);
+
+  WM_EndUpdate();
+  return win;
+}
+
+/* Without a framebuffer there are no pixels to blit, so both frames redraw */
+static void plain_move_invalidates_both_frames_and_records_event(void) {
+  Window *win;
+  const WindowMoveEvent *evt;
+
+  WM_Init();
+  win = open_test_window(40, 40, 120, 160);
+
+  WM_MoveWindow(win, 50, 44);
+  WM_MoveWindow(win, 60, 48);
+
+  expect_true(dirty_covers_point(40, 40), "plain move dirties old frame");
+  expect_true(dirty_covers_point(179, 127), "plain move dirties new frame");
+  expect_u16(WM_GetMoveEventCount(), 1, "plain moves coalesce");
+  evt = WM_GetPublishedMoveEvent();
+  expect_true(evt != (const WindowMoveEvent *)0, "plain event published");
+  if (evt) {
+    expect_u16(evt->kind, WM_MOVE_PLAIN, "plain event kind");
+    expect_rect(evt->from, rect_make(40, 40, 120, 160), "plain event from");
+    expect_rect(evt->to, rect_make(48, 60, 128, 180), "plain event to");
+  }
+
+  WM_EndUpdate();
+  expect_u16(WM_GetMoveEventCount(), 0, "end update clears move events");
+  expect_true(WM_GetPublishedMoveEvent() == (const WindowMoveEvent *)0,
+              "no event after end update");
+}
+
+static void fast_drag_is_opt_in(void) {
+  Window *win;
+
+  WM_Init();
+  win = open_test_window(40, 40, 120, 160);
+
+  expect_false(WM_BeginFastDrag(win), "fast drag off by default");
+  WM_SetFastDrag(1);
+  expect_true(WM_BeginFastDrag(win), "fast drag begins when enabled");
+  expect_true(WM_IsFastDragging(), "fast drag active");
+  expect_false(WM_BeginFastDrag(win), "second fast drag rejected");
+}
+
+static void fast_drag_snaps_and_dirties_only_uncovered_origin(void) {
+  Window *win;
+  const WindowMoveEvent *evt;
+
+  WM_Init();
+  WM_SetFastDrag(1);
+  win = open_test_window(40, 40, 120, 160);
+  expect_true(WM_BeginFastDrag(win), "drag begins");
+
+  /* 19px right, 3px down snaps to 16px right, 0 down. */
+  WM_MoveWindow(win, 59, 43);
+  expect_rect(win->frame, rect_make(40, 56, 120, 176), "drag frame snapped");
+
+  /* Only the 16px origin strip the window left behind needs pixels. */
+  expect_u16((uint16_t)dirty_area(), 16 * 80, "drag dirties exposed strip");
+  expect_true(dirty_covers_point(40, 40), "exposed strip left edge");
+  expect_false(dirty_covers_point(56, 40), "window cells are not redrawn");
+  expect_false(dirty_covers_point(170, 100), "new area outside origin clean");
+
+  evt = WM_GetPublishedMoveEvent();
+  expect_true(evt != (const WindowMoveEvent *)0, "drag event published");
+  if (evt) {
+    expect_u16(evt->kind, WM_MOVE_DRAG, "drag event kind");
+    expect_rect(evt->from, rect_make(40, 40, 120, 160), "drag event origin");
+    expect_rect(evt->to, rect_make(40, 56, 120, 176), "drag event to");
+  }
+  WM_EndUpdate();
+
+  /* Moving back over the strip exposes nothing new inside the origin. */
+  WM_MoveWindow(win, 48, 40);
+  expect_u16((uint16_t)dirty_area(), 0, "moving back exposes nothing");
+  WM_EndUpdate();
+}
+
+static void fast_drag_drop_rerenders_at_full_precision(void) {
+  Window *win;
+  const WindowMoveEvent *evt;
+
+  WM_Init();
+  WM_SetFastDrag(1);
+  win = open_test_window(40, 40, 120, 160);
+  expect_true(WM_BeginFastDrag(win), "drop drag begins");
+  WM_MoveWindow(win, 83, 61);
+  WM_EndUpdate();
+
+  WM_MoveWindow(win, 85, 62);
+  WM_EndFastDrag(85, 62);
+
+  expect_false(WM_IsFastDragging(), "drop ends fast drag");
+  expect_rect(win->frame, rect_make(62, 85, 142, 205), "drop frame exact");
+  expect_true(dirty_covers_point(40, 40), "drop dirties origin");
+  expect_true(dirty_covers_point(204, 141), "drop dirties final frame");
+
+  evt = WM_GetPublishedMoveEvent();
+  expect_true(evt != (const WindowMoveEvent *)0, "drop event published");
+  if (evt) {
+    expect_u16(evt->kind, WM_MOVE_DROP, "drop outranks drag in frame");
+    expect_rect(evt->to, rect_make(62, 85, 142, 205), "drop event to");
+  }
+  WM_EndUpdate();
+}
+
+static void fast_drag_rejects_windows_larger_than_spare_tiles(void) {
+  Window *big;
+  Window *front;
+
+  WM_Init();
+  WM_SetFastDrag(1);
+  big = open_test_window(20, 0, 224, 320);
+  expect_false(WM_BeginFastDrag(big), "full-screen window too large");
+
+  front = open_test_window(40, 40, 120, 160);
+  (void)front;
+  big = WM_GetBottomWindow();
+  expect_false(WM_BeginFastDrag(big), "back window not fast dragged");
+}
+
+static uint32_t layout_seed = 12345;
+
+static int16_t layout_rand(int16_t limit) {
+  layout_seed = layout_seed * 1103515245UL + 12345UL;
+  return (int16_t)((layout_seed >> 16) % (uint32_t)limit);
+}
+
+static Boolean rect_has(const Rect *r, int16_t x, int16_t y) {
+  return (x >= r->left && x < r->right && y >= r->top && y < r->bottom) ? 1
+                                                                         : 0;
+}
+
+/* Frame plus the drop shadow's right and bottom strips, minus their outer
+ * corners, which BLT_DrawShadow leaves alone. */
+static Boolean window_paints(const Window *win, int16_t x, int16_t y) {
+  if (rect_has(&win->frame, x, y))
+    return 1;
+  if (win->style != WM_STYLE_SHADOW && win->style != WM_STYLE_DIALOG)
+    return 0;
+  if (x == win->frame.right && y > win->frame.top && y <= win->frame.bottom)
+    return 1;
+  if (y == win->frame.bottom && x > win->frame.left && x < win->frame.right)
+    return 1;
+  return 0;
+}
+
+/* Every pixel must belong to exactly one visible piece of the frontmost
+ * window painted there, or to none if only the desktop shows. */
+static void expect_regions_tile_screen(const char *name) {
+  int16_t x;
+  int16_t y;
+  int before = failures;
+
+  for (y = 0; y < WM_SCREEN_H && failures == before; y++) {
+    for (x = 0; x < WM_SCREEN_W && failures == before; x++) {
+      Window *owner = (Window *)0;
+      Window *win;
+      uint8_t hits = 0;
+
+      for (win = WM_GetTopWindow(); win && !owner; win = win->below) {
+        if ((win->flags & WF_VISIBLE) && window_paints(win, x, y))
+          owner = win;
+      }
+
+      for (win = WM_GetTopWindow(); win; win = win->below) {
+        uint8_t n = WM_GetVisibleRectCount(win);
+        uint8_t i;
+
+        for (i = 0; i < n; i++) {
+          if (!rect_has(WM_GetVisibleRect(win, i), x, y))
+            continue;
+          hits++;
+          if (win != owner) {
+            printf("FAIL: %s pixel %d,%d in window %u piece, owner %d\n",
+                   name, x, y, win->id, owner ? owner->id : -1);
+            failures++;
+          }
+        }
+      }
+      if (hits != (owner ? 1 : 0)) {
+        printf("FAIL: %s pixel %d,%d covered %u times\n", name, x, y, hits);
+        failures++;
+      }
+
+      if (y >= WM_MENUBAR_H && (x % 7) == 0 && (y % 5) == 0) {
+        Point pt;
+        Window *found;
+
+        pt.x = x;
+        pt.y = y;
+        WM_FindWindow(pt, &found);
+        if (owner && !rect_has(&owner->frame, x, y))
+          owner = (Window *)0; /* Shadows are not hit targets */
+        if (found != owner && !(found && owner == (Window *)0 &&
+                                rect_has(&found->frame, x, y))) {
+          printf("FAIL: %s hit at %d,%d\n", name, x, y);
+          failures++;
+        }
+      }
+    }
+  }
+}
+
+/* The plan must paint every damaged pixel exactly once, by its owner, and
+ * list lower layers before the windows stacked over them. An overflowed
+ * plan may overdraw, but the owner must still paint each pixel last. */
+static void expect_plan_paints_once(const Rect *dirty, const char *name) {
+  static WMRedrawPlan plan;
+  int16_t x;
+  int16_t y;
+  uint8_t i;
+  int before = failures;
+
+  expect_true(WM_PlanRedraw(dirty, &plan), name);
+
+  for (i = 1; i < plan.count; i++) {
+    Window *lower = plan.pieces[i - 1].win;
+    Window *upper = plan.pieces[i].win;
+    Window *w;
+
+    if (!upper)
+      continue;
+    for (w = upper->above; w && lower; w = w->above) {
+      if (w == lower) {
+        printf("FAIL: %s window %u listed after window %u above it\n", name,
+               upper->id, lower->id);
+        failures++;
+        break;
+      }
+    }
+  }
+  for (i = 1; i < plan.count; i++) {
+    if (!plan.pieces[i].win && plan.pieces[i - 1].win) {
+      printf("FAIL: %s desktop piece after a window piece\n", name);
+      failures++;
+      break;
+    }
+  }
+
+  for (y = 0; y < WM_SCREEN_H && failures == before; y++) {
+    for (x = 0; x < WM_SCREEN_W && failures == before; x++) {
+      Window *owner = (Window *)0;
+      Window *win;
+      Window *last = (Window *)0;
+      uint8_t hits = 0;
+      Boolean damaged = rect_has(dirty, x, y);
+
+      for (win = WM_GetTopWindow(); win && !owner; win = win->below) {
+        if ((win->flags & WF_VISIBLE) && window_paints(win, x, y))
+          owner = win;
+      }
+      for (i = 0; i < plan.count; i++) {
+        if (!rect_has(&plan.pieces[i].clip, x, y))
+          continue;
+        hits++;
+        /* Bounds pieces cover the shadow corners the frame never writes */
+        if (!plan.pieces[i].win || window_paints(plan.pieces[i].win, x, y))
+          last = plan.pieces[i].win;
+        if (!plan.overflow && plan.pieces[i].win != owner) {
+          printf("FAIL: %s pixel %d,%d planned for wrong layer\n", name, x,
+                 y);
+          failures++;
+        }
+      }
+      if (plan.overflow) {
+        if (damaged && (!hits || last != owner)) {
+          printf("FAIL: %s pixel %d,%d not finished by its owner\n", name, x,
+                 y);
+          failures++;
+        }
+      } else if (hits != (damaged ? 1 : 0)) {
+        printf("FAIL: %s pixel %d,%d painted %u times\n", name, x, y, hits);
+        failures++;
+      }
+    }
+  }
+}
+
+static void visible_regions_tile_random_layouts(void) {
+  static const WindowStyle styles[] = {WM_STYLE_DOCUMENT, WM_STYLE_SHADOW,
+                                       WM_STYLE_DIALOG, WM_STYLE_PLAIN};
+  Window *wins[6];
+  uint8_t layout;
+  uint8_t overflowed = 0;
+  uint8_t planOverflows = 0;
+
+  for (layout = 0; layout < 40; layout++) {
+    uint8_t count = (uint8_t)(1 + layout_rand(6));
+    uint8_t i;
+
+    WM_Init();
+    for (i = 0; i < count; i++) {
+      int16_t left = layout_rand(280);
+      int16_t top = layout_rand(200);
+      Rect bounds = rect_make(top, left, (int16_t)(top + 16 + layout_rand(120)),
+                              (int16_t)(left + 16 + layout_rand(160)));
+
+      wins[i] = WM_NewWindow(&bounds, "R", styles[layout_rand(4)],
+                             layout_rand(5) ? WF_VISIBLE : 0);
+    }
+    expect_regions_tile_screen("fresh layout");
+
+    /* Restack, hide, show and move, then check the cache kept up */
+    WM_SelectWindow(wins[layout_rand(count)]);
+    WM_SendToBack(wins[layout_rand(count)]);
+    WM_HideWindow(wins[layout_rand(count)]);
+    WM_ShowWindow(wins[layout_rand(count)]);
+    WM_MoveWindow(wins[layout_rand(count)], layout_rand(280),
+                  layout_rand(200));
+    WM_SizeWindow(wins[layout_rand(count)], (int16_t)(20 + layout_rand(100)),
+                  (int16_t)(20 + layout_rand(80)));
+    expect_regions_tile_screen("edited layout");
+    {
+      Rect full = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+      int16_t left = layout_rand(300);
+      int16_t top = layout_rand(200);
+      Rect part = rect_make(top, left, (int16_t)(top + 1 + layout_rand(100)),
+                            (int16_t)(left + 1 + layout_rand(150)));
+
+      WMStats stats;
+
+      expect_plan_paints_once(&full, "full-screen plan");
+      expect_plan_paints_once(&part, "partial plan");
+      WM_GetStats(&stats);
+      planOverflows = (uint8_t)(planOverflows + stats.planOverflows);
+    }
+
+    for (i = 0; i < count; i++)
+      overflowed = (uint8_t)(overflowed + wins[i]->visOverflow);
+    WM_EndUpdate();
+  }
+
+  expect_u16(overflowed, 0, "random layouts fit the piece cache");
+  expect_u16(planOverflows, 0, "random plans fit");
+}
+
+static void fully_covered_window_has_no_pieces(void) {
+  Window *back;
+  Window *front;
+  Rect dirty = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+  Rect pieces[WM_VIS_MAX_RECTS];
+
+  WM_Init();
+  back = open_test_window(50, 50, 100, 100);
+  front = open_test_window(40, 40, 120, 160);
+  expect_u16(WM_GetVisibleRectCount(back), 0, "covered window skipped");
+  expect_u16(WM_GetVisiblePieces(front, &dirty, pieces, WM_VIS_MAX_RECTS), 1,
+             "front window one piece");
+  expect_rect(pieces[0], front->frame, "front piece is its frame");
+
+  WM_SelectWindow(back);
+  expect_u16(WM_GetVisibleRectCount(back), 1, "raised window visible");
+  expect_u16(WM_GetVisibleRectCount(front), 4, "ring around raised window");
+}
+
+static void sixteen_window_cascade_plans_exactly(void) {
+  Rect full = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+  WMStats stats;
+  uint8_t i;
+
+  WM_Init();
+  for (i = 0; i < WM_MAX_WINDOWS; i++)
+    open_test_window((int16_t)(20 + i * 8), (int16_t)(8 + i * 12),
+                     (int16_t)(100 + i * 8), (int16_t)(120 + i * 12));
+
+  expect_plan_paints_once(&full, "cascade plan");
+  WM_GetStats(&stats);
+  expect_u16(stats.planOverflows, 0, "cascade plan fits");
+  expect_u16(WM_GetVisibleRectCount(WM_GetTopWindow()->below), 2,
+             "second window shows an L");
+}
+
+static void window_pool_reuses_ids_and_tracks_high_water(void) {
+  Rect bounds = rect_make(20, 20, 80, 120);
+  Window *wins[WM_MAX_WINDOWS];
+  PoolStats stats;
+  uint8_t i;
+
+  WM_Init();
+  for (i = 0; i < WM_MAX_WINDOWS; i++) {
+    wins[i] = WM_NewWindow(&bounds, "P", WM_STYLE_DOCUMENT, WF_VISIBLE);
+    expect_u16(wins[i] ? wins[i]->id : 0xFF, i, "ids in slot order");
+  }
+  expect_true(WM_NewWindow(&bounds, "P", WM_STYLE_DOCUMENT, WF_VISIBLE) ==
+                  (Window *)0,
+              "seventeenth window refused");
+
+  WM_DisposeWindow(wins[3]);
+  WM_DisposeWindow(wins[9]);
+  expect_true(WM_GetWindowById(3) == (Window *)0, "disposed id not found");
+  expect_true(WM_GetWindowById(4) == wins[4], "live id found");
+  expect_u16(WM_GetWindowCount(), WM_MAX_WINDOWS - 2, "count after dispose");
+  wins[9] = WM_NewWindow(&bounds, "P", WM_STYLE_DOCUMENT, WF_VISIBLE);
+  expect_u16(wins[9] ? wins[9]->id : 0xFF, 9, "freed slot reused");
+
+  WM_GetWindowPoolStats(&stats);
+  expect_u16(stats.used, WM_MAX_WINDOWS - 1, "pool slots used");
+  expect_u16(stats.highWater, WM_MAX_WINDOWS, "pool high water");
+  expect_u16(stats.failures, 1, "pool refusal counted");
+}
+
+static void invalidation_marks_dirty_tiles_until_end_update(void) {
+  Rect a = rect_make(0, 0, 8, 8);
+  Rect b = rect_make(216, 312, 224, 320);
+
+  WM_Init();
+  WM_InvalidateRect(&a);
+  WM_InvalidateRect(&b);
+  expect_u16(WM_BeginUpdate(), 2, "distant rects stay separate");
+  expect_u16(DR_TileBitmapCount(WM_GetDirtyTiles()), 2, "two dirty tiles");
+  expect_true(DR_TileBitmapTest(WM_GetDirtyTiles(), 1119), "last tile dirty");
+  WM_EndUpdate();
+  expect_u16(DR_TileBitmapCount(WM_GetDirtyTiles()), 0, "tiles cleared");
+}
+
+static uint8_t framebuffer[BLT_FRAMEBUF_SIZE_4];
+
+static void framebuffer_reset(void) {
+  Rect screen = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+
+  memset(framebuffer, 0, sizeof(framebuffer));
+  BLT_Init(framebuffer);
+  BLT_SetMode(BLT_MODE_4BIT);
+  BLT_FillRect(&screen, BLT_4_WHITE);
+}
+
+/* Distinct colours per pixel so a misaligned or reversed copy shows up */
+static uint8_t window_pixel(int16_t x, int16_t y) {
+  return (uint8_t)(1 + ((x * 3 + y * 5) % 14));
+}
+
+static void paint_window_pixels(const Rect *r) {
+  int16_t x;
+  int16_t y;
+
+  for (y = r->top; y < r->bottom; y++)
+    for (x = r->left; x < r->right; x++)
+      BLT_SetPixel(x, y, window_pixel((int16_t)(x - r->left),
+                                      (int16_t)(y - r->top)));
+}
+
+static Boolean pixels_moved(const Rect *to) {
+  int16_t x;
+  int16_t y;
+
+  for (y = to->top; y < to->bottom; y++)
+    for (x = to->left; x < to->right; x++)
+      if (BLT_GetPixel(x, y) !=
+          window_pixel((int16_t)(x - to->left), (int16_t)(y - to->top)))
+        return 0;
+  return 1;
+}
+
+/* Paint `damage` the way the Sub render loop does: through the plan, or
+ * with plan NULL the old painter's order of desktop then every window */
+static void paint_damage(const Rect *damage, WMRedrawPlan *plan) {
+  Window *win;
+  uint8_t p;
+
+  if (!plan) {
+    BLT_SetClipRect(damage);
+    WM_DrawDesktopInRect(damage);
+    for (win = WM_GetBottomWindow(); win; win = win->above) {
+      if (!(win->flags & WF_VISIBLE))
+        continue;
+      BLT_SetClipRect(damage);
+      BLT_DrawWindowFrame(win, SysFont_Get());
+    }
+    BLT_ResetClip();
+    return;
+  }
+
+  WM_PlanRedraw(damage, plan);
+  for (p = 0; p < plan->count; p++) {
+    BLT_SetClipRect(&plan->pieces[p].clip);
+    if (plan->pieces[p].win)
+      BLT_DrawWindowFrame(plan->pieces[p].win, SysFont_Get());
+    else
+      WM_DrawDesktopInRect(&plan->pieces[p].clip);
+  }
+  BLT_ResetClip();
+}
+
+static void occlusion_plan_removes_overdraw(void) {
+  static WMRedrawPlan plan;
+  static uint8_t painted[BLT_FRAMEBUF_SIZE_4];
+  Rect full = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+  Rect stack;
+  WMStats stats;
+  uint32_t painterPixels;
+  uint8_t i;
+
+  WM_Init();
+  framebuffer_reset();
+  for (i = 0; i < 4; i++)
+    open_test_window((int16_t)(30 + i * 20), (int16_t)(30 + i * 30),
+                     (int16_t)(150 + i * 10), (int16_t)(200 + i * 30));
+
+  /* Painter's order writes the damage, then every window over it again */
+  WM_ResetStats();
+  paint_damage(&full, (WMRedrawPlan *)0);
+  WM_GetStats(&stats);
+  painterPixels = stats.pixelsPainted;
+  memcpy(painted, framebuffer, sizeof(painted));
+
+  framebuffer_reset();
+  WM_ResetStats();
+  paint_damage(&full, &plan);
+  WM_GetStats(&stats);
+  expect_true(memcmp(painted, framebuffer, sizeof(painted)) == 0,
+              "plan paints the same frame");
+  expect_true(stats.pixelsPainted >= stats.pixelsDamaged,
+              "every damaged pixel written");
+  expect_true(stats.pixelsPainted * 10 < stats.pixelsDamaged * 11,
+              "plan overdraws under a tenth");
+  expect_true(painterPixels * 2 > stats.pixelsPainted * 3,
+              "painter's order overdraws by half again");
+  expect_true(plan.pieces[0].win == (Window *)0, "desktop painted first");
+  expect_true(plan.pieces[plan.count - 1].win == WM_GetTopWindow(),
+              "front window painted last");
+
+  /* Damage entirely inside the front window skips everything below it */
+  stack = rect_make(100, 150, 140, 200);
+  expect_true(WM_PlanRedraw(&stack, &plan), "covered plan built");
+  expect_u16(plan.count, 1, "only the front window paints");
+  expect_true(plan.pieces[0].win == WM_GetTopWindow(), "front window piece");
+  WM_GetStats(&stats);
+  expect_u16(stats.plans, 2, "plans counted");
+  expect_u16(stats.planOverflows, 0, "no plan overflow");
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+static void blit_move_copies_pixels_and_dirties_exposed_strip(void) {
+  /* Odd, byte-aligned and word-aligned shifts, both directions */
+  static const int16_t steps[][2] = {{53, 40}, {42, 40}, {44, 40}, {36, 40},
+                                     {31, 40}, {48, 43}, {40, 61}, {44, 25}};
+  Window *win;
+  uint8_t i;
+
+  for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+    Rect from;
+    Rect to;
+
+    WM_Init();
+    framebuffer_reset();
+    win = open_test_window(40, 40, 120, 160);
+    from = win->frame;
+    paint_window_pixels(&from);
+
+    WM_MoveWindow(win, steps[i][0], steps[i][1]);
+    to = win->frame;
+    WM_BeginUpdate();
+    expect_true(pixels_moved(&to), "blit copies window pixels");
+    expect_false(dirty_covers_point((int16_t)(to.right - 1),
+                                    (int16_t)(to.bottom - 1)),
+                 "blit leaves new frame clean");
+    expect_true(dirty_covers_point(
+                    (to.left < from.left) ? (int16_t)(from.right - 1)
+                                          : from.left,
+                    (to.top < from.top) ? (int16_t)(from.bottom - 1)
+                                        : from.top),
+                "blit dirties exposed corner");
+    WM_EndUpdate();
+  }
+
+  /* A horizontal drag costs exactly the strip it uncovers */
+  WM_Init();
+  framebuffer_reset();
+  win = open_test_window(40, 40, 120, 160);
+  WM_MoveWindow(win, 50, 40);
+  WM_MoveWindow(win, 57, 40);
+  expect_u16((uint16_t)dirty_area(), 17 * 80, "horizontal blit dirty area");
+  WM_EndUpdate();
+}
+
+static void blit_move_redraws_what_the_copy_cannot_supply(void) {
+  Window *win;
+  Window *front;
+  Rect stale = rect_make(50, 60, 66, 71);
+
+  WM_Init();
+  framebuffer_reset();
+  win = open_test_window(40, 40, 120, 160);
+  front = open_test_window(100, 120, 150, 220);
+  WM_SelectWindow(win);
+  WM_EndUpdate();
+  WM_SelectWindow(front);
+  WM_EndUpdate();
+
+  /* e.g. the cursor's old position, not yet redrawn */
+  WM_InvalidateRect(&stale);
+  WM_MoveWindow(win, 30, 60);
+
+  expect_true(dirty_covers_point(50, 70), "stale pixels dirty at new spot");
+  expect_true(dirty_covers_point(140, 130), "covered pixels dirty at new spot");
+  expect_true(dirty_covers_point(125, 105), "window above redrawn");
+  expect_false(dirty_covers_point(35, 130), "clean window pixels reused");
+  WM_EndUpdate();
+
+  /* Restacking before the update drops the blit for a full redraw */
+  WM_MoveWindow(win, 40, 60);
+  WM_SelectWindow(win);
+  expect_true(dirty_covers_point(45, 130), "restack cancels blit");
+  WM_EndUpdate();
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+/* Saving and restoring stay inside the saved rect and survive a repaint */
+static void save_under_restores_covered_pixels(void) {
+  Window *doc;
+  Window *alert;
+  Rect bounds = rect_make(70, 90, 140, 230);
+  Rect paint = rect_make(70, 90, 141, 231);
+  Rect under = rect_make(20, 50, 90, 130);
+  Rect part = rect_make(60, 70, 80, 100);
+  Rect screen = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+  Rect small = rect_make(40, 40, 60, 80);
+  int8_t handles[WM_SAVE_UNDER_SLOTS];
+  int8_t handle;
+  uint8_t i;
+
+  WM_Init();
+  framebuffer_reset();
+  WM_SetCursorPos(300, 200);
+  doc = open_test_window(40, 40, 200, 280);
+  paint_window_pixels(&doc->frame);
+
+  /* An alert's copy is taken at the next update, before it paints */
+  alert = WM_NewWindow(&bounds, "Alert", WM_STYLE_DIALOG, WF_VISIBLE);
+  expect_true(alert->saveUnder != 0, "dialog reserves a save-under");
+  WM_BeginUpdate();
+  BLT_FillRect(&paint, BLT_4_DARK_BLUE);
+  WM_EndUpdate();
+
+  WM_DisposeWindow(alert);
+  expect_u16((uint16_t)dirty_area(), 0, "dismissal redraws nothing");
+  expect_true(pixels_moved(&doc->frame), "covered pixels restored");
+  WM_EndUpdate();
+
+  /* A dropdown saves mid-update and re-copies what repaints beneath it */
+  WM_BeginUpdate();
+  handle = WM_SaveUnder(&under);
+  expect_true(handle >= 0, "dropdown save-under");
+  BLT_FillRect(&under, BLT_4_DARK_BLUE);
+  WM_EndUpdate();
+
+  WM_InvalidateRect(&part);
+  WM_BeginUpdate();
+  BLT_FillRect(&part, BLT_4_DARK_GREEN);
+  WM_RefreshSaveUnder(handle);
+  BLT_FillRect(&under, BLT_4_DARK_BLUE);
+  WM_EndUpdate();
+
+  /* Outside an update the blit waits for Word RAM */
+  WM_RestoreUnder(handle);
+  expect_u16(BLT_GetPixel(60, 60), BLT_4_DARK_BLUE, "restore deferred");
+  WM_BeginUpdate();
+  expect_u16(BLT_GetPixel(75, 65), BLT_4_DARK_GREEN, "refreshed copy");
+  expect_u16(BLT_GetPixel(60, 50), window_pixel(20, 10), "window restored");
+  expect_u16(BLT_GetPixel(60, 30), BLT_4_WHITE, "desktop restored");
+  WM_EndUpdate();
+
+  /* The pool hands out slots until it or the slots run out */
+  expect_true(WM_SaveUnder(&screen) < 0, "full screen exceeds the pool");
+  for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++) {
+    handles[i] = WM_SaveUnder(&small);
+    expect_true(handles[i] >= 0, "small save-under fits");
+  }
+  expect_true(WM_SaveUnder(&small) < 0, "slots exhausted");
+  for (i = 0; i < WM_SAVE_UNDER_SLOTS; i++)
+    WM_RestoreUnder(handles[i]);
+  expect_true(WM_SaveUnder(&small) >= 0, "restores free their slots");
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+/* Anything redrawn beneath an alert while it is up is redrawn again after
+ * the restore; anything else keeps the restored pixels */
+static void save_under_replays_redraws_beneath(void) {
+  Window *doc;
+  Window *alert;
+  Rect bounds = rect_make(70, 90, 140, 230);
+  Rect spot = rect_make(80, 100, 90, 120);
+
+  WM_Init();
+  framebuffer_reset();
+  WM_SetCursorPos(300, 200);
+  doc = open_test_window(40, 40, 200, 280);
+  paint_window_pixels(&doc->frame);
+
+  alert = WM_NewWindow(&bounds, "Alert", WM_STYLE_DIALOG, WF_VISIBLE);
+  WM_BeginUpdate();
+  WM_EndUpdate();
+
+  WM_InvalidateRect(&spot);
+  WM_EndUpdate();
+  WM_SetTitle(alert, "Still up");
+  WM_EndUpdate();
+  open_test_window(60, 200, 100, 300);
+
+  WM_DisposeWindow(alert);
+  expect_true(dirty_covers_point(105, 85), "redraw beneath replayed");
+  expect_true(dirty_covers_point(210, 80), "window above redrawn");
+  expect_false(dirty_covers_point(150, 120), "restored pixels kept");
+  expect_false(dirty_covers_point(100, 72), "own title change not replayed");
+  WM_EndUpdate();
+
+  /* Moving or resizing drops the copy and redraws as before */
+  alert = WM_NewWindow(&bounds, "Alert", WM_STYLE_DIALOG, WF_VISIBLE);
+  WM_BeginUpdate();
+  WM_EndUpdate();
+  WM_SizeWindow(alert, 100, 50);
+  expect_false(alert->saveUnder != 0, "resize drops the copy");
+  WM_EndUpdate();
+  WM_DisposeWindow(alert);
+  expect_true(dirty_covers_point(95, 75), "unsaved dialog invalidates");
+  WM_EndUpdate();
+
+  /* No framebuffer, nothing to save */
+  BLT_SetFramebuffer((uint8_t *)0);
+  alert = WM_NewWindow(&bounds, "Alert", WM_STYLE_DIALOG, WF_VISIBLE);
+  expect_false(alert->saveUnder != 0, "no framebuffer, no save-under");
+}
+
+/* Switching menus restores the old dropdown after the frame's dirty rects
+ * were painted; what its copy could not hold is redrawn next frame */
+static void mid_update_restore_redraws_next_frame(void) {
+  Rect first = rect_make(20, 50, 90, 130);
+  Rect second = rect_make(20, 150, 90, 230);
+  int8_t handle;
+
+  WM_Init();
+  framebuffer_reset();
+  open_test_window(40, 40, 200, 280);
+  WM_EndUpdate();
+
+  /* Open the first dropdown with the cursor over it */
+  WM_SetCursorPos(60, 40);
+  WM_BeginUpdate();
+  handle = WM_SaveUnder(&first);
+  expect_true(handle >= 0, "first dropdown saved");
+  WM_EndUpdate();
+
+  /* Slide to the next title: nothing dirty, swap dropdowns mid-update */
+  WM_SetCursorPos(160, 10);
+  expect_u16(WM_BeginUpdate(), 0, "nothing to paint before the swap");
+  WM_RestoreUnder(handle);
+  expect_true(WM_SaveUnder(&second) >= 0, "second dropdown saved");
+  WM_EndUpdate();
+
+  expect_true(dirty_covers_point(65, 45), "stale cursor rect still dirty");
+  expect_false(dirty_covers_point(100, 80), "restored pixels kept");
+  WM_EndUpdate();
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+/* XOR touches exactly the rect, whatever its byte alignment, and undoes
+ * itself */
+static void xor_rect_flips_exactly_the_rect(void) {
+  static const int16_t spans[][2] = {{3, 4}, {3, 5}, {4, 6}, {5, 40},
+                                     {8, 41}, {1, 64}, {0, 319}};
+  Rect band = rect_make(10, 0, 12, WM_SCREEN_W);
+  uint8_t flip = BLT_4_BLACK ^ BLT_4_WHITE;
+  uint8_t i;
+  int16_t x;
+
+  framebuffer_reset();
+  paint_window_pixels(&band);
+  for (i = 0; i < sizeof(spans) / sizeof(spans[0]); i++) {
+    Rect r = rect_make(10, spans[i][0], 11, spans[i][1]);
+    Boolean exact = 1;
+
+    BLT_InvertRect(&r);
+    for (x = 0; x < WM_SCREEN_W; x++) {
+      uint8_t want = window_pixel(x, 0);
+      if (x >= r.left && x < r.right)
+        want ^= flip;
+      if (BLT_GetPixel(x, 10) != want ||
+          BLT_GetPixel(x, 11) != window_pixel(x, 1))
+        exact = 0;
+    }
+    expect_true(exact, "invert flips only the rect");
+    BLT_InvertRect(&r);
+  }
+  expect_true(pixels_moved(&band), "second invert restores");
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+/* An outline drag redraws nothing until the window is dropped */
+static void outline_drag_xors_frame_until_release(void) {
+  Window *win;
+  uint8_t flip = BLT_4_BLACK ^ BLT_4_WHITE;
+
+  WM_Init();
+  framebuffer_reset();
+  WM_SetCursorPos(300, 200);
+  win = open_test_window(40, 40, 120, 160);
+  paint_window_pixels(&win->frame);
+  expect_false(WM_BeginOutlineDrag(win), "outline drag is opt-in");
+
+  WM_SetOutlineDrag(1);
+  expect_true(WM_BeginOutlineDrag(win), "outline drag begins");
+  WM_MoveWindow(win, 60, 70);
+  expect_u16((uint16_t)win->frame.left, 40, "window stays put");
+  expect_u16((uint16_t)dirty_area(), 0, "tracking invalidates nothing");
+  WM_DrawDragOutline();
+  expect_u16(BLT_GetPixel(60, 70), (uint16_t)(window_pixel(20, 30) ^ flip),
+             "outline inverted");
+  expect_u16(BLT_GetPixel(61, 71), window_pixel(21, 31), "inside untouched");
+  WM_EndUpdate();
+
+  WM_MoveWindow(win, 70, 80);
+  WM_BeginUpdate();
+  expect_true(pixels_moved(&win->frame), "old outline erased exactly");
+  expect_u16((uint16_t)dirty_area(), 0, "second step invalidates nothing");
+  WM_DrawDragOutline();
+  WM_EndUpdate();
+
+  /* The drop is an ordinary move: blit plus the uncovered strips */
+  WM_EndOutlineDrag(70, 80);
+  expect_false(WM_IsOutlineDragging(), "drag released");
+  expect_u16((uint16_t)win->frame.left, 70, "window dropped");
+  expect_true(dirty_covers_point(45, 45), "uncovered strip redrawn");
+  expect_true(pixels_moved(&win->frame), "outline erased, window blitted");
+  WM_EndUpdate();
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+static uint8_t reference[BLT_FRAMEBUF_SIZE_4];
+
+/* Pixels inside `r` match the reference frame */
+static Boolean matches_reference(const Rect *r) {
+  uint8_t *fb = BLT_GetFramebuffer();
+  int16_t x;
+  int16_t y;
+
+  for (y = r->top; y < r->bottom; y++) {
+    for (x = r->left; x < r->right; x++) {
+      uint8_t got = BLT_GetPixel(x, y);
+      BLT_SetFramebuffer(reference);
+      if (BLT_GetPixel(x, y) != got) {
+        BLT_SetFramebuffer(fb);
+        return 0;
+      }
+      BLT_SetFramebuffer(fb);
+    }
+  }
+  return 1;
+}
+
+/* Render `win` the uncached way into the reference frame */
+static void draw_reference(const Window *win) {
+  uint8_t *fb = BLT_GetFramebuffer();
+
+  memcpy(reference, fb, sizeof(reference));
+  BLT_SetFramebuffer(reference);
+  BLT_DrawWindowFrame(win, SysFont_Get());
+  BLT_SetFramebuffer(fb);
+}
+
+static void chrome_cache_blits_identical_title_bars(void) {
+  Window *win;
+  WMStats stats;
+  Rect screen = rect_make(0, 0, WM_SCREEN_H, WM_SCREEN_W);
+  Rect half;
+
+  WM_Init();
+  framebuffer_reset();
+  win = open_test_window(40, 41, 120, 201);
+
+  /* First draw renders and keeps the bar, the second blits it back */
+  draw_reference(win);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  expect_true(matches_reference(&screen), "uncached frame identical");
+  paint_window_pixels(&win->titleBar);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  expect_true(matches_reference(&screen), "cached title bar identical");
+
+  /* Each hilite state has its own copy */
+  win->flags &= (uint8_t)~WF_HILITED;
+  draw_reference(win);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  WM_DrawWindowFrame(win, SysFont_Get());
+  expect_true(matches_reference(&screen), "inactive title bar identical");
+  win->flags |= WF_HILITED;
+  WM_DrawWindowFrame(win, SysFont_Get());
+  WM_GetStats(&stats);
+  expect_u16(stats.chromeMisses, 2, "one render per hilite state");
+  expect_u16(stats.chromeHits, 3, "redraws come from the cache");
+
+  /* Moving by whole stripe pattern cells keeps the copy */
+  WM_MoveWindow(win, 49, 56);
+  WM_EndUpdate();
+  draw_reference(win);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  expect_true(matches_reference(&screen), "moved title bar identical");
+
+  /* A clipped redraw restores only its part */
+  half = win->titleBar;
+  half.right = (int16_t)(half.left + 37);
+  paint_window_pixels(&win->titleBar);
+  memcpy(reference, BLT_GetFramebuffer(), sizeof(reference));
+  BLT_SetFramebuffer(reference);
+  BLT_SetClipRect(&half);
+  BLT_DrawWindowFrame(win, SysFont_Get());
+  BLT_SetFramebuffer(framebuffer);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  BLT_ResetClip();
+  expect_true(matches_reference(&screen), "clipped restore identical");
+  WM_GetStats(&stats);
+  expect_u16(stats.chromeHits, 5, "moved and clipped bars cached");
+
+  /* Retitling and resizing drop the copies */
+  WM_SetTitle(win, "Renamed");
+  WM_EndUpdate();
+  draw_reference(win);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  expect_true(matches_reference(&screen), "retitled bar redrawn");
+  WM_SizeWindow(win, 120, 70);
+  WM_EndUpdate();
+  draw_reference(win);
+  WM_DrawWindowFrame(win, SysFont_Get());
+  expect_true(matches_reference(&screen), "resized bar redrawn");
+  WM_GetStats(&stats);
+  expect_u16(stats.chromeMisses, 4, "retitle and resize re-render");
+
+  BLT_SetFramebuffer((uint8_t *)0);
+}
+
+/* Activation repaints the two title bars plus what the raised window had
+ * hidden under other windows */
+static void activation_invalidates_title_bars_and_covered_part(void) {
+  Window *back;
+  Window *front;
+
+  WM_Init();
+  back = open_test_window(40, 40, 120, 160);
+  front = open_test_window(60, 100, 160, 260);
+
+  WM_SelectWindow(back);
+  expect_true(WM_GetTopWindow() == back, "selected window raised");
+  expect_true((back->flags & WF_HILITED) != 0, "selected window hilited");
+  expect_false((front->flags & WF_HILITED) != 0, "old window unhilited");
+  expect_true(dirty_covers_point(100, 45), "new title bar redrawn");
+  expect_true(dirty_covers_point(200, 65), "old title bar redrawn");
+  expect_true(dirty_covers_point(130, 100), "covered part redrawn");
+  expect_false(dirty_covers_point(60, 100), "visible content kept");
+  expect_false(dirty_covers_point(200, 140), "old window content kept");
+  WM_EndUpdate();
+}
+
+int main(void) {
+  plain_move_invalidates_both_frames_and_records_event();
+  fast_drag_is_opt_in();
+  fast_drag_snaps_and_dirties_only_uncovered_origin();
+  fast_drag_drop_rerenders_at_full_precision();
+  fast_drag_rejects_windows_larger_than_spare_tiles();
+  blit_move_copies_pixels_and_dirties_exposed_strip();
+  blit_move_redraws_what_the_copy_cannot_supply();
+  save_under_restores_covered_pixels();
+  save_under_replays_redraws_beneath();
+  mid_update_restore_redraws_next_frame();
+  xor_rect_flips_exactly_the_rect();
+  outline_drag_xors_frame_until_release();
+  chrome_cache_blits_identical_title_bars();
+  activation_invalidates_title_bars_and_covered_part();
+  fully_covered_window_has_no_pieces();
+  occlusion_plan_removes_overdraw();
+  invalidation_marks_dirty_tiles_until_end_update();
+  sixteen_window_cascade_plans_exactly();
+  window_pool_reuses_ids_and_tracks_high_water();
+  visible_regions_tile_random_layouts();
+
+  if (failures) {
+    printf("%d wm test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("wm tests passed\n");
+  return 0;
+}
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Decode Sub CPU heap telemetry read back through CMD_HEAP_TELEMETRY.
+
+Input is text holding 16-bit hex words. By default each line is one
+command reply: the eight result registers STATUS0-STATUS7, where STATUS0
+is (first word << 8) | total words and STATUS1-7 carry the words from
+'first' on. Issue the command with params 0, 7, 14, ... and paste the
+replies in any order. With --words the input is the packed
+MEM_PackTelemetry() words themselves, in order.
+"""
+
+from __future__ import annotations
+
+import argparse
+import sys
+from pathlib import Path
+
+
+TELEMETRY_VERSION = 1
+HIST_BINS = 8
+PAGE_WORDS = 7
+
+# Word offsets, matching MEM_TM_* in include/mem.h
+TM_VERSION = 0
+TM_HEAP_SIZE = 1
+TM_USED = 3
+TM_HIGH_WATER = 5
+TM_LARGEST_FREE = 7
+TM_FAILED = 9
+TM_HISTOGRAM = 11
+TELEMETRY_WORDS = TM_HISTOGRAM + HIST_BINS
+
+
+def parse_words(text: str) -> list[list[int]]:
+    lines = []
+    for raw in text.splitlines():
+        raw = raw.split("#", 1)[0].replace(",", " ").strip()
+        if not raw:
+            continue
+        words = []
+        for token in raw.split():
+            value = int(token, 16)
+            if not 0 <= value <= 0xFFFF:
+                raise ValueError(f"not a 16-bit word: {token}")
+            words.append(value)
+        lines.append(words)
+    return lines
+
+
+def assemble_pages(pages: list[list[int]]) -> list[int]:
+    words: list[int | None] = [None] * TELEMETRY_WORDS
+    for page in pages:
+        if len(page) != 1 + PAGE_WORDS:
+            raise ValueError(f"reply needs 8 words, got {len(page)}")
+        first, total = page[0] >> 8, page[0] & 0xFF
+        if total != TELEMETRY_WORDS:
+            raise ValueError(
+                f"reply describes {total} words, decoder expects "
+                f"{TELEMETRY_WORDS}"
+            )
+        for i, value in enumerate(page[1:]):
+            if first + i < TELEMETRY_WORDS:
+                words[first + i] = value
+    missing = [i for i, value in enumerate(words) if value is None]
+    if missing:
+        starts = sorted({i - i % PAGE_WORDS for i in missing})
+        raise ValueError(
+            "missing words " + ", ".join(map(str, missing)) +
+            "; request pages starting at " + ", ".join(map(str, starts))
+        )
+    return [value for value in words if value is not None]
+
+
+def decode(words: list[int]) -> dict:
+    if len(words) != TELEMETRY_WORDS:
+        raise ValueError(
+            f"expected {TELEMETRY_WORDS} words, got {len(words)}"
+        )
+    if words[TM_VERSION] != TELEMETRY_VERSION:
+        raise ValueError(f"unknown telemetry version {words[TM_VERSION]}")
+
+    def u32(offset: int) -> int:
+        return (words[offset] << 16) | words[offset + 1]
+
+    return {
+        "heap_size": u32(TM_HEAP_SIZE),
+        "used": u32(TM_USED),
+        "high_water": u32(TM_HIGH_WATER),
+        "largest_free": u32(TM_LARGEST_FREE),
+        "failed": u32(TM_FAILED),
+        "histogram": words[TM_HISTOGRAM:TM_HISTOGRAM + HIST_BINS],
+    }
+
+
+def bin_label(index: int) -> str:
+    if index == 0:
+        return "1-15"
+    low = 1 << (index + 3)
+    if index == HIST_BINS - 1:
+        return f"{low}+"
+    return f"{low}-{(low << 1) - 1}"
+
+
+def report(t: dict) -> str:
+    heap = t["heap_size"] or 1
+    free = t["heap_size"] - t["used"]
+    frag = 0 if free == 0 else 100 - t["largest_free"] * 100 // free
+    total = sum(t["histogram"]) or 1
+    lines = [
+        f"heap          {t['heap_size']:>8} bytes",
+        f"used          {t['used']:>8} bytes ({t['used'] * 100 // heap}%)",
+        f"high water    {t['high_water']:>8} bytes "
+        f"({t['high_water'] * 100 // heap}%)",
+        f"largest free  {t['largest_free']:>8} bytes "
+        f"(fragmentation {frag}%)",
+        f"failed allocs {t['failed']:>8}",
+        "allocations by size:",
+    ]
+    for index, count in enumerate(t["histogram"]):
+        saturated = "+" if count == 0xFFFF else " "
+        bar = "#" * (count * 40 // total)
+        lines.append(
+            f"  {bin_label(index):>9} {count:>6}{saturated} {bar}"
+        )
+    return "\n".join(lines)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", default="-",
+                        help="text file of hex words, '-' for stdin")
+    parser.add_argument("--words", action="store_true",
+                        help="input is the packed words, not replies")
+    args = parser.parse_args()
+
+    text = (sys.stdin.read() if args.input == "-"
+            else Path(args.input).read_text())
+    try:
+        lines = parse_words(text)
+        if args.words:
+            words = [value for line in lines for value in line]
+        else:
+            words = assemble_pages(lines)
+        print(report(decode(words)))
+    except ValueError as err:
+        print(f"heap_telemetry: {err}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())